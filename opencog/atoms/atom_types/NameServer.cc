@@ -105,7 +105,7 @@ Type NameServer::declType(const Type parent, const std::string& name)
     // GroundedSchemaNode, which inherits from several types.
     Type type = getType(name);
     if (type != NOTYPE) {
-        std::lock_guard<std::mutex> l(type_mutex);
+        std::unique_lock<std::mutex> l(type_mutex);
 
         // ... unless someone is accidentally declaring the same type
         // in some different place. In that case, we throw an error.
@@ -119,6 +119,10 @@ Type NameServer::declType(const Type parent, const std::string& name)
         Type maxd = 1;
         setParentRecursively(parent, type, maxd);
         if (_maxDepth < maxd) _maxDepth = maxd;
+        l.unlock();
+
+        // The type hierarchy changed; anyone caching it needs to know.
+        _addTypeSignal.emit(type);
         return type;
     }
 
@@ -97,7 +97,8 @@ public:
      */
     Type declType(const Type parent, const std::string& name);
 
-    /** Provides ability to get type-added signals.
+    /** Provides ability to get type-added signals. The signal is
+     * also emitted when an existing type is given another parent.
      * @warning methods connected to this signal must not call
      * ClassServer::addType or things will deadlock.
      */
@@ -42,11 +42,12 @@
 //! Atom flag
 #define FETCHED_RECENTLY        1  //BIT0
 #define MARKED_FOR_REMOVAL      2  //BIT1
-// #define MULTIPLE_TRUTH_VALUES   4  //BIT2
-// #define FIRED_ACTIVATION        8  //BIT3
-// #define HYPOTETHICAL_FLAG       16 //BIT4
-// #define REMOVED_BY_DECAY        32 //BIT5
+#define KEEP_INCOMING           4  //BIT2
+#define RECENTLY_USED           8  //BIT3
+#define DIRTY                   16 //BIT4
+#define INCOMING_EVICTED        32 //BIT5
 #define CHECKED                 64  //BIT6
+#define IN_INCOMING             128 //BIT7
 
 //#define DPRINTF printf
 #define DPRINTF(...)
@@ -153,19 +154,34 @@ TruthValuePtr Atom::getTruthValue() const
 /// If the value is a null pointer, then the key is removed.
 void Atom::setValue(const Handle& key, const ValuePtr& value)
 {
-	std::lock_guard<std::mutex> lck(_mtx);
+	touch();
+	setDirty();
+	std::lock_guard<AtomLock> lck(_mtx);
+	auto pr = find_value(key);
 	if (nullptr != value)
 	{
-		_values[key] = value;
+		if (_values.end() != pr) pr->second = value;
+		else _values.emplace_back(key, value);
 	}
-	else
+	else if (_values.end() != pr)
 	{
 		// If the value is a null pointer, then the value at
 		// this key should be blanked out, i.e. unset.
-		_values.erase(key);
+		*pr = std::move(_values.back());
+		_values.pop_back();
+		if (_values.empty()) ValueVec().swap(_values);
 	}
 }
 
+/// Keys are compared by content, just as they were when the values
+/// were kept in a std::map. The caller must hold the lock.
+Atom::ValueVec::iterator Atom::find_value(const Handle& key) const
+{
+	for (auto it = _values.begin(); it != _values.end(); it++)
+		if (content_eq(it->first, key)) return it;
+	return _values.end();
+}
+
 ValuePtr Atom::getValue(const Handle& key) const
 {
     // OK. The atomic thread-safety of shared-pointers is subtle. See
@@ -179,9 +195,10 @@ ValuePtr Atom::getValue(const Handle& key) const
     // the multi-threaded async atom store in the SQL peristance backend.
     // Furthermore, we must make a copy while holding the lock! Got that?
 
+    touch();
     ValuePtr pap;
-    std::lock_guard<std::mutex> lck(_mtx);
-    auto pr = _values.find(key);
+    std::lock_guard<AtomLock> lck(_mtx);
+    auto pr = find_value(key);
     if (_values.end() != pr) pap = pr->second;
     return pap;
 }
@@ -189,13 +206,22 @@ ValuePtr Atom::getValue(const Handle& key) const
 HandleSet Atom::getKeys() const
 {
     HandleSet keyset;
-    std::lock_guard<std::mutex> lck(_mtx);
+    std::lock_guard<AtomLock> lck(_mtx);
     for (const auto& pr : _values)
         keyset.insert(pr.first);
 
     return keyset;
 }
 
+size_t Atom::value_table_bytes(std::vector<ValuePtr>* values) const
+{
+    std::lock_guard<AtomLock> lck(_mtx);
+    if (values)
+        for (const auto& pr : _values)
+            values->push_back(pr.second);
+    return _values.capacity() * sizeof(ValueVec::value_type);
+}
+
 void Atom::copyValues(const Handle& other)
 {
     HandleSet okeys(other->getKeys());
@@ -260,6 +286,62 @@ void Atom::setUnchecked(void)
     _flags &= ~CHECKED;
 }
 
+// The CLOCK bit is read before it is set, so that atoms that are used
+// over and over do not keep bouncing the cache line between threads.
+void Atom::touch(void) const
+{
+    if (0 == (_flags & RECENTLY_USED)) _flags |= RECENTLY_USED;
+}
+
+bool Atom::untouch(void) const
+{
+    return 0 != (_flags.fetch_and(~RECENTLY_USED) & RECENTLY_USED);
+}
+
+bool Atom::isDirty() const
+{
+    return (_flags & DIRTY) != 0;
+}
+
+void Atom::setDirty(void)
+{
+    if (0 == (_flags & DIRTY)) _flags |= DIRTY;
+}
+
+void Atom::clearDirty(void)
+{
+    _flags &= ~DIRTY;
+}
+
+void Atom::setInIncoming(void)
+{
+    if (0 == (_flags & IN_INCOMING)) _flags |= (char) IN_INCOMING;
+}
+
+bool Atom::clearInIncoming(void)
+{
+    return 0 != (_flags.fetch_and((char) ~IN_INCOMING) & IN_INCOMING);
+}
+
+void Atom::setIncomingEvicted(void)
+{
+    _flags |= INCOMING_EVICTED;
+}
+
+bool Atom::clearIncomingEvicted(void) const
+{
+    return 0 != (_flags.fetch_and(~INCOMING_EVICTED) & INCOMING_EVICTED);
+}
+
+/// Links in the incoming set were evicted by an AtomSpace that is over
+/// its budget; fetch them back, before anyone looks at the set.
+void Atom::fault_incoming(void) const
+{
+    if (0 == (_flags & INCOMING_EVICTED)) return;
+    if (not clearIncomingEvicted() or nullptr == _atom_space) return;
+    _atom_space->fault_incoming_set(get_handle());
+}
+
 // ==============================================================
 
 void Atom::setAtomSpace(AtomSpace *tb)
@@ -293,11 +375,11 @@ AtomTable* Atom::getAtomTable() const
 /// 1) std::set takes up 48 bytes
 /// 2) adding and removing uses up cpu cycles.
 /// Thus, if the incoming set isn't needed, then don't bother
-/// tracking it.
+/// tracking it. Even when tracked, the storage is not allocated
+/// until the first link shows up.
 void Atom::keep_incoming_set()
 {
-    if (_incoming_set) return;
-    _incoming_set = std::make_shared<InSet>();
+    _flags |= KEEP_INCOMING;
 }
 
 /// Stop tracking the incoming set for this atom.
@@ -305,27 +387,48 @@ void Atom::keep_incoming_set()
 /// be queried; it is erased.
 void Atom::drop_incoming_set()
 {
-    if (nullptr == _incoming_set) return;
-    std::lock_guard<std::mutex> lck (_mtx);
-    // _incoming_set->_iset.clear();
+    _flags &= ~KEEP_INCOMING;
+    std::lock_guard<AtomLock> lck (_mtx);
     _incoming_set = nullptr;
 }
 
-/// Add an atom to the incoming set.
-void Atom::insert_atom(const Handle& a)
+void Atom::InSet::insert(const Handle& a)
 {
-    if (nullptr == _incoming_set) return;
-    std::lock_guard<std::mutex> lck (_mtx);
-
     Type at = a->get_type();
-    auto bucket = _incoming_set->_iset.find(at);
-    if (bucket == _incoming_set->_iset.end())
+    WincomingSet* bucket = find(at);
+    if (nullptr == bucket)
     {
-        auto pr = _incoming_set->_iset.emplace(
-                   std::make_pair(at, WincomingSet()));
-        bucket = pr.first;
+        _iset.emplace_back(at, WincomingSet());
+        bucket = &_iset.back().second;
     }
-    bucket->second.insert(a);
+    bucket->insert(a);
+}
+
+void Atom::InSet::erase(const Atom* a, Type at)
+{
+    for (auto it = _iset.begin(); it != _iset.end(); it++)
+    {
+        if (at != it->first) continue;
+        it->second.erase(a);
+
+        // Drop empty buckets, so that the list stays short.
+        if (it->second.empty())
+        {
+            *it = std::move(_iset.back());
+            _iset.pop_back();
+        }
+        return;
+    }
+}
+
+/// Add an atom to the incoming set.
+void Atom::insert_atom(const Handle& a)
+{
+    if (0 == (_flags & KEEP_INCOMING)) return;
+    std::lock_guard<AtomLock> lck (_mtx);
+    if (nullptr == _incoming_set) _incoming_set.reset(new InSet());
+    _incoming_set->insert(a);
+    a->setInIncoming();
 
 #ifdef INCOMING_SET_SIGNALS
     _incoming_set->_addAtomSignal(shared_from_this(), a);
@@ -335,15 +438,21 @@ void Atom::insert_atom(const Handle& a)
 /// Remove an atom from the incoming set.
 void Atom::remove_atom(const Handle& a)
 {
+    std::lock_guard<AtomLock> lck (_mtx);
     if (nullptr == _incoming_set) return;
-    std::lock_guard<std::mutex> lck (_mtx);
 #ifdef INCOMING_SET_SIGNALS
     _incoming_set->_removeAtomSignal(shared_from_this(), a);
 #endif /* INCOMING_SET_SIGNALS */
-    Type at = a->get_type();
-    auto bucket = _incoming_set->_iset.find(at);
-    if (bucket != _incoming_set->_iset.end())
-        bucket->second.erase(a);
+    _incoming_set->erase(a.get(), a->get_type());
+}
+
+/// Remove a link that is being destroyed. There is no Handle for it
+/// any more, and so no signal either.
+void Atom::remove_gone(const Atom* a, Type t)
+{
+    std::lock_guard<AtomLock> lck (_mtx);
+    if (nullptr == _incoming_set) return;
+    _incoming_set->erase(a, t);
 }
 
 /// Remove old, and add new, atomically, so that every user
@@ -351,25 +460,15 @@ void Atom::remove_atom(const Handle& a)
 /// the incoming set. This is used to manage the StateLink.
 void Atom::swap_atom(const Handle& old, const Handle& neu)
 {
+    std::lock_guard<AtomLock> lck (_mtx);
     if (nullptr == _incoming_set) return;
-    std::lock_guard<std::mutex> lck (_mtx);
 
 #ifdef INCOMING_SET_SIGNALS
     _incoming_set->_removeAtomSignal(shared_from_this(), old);
 #endif /* INCOMING_SET_SIGNALS */
-    Type ot = old->get_type();
-    auto bucket = _incoming_set->_iset.find(ot);
-    bucket->second.erase(old);
-
-    Type nt = neu->get_type();
-    bucket = _incoming_set->_iset.find(nt);
-    if (bucket == _incoming_set->_iset.end())
-    {
-        auto pr = _incoming_set->_iset.emplace(
-                   std::make_pair(nt, WincomingSet()));
-        bucket = pr.first;
-    }
-    bucket->second.insert(neu);
+    _incoming_set->erase(old.get(), old->get_type());
+    _incoming_set->insert(neu);
+    neu->setInIncoming();
 
 #ifdef INCOMING_SET_SIGNALS
     _incoming_set->_addAtomSignal(shared_from_this(), neu);
@@ -381,30 +480,38 @@ void Atom::remove() {}
 
 size_t Atom::getIncomingSetSize(AtomSpace* as) const
 {
+    fault_incoming();
+    std::lock_guard<AtomLock> lck (_mtx);
     if (nullptr == _incoming_set) return 0;
-
-    std::lock_guard<std::mutex> lck (_mtx);
+    if (nullptr == as) return _incoming_set->size();
 
     size_t cnt = 0;
-    if (as)
-    {
-        const AtomTable *atab = &as->get_atomtable();
-        for (const auto& bucket : _incoming_set->_iset)
-        {
-            for (const WinkPtr& w : bucket.second)
-            {
-                Handle l(w.lock());
-                if (l and atab->in_environ(l)) cnt++;
-            }
-        }
-        return cnt;
-    }
-
-    for (const auto& pr : _incoming_set->_iset)
-        cnt += pr.second.size();
+    const AtomTable *atab = &as->get_atomtable();
+    for (auto& bucket : _incoming_set->_iset)
+        bucket.second.for_each([&](const Handle& l) {
+            if (atab->in_environ(l)) cnt++;
+        });
     return cnt;
 }
 
+bool Atom::has_incoming() const
+{
+    std::lock_guard<AtomLock> lck (_mtx);
+    return nullptr != _incoming_set and 0 < _incoming_set->size();
+}
+
+size_t Atom::incoming_set_bytes() const
+{
+    std::lock_guard<AtomLock> lck (_mtx);
+    if (nullptr == _incoming_set) return 0;
+
+    const InSet::Buckets& iset(_incoming_set->_iset);
+    size_t bytes = sizeof(InSet) + iset.capacity() * sizeof(iset[0]);
+    for (const auto& bucket : iset)
+        bytes += bucket.second.bytes();
+    return bytes;
+}
+
 // We return a copy here, and not a reference, because the set itself
 // is not thread-safe during reading while simultaneous insertion and
 // deletion.  Besides, the incoming set is weak; we have to make it
@@ -412,95 +519,75 @@ size_t Atom::getIncomingSetSize(AtomSpace* as) const
 IncomingSet Atom::getIncomingSet(AtomSpace* as) const
 {
     static IncomingSet empty_set;
+
+    fault_incoming();
+
+    // Prevent update of set while a copy is being made.
+    std::lock_guard<AtomLock> lck (_mtx);
     if (nullptr == _incoming_set) return empty_set;
 
+    IncomingSet iset;
     if (as) {
         const AtomTable *atab = &as->get_atomtable();
-        // Prevent update of set while a copy is being made.
-        std::lock_guard<std::mutex> lck (_mtx);
-        IncomingSet iset;
-        for (const auto& bucket : _incoming_set->_iset)
-        {
-            for (const WinkPtr& w : bucket.second)
-            {
-                Handle l(w.lock());
-                if (l and atab->in_environ(l))
-                    iset.emplace_back(l);
-            }
-        }
+        for (auto& bucket : _incoming_set->_iset)
+            bucket.second.for_each([&](const Handle& l) {
+                if (atab->in_environ(l)) iset.emplace_back(l);
+            });
         return iset;
     }
 
-    // Prevent update of set while a copy is being made.
-    std::lock_guard<std::mutex> lck (_mtx);
-    IncomingSet iset;
-    for (const auto& bucket : _incoming_set->_iset)
-    {
-        for (const WinkPtr& w : bucket.second)
-        {
-            Handle l(w.lock());
-            if (l) iset.emplace_back(l);
-        }
-    }
+    iset.reserve(_incoming_set->size());
+    for (auto& bucket : _incoming_set->_iset)
+        bucket.second.for_each([&](const Handle& l) {
+            iset.emplace_back(l);
+        });
     return iset;
 }
 
 IncomingSet Atom::getIncomingSetByType(Type type, AtomSpace* as) const
 {
     static IncomingSet empty_set;
-    if (nullptr == _incoming_set) return empty_set;
+
+    fault_incoming();
 
     // Lock to prevent updates of the set of atoms.
-    std::lock_guard<std::mutex> lck(_mtx);
+    std::lock_guard<AtomLock> lck(_mtx);
+    if (nullptr == _incoming_set) return empty_set;
 
-    const auto bucket = _incoming_set->_iset.find(type);
-    if (bucket == _incoming_set->_iset.cend()) return empty_set;
+    WincomingSet* bucket = _incoming_set->find(type);
+    if (nullptr == bucket) return empty_set;
 
     IncomingSet result;
     if (as) {
         const AtomTable *atab = &as->get_atomtable();
-        for (const WinkPtr& w : bucket->second)
-        {
-            Handle l(w.lock());
-            if (l and atab->in_environ(l))
-                result.emplace_back(l);
-        }
+        bucket->for_each([&](const Handle& l) {
+            if (atab->in_environ(l)) result.emplace_back(l);
+        });
         return result;
     }
 
-    for (const WinkPtr& w : bucket->second)
-    {
-        Handle l(w.lock());
-        if (l) result.emplace_back(l);
-    }
+    result.reserve(bucket->size());
+    bucket->for_each([&](const Handle& l) {
+        result.emplace_back(l);
+    });
     return result;
 }
 
 size_t Atom::getIncomingSetSizeByType(Type type, AtomSpace* as) const
 {
+    fault_incoming();
+    std::lock_guard<AtomLock> lck(_mtx);
     if (nullptr == _incoming_set) return 0;
-    std::lock_guard<std::mutex> lck(_mtx);
 
-    const auto bucket = _incoming_set->_iset.find(type);
-    if (bucket == _incoming_set->_iset.cend()) return 0;
+    WincomingSet* bucket = _incoming_set->find(type);
+    if (nullptr == bucket) return 0;
+    if (nullptr == as) return bucket->size();
 
     size_t cnt = 0;
-
-    if (as) {
-        const AtomTable *atab = &as->get_atomtable();
-        for (const WinkPtr& w : bucket->second)
-        {
-            Handle l(w.lock());
-            if (l and atab->in_environ(l)) cnt++;
-        }
-        return cnt;
-    }
-
-    for (const WinkPtr& w : bucket->second)
-    {
-        Handle l(w.lock());
-        if (l) cnt++;
-    }
+    const AtomTable *atab = &as->get_atomtable();
+    bucket->for_each([&](const Handle& l) {
+        if (atab->in_environ(l)) cnt++;
+    });
     return cnt;
 }
 
@@ -27,23 +27,24 @@
 #ifndef _OPENCOG_ATOM_H
 #define _OPENCOG_ATOM_H
 
+#include <atomic>
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <mutex>
 #include <string>
+#include <thread>
 #include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include <opencog/util/empty_string.h>
 #include <opencog/util/sigslot.h>
 #include <opencog/atoms/base/Handle.h>
+#include <opencog/atoms/base/WincomingSet.h>
 #include <opencog/atoms/value/Value.h>
 #include <opencog/atoms/truthvalue/TruthValue.h>
 
-namespace opencog
-{
-typedef std::weak_ptr<Atom> WinkPtr;
-}
-
 namespace std
 {
 
@@ -88,8 +89,27 @@ typedef std::size_t Arity;
 typedef HandleSeq IncomingSet;
 typedef SigSlot<Handle, Handle> AtomPairSignal;
 
-// typedef std::unordered_set<WinkPtr> WincomingSet;
-typedef std::set<WinkPtr, std::owner_less<WinkPtr> > WincomingSet;
+/**
+ * A one-byte lock, used to serialize changes to an atom. It is only
+ * ever held for a short while, with no callbacks made, so spinning
+ * (and yielding) costs little, while a std::mutex would cost 40 bytes
+ * in every atom. It is not recursive.
+ */
+class AtomLock
+{
+    std::atomic<bool> _held;
+
+public:
+    AtomLock() : _held(false) {}
+
+    void lock()
+    {
+        while (_held.exchange(true, std::memory_order_acquire))
+            while (_held.load(std::memory_order_relaxed))
+                std::this_thread::yield();
+    }
+    void unlock() { _held.store(false, std::memory_order_release); }
+};
 
 /**
  * Atoms are the basic implementational unit in the system that
@@ -103,6 +123,7 @@ class Atom
     friend class AtomTable;       // Needs to call MarkedForRemoval()
     friend class AtomSpace;       // Needs to call getAtomTable()
     friend class TypeIndex;       // Needs to clear _atom_space
+    friend class SampleIndex;     // Needs to set _sample_pos
     friend class Link;            // Needs to call install_atom()
     friend class StateLink;       // Needs to call swap_atom()
     friend class SQLAtomStorage;  // Needs to call getAtomTable()
@@ -117,7 +138,17 @@ protected:
 
     // Byte of bitflags (each bit is a flag).
     // Place this first, so that is shares a word with Type.
-    mutable char _flags;
+    // Atomic, because the AtomTable marks atoms for removal while
+    // other threads may be inspecting the flags.
+    mutable std::atomic<char> _flags;
+
+    // Lock, used to serialize changes. This used to be a std::mutex,
+    // at 40 bytes per atom; this one fits in the byte after the flags.
+    mutable AtomLock _mtx;
+
+    // Position of this atom in the SampleIndex. This fits in the
+    // padding after the flags, so it costs nothing.
+    uint32_t _sample_pos;
 
     /// Merkle-tree hash of the atom contents. Generically useful
     /// for indexing and comparison operations.
@@ -125,15 +156,13 @@ protected:
 
     AtomSpace *_atom_space;
 
-    /// All of the values on the atom, including the TV.
-    mutable std::map<const Handle, ValuePtr> _values;
-
-    // Lock, used to serialize changes.
-    // This costs 40 bytes per atom.  Tried using a single, global lock,
-    // but there seemed to be too much contention for it, so instead,
-    // we are using a lock-per-atom, even though this makes the atom
-    // kind-of fat.
-    mutable std::mutex _mtx;
+    /// All of the values on the atom, including the TV. Most atoms
+    /// carry no more than a few values, so these are kept in a flat
+    /// vector, searched linearly: this is 24 bytes, against 48 for an
+    /// empty std::map, and one allocation, instead of one per value.
+    typedef std::vector<std::pair<Handle, ValuePtr>> ValueVec;
+    mutable ValueVec _values;
+    ValueVec::iterator find_value(const Handle&) const;
 
     /**
      * Constructor for this class. Protected; no user should call this
@@ -144,6 +173,7 @@ protected:
     Atom(Type t)
       : Value(t),
         _flags(0),
+        _sample_pos(0),
         _content_hash(Handle::INVALID_HASH),
         _atom_space(nullptr)
     {}
@@ -159,6 +189,10 @@ protected:
     // std::set<ptr> uses 48 bytes (per atom).  See the README file
     // in this directory for a slightly longer explanation for why
     // weak pointers are needed, and why bdwgc cannot be used.
+    //
+    // The InSet is allocated only when the first link is added to
+    // it, so that atoms with empty incoming sets pay just for the
+    // pointer.
     struct InSet
     {
         // We want five things:
@@ -172,14 +206,32 @@ protected:
         //
         // In order to get b), we have to store atoms in buckets, each
         // bucket holding only one type.  To satisfy d), the buckets
-        // need to be either hash tables or rb-trees. Scanning for
-        // uniqueness in a vector is prohibitavely slow.  Note that
-        // incoming sets containing 10K atoms are not unusual, and can
-        // be the source of bottlnecks.  Note that an atomspace can
-        // contain a hundred-million atoms, so the solution has to be
-        // small. This rules out using a vector to store the
-        // buckets (I tried).
-        std::map<Type, WincomingSet> _iset;
+        // need to be hash tables. Scanning for uniqueness in a vector
+        // is prohibitavely slow.  Note that incoming sets containing
+        // millions of atoms are not unusual, and can be the source of
+        // bottlnecks.  Note that an atomspace can contain a
+        // hundred-million atoms, so the solution has to be small.
+        // This rules out a vector indexed by type, but an atom rarely
+        // has links of more than a few types pointing at it, so a
+        // short list of (type, bucket) pairs, searched linearly, does
+        // fine.
+        typedef std::vector<std::pair<Type, WincomingSet>> Buckets;
+        Buckets _iset;
+
+        WincomingSet* find(Type t)
+        {
+            for (auto& pr : _iset)
+                if (t == pr.first) return &pr.second;
+            return nullptr;
+        }
+        void insert(const Handle&);
+        void erase(const Atom*, Type);
+        size_t size() const
+        {
+            size_t cnt = 0;
+            for (const auto& pr : _iset) cnt += pr.second.size();
+            return cnt;
+        }
 
 #ifdef INCOMING_SET_SIGNALS
         // Some people want to know if the incoming set has changed...
@@ -190,7 +242,7 @@ protected:
         AtomPairSignal _removeAtomSignal;
 #endif /* INCOMING_SET_SIGNALS */
     };
-    typedef std::shared_ptr<InSet> InSetPtr;
+    typedef std::unique_ptr<InSet> InSetPtr;
     InSetPtr _incoming_set;
     void keep_incoming_set();
     void drop_incoming_set();
@@ -198,6 +250,7 @@ protected:
     // Insert and remove links from the incoming set.
     void insert_atom(const Handle&);
     void remove_atom(const Handle&);
+    void remove_gone(const Atom*, Type);
     void swap_atom(const Handle&, const Handle&);
     virtual void install();
     virtual void remove();
@@ -222,6 +275,28 @@ private:
     void setChecked();
     void setUnchecked();
 
+    /** Whether this link is in the incoming sets of its outgoing set.
+     *  If it is, when it is destroyed, it has to take itself out. */
+    void setInIncoming();
+    bool clearInIncoming();
+
+    /** Bookkeeping for an AtomSpace with a memory budget. The CLOCK
+     *  bit is set whenever the atom is looked up, or its values are
+     *  used; the eviction sweep clears it, and untouch() says whether
+     *  it was set. The dirty bit is set when the atom is added, or
+     *  its values change, and cleared once the backing store has the
+     *  same. The incoming-evicted bit is set on the atoms in the
+     *  outgoing set of an evicted link; the next look at the incoming
+     *  set fetches it back from the backing store. */
+    void touch() const;
+    bool untouch() const;
+    bool isDirty() const;
+    void setDirty();
+    void clearDirty();
+    void setIncomingEvicted();
+    bool clearIncomingEvicted() const;
+    void fault_incoming() const;
+
 public:
 
     virtual ~Atom();
@@ -305,7 +380,21 @@ public:
     /// Print all of the key-value pairs.
     std::string valuesToString() const;
 
-    //! Get the size of the incoming set.
+    /// Memory accounting: the bytes held by the table of values, not
+    /// counting the values themselves. If `values` is given, the
+    /// values are appended to it, so that they can be measured too.
+    size_t value_table_bytes(std::vector<ValuePtr>* values = nullptr) const;
+
+    /// Memory accounting: the bytes held by the incoming set, not
+    /// counting the links in it.
+    size_t incoming_set_bytes() const;
+
+    /// True if some link holds this atom. Unlike getIncomingSetSize(),
+    /// this does not fetch incoming links that were evicted.
+    bool has_incoming() const;
+
+    //! Get the size of the incoming set. Without an AtomSpace, this
+    //! takes time proportional to the number of link types, only.
     size_t getIncomingSetSize(AtomSpace* = nullptr) const;
 
     //! Return the incoming set of this atom.
@@ -329,16 +418,12 @@ public:
     template <typename OutputIterator> OutputIterator
     getIncomingSet(OutputIterator result) const
     {
+        fault_incoming();
+        std::lock_guard<AtomLock> lck(_mtx);
         if (nullptr == _incoming_set) return result;
-        std::lock_guard<std::mutex> lck(_mtx);
-        for (const auto& bucket : _incoming_set->_iset)
-        {
-            for (const WinkPtr& w : bucket.second)
-            {
-                Handle h(std::static_pointer_cast<Atom>(w.lock()));
-                if (h) { *result = h; result ++; }
-            }
-        }
+        for (auto& bucket : _incoming_set->_iset)
+            bucket.second.for_each(
+                [&](const Handle& h) { *result = h; result ++; });
         return result;
     }
 
@@ -369,24 +454,23 @@ public:
     template <typename OutputIterator> OutputIterator
     getIncomingSetByType(OutputIterator result, Type type) const
     {
+        fault_incoming();
+        std::lock_guard<AtomLock> lck(_mtx);
         if (nullptr == _incoming_set) return result;
-        std::lock_guard<std::mutex> lck(_mtx);
 
-        const auto bucket = _incoming_set->_iset.find(type);
-        if (bucket == _incoming_set->_iset.cend()) return result;
+        WincomingSet* bucket = _incoming_set->find(type);
+        if (nullptr == bucket) return result;
 
-        for (const WinkPtr& w : bucket->second)
-        {
-            Handle h(std::static_pointer_cast<Atom>(w.lock()));
-            if (h) { *result = h; result ++; }
-        }
+        bucket->for_each(
+            [&](const Handle& h) { *result = h; result ++; });
         return result;
     }
 
     /** Functional version of getIncomingSetByType.  */
     IncomingSet getIncomingSetByType(Type, AtomSpace* = nullptr) const;
 
-    /** Return the size of the incoming set, for the given type. */
+    /** Return the size of the incoming set, for the given type.
+     *  Without an AtomSpace, this takes constant time. */
     size_t getIncomingSetSizeByType(Type type, AtomSpace* = nullptr) const;
 
     /** Returns a string representation of the node. */
@@ -0,0 +1,183 @@
+/*
+ * opencog/atoms/base/AtomPool.cc
+ *
+ * Copyright (C) 2019 OpenCog Foundation
+ * All Rights Reserved
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <algorithm>
+#include <new>
+
+#include "AtomPool.h"
+
+using namespace opencog;
+
+// Size of the chunks of memory that blocks are carved from.
+#define SLAB_SIZE (64 * 1024)
+
+namespace {
+
+// Free blocks are chained through their first word.
+static inline void*& next_of(void* p) { return *static_cast<void**>(p); }
+
+// The free lists of one thread. This is plain data, so that it stays
+// usable even after the thread's destructors have run; atoms held in
+// statics get freed very late, at exit.
+struct ThreadCache
+{
+    void* head[AtomPool::NCLASSES];
+    size_t count[AtomPool::NCLASSES];
+    bool live;
+    bool dead;
+};
+
+static thread_local ThreadCache _cache;
+
+// Give the blocks back when the thread exits, so that other threads
+// can use them.
+struct CacheFlusher
+{
+    ~CacheFlusher()
+    {
+        AtomPool& pool = atom_pool();
+        for (size_t c = 0; c < AtomPool::NCLASSES; c++)
+        {
+            if (_cache.head[c])
+                pool.give(c, _cache.head[c], _cache.count[c]);
+            _cache.head[c] = nullptr;
+            _cache.count[c] = 0;
+        }
+        _cache.dead = true;
+    }
+};
+
+static thread_local CacheFlusher _flusher;
+
+}
+
+AtomPool::AtomPool() :
+    _reserved(0)
+{
+}
+
+/// Cut a new slab into batches of free blocks. The caller must hold
+/// the lock for the size class.
+void AtomPool::carve(size_t cls)
+{
+    size_t bsz = (cls + 1) * GRANULE;
+    size_t nblocks = SLAB_SIZE / bsz;
+    char* slab = static_cast<char*>(::operator new(nblocks * bsz));
+    _reserved += nblocks * bsz;
+
+    for (size_t i = 0; i < nblocks; i += BATCH)
+    {
+        size_t n = std::min(BATCH, nblocks - i);
+        char* first = slab + i * bsz;
+        for (size_t j = 0; j + 1 < n; j++)
+            next_of(first + j * bsz) = first + (j + 1) * bsz;
+        next_of(first + (n - 1) * bsz) = nullptr;
+        _classes[cls].batches.push_back(Batch{first, n});
+    }
+}
+
+AtomPool::Batch AtomPool::take(size_t cls)
+{
+    SizeClass& sc = _classes[cls];
+    std::lock_guard<std::mutex> lck(sc.mtx);
+    if (sc.batches.empty()) carve(cls);
+    Batch b = sc.batches.back();
+    sc.batches.pop_back();
+    return b;
+}
+
+void AtomPool::give(size_t cls, void* head, size_t count)
+{
+    SizeClass& sc = _classes[cls];
+    std::lock_guard<std::mutex> lck(sc.mtx);
+    sc.batches.push_back(Batch{head, count});
+}
+
+void* AtomPool::allocate(size_t sz)
+{
+    size_t cls = size_class(sz);
+    if (NCLASSES <= cls) return ::operator new(sz);
+
+    ThreadCache& tc = _cache;
+    if (nullptr == tc.head[cls])
+    {
+        // Late in exit, with the cache gone: go around it.
+        if (tc.dead)
+        {
+            Batch b = take(cls);
+            if (b.count > 1) give(cls, next_of(b.head), b.count - 1);
+            return b.head;
+        }
+        if (not tc.live)
+        {
+            // Make sure the flusher runs when this thread exits.
+            (void) &_flusher;
+            tc.live = true;
+        }
+        Batch b = take(cls);
+        tc.head[cls] = b.head;
+        tc.count[cls] = b.count;
+    }
+
+    void* p = tc.head[cls];
+    tc.head[cls] = next_of(p);
+    tc.count[cls]--;
+    return p;
+}
+
+void AtomPool::deallocate(void* p, size_t sz) noexcept
+{
+    size_t cls = size_class(sz);
+    if (NCLASSES <= cls) { ::operator delete(p); return; }
+
+    ThreadCache& tc = _cache;
+    if (tc.dead)
+    {
+        next_of(p) = nullptr;
+        give(cls, p, 1);
+        return;
+    }
+
+    next_of(p) = tc.head[cls];
+    tc.head[cls] = p;
+    tc.count[cls]++;
+
+    // Too many on hand; pass a batch back to the central pool.
+    if (2 * BATCH <= tc.count[cls])
+    {
+        void* head = tc.head[cls];
+        void* tail = head;
+        for (size_t i = 1; i < BATCH; i++) tail = next_of(tail);
+        tc.head[cls] = next_of(tail);
+        next_of(tail) = nullptr;
+        tc.count[cls] -= BATCH;
+        give(cls, head, BATCH);
+    }
+}
+
+AtomPool& opencog::atom_pool()
+{
+    // Never deleted: atoms in statics may be freed after it would
+    // have been destroyed.
+    static AtomPool* _pool = new AtomPool();
+    return *_pool;
+}
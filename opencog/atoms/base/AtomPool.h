@@ -0,0 +1,145 @@
+/*
+ * opencog/atoms/base/AtomPool.h
+ *
+ * Copyright (C) 2019 OpenCog Foundation
+ * All Rights Reserved
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _OPENCOG_ATOM_POOL_H
+#define _OPENCOG_ATOM_POOL_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace opencog
+{
+/** \addtogroup grp_atomspace
+ *  @{
+ */
+
+/**
+ * Pooled memory for atoms.
+ *
+ * Blocks are handed out in size classes of 16 bytes, up to 512
+ * bytes; anything larger goes to plain operator new. Each thread keeps
+ * a free list per size class, so allocating and freeing touch no lock
+ * and no shared cache line. Threads trade blocks with a central pool,
+ * in batches: a thread that frees a lot of atoms at once (clearing a
+ * transient atomspace, say) hands whole batches back, one lock each,
+ * and the next thread to build atoms takes them, a batch at a time.
+ *
+ * Memory is carved out of slabs that are never given back to the
+ * operating system; freed blocks are only ever reused for atoms of
+ * the same size class.
+ */
+class AtomPool
+{
+public:
+    static const size_t GRANULE = 16;
+    static const size_t NCLASSES = 32;
+    static const size_t BATCH = 64;
+
+private:
+    struct Batch
+    {
+        void* head;
+        size_t count;
+    };
+
+    struct SizeClass
+    {
+        std::mutex mtx;
+        std::vector<Batch> batches;
+    };
+    SizeClass _classes[NCLASSES];
+    std::atomic<size_t> _reserved;
+
+    void carve(size_t cls);
+
+    AtomPool(const AtomPool&) = delete;
+    AtomPool& operator=(const AtomPool&) = delete;
+
+public:
+    AtomPool();
+
+    static size_t size_class(size_t sz)
+    {
+        return (sz + GRANULE - 1) / GRANULE - 1;
+    }
+
+    /// Take a batch of free blocks of the given class, or give one
+    /// back. These are for the per-thread caches.
+    Batch take(size_t cls);
+    void give(size_t cls, void* head, size_t count);
+
+    void* allocate(size_t);
+    void deallocate(void*, size_t) noexcept;
+
+    /// Bytes obtained from the system, so far, for slabs.
+    size_t reserved() const { return _reserved.load(); }
+};
+
+AtomPool& atom_pool();
+
+/**
+ * A standard allocator that draws on the atom_pool(). This is meant
+ * for std::allocate_shared(), which allocates the atom and its
+ * reference counts together, in one block.
+ */
+template <typename T>
+struct PoolAllocator
+{
+    typedef T value_type;
+
+    PoolAllocator() noexcept {}
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U>&) noexcept {}
+
+    T* allocate(size_t n)
+    {
+        return static_cast<T*>(atom_pool().allocate(n * sizeof(T)));
+    }
+    void deallocate(T* p, size_t n) noexcept
+    {
+        atom_pool().deallocate(p, n * sizeof(T));
+    }
+};
+
+template <typename T, typename U>
+bool operator==(const PoolAllocator<T>&, const PoolAllocator<U>&)
+    { return true; }
+template <typename T, typename U>
+bool operator!=(const PoolAllocator<T>&, const PoolAllocator<U>&)
+    { return false; }
+
+/// Like std::make_shared, but from the atom_pool().
+template <typename T, typename... Args>
+std::shared_ptr<T> make_pooled(Args&&... args)
+{
+    return std::allocate_shared<T>(PoolAllocator<T>(),
+                                   std::forward<Args>(args)...);
+}
+
+/** @}*/
+} //namespace opencog
+
+#endif // _OPENCOG_ATOM_POOL_H
@@ -28,6 +28,7 @@
 
 #include <opencog/atoms/atom_types/NameServer.h>
 #include <opencog/atoms/base/Node.h>
+#include <opencog/atoms/base/hash.h>
 #include <opencog/atomspace/AtomTable.h>
 
 #include "Link.h"
@@ -55,6 +56,13 @@ void Link::init()
 Link::~Link()
 {
     DPRINTF("Deleting link:\n%s\n", this->to_string().c_str());
+
+    // The atomspace takes links out of the incoming sets when they
+    // leave it, so this should not happen; but if it does, the sizes
+    // of those incoming sets must not count a link that is gone.
+    if (clearInIncoming())
+        for (const Handle& h : _outgoing)
+            h->remove_gone(this, get_type());
 }
 
 /// Return a universally-unique string for each distinct link.
@@ -164,19 +172,11 @@ bool Link::operator<(const Atom& other) const
 /// chains the hash values of the child atoms, as well.
 ContentHash Link::compute_hash() const
 {
-	// 1<<44 - 377 is prime
-	ContentHash hsh = ((1UL<<44) - 377) * get_type();
-	for (const Handle& h: _outgoing)
-	{
-		hsh += (hsh <<5) ^ (353 * h->get_hash()); // recursive!
-
-		// Bit-mixing copied from murmur64. Yes, this is needed.
-		hsh ^= hsh >> 33;
-		hsh *= 0xff51afd7ed558ccdL;
-		hsh ^= hsh >> 33;
-		hsh *= 0xc4ceb9fe1a85ec53L;
-		hsh ^= hsh >> 33;
-	}
+	// Seeded with the type; the outgoing hashes are taken several at
+	// a time, so wide links don't wait on one long multiply chain.
+	ContentHash hsh = hash_words(_outgoing.size(),
+		[this](size_t i) { return _outgoing[i]->get_hash(); }, // recursive!
+		get_type());
 
 	// Links will always have the MSB set.
 	ContentHash mask = ((ContentHash) 1UL) << (8*sizeof(ContentHash) - 1);
@@ -197,6 +197,7 @@ void Link::install()
 
 void Link::remove()
 {
+	clearInIncoming();
 	Handle lll(get_handle());
 	for (Handle& h : _outgoing)
 		h->remove_atom(lll);
@@ -28,6 +28,7 @@
 #include <string>
 
 #include <opencog/atoms/base/Atom.h>
+#include <opencog/atoms/base/AtomPool.h>
 #include <opencog/atoms/base/ClassServer.h>
 
 namespace opencog
@@ -215,7 +216,7 @@ static inline LinkPtr LinkCast(const AtomPtr& a)
 template< class... Args >
 Handle createLink( Args&&... args )
 {
-	Handle tmp(std::make_shared<Link>(std::forward<Args>(args) ...));
+	Handle tmp(make_pooled<Link>(std::forward<Args>(args) ...));
 	return classserver().factory(tmp);
 }
 
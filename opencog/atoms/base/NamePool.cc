@@ -0,0 +1,113 @@
+/*
+ * opencog/atoms/base/NamePool.cc
+ *
+ * Copyright (C) 2019 OpenCog Foundation
+ * All Rights Reserved
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <mutex>
+#include <unordered_map>
+
+#include <opencog/atoms/base/hash.h>
+#include "NamePool.h"
+
+using namespace opencog;
+
+// The pool is split into independently locked parts, by hash, so
+// that threads creating nodes do not all wait on one lock.
+#define NUM_SHARDS 64
+
+namespace {
+
+struct Shard
+{
+    std::mutex mtx;
+    std::unordered_multimap<size_t, Name::Entry*> map;
+};
+
+static Shard* shards()
+{
+    // Never deleted: Names held in statics may be released after it
+    // would have been destroyed.
+    static Shard* _shards = new Shard[NUM_SHARDS];
+    return _shards;
+}
+
+static inline Shard& shard_of(size_t hash)
+{
+    return shards()[(hash ^ (hash >> 32)) % NUM_SHARDS];
+}
+
+}
+
+Name::Entry* Name::intern(const std::string& s)
+{
+    size_t hash = hash_bytes(s.data(), s.size());
+    Shard& sh = shard_of(hash);
+
+    std::lock_guard<std::mutex> lck(sh.mtx);
+    auto range = sh.map.equal_range(hash);
+    for (auto it = range.first; it != range.second; it++)
+    {
+        if (it->second->str != s) continue;
+        it->second->refs++;
+        return it->second;
+    }
+
+    Entry* e = new Entry{{1}, hash, s};
+    sh.map.emplace(hash, e);
+    return e;
+}
+
+/// Drop a reference. Only the last one needs the lock: as long as
+/// there is more than one, no one can drop the count to zero, and
+/// once there is just ours, the count can only go up again by way of
+/// intern(), which takes the lock.
+void Name::release(Entry* e)
+{
+    size_t refs = e->refs.load();
+    while (1 < refs)
+        if (e->refs.compare_exchange_weak(refs, refs - 1)) return;
+
+    Shard& sh = shard_of(e->hash);
+    {
+        std::lock_guard<std::mutex> lck(sh.mtx);
+        if (1 != e->refs--) return;
+
+        auto range = sh.map.equal_range(e->hash);
+        for (auto it = range.first; it != range.second; it++)
+        {
+            if (it->second != e) continue;
+            sh.map.erase(it);
+            break;
+        }
+    }
+    delete e;
+}
+
+size_t Name::pool_size()
+{
+    size_t n = 0;
+    for (size_t i = 0; i < NUM_SHARDS; i++)
+    {
+        Shard& sh = shards()[i];
+        std::lock_guard<std::mutex> lck(sh.mtx);
+        n += sh.map.size();
+    }
+    return n;
+}
@@ -0,0 +1,103 @@
+/*
+ * opencog/atoms/base/NamePool.h
+ *
+ * Copyright (C) 2019 OpenCog Foundation
+ * All Rights Reserved
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _OPENCOG_NAME_POOL_H
+#define _OPENCOG_NAME_POOL_H
+
+#include <atomic>
+#include <string>
+
+namespace opencog
+{
+/** \addtogroup grp_atomspace
+ *  @{
+ */
+
+/**
+ * An interned node name.
+ *
+ * All Names with the same string share one pool entry, which holds
+ * the string, its hash (computed once), and a reference count. Two
+ * Names are equal exactly when they point at the same entry, so
+ * comparing them is a pointer compare. The entry is removed from the
+ * pool when the last Name referring to it goes away.
+ *
+ * A Name is one pointer wide. Copies only bump the reference count;
+ * it is building a Name from a string that looks it up in the pool.
+ * Interning and releasing are thread-safe.
+ */
+class Name
+{
+public:
+    struct Entry
+    {
+        std::atomic<size_t> refs;
+        size_t hash;
+        std::string str;
+    };
+
+private:
+    Entry* _e;
+
+    static Entry* intern(const std::string&);
+    static void release(Entry*);
+
+public:
+    Name() : _e(intern(std::string())) {}
+    Name(const std::string& s) : _e(intern(s)) {}
+    Name(const char* s) : _e(intern(s)) {}
+    Name(const Name& o) : _e(o._e) { _e->refs++; }
+    ~Name() { release(_e); }
+
+    Name& operator=(const Name& o)
+    {
+        o._e->refs++;
+        release(_e);
+        _e = o._e;
+        return *this;
+    }
+    Name& operator=(const std::string& s)
+    {
+        Entry* e = intern(s);
+        release(_e);
+        _e = e;
+        return *this;
+    }
+
+    const std::string& str() const { return _e->str; }
+    operator const std::string&() const { return _e->str; }
+    const char* c_str() const { return _e->str.c_str(); }
+
+    /// The hash_bytes() of the name, computed once, when interned.
+    size_t hash() const { return _e->hash; }
+
+    bool operator==(const Name& o) const { return _e == o._e; }
+    bool operator!=(const Name& o) const { return _e != o._e; }
+
+    /// Number of distinct names in the pool.
+    static size_t pool_size();
+};
+
+/** @}*/
+} //namespace opencog
+
+#endif // _OPENCOG_NAME_POOL_H
@@ -22,6 +22,7 @@
  */
 
 #include <opencog/atoms/atom_types/NameServer.h>
+#include <opencog/atoms/base/hash.h>
 
 #include "Node.h"
 
@@ -44,7 +45,7 @@ std::string Node::to_short_string(const std::string& indent) const
 {
     std::stringstream nstrm;
     nstrm << indent << "(" <<  nameserver().getTypeName(_type)
-        << " \"" << _name << "\")";
+        << " \"" << _name.str() << "\")";
     return nstrm.str();
 }
 
@@ -52,7 +53,7 @@ std::string Node::to_string(const std::string& indent) const
 {
     std::string answer = indent;
     answer += "(" + nameserver().getTypeName(_type);
-    answer += " \"" + _name + "\"";
+    answer += " \"" + _name.str() + "\"";
 
     // Print the TV only if its not the default.
     if (not getTruthValue()->isDefaultTV())
@@ -72,7 +73,10 @@ bool Node::operator==(const Atom& other) const
     if (get_hash() != other.get_hash()) return false;
 
     if (get_type() != other.get_type()) return false;
-    return get_name() == other.get_name();
+
+    // Same type, so the other is a Node, too. Names are interned, so
+    // equal names are the same pool entry.
+    return _name == static_cast<const Node&>(other)._name;
 }
 
 bool Node::operator<(const Atom& other) const
@@ -94,10 +98,8 @@ bool Node::operator<(const Atom& other) const
 
 ContentHash Node::compute_hash() const
 {
-	ContentHash hsh = std::hash<std::string>()(get_name());
-
-	// 1<<43 - 369 is a prime number.
-	hsh += (hsh<<5) + ((1UL<<43)-369) * get_type();
+	// The name hash was computed when the name was interned.
+	ContentHash hsh = hash_combine(_name.hash(), get_type());
 
 	// Nodes will never have the MSB set.
 	ContentHash mask = ~(((ContentHash) 1UL) << (8*sizeof(ContentHash) - 1));
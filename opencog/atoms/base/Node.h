@@ -27,7 +27,9 @@
 #define _OPENCOG_NODE_H
 
 #include <opencog/atoms/base/Atom.h>
+#include <opencog/atoms/base/AtomPool.h>
 #include <opencog/atoms/base/ClassServer.h>
+#include <opencog/atoms/base/NamePool.h>
 
 namespace opencog
 {
@@ -43,7 +45,9 @@ class Node : public Atom
 {
 protected:
     // properties
-    std::string _name;
+    // The name is interned: nodes with the same name share one copy
+    // of it, and its hash.
+    Name _name;
     void init();
 
     virtual ContentHash compute_hash() const;
@@ -73,7 +77,7 @@ public:
      *
      * @return The name of the node.
      */
-    virtual const std::string& get_name() const { return _name; }
+    virtual const std::string& get_name() const { return _name.str(); }
 
     virtual size_t size() const { return 1; }
 
@@ -120,7 +124,7 @@ static inline NodePtr NodeCast(const AtomPtr& a)
 template< class... Args >
 Handle createNode( Args&&... args )
 {
-   Handle tmp(std::make_shared<Node>(std::forward<Args>(args) ...));
+   Handle tmp(make_pooled<Node>(std::forward<Args>(args) ...));
    return classserver().factory(tmp);
 }
 
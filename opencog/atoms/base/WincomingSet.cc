@@ -0,0 +1,108 @@
+/*
+ * opencog/atoms/base/WincomingSet.cc
+ *
+ * Copyright (C) 2019 OpenCog Foundation
+ * All Rights Reserved
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "WincomingSet.h"
+
+using namespace opencog;
+
+// Smallest table that is ever allocated.
+#define MIN_SLOTS 8
+
+/// Rehash into a table sized for `n` entries, at most half full,
+/// dropping the tombstones.
+void WincomingSet::rebuild(size_t n)
+{
+    size_t cap = MIN_SLOTS;
+    while (cap < 2 * n) cap *= 2;
+
+    std::vector<Slot> old(cap, Slot{nullptr, WinkPtr()});
+    old.swap(_slots);
+    _dead = 0;
+
+    size_t mask = cap - 1;
+    for (Slot& s : old)
+    {
+        if (not is_used(s.key)) continue;
+        size_t i = hash(s.key) & mask;
+        while (nullptr != _slots[i].key) i = (i + 1) & mask;
+        _slots[i].key = s.key;
+        _slots[i].link = std::move(s.link);
+    }
+}
+
+bool WincomingSet::insert(const Handle& h)
+{
+    // Keep at least a quarter of the slots empty, so that probes
+    // stay short, and always end.
+    if (4 * (_live + _dead + 1) > 3 * _slots.size())
+        rebuild(_live + 1);
+
+    const Atom* a = h.get();
+    size_t mask = _slots.size() - 1;
+    size_t i = hash(a) & mask;
+    Slot* grave = nullptr;
+    for (; nullptr != _slots[i].key; i = (i + 1) & mask)
+    {
+        Slot& s = _slots[i];
+        if (tombstone() == s.key)
+        {
+            if (nullptr == grave) grave = &s;
+            continue;
+        }
+        if (a != s.key) continue;
+
+        // A link that went away without being removed, and a new
+        // one that got the same address.
+        if (s.link.expired())
+        {
+            s.link = h;
+            return true;
+        }
+        return false;
+    }
+
+    Slot& s = grave ? *grave : _slots[i];
+    if (grave) _dead--;
+    s.key = a;
+    s.link = h;
+    _live++;
+    return true;
+}
+
+bool WincomingSet::erase(const Atom* a)
+{
+    if (0 == _live) return false;
+
+    size_t mask = _slots.size() - 1;
+    for (size_t i = hash(a) & mask; nullptr != _slots[i].key;
+         i = (i + 1) & mask)
+    {
+        if (a != _slots[i].key) continue;
+        bury(_slots[i]);
+
+        // Give back memory when the table is mostly empty.
+        if (MIN_SLOTS < _slots.size() and 8 * _live < _slots.size())
+            rebuild(_live);
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,127 @@
+/*
+ * opencog/atoms/base/WincomingSet.h
+ *
+ * Copyright (C) 2019 OpenCog Foundation
+ * All Rights Reserved
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _OPENCOG_WINCOMING_SET_H
+#define _OPENCOG_WINCOMING_SET_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <opencog/atoms/base/Handle.h>
+
+namespace opencog
+{
+/** \addtogroup grp_atomspace
+ *  @{
+ */
+
+typedef std::weak_ptr<Atom> WinkPtr;
+
+/**
+ * The links of one type, in the incoming set of an atom.
+ *
+ * This is an open-addressing hash table, keyed on the address of the
+ * link, and laid out flat, so that walking it touches consecutive
+ * memory, and allocates nothing. Removed entries are left behind as
+ * tombstones; these get swept out whenever the table is rebuilt,
+ * which happens when it gets too full, or too empty. The number of
+ * entries is kept up to date, so that the size is had in constant
+ * time.
+ *
+ * A link takes itself out when it leaves the atomspace, and so the
+ * count is exact. A link that is dropped while still in here (which
+ * the atomspace never does) takes itself out when it is destroyed; a
+ * walk that comes across one in the meantime passes over it.
+ *
+ * This is not thread-safe; the Atom serializes access with its lock.
+ */
+class WincomingSet
+{
+    struct Slot
+    {
+        const Atom* key;
+        WinkPtr link;
+    };
+
+    std::vector<Slot> _slots;
+    size_t _live;
+    size_t _dead;
+
+    static const Atom* tombstone()
+    {
+        return reinterpret_cast<const Atom*>(uintptr_t(1));
+    }
+    static bool is_used(const Atom* key)
+    {
+        return nullptr != key and tombstone() != key;
+    }
+    static size_t hash(const Atom* a)
+    {
+        uint64_t h = (uintptr_t(a) >> 4) * 0x9e3779b97f4a7c15ULL;
+        return h ^ (h >> 32);
+    }
+
+    void bury(Slot& s)
+    {
+        s.key = tombstone();
+        s.link.reset();
+        _live--;
+        _dead++;
+    }
+    void rebuild(size_t);
+
+public:
+    WincomingSet() : _live(0), _dead(0) {}
+
+    /// Number of links held. Constant time.
+    size_t size() const { return _live; }
+    bool empty() const { return 0 == _live; }
+
+    /// Bytes of memory held by the table.
+    size_t bytes() const { return _slots.capacity() * sizeof(Slot); }
+
+    /// Return false if the link was already there.
+    bool insert(const Handle&);
+
+    /// Return false if the link was not there. The link is looked
+    /// for by address, and so it may be in the middle of destruction.
+    bool erase(const Atom*);
+    bool erase(const Handle& h) { return erase(h.get()); }
+
+    /// Call func on each link that is still alive.
+    template <typename Function> void for_each(Function func)
+    {
+        for (Slot& s : _slots)
+        {
+            if (not is_used(s.key)) continue;
+            Handle h(s.link.lock());
+            if (h) func(h);
+            else bury(s);
+        }
+    }
+};
+
+/** @}*/
+} //namespace opencog
+
+#endif // _OPENCOG_WINCOMING_SET_H
@@ -1,11 +1,161 @@
 #ifndef _OPENCOG_HASH_H
 #define _OPENCOG_HASH_H
 
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
 #include <opencog/atoms/base/Handle.h>
 
 namespace opencog {
 
-// Fowler–Noll–Vo hash function
+// The one hash used for atom content: Node names, Link outgoing sets
+// and the alpha-converted hashes of ScopeLinks all go through here.
+// It is in the style of wyhash (https://github.com/wangyi-fudan/wyhash):
+// each step is a single 64x64->128 bit multiply, folded in half. Long
+// inputs are consumed three independent lanes at a time, so that the
+// multiplies can overlap in the pipeline; the lanes are joined at the
+// end.
+//
+// The hashes are not stable across endianness, and are not meant to be
+// stored; they are recomputed whenever an atom is created.
+
+const uint64_t HASH_P0 = 0xa0761d6478bd642full;
+const uint64_t HASH_P1 = 0xe7037ed1a0b428dbull;
+const uint64_t HASH_P2 = 0x8ebc6af09c88c6e3ull;
+const uint64_t HASH_P3 = 0x589965cc75374cc3ull;
+
+/// Full 128-bit product of a and b; the low half goes into a, the
+/// high half into b.
+inline void hash_mum(uint64_t& a, uint64_t& b)
+{
+#ifdef __SIZEOF_INT128__
+	__uint128_t r = (__uint128_t) a * b;
+	a = (uint64_t) r;
+	b = (uint64_t) (r >> 64);
+#else
+	uint64_t ha = a >> 32, hb = b >> 32, la = (uint32_t) a, lb = (uint32_t) b;
+	uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+	uint64_t t = rl + (rm0 << 32);
+	uint64_t c = t < rl;
+	uint64_t lo = t + (rm1 << 32);
+	c += lo < t;
+	a = lo;
+	b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif
+}
+
+/// Mix two words into one.
+inline uint64_t hash_mix(uint64_t a, uint64_t b)
+{
+	hash_mum(a, b);
+	return a ^ b;
+}
+
+/// Fold one more word into a running hash.
+inline uint64_t hash_combine(uint64_t h, uint64_t v)
+{
+	return hash_mix(h ^ HASH_P0, v ^ HASH_P1);
+}
+
+inline uint64_t hash_r8(const uint8_t* p)
+{
+	uint64_t v; memcpy(&v, p, 8); return v;
+}
+
+inline uint64_t hash_r4(const uint8_t* p)
+{
+	uint32_t v; memcpy(&v, p, 4); return v;
+}
+
+/// Hash a block of memory.
+inline uint64_t hash_bytes(const void* key, size_t len, uint64_t seed = 0)
+{
+	const uint8_t* p = (const uint8_t*) key;
+	seed ^= hash_mix(seed ^ HASH_P0, HASH_P1);
+	uint64_t a, b;
+	if (len <= 16)
+	{
+		if (4 <= len)
+		{
+			size_t off = (len >> 3) << 2;
+			a = (hash_r4(p) << 32) | hash_r4(p + off);
+			b = (hash_r4(p + len - 4) << 32) | hash_r4(p + len - 4 - off);
+		}
+		else if (0 < len)
+		{
+			a = (((uint64_t) p[0]) << 16) | (((uint64_t) p[len >> 1]) << 8)
+			    | p[len - 1];
+			b = 0;
+		}
+		else a = b = 0;
+	}
+	else
+	{
+		size_t i = len;
+		if (48 < i)
+		{
+			uint64_t s1 = seed, s2 = seed;
+			do
+			{
+				seed = hash_mix(hash_r8(p) ^ HASH_P1, hash_r8(p + 8) ^ seed);
+				s1 = hash_mix(hash_r8(p + 16) ^ HASH_P2, hash_r8(p + 24) ^ s1);
+				s2 = hash_mix(hash_r8(p + 32) ^ HASH_P3, hash_r8(p + 40) ^ s2);
+				p += 48; i -= 48;
+			}
+			while (48 < i);
+			seed ^= s1 ^ s2;
+		}
+		while (16 < i)
+		{
+			seed = hash_mix(hash_r8(p) ^ HASH_P1, hash_r8(p + 8) ^ seed);
+			p += 16; i -= 16;
+		}
+		a = hash_r8(p + i - 16);
+		b = hash_r8(p + i - 8);
+	}
+	a ^= HASH_P1;
+	b ^= seed;
+	hash_mum(a, b);
+	return hash_mix(a ^ HASH_P0 ^ len, b ^ HASH_P1);
+}
+
+/// Hash a sequence of n words, as given by word(0) ... word(n-1).
+/// This is the same scheme as hash_bytes(), but over words that need
+/// not be adjacent in memory, e.g. the hashes of the atoms in an
+/// outgoing set. The word function is called exactly once for each
+/// index, in order.
+template<typename Word>
+uint64_t hash_words(size_t n, Word word, uint64_t seed = 0)
+{
+	seed ^= hash_mix(seed ^ HASH_P0, HASH_P1);
+	size_t i = 0;
+	if (6 < n)
+	{
+		uint64_t s1 = seed, s2 = seed;
+		for (; i + 6 <= n; i += 6)
+		{
+			uint64_t w0 = word(i), w1 = word(i+1), w2 = word(i+2);
+			uint64_t w3 = word(i+3), w4 = word(i+4), w5 = word(i+5);
+			seed = hash_mix(w0 ^ HASH_P1, w1 ^ seed);
+			s1 = hash_mix(w2 ^ HASH_P2, w3 ^ s1);
+			s2 = hash_mix(w4 ^ HASH_P3, w5 ^ s2);
+		}
+		seed ^= s1 ^ s2;
+	}
+	for (; i + 2 <= n; i += 2)
+	{
+		uint64_t w0 = word(i);
+		seed = hash_mix(w0 ^ HASH_P1, word(i+1) ^ seed);
+	}
+	uint64_t a = HASH_P1, b = seed;
+	if (i < n) a ^= word(i);
+	hash_mum(a, b);
+	return hash_mix(a ^ HASH_P0 ^ n, b ^ HASH_P1);
+}
+
+// Fowler–Noll–Vo hash function. The atoms no longer use it; it is kept
+// for code outside of the atomspace that does.
 // Parameters are taken from author's page
 // http://www.isthe.com/chongo/tech/comp/fnv/index.html#FNV-1a
 const size_t FNV_32_PRIME = 0x01000193;
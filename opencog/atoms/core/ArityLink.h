@@ -63,7 +63,7 @@ static inline ArityLinkPtr ArityLinkCast(const Handle& h)
 static inline ArityLinkPtr ArityLinkCast(const AtomPtr& a)
 	{ return std::dynamic_pointer_cast<ArityLink>(a); }
 
-#define createArityLink std::make_shared<ArityLink>
+#define createArityLink opencog::make_pooled<ArityLink>
 
 /** @}*/
 }
@@ -54,7 +54,7 @@ static inline CondLinkPtr CondLinkCast(const Handle& h)
 static inline CondLinkPtr CondLinkCast(AtomPtr a)
 	{ return std::dynamic_pointer_cast<CondLink>(a); }
 
-#define createCondLink std::make_shared<CondLink>
+#define createCondLink opencog::make_pooled<CondLink>
 
 /** @}*/
 }
@@ -92,7 +92,7 @@ static inline DefineLinkPtr DefineLinkCast(const Handle& h)
 static inline DefineLinkPtr DefineLinkCast(const AtomPtr& a)
 	{ return std::dynamic_pointer_cast<DefineLink>(a); }
 
-#define createDefineLink std::make_shared<DefineLink>
+#define createDefineLink opencog::make_pooled<DefineLink>
 
 /** @}*/
 }
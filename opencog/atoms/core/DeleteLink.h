@@ -60,7 +60,7 @@ static inline DeleteLinkPtr DeleteLinkCast(const Handle& h)
 static inline DeleteLinkPtr DeleteLinkCast(const AtomPtr& a)
 	{ return std::dynamic_pointer_cast<DeleteLink>(a); }
 
-#define createDeleteLink std::make_shared<DeleteLink>
+#define createDeleteLink opencog::make_pooled<DeleteLink>
 
 /** @}*/
 }
@@ -62,7 +62,7 @@ static inline FreeLinkPtr FreeLinkCast(const Handle& h)
 static inline FreeLinkPtr FreeLinkCast(const AtomPtr& a)
    { return std::dynamic_pointer_cast<FreeLink>(a); }
 
-#define createFreeLink std::make_shared<FreeLink>
+#define createFreeLink opencog::make_pooled<FreeLink>
 
 /** @}*/
 }
@@ -86,7 +86,7 @@ static inline FunctionLinkPtr FunctionLinkCast(const AtomPtr& a)
 static inline FunctionLinkPtr FunctionLinkCast(const ValuePtr& a)
    { return std::dynamic_pointer_cast<FunctionLink>(a); }
 
-#define createFunctionLink std::make_shared<FunctionLink>
+#define createFunctionLink opencog::make_pooled<FunctionLink>
 
 /** @}*/
 }
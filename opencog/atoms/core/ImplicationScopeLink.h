@@ -67,7 +67,7 @@ static inline ImplicationScopeLinkPtr ImplicationScopeLinkCast(const Handle& h)
 static inline ImplicationScopeLinkPtr ImplicationScopeLinkCast(AtomPtr a)
 	{ return std::dynamic_pointer_cast<ImplicationScopeLink>(a); }
 
-#define createImplicationScopeLink std::make_shared<ImplicationScopeLink>
+#define createImplicationScopeLink opencog::make_pooled<ImplicationScopeLink>
 
 /** @}*/
 }
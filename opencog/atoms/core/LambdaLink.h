@@ -71,7 +71,7 @@ static inline LambdaLinkPtr LambdaLinkCast(const Handle& h)
 static inline LambdaLinkPtr LambdaLinkCast(const AtomPtr& a)
 	{ return std::dynamic_pointer_cast<LambdaLink>(a); }
 
-#define createLambdaLink std::make_shared<LambdaLink>
+#define createLambdaLink opencog::make_pooled<LambdaLink>
 
 /** @}*/
 }
@@ -89,7 +89,7 @@ static inline NumberNodePtr NumberNodeCast(const AtomPtr& a)
 static inline NumberNodePtr NumberNodeCast(const ValuePtr& a)
 	{ return std::dynamic_pointer_cast<NumberNode>(a); }
 
-#define createNumberNode std::make_shared<NumberNode>
+#define createNumberNode opencog::make_pooled<NumberNode>
 
 // --------------------
 // Scalar multiplication and addition
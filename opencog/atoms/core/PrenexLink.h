@@ -64,7 +64,7 @@ static inline PrenexLinkPtr PrenexLinkCast(const Handle& h)
 static inline PrenexLinkPtr PrenexLinkCast(const AtomPtr& a)
 	{ return std::dynamic_pointer_cast<PrenexLink>(a); }
 
-#define createPrenexLink std::make_shared<PrenexLink>
+#define createPrenexLink opencog::make_pooled<PrenexLink>
 
 /** @}*/
 }
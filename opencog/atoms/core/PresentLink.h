@@ -74,7 +74,7 @@ static inline PresentLinkPtr PresentLinkCast(const Handle& h)
 static inline PresentLinkPtr PresentLinkCast(const AtomPtr& a)
 	{ return std::dynamic_pointer_cast<PresentLink>(a); }
 
-#define createPresentLink std::make_shared<PresentLink>
+#define createPresentLink opencog::make_pooled<PresentLink>
 
 /** @}*/
 }
@@ -102,7 +102,7 @@ static inline PutLinkPtr PutLinkCast(const Handle& h)
 static inline PutLinkPtr PutLinkCast(const AtomPtr& a)
    { return std::dynamic_pointer_cast<PutLink>(a); }
 
-#define createPutLink std::make_shared<PutLink>
+#define createPutLink opencog::make_pooled<PutLink>
 
 /** @}*/
 }
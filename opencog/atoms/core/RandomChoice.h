@@ -78,7 +78,7 @@ static inline RandomChoiceLinkPtr RandomChoiceLinkCast(const Handle& h)
 static inline RandomChoiceLinkPtr RandomChoiceLinkCast(const AtomPtr& a)
 	{ return std::dynamic_pointer_cast<RandomChoiceLink>(a); }
 
-#define createRandomChoiceLink std::make_shared<RandomChoiceLink>
+#define createRandomChoiceLink opencog::make_pooled<RandomChoiceLink>
 
 /** @}*/
 }
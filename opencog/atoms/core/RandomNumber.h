@@ -64,7 +64,7 @@ static inline RandomNumberLinkPtr RandomNumberLinkCast(const Handle& h)
 static inline RandomNumberLinkPtr RandomNumberLinkCast(AtomPtr a)
 	{ return std::dynamic_pointer_cast<RandomNumberLink>(a); }
 
-#define createRandomNumberLink std::make_shared<RandomNumberLink>
+#define createRandomNumberLink opencog::make_pooled<RandomNumberLink>
 
 /** @}*/
 }
@@ -265,7 +265,7 @@ static inline RewriteLinkPtr RewriteLinkCast(const Handle& h)
 static inline RewriteLinkPtr RewriteLinkCast(const AtomPtr& a)
 	{ return std::dynamic_pointer_cast<RewriteLink>(a); }
 
-#define createRewriteLink std::make_shared<RewriteLink>
+#define createRewriteLink opencog::make_pooled<RewriteLink>
 
 /** @}*/
 }
@@ -307,9 +307,7 @@ ContentHash ScopeLink::compute_hash() const
 
 ContentHash ScopeLink::scope_hash(const FreeVariables::IndexMap& index) const
 {
-	ContentHash hsh = get_fvna_offset<sizeof(ContentHash)>();
-	fnv1a_hash(hsh, get_type());
-	fnv1a_hash(hsh, _variables.varseq.size());
+	ContentHash hsh = hash_combine(get_type(), _variables.varseq.size());
 
 	// It is not safe to mix here, since the sort order of the
 	// typemaps will depend on the variable names. So must be
@@ -319,30 +317,28 @@ ContentHash ScopeLink::scope_hash(const FreeVariables::IndexMap& index) const
 	{
 		for (Type t : pr.second) vth += t;
 	}
-	fnv1a_hash(hsh, vth);
+	hsh = hash_combine(hsh, vth);
 
 	for (const auto& pr : _variables._deep_typemap)
 	{
 		for (const Handle& th : pr.second) vth += th->get_hash();
 	}
-	fnv1a_hash(hsh, vth);
+	hsh = hash_combine(hsh, vth);
 
 	for(const auto& pr: _variables._glob_intervalmap){
 		vth += pr.first->get_hash();
 	}
-	fnv1a_hash(hsh, vth);
+	hsh = hash_combine(hsh, vth);
 
 	// As to not mix together VariableList and VariableSet
-	fnv1a_hash(hsh, _variables._ordered);
+	hsh = hash_combine(hsh, _variables._ordered);
 
 	Arity vardecl_offset = _vardecl != Handle::UNDEFINED;
 	Arity n_scoped_terms = get_arity() - vardecl_offset;
-	UnorderedHandleSet hidden;
-	for (Arity i = 0; i < n_scoped_terms; ++i)
-	{
-		const Handle& h(_outgoing[i + vardecl_offset]);
-		fnv1a_hash(hsh, term_hash(h, index));
-	}
+	hsh = hash_words(n_scoped_terms,
+		[&](size_t i) {
+			return term_hash(_outgoing[i + vardecl_offset], index);
+		}, hsh);
 
 	// Links will always have the MSB set.
 	ContentHash mask = ((ContentHash) 1UL) << (8*sizeof(ContentHash) - 1);
@@ -367,9 +363,7 @@ ContentHash ScopeLink::term_hash(const Handle& h,
 		{
 			// Alpha-convert the variable "name" to its unique position
 			// in the sequence of bound vars.  Thus, the name is unique.
-			ContentHash hsh = get_fvna_offset<sizeof(ContentHash)>();
-			fnv1a_hash(hsh, 1 + it->second);
-			return hsh;
+			return hash_combine(HASH_P2, 1 + it->second);
 		}
 		// Otherwise treat that variable as a constant, i.e. move on
 	}
@@ -413,13 +407,8 @@ ContentHash ScopeLink::term_hash(const Handle& h,
 		std::sort(hash_vec.begin(), hash_vec.end());
 	}
 
-	ContentHash hsh = get_fvna_offset<sizeof(ContentHash)>();
-	fnv1a_hash(hsh, t);
-	for (ContentHash & t_hash: hash_vec) {
-		fnv1a_hash(hsh, t_hash);
-	}
-
-	return hsh;
+	return hash_words(hash_vec.size(),
+		[&](size_t i) { return hash_vec[i]; }, t);
 }
 
 /* ================================================================= */
@@ -114,7 +114,7 @@ static inline ScopeLinkPtr ScopeLinkCast(const Handle& h)
 static inline ScopeLinkPtr ScopeLinkCast(const AtomPtr& a)
 	{ return std::dynamic_pointer_cast<ScopeLink>(a); }
 
-#define createScopeLink std::make_shared<ScopeLink>
+#define createScopeLink opencog::make_pooled<ScopeLink>
 
 /** @}*/
 }
@@ -54,7 +54,7 @@ static inline SleepLinkPtr SleepLinkCast(const Handle& h)
 static inline SleepLinkPtr SleepLinkCast(AtomPtr a)
 	{ return std::dynamic_pointer_cast<SleepLink>(a); }
 
-#define createSleepLink std::make_shared<SleepLink>
+#define createSleepLink opencog::make_pooled<SleepLink>
 
 /** @}*/
 }
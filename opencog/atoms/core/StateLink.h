@@ -95,7 +95,7 @@ static inline StateLinkPtr StateLinkCast(const Handle& h)
 static inline StateLinkPtr StateLinkCast(const AtomPtr& a)
 	{ return std::dynamic_pointer_cast<StateLink>(a); }
 
-#define createStateLink std::make_shared<StateLink>
+#define createStateLink opencog::make_pooled<StateLink>
 
 /** @}*/
 }
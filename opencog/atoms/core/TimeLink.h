@@ -53,7 +53,7 @@ static inline TimeLinkPtr TimeLinkCast(const Handle& h)
 static inline TimeLinkPtr TimeLinkCast(AtomPtr a)
 	{ return std::dynamic_pointer_cast<TimeLink>(a); }
 
-#define createTimeLink std::make_shared<TimeLink>
+#define createTimeLink opencog::make_pooled<TimeLink>
 
 /** @}*/
 }
@@ -100,7 +100,7 @@ static inline TypeNodePtr TypeNodeCast(const Handle& h)
 static inline TypeNodePtr TypeNodeCast(AtomPtr a)
 	{ return std::dynamic_pointer_cast<TypeNode>(a); }
 
-#define createTypeNode std::make_shared<TypeNode>
+#define createTypeNode opencog::make_pooled<TypeNode>
 
 /** @}*/
 }
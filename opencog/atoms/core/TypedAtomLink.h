@@ -79,7 +79,7 @@ static inline TypedAtomLinkPtr TypedAtomLinkCast(const Handle& h)
 static inline TypedAtomLinkPtr TypedAtomLinkCast(AtomPtr a)
 	{ return std::dynamic_pointer_cast<TypedAtomLink>(a); }
 
-#define createTypedAtomLink std::make_shared<TypedAtomLink>
+#define createTypedAtomLink opencog::make_pooled<TypedAtomLink>
 
 /** @}*/
 }
@@ -67,7 +67,7 @@ static inline UniqueLinkPtr UniqueLinkCast(const Handle& h)
 static inline UniqueLinkPtr UniqueLinkCast(const AtomPtr& a)
 	{ return std::dynamic_pointer_cast<UniqueLink>(a); }
 
-#define createUniqueLink std::make_shared<UniqueLink>
+#define createUniqueLink opencog::make_pooled<UniqueLink>
 
 /** @}*/
 }
@@ -69,7 +69,7 @@ static inline UnorderedLinkPtr UnorderedLinkCast(const Handle& h)
 static inline UnorderedLinkPtr UnorderedLinkCast(const AtomPtr& a)
 	{ return std::dynamic_pointer_cast<UnorderedLink>(a); }
 
-#define createUnorderedLink std::make_shared<UnorderedLink>
+#define createUnorderedLink opencog::make_pooled<UnorderedLink>
 
 /** @}*/
 }
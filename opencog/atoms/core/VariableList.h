@@ -94,7 +94,7 @@ static inline VariableListPtr VariableListCast(const Handle& h)
 static inline VariableListPtr VariableListCast(const AtomPtr& a)
 	{ return std::dynamic_pointer_cast<VariableList>(a); }
 
-#define createVariableList std::make_shared<VariableList>
+#define createVariableList opencog::make_pooled<VariableList>
 
 // Debugging helpers see
 // http://wiki.opencog.org/w/Development_standards#Print_OpenCog_Objects
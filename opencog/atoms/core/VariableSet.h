@@ -62,7 +62,7 @@ static inline VariableSetPtr VariableSetCast(const Handle& h)
 static inline VariableSetPtr VariableSetCast(const AtomPtr& a)
 	{ return std::dynamic_pointer_cast<VariableSet>(a); }
 
-#define createVariableSet std::make_shared<VariableSet>
+#define createVariableSet opencog::make_pooled<VariableSet>
 
 // Debugging helpers see
 // http://wiki.opencog.org/w/Development_standards#Print_OpenCog_Objects
@@ -47,7 +47,7 @@ static inline EvaluationLinkPtr EvaluationLinkCast(const Handle& h)
 static inline EvaluationLinkPtr EvaluationLinkCast(AtomPtr a)
    { return std::dynamic_pointer_cast<EvaluationLink>(a); }
 
-#define createEvaluationLink std::make_shared<EvaluationLink>
+#define createEvaluationLink opencog::make_pooled<EvaluationLink>
 
 /** @}*/
 }
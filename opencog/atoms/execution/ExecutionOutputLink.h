@@ -67,7 +67,7 @@ static inline ExecutionOutputLinkPtr ExecutionOutputLinkCast(const Handle& h)
 static inline ExecutionOutputLinkPtr ExecutionOutputLinkCast(AtomPtr a)
    { return std::dynamic_pointer_cast<ExecutionOutputLink>(a); }
 
-#define createExecutionOutputLink std::make_shared<ExecutionOutputLink>
+#define createExecutionOutputLink opencog::make_pooled<ExecutionOutputLink>
 
 /** @}*/
 }
@@ -82,7 +82,7 @@ static inline MapLinkPtr MapLinkCast(const Handle& h)
 static inline MapLinkPtr MapLinkCast(AtomPtr a)
 	{ return std::dynamic_pointer_cast<MapLink>(a); }
 
-#define createMapLink std::make_shared<MapLink>
+#define createMapLink opencog::make_pooled<MapLink>
 
 /** @}*/
 }
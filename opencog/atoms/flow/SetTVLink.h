@@ -59,7 +59,7 @@ static inline SetTVLinkPtr SetTVLinkCast(const Handle& h)
 static inline SetTVLinkPtr SetTVLinkCast(AtomPtr a)
 	{ return std::dynamic_pointer_cast<SetTVLink>(a); }
 
-#define createSetTVLink std::make_shared<SetTVLink>
+#define createSetTVLink opencog::make_pooled<SetTVLink>
 
 /** @}*/
 }
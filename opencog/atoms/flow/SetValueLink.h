@@ -55,7 +55,7 @@ static inline SetValueLinkPtr SetValueLinkCast(const Handle& h)
 static inline SetValueLinkPtr SetValueLinkCast(AtomPtr a)
 	{ return std::dynamic_pointer_cast<SetValueLink>(a); }
 
-#define createSetValueLink std::make_shared<SetValueLink>
+#define createSetValueLink opencog::make_pooled<SetValueLink>
 
 /** @}*/
 }
@@ -56,7 +56,7 @@ static inline TruthValueOfLinkPtr TruthValueOfLinkCast(const Handle& h)
 static inline TruthValueOfLinkPtr TruthValueOfLinkCast(AtomPtr a)
 	{ return std::dynamic_pointer_cast<TruthValueOfLink>(a); }
 
-#define createTruthValueOfLink std::make_shared<TruthValueOfLink>
+#define createTruthValueOfLink opencog::make_pooled<TruthValueOfLink>
 
 // ====================================================================
 
@@ -83,7 +83,7 @@ static inline StrengthOfLinkPtr StrengthOfLinkCast(const Handle& h)
 static inline StrengthOfLinkPtr StrengthOfLinkCast(AtomPtr a)
 	{ return std::dynamic_pointer_cast<StrengthOfLink>(a); }
 
-#define createStrengthOfLink std::make_shared<StrengthOfLink>
+#define createStrengthOfLink opencog::make_pooled<StrengthOfLink>
 
 // ====================================================================
 
@@ -110,7 +110,7 @@ static inline ConfidenceOfLinkPtr ConfidenceOfLinkCast(const Handle& h)
 static inline ConfidenceOfLinkPtr ConfidenceOfLinkCast(AtomPtr a)
 	{ return std::dynamic_pointer_cast<ConfidenceOfLink>(a); }
 
-#define createConfidenceOfLink std::make_shared<ConfidenceOfLink>
+#define createConfidenceOfLink opencog::make_pooled<ConfidenceOfLink>
 
 /** @}*/
 }
@@ -54,7 +54,7 @@ static inline ValueOfLinkPtr ValueOfLinkCast(const Handle& h)
 static inline ValueOfLinkPtr ValueOfLinkCast(AtomPtr a)
 	{ return std::dynamic_pointer_cast<ValueOfLink>(a); }
 
-#define createValueOfLink std::make_shared<ValueOfLink>
+#define createValueOfLink opencog::make_pooled<ValueOfLink>
 
 /** @}*/
 }
@@ -54,7 +54,7 @@ static inline BindLinkPtr BindLinkCast(const Handle& h)
 static inline BindLinkPtr BindLinkCast(AtomPtr a)
 	{ return std::dynamic_pointer_cast<BindLink>(a); }
 
-#define createBindLink std::make_shared<BindLink>
+#define createBindLink opencog::make_pooled<BindLink>
 
 /** @}*/
 }
@@ -50,7 +50,7 @@ static inline DualLinkPtr DualLinkCast(const Handle& h)
 static inline DualLinkPtr DualLinkCast(AtomPtr a)
 	{ return std::dynamic_pointer_cast<DualLink>(a); }
 
-#define createDualLink std::make_shared<DualLink>
+#define createDualLink opencog::make_pooled<DualLink>
 
 /** @}*/
 }
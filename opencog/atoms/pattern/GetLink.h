@@ -53,7 +53,7 @@ static inline GetLinkPtr GetLinkCast(const Handle& h)
 static inline GetLinkPtr GetLinkCast(AtomPtr a)
 	{ return std::dynamic_pointer_cast<GetLink>(a); }
 
-#define createGetLink std::make_shared<GetLink>
+#define createGetLink opencog::make_pooled<GetLink>
 
 /** @}*/
 }
@@ -182,7 +182,7 @@ static inline PatternLinkPtr PatternLinkCast(const Handle& h)
 static inline PatternLinkPtr PatternLinkCast(AtomPtr a)
 	{ return std::dynamic_pointer_cast<PatternLink>(a); }
 
-#define createPatternLink std::make_shared<PatternLink>
+#define createPatternLink opencog::make_pooled<PatternLink>
 
 // For gdb, see
 // http://wiki.opencog.org/w/Development_standards#Print_OpenCog_Objects
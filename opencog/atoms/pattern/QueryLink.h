@@ -66,7 +66,7 @@ static inline QueryLinkPtr QueryLinkCast(const Handle& h)
 static inline QueryLinkPtr QueryLinkCast(AtomPtr a)
 	{ return std::dynamic_pointer_cast<QueryLink>(a); }
 
-#define createQueryLink std::make_shared<QueryLink>
+#define createQueryLink opencog::make_pooled<QueryLink>
 
 /** @}*/
 }
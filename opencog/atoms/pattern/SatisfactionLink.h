@@ -56,7 +56,7 @@ static inline SatisfactionLinkPtr SatisfactionLinkCast(const Handle& h)
 static inline SatisfactionLinkPtr SatisfactionLinkCast(AtomPtr a)
 	{ return std::dynamic_pointer_cast<SatisfactionLink>(a); }
 
-#define createSatisfactionLink std::make_shared<SatisfactionLink>
+#define createSatisfactionLink opencog::make_pooled<SatisfactionLink>
 
 /** @}*/
 }
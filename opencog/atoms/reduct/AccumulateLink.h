@@ -45,7 +45,7 @@ static inline AccumulateLinkPtr AccumulateLinkCast(const Handle& h)
 static inline AccumulateLinkPtr AccumulateLinkCast(AtomPtr a)
    { return std::dynamic_pointer_cast<AccumulateLink>(a); }
 
-#define createAccumulateLink std::make_shared<AccumulateLink>
+#define createAccumulateLink opencog::make_pooled<AccumulateLink>
 
 /** @}*/
 }
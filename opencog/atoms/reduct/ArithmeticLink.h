@@ -70,7 +70,7 @@ static inline ArithmeticLinkPtr ArithmeticLinkCast(const Handle& h)
 static inline ArithmeticLinkPtr ArithmeticLinkCast(AtomPtr a)
    { return std::dynamic_pointer_cast<ArithmeticLink>(a); }
 
-#define createArithmeticLink std::make_shared<ArithmeticLink>
+#define createArithmeticLink opencog::make_pooled<ArithmeticLink>
 
 /** @}*/
 }
@@ -42,7 +42,7 @@ static inline DivideLinkPtr DivideLinkCast(const Handle& h)
 static inline DivideLinkPtr DivideLinkCast(AtomPtr a)
    { return std::dynamic_pointer_cast<DivideLink>(a); }
 
-#define createDivideLink std::make_shared<DivideLink>
+#define createDivideLink opencog::make_pooled<DivideLink>
 
 /** @}*/
 }
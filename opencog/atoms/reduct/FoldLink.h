@@ -63,7 +63,7 @@ static inline FoldLinkPtr FoldLinkCast(const Handle& h)
 static inline FoldLinkPtr FoldLinkCast(AtomPtr a)
    { return std::dynamic_pointer_cast<FoldLink>(a); }
 
-#define createFoldLink std::make_shared<FoldLink>
+#define createFoldLink opencog::make_pooled<FoldLink>
 
 /** @}*/
 }
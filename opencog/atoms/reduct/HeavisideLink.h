@@ -46,7 +46,7 @@ static inline HeavisideLinkPtr HeavisideLinkCast(const Handle& h)
 static inline HeavisideLinkPtr HeavisideLinkCast(AtomPtr a)
    { return std::dynamic_pointer_cast<HeavisideLink>(a); }
 
-#define createHeavisideLink std::make_shared<HeavisideLink>
+#define createHeavisideLink opencog::make_pooled<HeavisideLink>
 
 /** @}*/
 }
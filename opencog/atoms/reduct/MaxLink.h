@@ -43,7 +43,7 @@ static inline MaxLinkPtr MaxLinkCast(const Handle& h)
 static inline MaxLinkPtr MaxLinkCast(AtomPtr a)
    { return std::dynamic_pointer_cast<MaxLink>(a); }
 
-#define createMaxLink std::make_shared<MaxLink>
+#define createMaxLink opencog::make_pooled<MaxLink>
 
 /** @}*/
 }
@@ -43,7 +43,7 @@ static inline MinLinkPtr MinLinkCast(const Handle& h)
 static inline MinLinkPtr MinLinkCast(AtomPtr a)
    { return std::dynamic_pointer_cast<MinLink>(a); }
 
-#define createMinLink std::make_shared<MinLink>
+#define createMinLink opencog::make_pooled<MinLink>
 
 /** @}*/
 }
@@ -42,7 +42,7 @@ static inline MinusLinkPtr MinusLinkCast(const Handle& h)
 static inline MinusLinkPtr MinusLinkCast(AtomPtr a)
    { return std::dynamic_pointer_cast<MinusLink>(a); }
 
-#define createMinusLink std::make_shared<MinusLink>
+#define createMinusLink opencog::make_pooled<MinusLink>
 
 /** @}*/
 }
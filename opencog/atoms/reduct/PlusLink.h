@@ -45,7 +45,7 @@ static inline PlusLinkPtr PlusLinkCast(const Handle& h)
 static inline PlusLinkPtr PlusLinkCast(AtomPtr a)
    { return std::dynamic_pointer_cast<PlusLink>(a); }
 
-#define createPlusLink std::make_shared<PlusLink>
+#define createPlusLink opencog::make_pooled<PlusLink>
 
 /** @}*/
 }
@@ -45,7 +45,7 @@ static inline TimesLinkPtr TimesLinkCast(const Handle& h)
 static inline TimesLinkPtr TimesLinkCast(AtomPtr a)
    { return std::dynamic_pointer_cast<TimesLink>(a); }
 
-#define createTimesLink std::make_shared<TimesLink>
+#define createTimesLink opencog::make_pooled<TimesLink>
 
 /** @}*/
 }
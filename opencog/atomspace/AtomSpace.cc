@@ -62,7 +62,10 @@ AtomSpace::AtomSpace(AtomSpace* parent, bool transient) :
     _atom_table(parent? &parent->_atom_table : nullptr, this, transient),
     _backing_store(nullptr),
     _read_only(false),
-    _copy_on_write(transient)
+    _copy_on_write(transient),
+    _atom_budget(0),
+    _memory_budget(0),
+    _atom_limit(0)
 {
 }
 
@@ -92,6 +95,285 @@ void AtomSpace::set_read_write(void)
     _read_only = false;
 }
 
+// ====================================================================
+// Bounded atomspaces
+
+/// Refuse a budget that the backing store cannot honor.
+void AtomSpace::check_evictable(size_t budget)
+{
+    if (0 < budget and _backing_store and
+        not _backing_store->supportsEviction())
+        throw RuntimeException(TRACE_INFO,
+            "The backing store does not support a bounded AtomSpace.");
+}
+
+void AtomSpace::set_atom_budget(size_t natoms)
+{
+    check_evictable(natoms);
+    _atom_budget = natoms;
+    update_limit();
+    check_budget();
+}
+
+void AtomSpace::set_memory_budget(size_t bytes)
+{
+    check_evictable(bytes);
+    _memory_budget = bytes;
+    update_limit();
+    check_budget();
+}
+
+/// The limit is the smaller of the two budgets. The memory budget is
+/// divided by the bytes per atom, as sampled from the atoms held now,
+/// plus their share of the lookup index; before there are any, a
+/// typical size will have to do.
+void AtomSpace::update_limit(void)
+{
+    size_t limit = _atom_budget;
+    if (0 < _memory_budget)
+    {
+        size_t per_atom = 256;
+        size_t natoms = _atom_table.getLocalSize();
+        if (0 < natoms)
+        {
+            MemoryReport rpt(_atom_table.getMemoryReport(64));
+            per_atom = std::max<size_t>(1,
+                (rpt.total().total() + rpt.lookup_index) / natoms);
+        }
+
+        size_t mlimit = std::max<size_t>(1, _memory_budget / per_atom);
+        if (0 == limit or mlimit < limit) limit = mlimit;
+    }
+    _atom_limit = limit;
+}
+
+/// Evict the coldest atoms, until the atomspace is a tenth under its
+/// limit. Only atoms that no link in RAM holds can go; the links
+/// above the rest have to go first, and so a sweep may take several
+/// passes. Atoms that anyone outside of the table holds a Handle to
+/// (a caller, a value, a key) stay too: a change made through that
+/// Handle, after the atom left, would never be written back.
+void AtomSpace::evict(void)
+{
+    // One sweep at a time; anyone else who finds the atomspace over
+    // budget just carries on.
+    std::unique_lock<std::mutex> lck(_evict_mtx, std::try_to_lock);
+    if (not lck.owns_lock() or nullptr == _backing_store) return;
+
+    if (0 < _memory_budget) update_limit();
+    size_t limit = _atom_limit;
+    if (0 == limit) return;
+    size_t low = limit - limit / 10;
+
+    size_t size = _atom_table.getLocalSize();
+    while (low < size)
+    {
+        // Two turns of the hand clear every CLOCK bit, and so are
+        // enough to find whatever there is to be found.
+        HandleSeq cold(_atom_table.getColdAtoms(size - low, 2 * size));
+
+        HandleSeq victims;
+        HandleSeq dirty;
+        for (const Handle& h : cold)
+        {
+            if (h->has_incoming()) continue;
+
+            // The table holds some references, and so does `cold`.
+            if (AtomTable::INDEX_REFS + 1 < h.use_count()) continue;
+            if (h->isDirty())
+            {
+                // Can't write it back, so it has to stay.
+                if (_read_only) continue;
+                h->clearDirty();
+                dirty.emplace_back(h);
+            }
+            victims.emplace_back(h);
+        }
+        if (victims.empty()) break;
+
+        // Everything must be in the backing store before it leaves
+        // RAM; a fault must never find an older version out there.
+        // The barrier also covers atoms stored earlier, by the user.
+        try {
+            if (not dirty.empty()) _backing_store->storeAtoms(dirty);
+            _backing_store->barrier();
+        }
+        catch (...) {
+            for (const Handle& h : dirty) h->setDirty();
+            throw;
+        }
+        cold.clear();
+        dirty.clear();
+
+        HandleSeq gone;
+        for (Handle& h : victims)
+        {
+            // Changed while it was being written; keep it for now.
+            if (h->isDirty()) continue;
+
+            // Picked up by someone while it was being written. Now,
+            // only the table and `victims` should be holding it.
+            if (AtomTable::INDEX_REFS + 1 < h.use_count()) continue;
+
+            // Noted before it leaves, so that an add racing with the
+            // extract faults it back in, rather than adding it afresh.
+            note_evicted(h);
+
+            // Whatever links above it were evicted stay evicted; the
+            // extract must not fault them back in to check for them.
+            bool evicted = h->clearIncomingEvicted();
+            if (0 == _atom_table.extract(h, false).size())
+            {
+                if (evicted) h->setIncomingEvicted();
+                forget_evicted(h);
+                continue;
+            }
+
+            // The atoms under it no longer have all of their incoming
+            // set in RAM.
+            if (h->is_link())
+                for (const Handle& ho : h->getOutgoingSet())
+                    ho->setIncomingEvicted();
+            gone.emplace_back(h);
+        }
+        if (gone.empty()) break;
+        _backing_store->releaseAtoms(gone);
+
+        size = _atom_table.getLocalSize();
+    }
+}
+
+/// Ask the backing store for the atom, with all of its values.
+Handle AtomSpace::get_stored(const Handle& h)
+{
+    if (h->is_node())
+        return _backing_store->getNode(h->get_type(),
+                                       h->get_name().c_str());
+    if (h->is_link())
+        return _backing_store->getLink(h->get_type(),
+                                       h->getOutgoingSet());
+    return Handle::UNDEFINED;
+}
+
+/// The atoms under h that are not in the table.
+static void collect_missing(const AtomTable& table, const Handle& h,
+                            HandleSeq& missing)
+{
+    if (not h->is_link()) return;
+    for (const Handle& ho : h->getOutgoingSet())
+    {
+        if (table.getHandle(ho)) continue;
+        missing.emplace_back(ho);
+        collect_missing(table, ho, missing);
+    }
+}
+
+/// Bring back an atom that was evicted. Returns null if it was not,
+/// or if the backing store no longer has it. Its incoming set, and
+/// those of the atoms under it that come back with it, are fetched
+/// later, if anyone looks at them.
+Handle AtomSpace::fault_in(const Handle& h)
+{
+    if (nullptr == _backing_store) return Handle::UNDEFINED;
+
+    if (not was_evicted(h)) return Handle::UNDEFINED;
+    Handle hv(get_stored(h));
+    forget_evicted(h);
+    if (nullptr == hv) return Handle::UNDEFINED;
+
+    HandleSeq under;
+    collect_missing(_atom_table, hv, under);
+
+    // Evicted atoms under it must come back with their own values.
+    if (hv->is_link()) fault_in(hv->getOutgoingSet());
+
+    hv = _atom_table.add(hv);
+    if (nullptr == hv) return hv;
+    mark_fetched(hv);
+    hv->setIncomingEvicted();
+    for (const Handle& ho : under)
+    {
+        Handle ha(_atom_table.getHandle(ho));
+        if (ha) ha->setIncomingEvicted();
+    }
+
+    // No check_budget() here: this is called from the const getters,
+    // and a lookup must not evict atoms that the caller may be
+    // holding. The next addition will bring the atomspace back under
+    // its budget.
+    return hv;
+}
+
+/// Before adding atoms to a bounded atomspace: bring back those that
+/// were evicted, and the evicted atoms under them, all at once.
+/// Otherwise, an evicted atom would be added again without its
+/// values, and then written back that way.
+void AtomSpace::fault_in(const HandleSeq& atoms)
+{
+    if (nullptr == _backing_store) return;
+    {
+        std::lock_guard<std::mutex> lck(_evicted_mtx);
+        if (_evicted.empty()) return;
+    }
+
+    HandleSeq under;
+    for (const Handle& h : atoms)
+    {
+        if (nullptr == h or _atom_table.getHandle(h)) continue;
+        under.emplace_back(h);
+        collect_missing(_atom_table, h, under);
+    }
+
+    // An atom under a link that was never evicted might have been
+    // evicted on its own, and so each is checked separately.
+    HandleSeq missing;
+    for (const Handle& h : under)
+        if (was_evicted(h)) missing.emplace_back(h);
+    if (missing.empty()) return;
+
+    HandleSeq found(_backing_store->getAtoms(missing));
+    for (size_t i = 0; i < missing.size(); i++)
+    {
+        forget_evicted(missing[i]);
+        const Handle& hv = found[i];
+        if (nullptr == hv) continue;
+        Handle ha(_atom_table.add(hv));
+        if (nullptr == ha) continue;
+        mark_fetched(ha);
+        ha->setIncomingEvicted();
+    }
+}
+
+/// The incoming set of h just came from the backing store, and so it
+/// does not need to be written back.
+void AtomSpace::fetched_incoming(const Handle& h)
+{
+    h->clearIncomingEvicted();
+    for (const Handle& l : h->getIncomingSet()) mark_fetched(l);
+}
+
+bool AtomSpace::was_evicted(const Handle& h)
+{
+    std::lock_guard<std::mutex> lck(_evicted_mtx);
+    if (_evicted.empty()) return false;
+    return 0 < _evicted.count(h->get_hash());
+}
+
+void AtomSpace::note_evicted(const Handle& h)
+{
+    std::lock_guard<std::mutex> lck(_evicted_mtx);
+    _evicted.insert(h->get_hash());
+}
+
+void AtomSpace::forget_evicted(const Handle& h)
+{
+    std::lock_guard<std::mutex> lck(_evicted_mtx);
+    auto it = _evicted.find(h->get_hash());
+    if (_evicted.end() != it) _evicted.erase(it);
+}
+
+// ====================================================================
+
 bool AtomSpace::compare_atomspaces(const AtomSpace& space_first,
                                    const AtomSpace& space_second,
                                    bool check_values,
@@ -282,7 +564,12 @@ void AtomSpace::registerBackingStore(BackingStore *bs)
         throw RuntimeException(TRACE_INFO,
             "AtomSpace is already connected to a BackingStore.");
 
+    if (0 < _atom_limit and not bs->supportsEviction())
+        throw RuntimeException(TRACE_INFO,
+            "The backing store does not support a bounded AtomSpace.");
+
     _backing_store = bs;
+    clear_evicted();
 }
 
 void AtomSpace::unregisterBackingStore(BackingStore *bs)
@@ -292,12 +579,17 @@ void AtomSpace::unregisterBackingStore(BackingStore *bs)
             "AtomSpace is not connected to a BackingStore.");
 
     if (bs == _backing_store) _backing_store = nullptr;
+    clear_evicted();
 }
 
 // ====================================================================
 
 Handle AtomSpace::add_atom(const Handle& h)
 {
+    // In a bounded atomspace, the atom may have been evicted; bring
+    // it back, values and all, so that adding it does not lose them.
+    if (0 < _atom_limit and h) fault_in(HandleSeq({h}));
+
     // Cannot add atoms to a read-only atomspace. But if it's already
     // in the atomspace, return it.
     if (_read_only) return _atom_table.getHandle(h);
@@ -313,33 +605,86 @@ Handle AtomSpace::add_atom(const Handle& h)
         if (_backing_store)
            _backing_store->removeAtom(h, false);
     }
+    check_budget();
     return rh;
 }
 
+HandleSeq AtomSpace::add_atoms(const HandleSeq& atoms)
+{
+    if (0 < _atom_limit) fault_in(atoms);
+
+    // Cannot add atoms to a read-only atomspace. But return the
+    // ones that are already in the atomspace.
+    if (_read_only)
+    {
+        HandleSeq rhs;
+        rhs.reserve(atoms.size());
+        for (const Handle& h : atoms)
+            rhs.emplace_back(_atom_table.getHandle(h));
+        return rhs;
+    }
+
+    try {
+        HandleSeq rhs(_atom_table.add_atoms(atoms));
+        check_budget();
+        return rhs;
+    }
+    catch (const DeleteException& ex) {
+        // Some DeleteLink in the batch. Let add_atom() sort it out;
+        // whatever was added so far will simply be found again.
+    }
+
+    HandleSeq rhs;
+    rhs.reserve(atoms.size());
+    for (const Handle& h : atoms)
+        rhs.emplace_back(add_atom(h));
+    return rhs;
+}
+
 Handle AtomSpace::add_node(Type t, std::string&& name)
 {
     // Cannot add atoms to a read-only atomspace. But if it's already
     // in the atomspace, return it.
-    if (_read_only) return _atom_table.getHandle(t, std::move(name));
+    if (_read_only) return get_node(t, std::move(name));
 
-    return _atom_table.add(createNode(t, std::move(name)));
+    // In a bounded atomspace, the node may have been evicted; if so,
+    // bring it back, values and all.
+    Handle h(createNode(t, std::move(name)));
+    if (0 < _atom_limit) fault_in(HandleSeq({h}));
+
+    h = _atom_table.add(h);
+    check_budget();
+    return h;
 }
 
 Handle AtomSpace::get_node(Type t, std::string&& name) const
 {
-    return _atom_table.getHandle(t, std::move(name));
+    Handle hn(createNode(t, std::move(name)));
+    Handle h(_atom_table.lookupHandle(hn));
+    if (h or 0 == _atom_limit) return h;
+
+    // A miss, in a bounded atomspace; the node may have been evicted.
+    // The atomspace is only a cache for the backing store, and so
+    // filling it in does not really change it.
+    return const_cast<AtomSpace*>(this)->fault_in(hn);
 }
 
 Handle AtomSpace::add_link(Type t, HandleSeq&& outgoing)
 {
     // Cannot add atoms to a read-only atomspace. But if it's already
     // in the atomspace, return it.
-    if (_read_only) return _atom_table.getHandle(t, std::move(outgoing));
+    if (_read_only) return get_link(t, std::move(outgoing));
 
-    // If it is a DeleteLink, then the addition will fail. Deal with it.
+    // In a bounded atomspace, the link, or atoms under it, may have
+    // been evicted; if so, bring them back, values and all.
     Handle h(createLink(std::move(outgoing), t));
+    if (0 < _atom_limit) fault_in(HandleSeq({h}));
+
+    // If it is a DeleteLink, then the addition will fail. Deal with it.
     try {
-        return _atom_table.add(h);
+        Handle rh(_atom_table.add(h));
+        check_budget();
+        return rh;
     }
     catch (const DeleteException& ex) {
         if (_backing_store)
@@ -350,7 +695,12 @@ Handle AtomSpace::add_link(Type t, HandleSeq&& outgoing)
 
 Handle AtomSpace::get_link(Type t, HandleSeq&& outgoing) const
 {
-    return _atom_table.getHandle(t, std::move(outgoing));
+    Handle hl(createLink(std::move(outgoing), t));
+    Handle h(_atom_table.lookupHandle(hl));
+    if (h or 0 == _atom_limit) return h;
+
+    // A miss, in a bounded atomspace; see get_node().
+    return const_cast<AtomSpace*>(this)->fault_in(hl);
 }
 
 void AtomSpace::store_atom(const Handle& h)
@@ -361,7 +711,39 @@ void AtomSpace::store_atom(const Handle& h)
     if (_read_only)
         throw RuntimeException(TRACE_INFO, "Read-only AtomSpace!");
 
-    _backing_store->storeAtom(h);
+    // Clear the bit first, so that a change made while the atom is
+    // being written marks it dirty again. Restore it if the write
+    // fails; otherwise, the atom could be evicted without ever
+    // having been written.
+    h->clearDirty();
+    try {
+        _backing_store->storeAtom(h);
+    }
+    catch (...) {
+        h->setDirty();
+        throw;
+    }
+}
+
+void AtomSpace::store_atoms(const HandleSeq& atoms)
+{
+    if (nullptr == _backing_store)
+        throw RuntimeException(TRACE_INFO, "No backing store");
+
+    if (_read_only)
+        throw RuntimeException(TRACE_INFO, "Read-only AtomSpace!");
+
+    // See store_atom().
+    for (const Handle& h : atoms)
+        if (h) h->clearDirty();
+    try {
+        _backing_store->storeAtoms(atoms);
+    }
+    catch (...) {
+        for (const Handle& h : atoms)
+            if (h) h->setDirty();
+        throw;
+    }
 }
 
 Handle AtomSpace::fetch_atom(const Handle& h)
@@ -376,20 +758,17 @@ Handle AtomSpace::fetch_atom(const Handle& h)
     // and not to play monkey-shines with them.  If you want something
     // else, then save the old TV, fetch the new TV, and combine them
     // with your favorite algo.
-    Handle hv;
-    if (h->is_node()) {
-        hv = _backing_store->getNode(h->get_type(),
-                                     h->get_name().c_str());
-    }
-    else if (h->is_link()) {
-        hv = _backing_store->getLink(h->get_type(),
-                                     h->getOutgoingSet());
-    }
+    Handle hv(get_stored(h));
 
     // If we found it, add it to the atomspace -- even when the
     // atomspace is marked read-only; the atomspace is acting as
     // a cache for the backingstore.
-    if (hv) return _atom_table.add(hv);
+    if (hv) {
+        hv = _atom_table.add(hv);
+        if (hv) mark_fetched(hv);
+        check_budget();
+        return hv;
+    }
 
     // If it is not found, then it cannot be added.
     if (_read_only) return Handle::UNDEFINED;
@@ -397,6 +776,54 @@ Handle AtomSpace::fetch_atom(const Handle& h)
     return _atom_table.add(h);
 }
 
+HandleSeq AtomSpace::fetch_atoms(const HandleSeq& atoms)
+{
+    if (nullptr == _backing_store)
+        throw RuntimeException(TRACE_INFO, "No backing store");
+
+    HandleSeq found(_backing_store->getAtoms(atoms));
+    return add_fetched(atoms, found);
+}
+
+std::future<HandleSeq> AtomSpace::fetch_atoms_async(const HandleSeq& atoms)
+{
+    if (nullptr == _backing_store)
+        throw RuntimeException(TRACE_INFO, "No backing store");
+
+    // The backend works in the background; the atoms go into the
+    // atomtable in the thread that asks for them.
+    std::shared_future<HandleSeq> found =
+        _backing_store->getAtomsAsync(atoms).share();
+    return std::async(std::launch::deferred,
+        [this, atoms, found]() { return add_fetched(atoms, found.get()); });
+}
+
+/// Add the atoms that came back from the backing store, as
+/// fetch_atom() does.
+HandleSeq AtomSpace::add_fetched(const HandleSeq& atoms,
+                                 const HandleSeq& found)
+{
+    HandleSeq rhs;
+    rhs.reserve(atoms.size());
+    for (size_t i = 0; i < atoms.size(); i++)
+    {
+        if (nullptr == atoms[i])
+            rhs.emplace_back(Handle::UNDEFINED);
+        else if (found[i])
+        {
+            Handle ha(_atom_table.add(found[i]));
+            if (ha) mark_fetched(ha);
+            rhs.emplace_back(ha);
+        }
+        else if (_read_only)
+            rhs.emplace_back(Handle::UNDEFINED);
+        else
+            rhs.emplace_back(_atom_table.add(atoms[i]));
+    }
+    check_budget();
+    return rhs;
+}
+
 Handle AtomSpace::fetch_incoming_set(Handle h, bool recursive)
 {
     if (nullptr == _backing_store)
@@ -407,16 +834,56 @@ Handle AtomSpace::fetch_incoming_set(Handle h, bool recursive)
 
     // Get everything from the backing store.
     _backing_store->getIncomingSet(_atom_table, h);
+    fetched_incoming(h);
+
+    if (not recursive)
+    {
+        check_budget();
+        return h;
+    }
 
-    if (not recursive) return h;
+    // One level at a time; each level in one request.
+    HandleSet seen({h});
+    HandleSeq level;
+    for (const Handle& lp : h->getIncomingSet())
+        if (seen.insert(lp).second) level.push_back(lp);
 
-    IncomingSet vh(h->getIncomingSet());
-    for (const Handle& lp : vh)
-        fetch_incoming_set(lp, true);
+    while (not level.empty())
+    {
+        _backing_store->getIncomingSets(_atom_table, level);
+
+        HandleSeq next;
+        for (const Handle& lh : level)
+        {
+            fetched_incoming(lh);
+            for (const Handle& lp : lh->getIncomingSet())
+                if (seen.insert(lp).second) next.push_back(lp);
+        }
+        level.swap(next);
+    }
 
+    check_budget();
     return h;
 }
 
+void AtomSpace::fetch_incoming_sets(const HandleSeq& atoms)
+{
+    if (nullptr == _backing_store)
+        throw RuntimeException(TRACE_INFO, "No backing store");
+
+    HandleSeq here;
+    here.reserve(atoms.size());
+    for (const Handle& h : atoms)
+    {
+        Handle ha(get_atom(h));
+        if (ha) here.emplace_back(ha);
+    }
+    _backing_store->getIncomingSets(_atom_table, here);
+    for (const Handle& h : here)
+        fetched_incoming(h);
+    check_budget();
+}
+
 Handle AtomSpace::fetch_incoming_by_type(Handle h, Type t)
 {
     if (nullptr == _backing_store)
@@ -427,6 +894,9 @@ Handle AtomSpace::fetch_incoming_by_type(Handle h, Type t)
 
     // Get everything from the backing store.
     _backing_store->getIncomingByType(_atom_table, h, t);
+    for (const Handle& l : h->getIncomingSetByType(t))
+        mark_fetched(l);
+    check_budget();
 
     return h;
 }
@@ -25,7 +25,12 @@
 #ifndef _OPENCOG_ATOMSPACE_H
 #define _OPENCOG_ATOMSPACE_H
 
+#include <atomic>
+#include <future>
 #include <list>
+#include <mutex>
+#include <string>
+#include <unordered_set>
 
 #include <opencog/util/exceptions.h>
 #include <opencog/atoms/truthvalue/TruthValue.h>
@@ -59,6 +64,7 @@ class AtomSpace
     friend class BackingStore;
     friend class IPFSAtomStorage;    // Needs to call get_atomtable()
     friend class SQLAtomStorage;     // Needs to call get_atomtable()
+    friend class SnapshotStorage;    // Needs to call get_atomtable()
     friend class UuidSCM;            // Needs to call get_atomtable()
     friend class ZMQPersistSCM;
     friend class ::AtomTableUTest;
@@ -79,9 +85,80 @@ class AtomSpace
     BackingStore* _backing_store;
 
     AtomTable& get_atomtable(void) { return _atom_table; }
+    HandleSeq add_fetched(const HandleSeq&, const HandleSeq&);
 
     bool _read_only;
     bool _copy_on_write;
+
+    /**
+     * The budget, for an atomspace that evicts to its backing store.
+     * The limit is the number of atoms allowed in RAM; zero if there
+     * is no budget. A memory budget is turned into an atom limit with
+     * the memory report, each time that atoms are evicted.
+     */
+    size_t _atom_budget;
+    size_t _memory_budget;
+    std::atomic<size_t> _atom_limit;
+    std::mutex _evict_mtx;
+
+    /**
+     * The content hashes of the atoms that this atomspace evicted.
+     * In a bounded atomspace, an atom that is not in RAM might have
+     * been evicted, and then it has to be faulted back in, with its
+     * values, before it is used. Asking the backing store about every
+     * lookup miss, and about every atom added, would be far too slow;
+     * only atoms whose hash is here are asked about. A hash is put in
+     * once for each eviction, and taken out once for each fault. The
+     * whole set is dropped when the backing store changes.
+     *
+     * Atoms that were in the backing store all along, but that this
+     * atomspace never held, are not faulted in: just as in an
+     * unbounded atomspace, they have to be fetched before they are
+     * used, or else they are added afresh, without their values.
+     */
+    std::mutex _evicted_mtx;
+    std::unordered_multiset<ContentHash> _evicted;
+
+    bool was_evicted(const Handle&);
+    void note_evicted(const Handle&);
+    void forget_evicted(const Handle&);
+    void clear_evicted(void) {
+        std::lock_guard<std::mutex> lck(_evicted_mtx);
+        _evicted.clear();
+    }
+
+    void check_budget(void) {
+        if (0 < _atom_limit and _atom_limit < _atom_table.getLocalSize())
+            evict();
+    }
+    void evict(void);
+    void update_limit(void);
+    void check_evictable(size_t);
+    Handle get_stored(const Handle&);
+    Handle fault_in(const Handle&);
+    void fault_in(const HandleSeq&);
+    void fetched_incoming(const Handle&);
+
+    /// The atom just came from the backing store, and so it need not
+    /// be written back. Neither do the atoms under it that came along
+    /// without their values; writing those back would erase them.
+    void mark_fetched(const Handle& h) {
+        h->clearDirty();
+        if (not h->is_link()) return;
+        for (const Handle& ho : h->getOutgoingSet())
+            if (ho->isDirty() and ho->getKeys().empty())
+                mark_fetched(ho);
+    }
+
+    /// Called by an atom whose incoming set had links evicted, when
+    /// someone looks at the set. This is inline, so that the atom
+    /// library does not have to link to this one; see the comments
+    /// on AtomTable::in_environ().
+    void fault_incoming_set(const Handle& h) {
+        if (nullptr == _backing_store) return;
+        _backing_store->getIncomingSet(_atom_table, h);
+        for (const Handle& l : h->getIncomingSet()) mark_fetched(l);
+    }
 protected:
 
     /**
@@ -146,8 +223,50 @@ public:
     inline size_t get_num_links() const { return _atom_table.getNumLinks(); }
     inline size_t get_num_atoms_of_type(Type type, bool subclass=false) const
         { return _atom_table.getNumAtomsOfType(type, subclass); }
+
+    /// Hash collision and bucket chain statistics; slow, for debugging.
+    HashStats get_hash_stats() const { return _atom_table.getHashStats(); }
+
+    /// Bytes used, by atom type and by value type. Large types are
+    /// sampled; see AtomTable::getMemoryReport().
+    MemoryReport memory_report(size_t sample = 256) const
+        { return _atom_table.getMemoryReport(sample); }
     inline UUID get_uuid(void) const { return _atom_table.get_uuid(); }
 
+    /**
+     * Return k atoms of the given type (and its subtypes, if subclass
+     * is set), drawn uniformly at random, with replacement.
+     */
+    HandleSeq get_random_atoms(size_t k, Type type=ATOM,
+                               bool subclass=true) const
+        { return _atom_table.getRandom(&randGen(), k, type, subclass); }
+
+    /**
+     * Bound the atomspace, so that it can work on more data than fits
+     * in RAM. Once it holds more than the given number of atoms (or
+     * more than the given number of bytes, as estimated by the memory
+     * report), the least recently used atoms that no link in RAM
+     * holds are written to the backing store, if they changed, and
+     * extracted. After that, they are fetched back as needed: when
+     * get_node() or get_link() misses on an atom that was evicted,
+     * when an evicted atom is added again, and when the incoming set
+     * of an atom that lost some of it is looked at. Atoms that were
+     * never in RAM are not looked for; load or fetch them first, as
+     * with an unbounded atomspace. Passing zero removes the bound.
+     * Nothing is evicted while there is no backing store.
+     *
+     * Atoms are evicted a tenth of the budget at a time, so that the
+     * cost of the sweep is spread over many additions. Atoms that
+     * were loaded or fetched are not written back unless they change.
+     * An atom held by anyone outside of the atomspace is not evicted.
+     * Throws if the backing store does not support eviction; see
+     * BackingStore::supportsEviction().
+     */
+    void set_atom_budget(size_t);
+    void set_memory_budget(size_t);
+    size_t get_atom_budget(void) const { return _atom_budget; }
+    size_t get_memory_budget(void) const { return _memory_budget; }
+
     //! Clear the atomspace, extract all atoms. Does NOT clear the
     //! attached backingstore.
     void clear()
@@ -161,6 +280,14 @@ public:
     Handle add_atom(const AtomPtr& a)
         { return add_atom(a->get_handle()); }
 
+    /**
+     * Add a batch of atoms to the Atom Table. This is equivalent to
+     * calling add_atom() on each, but much faster for large batches.
+     * Returns the atoms in the atomspace, in the same order as the
+     * arguments.
+     */
+    HandleSeq add_atoms(const HandleSeq&);
+
     /**
      * Add a node to the Atom Table.  If the atom already exists
      * then that is returned.
@@ -271,6 +398,21 @@ public:
      */
     Handle fetch_atom(const Handle&);
 
+    /**
+     * Fetch many atoms from the backingstore at once, as fetch_atom()
+     * does for one. The atoms are returned in the same order; atoms
+     * that are neither in storage nor addable are Handle::UNDEFINED.
+     */
+    HandleSeq fetch_atoms(const HandleSeq&);
+
+    /**
+     * Start fetching the atoms from the backingstore, and return
+     * without waiting. The atoms are placed in the atomtable when
+     * get() is called on the future, which returns the same thing
+     * fetch_atoms() would.
+     */
+    std::future<HandleSeq> fetch_atoms_async(const HandleSeq&);
+
     /**
      * Get an atom from the AtomTable. If the atom is not there, then
      * return Handle::UNDEFINED.
@@ -310,10 +452,17 @@ public:
      * If the flag is true, then the load is done recursively.
      * This method queries the backing store to obtain all atoms that
      * contain this one in their outgoing sets. All of these atoms are
-     * then loaded into this atomtable/atomspace.
+     * then loaded into this atomtable/atomspace. A recursive fetch
+     * asks for the incoming sets of each level all at once.
      */
     Handle fetch_incoming_set(Handle, bool=false);
 
+    /**
+     * Use the backing store to load the incoming sets of all of the
+     * atoms, with one batched request.
+     */
+    void fetch_incoming_sets(const HandleSeq&);
+
     /**
      * Use the backing store to load the incoming set of the
      * atom, but only those atoms of the given type.
@@ -329,6 +478,12 @@ public:
      */
     void store_atom(const Handle& h);
 
+    /**
+     * Store many atoms to the backing store at once, as store_atom()
+     * does for one.
+     */
+    void store_atoms(const HandleSeq&);
+
     /**
      * Extract an atom from the atomspace.  This only removes the atom
      * from the (local, in-RAM) AtomSpace (in this process); any copies
@@ -476,8 +631,8 @@ public:
     /**
      * Gets a sequence of handles that matches with the given type
      * (subclasses optionally).
-     * Caution: this is slower than using get_handleset_by_type() to
-     * get a set, as it forces the use of a copy to deduplicate atoms.
+     * Atoms in a parent atomspace that are hidden by an atom in this
+     * one are left out.
      *
      * @param appendToHandles the HandleSeq to which to append the handles.
      * @param type The desired type.
@@ -512,8 +667,8 @@ public:
     /**
      * Gets a container of handles that matches with the given type
      * (subclasses optionally).
-     * Caution: this is slower than using get_handleset_by_type() to
-     * get a set, as it forces the use of a copy to deduplicate atoms.
+     * Atoms in a parent atomspace that are hidden by an atom in this
+     * one are left out.
      *
      * @param result An output iterator.
      * @param type The desired type.
@@ -539,6 +694,32 @@ public:
         return _atom_table.getHandlesByType(result, type, subclass);
     }
 
+    /**
+     * Call func on every atom of the given type (subclasses
+     * optionally), until func returns true. This includes the atoms
+     * in parent atomspaces, except those hidden by an atom in this
+     * one. No copy of the whole result is made, and no lock is held
+     * while func runs, so it may add and remove atoms freely.
+     *
+     * @return true if func stopped the loop early.
+     *
+     * Example of call to this method, which looks for a ConceptNode
+     * with a long name:
+     * @code
+     *         atomSpace.foreach_handle_by_type(
+     *             [](const Handle& h)->bool {
+     *                 return 80 < h->get_name().size(); },
+     *             CONCEPT_NODE);
+     * @endcode
+     */
+    template <typename Function> bool
+    foreach_handle_by_type(Function func,
+                           Type type,
+                           bool subclass=false) const
+    {
+        return _atom_table.visitHandlesByType(func, type, subclass);
+    }
+
     /**
      * Convert the atomspace into a string
      */
@@ -551,6 +732,10 @@ public:
     {
         return _atom_table.atomAddedSignal();
     }
+    AtomSeqSignal& atomsAddedSignal()
+    {
+        return _atom_table.atomsAddedSignal();
+    }
     AtomSignal& atomRemovedSignal()
     {
         return _atom_table.atomRemovedSignal();
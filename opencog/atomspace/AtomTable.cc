@@ -28,11 +28,15 @@
 
 #include "AtomTable.h"
 
+#include <algorithm>
 #include <atomic>
 #include <functional>
 #include <iterator>
+#include <limits>
 #include <mutex>
 #include <set>
+#include <unordered_map>
+#include <vector>
 
 #include <stdlib.h>
 
@@ -43,6 +47,8 @@
 #include <opencog/util/functional.h>
 #include <opencog/util/Logger.h>
 
+#include "Epoch.h"
+
 //#define DPRINTF printf
 #define DPRINTF(...)
 
@@ -68,9 +74,17 @@ using namespace opencog;
 // "no atomtable" (in the persist code).
 static std::atomic<UUID> _id_pool(1);
 
+const size_t AtomTable::NUM_SHARDS;
+
 AtomTable::AtomTable(AtomTable* parent, AtomSpace* holder, bool transient) :
     _nameserver(nameserver())
 {
+    _num_shards = transient ? 1 : NUM_SHARDS;
+    _shards.reset(new IndexShard[_num_shards]);
+    _clock_shard = 0;
+    _clock_type = 0;
+    _clock_pos = 0;
+
     _as = holder;
     _environ = parent;
     if (_environ) _environ->_num_nested++;
@@ -86,8 +100,6 @@ AtomTable::AtomTable(AtomTable* parent, AtomSpace* holder, bool transient) :
 
 AtomTable::~AtomTable()
 {
-    std::lock_guard<std::recursive_mutex> lck(_mtx);
-
     if (_environ) _environ->_num_nested--;
     _nameserver.typeAddedSignal().disconnect(addedTypeConnection);
 
@@ -117,8 +129,6 @@ void AtomTable::clear_transient()
         throw opencog::RuntimeException(TRACE_INFO,
                 "AtomTable - clear_transient called on non-transient atom table.");
 
-    std::lock_guard<std::recursive_mutex> lck(_mtx);
-
     // Clear all the atoms
     clear_all_atoms();
 
@@ -130,15 +140,43 @@ void AtomTable::clear_transient()
 
 void AtomTable::clear_all_atoms()
 {
-    typeIndex.clear();
+    for (size_t i = 0; i < _num_shards; i++)
+    {
+        IndexShard& shard = _shards[i];
+        std::lock_guard<std::recursive_mutex> lck(shard.mtx);
+        shard.lookup.clear();
+        shard.sample.clear();
+        shard.counts.clear();
+        shard.idx.clear();
+    }
 }
 
 void AtomTable::clear()
 {
-    std::lock_guard<std::recursive_mutex> lck(_mtx);
     clear_all_atoms();
 }
 
+bool AtomTable::contains_duplicate() const
+{
+    // Equal atoms have equal hashes, and so always land in the same
+    // shard. Thus, it is enough to check each shard on its own.
+    for (size_t i = 0; i < _num_shards; i++)
+    {
+        const IndexShard& shard = _shards[i];
+        std::lock_guard<std::recursive_mutex> lck(shard.mtx);
+        if (shard.idx.contains_duplicate()) return true;
+    }
+    return false;
+}
+
+bool AtomTable::shadowed(const Handle& h, const AtomTable* env) const
+{
+    EpochGuard guard;
+    for (const AtomTable* t = this; t and t != env; t = t->_environ)
+        if (t->get_shard(h).lookup.find(h)) return true;
+    return false;
+}
+
 Handle AtomTable::getHandle(Type t, const std::string&& n) const
 {
     Handle h(createNode(t, std::move(n)));
@@ -153,16 +191,26 @@ Handle AtomTable::getHandle(Type t, const HandleSeq&& seq) const
 
 /// Find an equivalent atom that is exactly the same as the arg. If
 /// such an atom is in the table, it is returned, else return nullptr.
+///
+/// This never blocks: the lookup index of each table in the
+/// environment chain is searched without locking, while writers
+/// may be busy inserting and removing atoms.
 Handle AtomTable::lookupHandle(const Handle& a) const
 {
     if (nullptr == a) return Handle::UNDEFINED;
 
-    std::lock_guard<std::recursive_mutex> lck(_mtx);
-    Handle h(typeIndex.findAtom(a));
-    if (h) return h;
+    // Compute the hash before entering the critical section.
+    a->get_hash();
 
-    if (_environ)
-        return _environ->lookupHandle(a);
+    EpochGuard guard;
+    const AtomTable* env = this;
+    while (env)
+    {
+        // Only the shard that the atom hashes to needs to be searched.
+        Handle h(env->get_shard(a).lookup.find(a));
+        if (h) { h->touch(); return h; }
+        env = env->_environ;
+    }
 
     return Handle::UNDEFINED;
 }
@@ -173,8 +221,10 @@ Handle AtomTable::getHandle(const Handle& a) const
 {
     if (nullptr == a) return Handle::UNDEFINED;
 
-    if (in_environ(a))
+    if (in_environ(a)) {
+        a->touch();
         return a;
+    }
 
     return lookupHandle(a);
 }
@@ -198,22 +248,34 @@ static void prt_diag(Handle atom, size_t i, size_t arity, const HandleSeq& ogs)
 }
 #endif
 
-Handle AtomTable::add(const Handle& orig, bool force)
+/// The part of add() that runs before any shard lock is taken.
+/// If an equivalent atom is already in the table, return it, and set
+/// `found`. Otherwise, add the outgoing set, and return the atom that
+/// should be inserted. If `deferred` is not null, then the atoms added
+/// in the outgoing set are appended to it, instead of being signalled.
+Handle AtomTable::prepare_add(const Handle& orig, bool force, bool fetched,
+                              bool& found, HandleSeq* deferred)
 {
+    found = true;
+
     // Can be null, if its a Value
     if (nullptr == orig) return Handle::UNDEFINED;
 
     // Is the atom already in this table, or one of its environments?
-    if (not force and in_environ(orig))
+    if (not force and in_environ(orig)) {
+        orig->touch();
         return orig;
+    }
 
     // Force computation of hash external to the locked section.
     orig->get_hash();
 
-    // Lock before checking to see if this kind of atom is already in
-    // the atomspace.  Lock, to prevent two different threads from
-    // trying to add exactly the same atom.
-    std::unique_lock<std::recursive_mutex> lck(_mtx);
+    // Check to see if this kind of atom is already in the atomspace.
+    // This is done without holding any shard lock, so that the
+    // outgoing set can be added (below) without nesting shard locks.
+    // The check is repeated under the shard lock, just before the
+    // insertion, to prevent two different threads from adding
+    // exactly the same atom.
     if (not force) {
         Handle hcheck(getHandle(orig));
         if (hcheck) {
@@ -255,7 +317,7 @@ Handle AtomTable::add(const Handle& orig, bool force)
                 // operator->() will be null if its a Value that is
                 // not an atom.
                 if (nullptr == h.operator->()) return Handle::UNDEFINED;
-                closet.emplace_back(add(h));
+                closet.emplace_back(do_add(h, false, fetched, deferred));
             }
             atom = createLink(std::move(closet), atom->get_type());
         } else {
@@ -269,22 +331,194 @@ Handle AtomTable::add(const Handle& orig, bool force)
     }
 
     if (atom != orig) atom->copyValues(orig);
+
+    found = false;
+    return atom;
+}
+
+/// Insert an atom made by prepare_add(). The caller must hold the
+/// shard lock. Some other thread may have added the same atom while
+/// this one was being prepared; if so, theirs is returned, and this
+/// one is dropped.
+Handle AtomTable::insert_locked(IndexShard& shard, const Handle& atom,
+                                bool fetched)
+{
+    Handle hcheck(shard.idx.findAtom(atom));
+    if (hcheck) return hcheck;
+
     atom->install();
     atom->keep_incoming_set();
     atom->setAtomSpace(_as);
 
-    typeIndex.insertAtom(atom);
+    // New to this table, and so not yet in any backing store, as far
+    // as we know, unless it was just loaded from there. Its values
+    // were set before it got here, and so whatever they did to the
+    // bit is overridden.
+    atom->touch();
+    if (fetched) atom->clearDirty();
+    else atom->setDirty();
+
+    shard.idx.insertAtom(atom);
+    shard.lookup.insert(atom);
+    shard.sample.insertAtom(atom);
+    shard.counts.insert(atom->get_type());
+    return atom;
+}
+
+/// If some atom in the outgoing set was extracted by another thread
+/// while we were adding this link, then the extraction either saw
+/// this link in the incoming set and took it along, or it did not,
+/// in which case we must back out on our own. The removal mark is set
+/// before the incoming set is scanned, and we installed before
+/// checking it, so one of the two always notices. Must be called
+/// with no shard lock held. Returns false if the link was backed out.
+bool AtomTable::check_outgoing(const Handle& atom)
+{
+    if (not atom->is_link()) return true;
+
+    for (const Handle& h : atom->getOutgoingSet()) {
+        if (h->isMarkedForRemoval()) {
+            Handle hx(atom);
+            extract(hx, true);
+            return false;
+        }
+    }
+    return true;
+}
+
+Handle AtomTable::add(const Handle& orig, bool force, bool fetched)
+{
+    return do_add(orig, force, fetched, nullptr);
+}
+
+Handle AtomTable::do_add(const Handle& orig, bool force, bool fetched,
+                         HandleSeq* deferred)
+{
+    bool found;
+    Handle atom(prepare_add(orig, force, fetched, found, deferred));
+    if (found or nullptr == atom) return atom;
+
+    IndexShard& shard = get_shard(atom);
+    std::unique_lock<std::recursive_mutex> lck(shard.mtx);
+    Handle hcheck(insert_locked(shard, atom, fetched));
 
     // Unlock, because the signal needs to run unlocked.
     lck.unlock();
 
+    if (hcheck != atom) {
+        hcheck->copyValues(orig);
+        return hcheck;
+    }
+
+    if (not check_outgoing(atom)) return Handle::UNDEFINED;
+
     // Now that we are completely done, emit the added signal.
     // Don't emit signal until after the indexes are updated!
-    _addAtomSignal.emit(atom);
+    if (deferred)
+        deferred->emplace_back(atom);
+    else
+        _addAtomSignal.emit(atom);
 
     return atom;
 }
 
+HandleSeq AtomTable::add_atoms(const HandleSeq& atoms, bool force)
+{
+    size_t sz = atoms.size();
+    HandleSeq result(sz);
+
+    // Pass one: find the duplicates in the batch. `first[i]` is the
+    // position of the first atom that is equal (by content) to the
+    // i'th one; only those get added.
+    std::vector<size_t> first(sz);
+    std::unordered_multimap<ContentHash, size_t> seen;
+    seen.reserve(sz);
+    for (size_t i = 0; i < sz; i++)
+    {
+        first[i] = i;
+        const Handle& h = atoms[i];
+        if (nullptr == h) continue;
+
+        ContentHash hv = h->get_hash();
+        auto range = seen.equal_range(hv);
+        for (auto it = range.first; it != range.second; it++)
+            if (*atoms[it->second] == *h) /* content-compare */
+            {
+                first[i] = it->second;
+                break;
+            }
+        if (first[i] == i) seen.insert({hv, i});
+    }
+
+    // Pass two: prepare the new atoms, without holding any locks,
+    // and sort them by shard. Links that hold other atoms of this
+    // same batch will add those atoms in passing; the duplicate
+    // check in insert_locked() sorts that out. Atoms added in passing
+    // are collected, so that they are signalled with the rest.
+    HandleSeq added;
+    std::vector<std::vector<size_t>> pending(_num_shards);
+    for (size_t i = 0; i < sz; i++)
+    {
+        if (first[i] != i) continue;
+        bool found;
+        result[i] = prepare_add(atoms[i], force, false, found, &added);
+        if (not found and result[i])
+            pending[shard_index(result[i]->get_hash())].push_back(i);
+    }
+
+    // Pass three: insert, taking each shard lock just once.
+    // Atoms that were inserted, and those that lost the race to some
+    // other thread adding the same atom.
+    std::vector<bool> inserted(sz, false);
+    std::vector<bool> lost(sz, false);
+    for (size_t s = 0; s < _num_shards; s++)
+    {
+        if (pending[s].empty()) continue;
+        IndexShard& shard = _shards[s];
+        std::lock_guard<std::recursive_mutex> lck(shard.mtx);
+        for (size_t i : pending[s])
+        {
+            Handle hcheck(insert_locked(shard, result[i], false));
+            inserted[i] = (hcheck == result[i]);
+            lost[i] = not inserted[i];
+            result[i] = hcheck;
+        }
+    }
+
+    // Pass four: unlocked clean-up, in the original order.
+    for (size_t i = 0; i < sz; i++)
+    {
+        if (first[i] != i)
+        {
+            result[i] = result[first[i]];
+            if (result[i] and result[i] != atoms[i])
+                result[i]->copyValues(atoms[i]);
+            continue;
+        }
+        if (inserted[i])
+        {
+            if (check_outgoing(result[i]))
+                added.emplace_back(result[i]);
+            else
+                result[i] = Handle::UNDEFINED;
+        }
+        else if (lost[i])
+        {
+            result[i]->copyValues(atoms[i]);
+        }
+    }
+
+    // Finally, the signals. Subscribers to the per-atom signal still
+    // see every atom; the batch signal is for those that can do
+    // better with the whole lot at once.
+    for (const Handle& h : added)
+        _addAtomSignal.emit(h);
+    if (not added.empty())
+        _addAtomsSignal.emit(added);
+
+    return result;
+}
+
 void AtomTable::barrier()
 {
 }
@@ -294,6 +528,14 @@ size_t AtomTable::getSize() const
     return getNumAtomsOfType(ATOM, true);
 }
 
+size_t AtomTable::getLocalSize() const
+{
+    size_t result = 0;
+    for (size_t i = 0; i < _num_shards; i++)
+        result += _shards[i].counts.count(ATOM, true);
+    return result;
+}
+
 size_t AtomTable::getNumNodes() const
 {
     return getNumAtomsOfType(NODE, true);
@@ -304,45 +546,205 @@ size_t AtomTable::getNumLinks() const
     return getNumAtomsOfType(LINK, true);
 }
 
+/// The counts are maintained as atoms come and go, so this takes no
+/// locks, and does not depend on the number of atoms or types; only
+/// on the number of shards, and the depth of the environment.
 size_t AtomTable::getNumAtomsOfType(Type type, bool subclass) const
 {
-    std::lock_guard<std::recursive_mutex> lck(_mtx);
+    size_t result = 0;
 
-    size_t result = typeIndex.size(type);
-    if (subclass)
+    EpochGuard guard;
+    for (const AtomTable* env = this; env; env = env->_environ)
+        for (size_t i = 0; i < env->_num_shards; i++)
+            result += env->_shards[i].counts.count(type, subclass);
+
+    return result;
+}
+
+/// Equal hashes always land in the same shard, so the per-shard
+/// counts of distinct hashes simply add up.
+HashStats AtomTable::getHashStats() const
+{
+    HashStats st;
+    for (size_t i = 0; i < _num_shards; i++)
     {
-        // Also count subclasses of this type, if need be.
-        Type ntypes = _nameserver.getNumberOfClasses();
-        for (Type t = ATOM; t<ntypes; t++)
+        const IndexShard& shard = _shards[i];
+        std::lock_guard<std::recursive_mutex> lck(shard.mtx);
+        st += shard.idx.hash_stats();
+    }
+    return st;
+}
+
+/// Walk the dense sample index, so that a sample can be spread evenly
+/// over all of the atoms of a type, without walking the rest.
+MemoryReport AtomTable::getMemoryReport(size_t sample) const
+{
+    MemoryReport rpt;
+    for (size_t i = 0; i < _num_shards; i++)
+    {
+        const IndexShard& shard = _shards[i];
+        std::lock_guard<std::recursive_mutex> lck(shard.mtx);
+        rpt.lookup_index += shard.lookup.bytes();
+        for (Type t = 0; t < shard.sample.num_types(); t++)
         {
-            if (t != type and _nameserver.isA(t, type))
-                result += typeIndex.size(t);
+            size_t n = shard.sample.size(t);
+            if (0 == n) continue;
+
+            // The part carries the names already seen, so that
+            // each is counted once in the whole report.
+            size_t k = (0 == sample or n <= sample) ? n : sample;
+            MemoryReport part;
+            part.names.swap(rpt.names);
+            for (size_t j = 0; j < k; j++)
+                part.measure(shard.sample.at(t, j * n / k));
+            part.scale(n, k);
+            rpt.names.swap(part.names);
+            rpt += part;
         }
     }
+    return rpt;
+}
 
-    if (_environ)
-        result += _environ->getNumAtomsOfType(type, subclass);
+/// The hand walks the dense sample index, one shard at a time. The
+/// index swaps the last atom into the hole left by a removal, so an
+/// atom can occasionally be skipped, or passed twice, in one turn;
+/// that does not matter for an approximation of LRU.
+HandleSeq AtomTable::getColdAtoms(size_t want, size_t scan)
+{
+    HandleSeq cold;
+    std::lock_guard<std::mutex> hand(_clock_mtx);
+    _clock_shard &= _num_shards - 1;
 
-    return result;
+    size_t passed = 0;
+    size_t empty = 0;
+    while (cold.size() < want and passed < scan and empty < _num_shards)
+    {
+        size_t before = passed;
+        {
+            IndexShard& shard = _shards[_clock_shard];
+            std::lock_guard<std::recursive_mutex> lck(shard.mtx);
+            for (; _clock_type < shard.sample.num_types();
+                 _clock_type++, _clock_pos = 0)
+            {
+                size_t n = shard.sample.size(_clock_type);
+                for (; _clock_pos < n; _clock_pos++)
+                {
+                    if (want <= cold.size() or scan <= passed)
+                        return cold;
+
+                    Atom* a = shard.sample.atom_at(_clock_type, _clock_pos);
+                    passed++;
+                    if (not a->untouch())
+                        cold.emplace_back(a->get_handle());
+                }
+            }
+        }
+
+        // Give up after going all the way around an empty table.
+        empty = (before == passed) ? empty + 1 : 0;
+        _clock_shard = (_clock_shard + 1) & (_num_shards - 1);
+        _clock_type = 0;
+        _clock_pos = 0;
+    }
+    return cold;
 }
 
 Handle AtomTable::getRandom(RandGen *rng) const
 {
-    size_t x = rng->randint(getSize());
+    HandleSeq hs(getRandom(rng, 1));
+    if (hs.empty()) return Handle::UNDEFINED;
+    return hs[0];
+}
+
+/// Uniform integer in [0, n); RandGen::randint() only does int.
+static size_t pick(RandGen* rng, size_t n)
+{
+    if (n <= (size_t) std::numeric_limits<int>::max())
+        return rng->randint((int) n);
+    size_t x = rng->randdouble_one_excluded() * n;
+    return std::min(x, n-1);
+}
+
+HandleSeq AtomTable::getRandom(RandGen* rng, size_t k,
+                               Type type, bool subclass) const
+{
+    // The types to sample from.
+    std::vector<Type> types({type});
+    if (subclass)
+    {
+        Type ntypes = _nameserver.getNumberOfClasses();
+        for (Type t = type+1; t < ntypes; t++)
+            if (_nameserver.isA(t, type)) types.push_back(t);
+    }
 
-    Handle randy(Handle::UNDEFINED);
+    // Count the atoms in each shard of each table in the environment.
+    // This is the only part that depends on the number of types; the
+    // draws below are (nearly) constant time each.
+    std::vector<const IndexShard*> shards;
+    std::vector<size_t> cumul;
+    size_t total = 0;
+    for (const AtomTable* env = this; env; env = env->_environ)
+    {
+        for (size_t i = 0; i < env->_num_shards; i++)
+        {
+            const IndexShard& shard = env->_shards[i];
+            std::lock_guard<std::recursive_mutex> lck(shard.mtx);
+            size_t cnt = 0;
+            for (Type t : types) cnt += shard.sample.size(t);
+            if (0 == cnt) continue;
+            total += cnt;
+            shards.push_back(&shard);
+            cumul.push_back(total);
+        }
+    }
 
-    // XXX TODO it would be considerably more efficient to go into the
-    // the type index, and decrement x by the size of the index for
-    // each type.  This would speed up the algo by about 100 (by about
-    // the number of types that are in use...).
-    foreachHandleByType(
-        [&](Handle h)->void {
-            if (0 == x) randy = h;
-            x--;
-        },
-        ATOM, true);
-    return randy;
+    HandleSeq result;
+    if (0 == total or 0 == k) return result;
+
+    // Draw all of the positions first, and bin them by shard, so that
+    // each shard is locked just once.
+    std::vector<std::vector<size_t>> draws(shards.size());
+    for (size_t j = 0; j < k; j++)
+    {
+        size_t x = pick(rng, total);
+        size_t s = std::upper_bound(cumul.begin(), cumul.end(), x)
+                   - cumul.begin();
+        draws[s].push_back(x - (0 == s ? 0 : cumul[s-1]));
+    }
+
+    result.reserve(k);
+    std::vector<size_t> tcumul(types.size());
+    for (size_t s = 0; s < shards.size(); s++)
+    {
+        if (draws[s].empty()) continue;
+        const IndexShard& shard = *shards[s];
+        std::lock_guard<std::recursive_mutex> lck(shard.mtx);
+
+        size_t cnt = 0;
+        for (size_t i = 0; i < types.size(); i++)
+        {
+            cnt += shard.sample.size(types[i]);
+            tcumul[i] = cnt;
+        }
+
+        // The shard may have changed since it was counted; if so,
+        // fold the draws onto what is there now.
+        if (0 == cnt) continue;
+        for (size_t x : draws[s])
+        {
+            x %= cnt;
+            size_t i = std::upper_bound(tcumul.begin(), tcumul.end(), x)
+                       - tcumul.begin();
+            result.emplace_back(shard.sample.at(types[i],
+                                x - (0 == i ? 0 : tcumul[i-1])));
+        }
+    }
+
+    // Binning by shard sorted the results; undo that.
+    for (size_t j = result.size(); 1 < j; j--)
+        std::swap(result[j-1], result[pick(rng, j)]);
+
+    return result;
 }
 
 HandleSet AtomTable::extract(Handle& handle, bool recursive)
@@ -366,45 +768,58 @@ HandleSet AtomTable::extract(Handle& handle, bool recursive)
         return other->extract(handle, recursive);
     }
 
-    // Lock before fetching the incoming set. Since getting the
-    // incoming set also grabs a lock, we need this mutex to be
-    // recursive. We need to lock here to avoid confusion if multiple
-    // threads are trying to delete the same atom.
-    std::unique_lock<std::recursive_mutex> lck(_mtx);
-
-    if (handle->isMarkedForRemoval()) return result;
-    handle->markForRemoval();
+    // Mark the atom under the shard lock, so that only one thread
+    // gets to extract it, if several are racing to do so.
+    IndexShard& shard = get_shard(handle);
+    {
+        std::lock_guard<std::recursive_mutex> lck(shard.mtx);
+        if (handle->isMarkedForRemoval()) return result;
+        handle->markForRemoval();
+    }
 
     // If recursive-flag is set, also extract all the links in the atom's
-    // incoming set
+    // incoming set. No shard lock is held while doing so: the links
+    // may live in other shards, and waiting on one shard lock while
+    // holding another would deadlock against a thread doing the
+    // reverse.
     if (recursive) {
-        // We need to make a copy of the incoming set because the
-        // recursive call will trash the incoming set when the atom
-        // is removed.
-        IncomingSet is(handle->getIncomingSet());
-
-        IncomingSet::iterator is_it = is.begin();
-        IncomingSet::iterator is_end = is.end();
-        for (; is_it != is_end; ++is_it)
+        // Links that get added to the incoming set while this loop
+        // runs are caught on the next pass. Passes continue until
+        // nothing more gets extracted.
+        bool again = true;
+        while (again)
         {
-            Handle his(*is_it);
-            DPRINTF("[AtomTable::extract] incoming set: %s",
-                 (his) ? his->to_string().c_str() : "INVALID HANDLE");
-
-            // Something is seriously screwed up if the incoming set
-            // is not in this atomtable, and its not a child of this
-            // atom table.  So flag that as an error; it will assert
-            // a few dozen lines later, below.
-            AtomTable* other = his->getAtomTable();
-            if (other and other != this and not other->in_environ(handle)) {
-                logger().warn() << "AtomTable::extract() internal error, "
-                                << "non-DAG membership.";
-            }
-            if (not his->isMarkedForRemoval()) {
-                DPRINTF("[AtomTable::extract] marked for removal is false");
-                if (other) {
-                    HandleSet ex = other->extract(his, true);
-                    result.insert(ex.begin(), ex.end());
+            again = false;
+
+            // We need to make a copy of the incoming set because the
+            // recursive call will trash the incoming set when the atom
+            // is removed.
+            IncomingSet is(handle->getIncomingSet());
+
+            IncomingSet::iterator is_it = is.begin();
+            IncomingSet::iterator is_end = is.end();
+            for (; is_it != is_end; ++is_it)
+            {
+                Handle his(*is_it);
+                DPRINTF("[AtomTable::extract] incoming set: %s",
+                     (his) ? his->to_string().c_str() : "INVALID HANDLE");
+
+                // Something is seriously screwed up if the incoming set
+                // is not in this atomtable, and its not a child of this
+                // atom table.  So flag that as an error; it will assert
+                // a few dozen lines later, below.
+                AtomTable* other = his->getAtomTable();
+                if (other and other != this and not other->in_environ(handle)) {
+                    logger().warn() << "AtomTable::extract() internal error, "
+                                    << "non-DAG membership.";
+                }
+                if (not his->isMarkedForRemoval()) {
+                    DPRINTF("[AtomTable::extract] marked for removal is false");
+                    if (other) {
+                        HandleSet ex = other->extract(his, true);
+                        if (0 < ex.size()) again = true;
+                        result.insert(ex.begin(), ex.end());
+                    }
                 }
             }
         }
@@ -429,20 +844,23 @@ HandleSet AtomTable::extract(Handle& handle, bool recursive)
     // Issue the atom removal signal *BEFORE* the atom is actually
     // removed.  This is needed so that certain subsystems, e.g. the
     // Agent system activity table, can correctly manage the atom;
-    // it needs info that gets blanked out during removal.
-    // Pfft. Give up the pretension. This is a recursive lock;
-    // unlocking it once is not enough, because it can still be
-    // recurisvely locked.
-    // lck.unlock();
+    // it needs info that gets blanked out during removal. No locks
+    // are held at this point, so the signal handlers are free to
+    // touch the table.
     _removeAtomSignal.emit(handle);
-    // lck.lock();
 
-    typeIndex.removeAtom(handle);
+    {
+        std::lock_guard<std::recursive_mutex> lck(shard.mtx);
+        shard.idx.removeAtom(handle);
+        shard.sample.removeAtom(handle);
+        shard.counts.remove(handle->get_type());
+        shard.lookup.remove(handle);
 
-    // Remove handle from other incoming sets.
-    handle->remove();
+        // Remove handle from other incoming sets.
+        handle->remove();
 
-    handle->setAtomSpace(nullptr);
+        handle->setAtomSpace(nullptr);
+    }
 
     result.insert(handle);
     return result;
@@ -451,6 +869,13 @@ HandleSet AtomTable::extract(Handle& handle, bool recursive)
 /// This is the resize callback, when a new type is dynamically added.
 void AtomTable::typeAdded(Type t)
 {
-    std::lock_guard<std::recursive_mutex> lck(_mtx);
-    typeIndex.resize();
+    TypeCounter::Ancestry anc(TypeCounter::make_ancestry(true));
+    for (size_t i = 0; i < _num_shards; i++)
+    {
+        IndexShard& shard = _shards[i];
+        std::lock_guard<std::recursive_mutex> lck(shard.mtx);
+        shard.idx.resize();
+        shard.sample.resize();
+        shard.counts.resize(anc);
+    }
 }
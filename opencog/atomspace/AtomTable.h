@@ -27,11 +27,12 @@
 
 #include <atomic>
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <set>
 #include <vector>
 
 #include <opencog/util/async_method_caller.h>
-#include <opencog/util/oc_omp.h>
 #include <opencog/util/RandGen.h>
 #include <opencog/util/sigslot.h>
 
@@ -39,7 +40,12 @@
 
 #include <opencog/atoms/atom_types/NameServer.h>
 
+#include <opencog/atomspace/LookupIndex.h>
+#include <opencog/atomspace/MemoryReport.h>
+#include <opencog/atomspace/SampleIndex.h>
+#include <opencog/atomspace/TypeCounter.h>
 #include <opencog/atomspace/TypeIndex.h>
+#include <opencog/atomspace/WorkPool.h>
 
 class AtomSpaceUTest;
 class AtomTableUTest;
@@ -51,6 +57,7 @@ namespace opencog
  */
 
 typedef SigSlot<const Handle&> AtomSignal;
+typedef SigSlot<const HandleSeq&> AtomSeqSignal;
 typedef SigSlot<const Handle&,
                 const TruthValuePtr&,
                 const TruthValuePtr&> TVCHSigl;
@@ -69,14 +76,75 @@ class AtomTable
     friend class ::AtomSpaceUTest;
 
 private:
-    // Single, global mutex for locking the indexes.
-    // Its recursive because we need to lock twice during atom insertion
-    // and removal: we need to keep the indexes stable while we search
-    // them during add/remove.
-    mutable std::recursive_mutex _mtx;
+    /**
+     * The index of atoms is striped into shards, so that threads
+     * inserting or looking up unrelated atoms do not contend for
+     * the same lock. An atom is assigned to a shard by its content
+     * hash (which already folds in the atom type), so that all
+     * copies of "the same" atom always land in the same shard, and
+     * the duplicate check during insertion only needs to lock that
+     * one shard.
+     *
+     * The shard mutexes are recursive, because the callbacks issued
+     * during iteration are allowed to add atoms to the table.
+     *
+     * Lookups by content do not take the lock at all; they go through
+     * a separate hash index that can be read concurrently with writes.
+     */
+    struct IndexShard
+    {
+        mutable std::recursive_mutex mtx;
+
+        //! Index of atoms in this shard.
+        TypeIndex idx;
+
+        //! Lock-free content-hash index of the same atoms. Updated
+        //! only while holding mtx.
+        LookupIndex lookup;
+
+        //! Dense per-type arrays of the same atoms, for sampling.
+        SampleIndex sample;
+
+        //! Number of atoms in this shard, by type and type subtree.
+        //! Readable without the lock.
+        TypeCounter counts;
+    };
+
+    //! Number of shards used by non-transient tables. Must be a
+    //! power of two. Transient tables use just one shard, as they
+    //! are small, short-lived, and almost never shared by threads.
+    static const size_t NUM_SHARDS = 16;
+
+    std::unique_ptr<IndexShard[]> _shards;
+    size_t _num_shards;
+
+    //! Position of the CLOCK hand of getColdAtoms(): a shard, a type,
+    //! and a place in the sample index of that type.
+    std::mutex _clock_mtx;
+    size_t _clock_shard;
+    Type _clock_type;
+    size_t _clock_pos;
+
+    size_t shard_index(ContentHash h) const
+    {
+        return (h ^ (h >> 32)) & (_num_shards - 1);
+    }
+    IndexShard& get_shard(ContentHash h) const
+    {
+        return _shards[shard_index(h)];
+    }
+    IndexShard& get_shard(const Handle& h) const
+    {
+        return get_shard(h->get_hash());
+    }
+
+    // Return true if some shard holds duplicated atoms (equal by
+    // content). Used during unit tests.
+    bool contains_duplicate() const;
 
-    //! Index of atoms.
-    TypeIndex typeIndex;
+    // Return true if a table closer than `env`, in the environment
+    // chain starting at this table, holds an atom equal to h.
+    bool shadowed(const Handle& h, const AtomTable* env) const;
 
     /// Parent environment for this table.  Null if top-level.
     /// This allows atomspaces to be nested; atoms in this atomspace
@@ -100,6 +168,7 @@ private:
 
     /** Provided signals */
     AtomSignal _addAtomSignal;
+    AtomSeqSignal _addAtomsSignal;
     AtomSignal _removeAtomSignal;
 
     /** Signal emitted when the TV changes. */
@@ -113,7 +182,20 @@ private:
     AtomTable(const AtomTable&) = delete;
 
     void clear_all_atoms();
+
+    // The steps of add(), split up so that add_atoms() can share them.
+    Handle do_add(const Handle&, bool force, bool fetched,
+                  HandleSeq* deferred);
+    Handle prepare_add(const Handle&, bool force, bool fetched,
+                       bool& found, HandleSeq* deferred);
+    Handle insert_locked(IndexShard&, const Handle&, bool fetched);
+    bool check_outgoing(const Handle&);
 public:
+    //! Number of strong references to an atom held by the table
+    //! itself; the TypeIndex holds the only one. The other indexes
+    //! hold raw pointers. Any more than this are held by someone
+    //! outside of the table.
+    static const long INDEX_REFS = 1;
 
     /**
      * Constructor and destructor for this class.
@@ -163,10 +245,36 @@ public:
      * Return the number of atoms contained in a table.
      */
     size_t getSize() const;
+    size_t getLocalSize() const;
     size_t getNumNodes() const;
     size_t getNumLinks() const;
     size_t getNumAtomsOfType(Type type, bool subclass=true) const;
 
+    /**
+     * Return the hash table statistics for the atoms in this table
+     * (not its environment). Walks every atom, under the shard locks;
+     * for debugging only.
+     */
+    HashStats getHashStats() const;
+
+    /**
+     * Return an estimate of the memory used by the atoms in this
+     * table (not its environment), by type. Types with more than
+     * `sample` atoms in a shard are sampled; pass zero to measure
+     * every atom.
+     */
+    MemoryReport getMemoryReport(size_t sample = 256) const;
+
+    /**
+     * Sweep a CLOCK hand over the atoms in this table (not its
+     * environment), clearing the recently-used bit of each atom that
+     * it passes, and returning those that did not have it set. Stops
+     * after `want` atoms are found, or `scan` atoms are passed; the
+     * next call picks up where this one stopped. Used to pick the
+     * atoms to evict from an AtomSpace that is over its budget.
+     */
+    HandleSeq getColdAtoms(size_t want, size_t scan);
+
     /**
      * Returns the exact atom for the given name and type.
      * Note: Type must inherit from NODE. Otherwise, it returns
@@ -194,16 +302,60 @@ public:
                        bool subclass=false,
                        bool parent=true) const
     {
-        std::lock_guard<std::recursive_mutex> lck(_mtx);
-        auto tit = typeIndex.begin(type, subclass);
-        auto tend = typeIndex.end();
-        while (tit != tend) { hset.insert(*tit); tit++; }
+        for (size_t i = 0; i < _num_shards; i++)
+        {
+            const IndexShard& shard = _shards[i];
+            std::lock_guard<std::recursive_mutex> lck(shard.mtx);
+            auto tit = shard.idx.begin(type, subclass);
+            auto tend = shard.idx.end();
+            while (tit != tend) { hset.insert(*tit); tit++; }
+        }
         // If an atom is already in the set, it will hide any duplicate
         // atom in the parent.
         if (parent and _environ)
             _environ->getHandleSetByType(hset, type, subclass, parent);
     }
 
+    /**
+     * Calls function 'func' on each atom of the given type, until
+     * func returns true. If `parent` is set, then the atoms in the
+     * environment tables are visited too, except those hidden by an
+     * equal atom in a closer table. Hidden atoms are found with a
+     * hash lookup, so nothing gets copied into a set; only one shard
+     * at a time is copied out, so that func runs with no locks held,
+     * and is free to add and remove atoms.
+     *
+     * @return true if func ended the iteration early.
+     */
+    template <typename Function> bool
+    visitHandlesByType(Function func,
+                       Type type,
+                       bool subclass=false,
+                       bool parent=true) const
+    {
+        HandleSeq hseq;
+        for (const AtomTable* env = this; env; env = env->_environ)
+        {
+            for (size_t i = 0; i < env->_num_shards; i++)
+            {
+                {
+                    const IndexShard& shard = env->_shards[i];
+                    std::lock_guard<std::recursive_mutex> lck(shard.mtx);
+                    std::copy(shard.idx.begin(type, subclass),
+                              shard.idx.end(), back_inserter(hseq));
+                }
+                for (const Handle& h : hseq)
+                {
+                    if (env != this and shadowed(h, env)) continue;
+                    if (func(h)) return true;
+                }
+                hseq.clear();
+            }
+            if (not parent) break;
+        }
+        return false;
+    }
+
     /**
      * Returns the set of atoms of a given type (subclasses optionally).
      *
@@ -217,19 +369,13 @@ public:
                      bool subclass=false,
                      bool parent=true) const
     {
-        // If parent wanted, and parent exists, then we must use the
-        // handleset to disambiguate results.  This causes an extra
-        // copy of the handles, unfortunately.
-        if (parent and _environ) {
-           HandleSet hset;
-           getHandleSetByType(hset, type, subclass, parent);
-           return std::copy(hset.begin(), hset.end(), result);
-        }
-
-        // No parent ... avoid the copy above.
-        std::lock_guard<std::recursive_mutex> lck(_mtx);
-        return std::copy(typeIndex.begin(type, subclass),
-                         typeIndex.end(), result);
+        visitHandlesByType(
+            [&](const Handle& h)->bool {
+                *result++ = h;
+                return false;
+            },
+            type, subclass, parent);
+        return result;
     }
 
     /** Calls function 'func' on all atoms */
@@ -239,69 +385,34 @@ public:
                         bool subclass=false,
                         bool parent=true) const
     {
-        // If parent wanted, and parent exists, then we must use the
-        // handleset to disambiguate results.  This causes an extra
-        // copy of the handles, unfortunately.
-        if (parent and _environ) {
-           HandleSet hset;
-           getHandleSetByType(hset, type, subclass, parent);
-           std::for_each(hset.begin(), hset.end(),
-                [&](const Handle& h)->void {
-                     (func)(h);
-                });
-           return;
-        }
-
-        // No parent ... avoid the copy above.
-        // This can (will) deadlock if func touches the table.
-        std::lock_guard<std::recursive_mutex> lck(_mtx);
-        std::for_each(typeIndex.begin(type, subclass),
-                      typeIndex.end(),
-             [&](const Handle& h)->void {
-                  (func)(h);
-             });
+        visitHandlesByType(
+            [&](const Handle& h)->bool {
+                (func)(h);
+                return false;
+            },
+            type, subclass, parent);
     }
 
+    /**
+     * Calls function 'func' on all atoms of the given type, in
+     * parallel, on the threads of the work_pool(). The atoms are
+     * snapshotted first, and no lock is held while func runs, so
+     * func may add atoms and set values; atoms added meanwhile are
+     * not visited.
+     */
     template <typename Function> void
     foreachParallelByType(Function func,
-                        Type type,
-                        bool subclass=false,
-                        bool parent=true) const
+                          Type type,
+                          bool subclass=false,
+                          bool parent=true) const
     {
-        // If parent wanted, and parent exists, then we must use the
-        // handleset to disambiguate results.  This causes an extra
-        // copy of the handles, unfortunately.
-        if (parent and _environ) {
-           HandleSet hset;
-           getHandleSetByType(hset, type, subclass, parent);
-
-           // Parallelize, always, no matter what!
-           opencog::setting_omp(opencog::num_threads(), 1);
-
-           OMP_ALGO::for_each(hset.begin(), hset.end(),
-                [&](const Handle& h)->void {
-                     (func)(h);
-                });
-
-           // Reset to default.
-           opencog::setting_omp(opencog::num_threads());
-           return;
-        }
+        HandleSeq hseq;
+        getHandlesByType(back_inserter(hseq), type, subclass, parent);
 
-        // No parent ... avoid the copy above.
-        // This can (will) deadlock if func touches the table.
-        std::lock_guard<std::recursive_mutex> lck(_mtx);
-        // Parallelize, always, no matter what!
-        opencog::setting_omp(opencog::num_threads(), 1);
-
-        OMP_ALGO::for_each(typeIndex.begin(type, subclass),
-                      typeIndex.end(),
-             [&](const Handle& h)->void {
-                  (func)(h);
-             });
-
-        // Reset to default.
-        opencog::setting_omp(opencog::num_threads());
+        work_pool().for_each(hseq.size(),
+            [&](size_t i)->void {
+                (func)(hseq[i]);
+            });
     }
 
     /**
@@ -310,10 +421,32 @@ public:
      * The `force` flag forces the addition of this atom into the
      * atomtable, even if it is already in a parent atomspace.
      *
+     * The `fetched` flag is for backing stores: the atom was just
+     * loaded, with all of its values, and so the atoms that are new
+     * to the table are left clean, rather than being marked dirty.
+     * They need not be written back, unless they are changed.
+     *
      * @param The new atom to be added.
      * @return The handle of the newly added atom.
      */
-    Handle add(const Handle&, bool force=false);
+    Handle add(const Handle&, bool force=false, bool fetched=false);
+
+    /**
+     * Adds a batch of atoms to the table.
+     *
+     * This is equivalent to calling add() on each atom in turn, but
+     * is much cheaper for large batches: duplicates within the batch
+     * are found in a single pass, each shard is locked just once for
+     * the whole batch, and the added-atom signals are deferred until
+     * the entire batch is in the table. After the per-atom signals,
+     * the atomsAddedSignal() is emitted once, with all of the atoms
+     * that were actually added (i.e. not already in the table).
+     *
+     * @param The atoms to be added.
+     * @return The atoms in the table, in the same order as the
+     *         arguments; equal atoms yield the same handle.
+     */
+    HandleSeq add_atoms(const HandleSeq&, bool force=false);
 
     /**
      * Read-write synchronization barrier fence.  When called, this
@@ -351,7 +484,22 @@ public:
      */
     Handle getRandom(RandGen* rng) const;
 
+    /**
+     * Return k atoms of the given type, drawn uniformly at random,
+     * with replacement, from this table and its environments. The
+     * cost does not depend on the number of atoms in the table, only
+     * on the number of types being sampled from; so it pays to ask
+     * for many atoms at once.
+     *
+     * Fewer than k atoms are returned only if atoms are being
+     * extracted while sampling is in progress, or if there are no
+     * atoms of the type.
+     */
+    HandleSeq getRandom(RandGen* rng, size_t k,
+                        Type type=ATOM, bool subclass=true) const;
+
     AtomSignal& atomAddedSignal() { return _addAtomSignal; }
+    AtomSeqSignal& atomsAddedSignal() { return _addAtomsSignal; }
     AtomSignal& atomRemovedSignal() { return _removeAtomSignal; }
 
     /** Provide ability for others to find out about TV changes */
@@ -37,3 +37,64 @@ void BackingStore::unregisterWith(AtomSpace* atomspace)
 {
 	atomspace->unregisterBackingStore(this);
 }
+
+/* ================================================================ */
+// Default batched and non-blocking calls: loop over the singular ones.
+
+HandleSeq BackingStore::getAtoms(const HandleSeq& atoms)
+{
+	HandleSeq found;
+	found.reserve(atoms.size());
+	for (const Handle& h : atoms)
+	{
+		if (nullptr == h)
+			found.emplace_back(Handle());
+		else if (h->is_node())
+			found.emplace_back(getNode(h->get_type(),
+			                           h->get_name().c_str()));
+		else
+			found.emplace_back(getLink(h->get_type(),
+			                           h->getOutgoingSet()));
+	}
+	return found;
+}
+
+void BackingStore::getIncomingSets(AtomTable& table, const HandleSeq& atoms)
+{
+	for (const Handle& h : atoms)
+		getIncomingSet(table, h);
+}
+
+void BackingStore::storeAtoms(const HandleSeq& atoms, bool synchronous)
+{
+	for (const Handle& h : atoms)
+		storeAtom(h, synchronous);
+}
+
+std::future<HandleSeq> BackingStore::getAtomsAsync(const HandleSeq& atoms)
+{
+	return std::async(std::launch::async,
+		[this, atoms]() { return getAtoms(atoms); });
+}
+
+std::future<void> BackingStore::getIncomingSetsAsync(AtomTable& table,
+                                                     const HandleSeq& atoms)
+{
+	return std::async(std::launch::async,
+		[this, &table, atoms]() { getIncomingSets(table, atoms); });
+}
+
+std::future<void> BackingStore::storeAtomsAsync(const HandleSeq& atoms)
+{
+	return std::async(std::launch::async,
+		[this, atoms]() { storeAtoms(atoms, true); });
+}
+
+void BackingStore::releaseAtoms(const HandleSeq&)
+{
+}
+
+bool BackingStore::supportsEviction(void) const
+{
+	return true;
+}
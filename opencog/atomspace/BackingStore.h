@@ -24,6 +24,7 @@
 #ifndef _OPENCOG_BACKING_STORE_H
 #define _OPENCOG_BACKING_STORE_H
 
+#include <future>
 #include <set>
 
 #include <opencog/atoms/base/Atom.h>
@@ -123,6 +124,62 @@ class BackingStore
 		 */
 		virtual void barrier() = 0;
 
+		// ---------------------------------------------------------
+		// Batched and non-blocking variants of the above. Backends
+		// that can do better than one atom at a time should override
+		// these; the defaults just loop over the singular calls.
+
+		/**
+		 * Fetch many atoms at once. The i'th entry of the result is
+		 * what getNode() or getLink() would return for the i'th atom:
+		 * the atom, with all of its values, or nullptr if the backing
+		 * store does not have it.
+		 */
+		virtual HandleSeq getAtoms(const HandleSeq&);
+
+		/**
+		 * Put the incoming sets of all of the atoms into the atom
+		 * table, together with the values on the incoming links,
+		 * as getIncomingSet() does for one atom.
+		 */
+		virtual void getIncomingSets(AtomTable&, const HandleSeq&);
+
+		/**
+		 * Store many atoms, and all of their values, at once; see
+		 * storeAtom().
+		 */
+		virtual void storeAtoms(const HandleSeq&, bool synchronous = false);
+
+		/**
+		 * Non-blocking versions of getAtoms(), getIncomingSets() and
+		 * storeAtoms(). The future becomes ready when the work is
+		 * done; any exception is delivered through it. The atom table
+		 * passed to getIncomingSetsAsync() must outlive the future.
+		 * The defaults run the batched call in another thread.
+		 */
+		virtual std::future<HandleSeq> getAtomsAsync(const HandleSeq&);
+		virtual std::future<void> getIncomingSetsAsync(AtomTable&,
+		                                               const HandleSeq&);
+		virtual std::future<void> storeAtomsAsync(const HandleSeq&);
+
+		/**
+		 * The atomspace has evicted these atoms from RAM, after
+		 * making sure that the backing store has them. Backends that
+		 * keep references to atoms (e.g. to map them to database
+		 * keys) should drop them, so that the memory can be freed.
+		 * The default does nothing.
+		 */
+		virtual void releaseAtoms(const HandleSeq&);
+
+		/**
+		 * Whether an atomspace with a budget may evict to this
+		 * backing store. Eviction stores atoms a few at a time,
+		 * and calls barrier() after each sweep; backends for which
+		 * that is very slow should return false. The default is
+		 * true.
+		 */
+		virtual bool supportsEviction(void) const;
+
 		/**
 		 * Register this backing store with the atomspace.
 		 */
@@ -0,0 +1,197 @@
+/*
+ * opencog/atomspace/Epoch.cc
+ *
+ * Copyright (C) 2019 OpenCog Foundation
+ * All Rights Reserved
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <thread>
+#include <vector>
+
+#include "Epoch.h"
+
+using namespace opencog;
+
+// Collect after this many retirements. Small enough to keep the
+// limbo list short, large enough to amortize the scan of the records.
+#define COLLECT_INTERVAL 128
+
+// Collect right away when this much is waiting, no matter how recently
+// the last collection was. This bounds the limbo list, when a reader
+// holds up a collection, or when large objects are retired.
+#define MAX_LIMBO_SIZE 4096
+#define MAX_LIMBO_BYTES (64UL * 1024UL * 1024UL)
+
+namespace {
+
+// Give the record back when the thread exits, so that the next
+// thread can reuse it.
+struct RecordHolder
+{
+    EpochManager::Record* rec = nullptr;
+    ~RecordHolder()
+    {
+        if (nullptr == rec) return;
+        rec->nest = 0;
+        rec->epoch.store(0);
+        rec->in_use.store(false);
+    }
+};
+
+static thread_local RecordHolder _holder;
+
+}
+
+EpochManager::EpochManager() :
+    _global_epoch(1),
+    _records(nullptr),
+    _limbo_bytes(0),
+    _retired_since_collect(0)
+{
+}
+
+/// Return the record for the calling thread, claiming one on first use.
+EpochManager::Record* EpochManager::my_record()
+{
+    if (_holder.rec) return _holder.rec;
+
+    // Try to reuse a record left behind by some thread that exited.
+    for (Record* r = _records.load(); r; r = r->next)
+    {
+        bool expect = false;
+        if (r->in_use.compare_exchange_strong(expect, true))
+        {
+            _holder.rec = r;
+            return r;
+        }
+    }
+
+    // None free; make a new one, and push it onto the list.
+    Record* r = new Record();
+    r->epoch.store(0);
+    r->in_use.store(true);
+    r->nest = 0;
+    r->next = _records.load();
+    while (not _records.compare_exchange_weak(r->next, r)) {}
+
+    _holder.rec = r;
+    return r;
+}
+
+void EpochManager::enter()
+{
+    Record* r = my_record();
+    if (0 < r->nest++) return;
+
+    // Sequentially-consistent, so that the announcement is visible
+    // before any of the reads that follow it.
+    r->epoch.store(_global_epoch.load());
+}
+
+void EpochManager::leave()
+{
+    Record* r = my_record();
+    if (0 < --r->nest) return;
+    r->epoch.store(0, std::memory_order_release);
+}
+
+void EpochManager::retire(std::shared_ptr<void> obj, size_t bytes)
+{
+    bool need_collect = false;
+    {
+        std::lock_guard<std::mutex> lck(_limbo_mtx);
+        _limbo.push_back({_global_epoch.load(), bytes, std::move(obj)});
+        _limbo_bytes += bytes;
+        if (COLLECT_INTERVAL <= ++_retired_since_collect or
+            MAX_LIMBO_SIZE <= _limbo.size() or
+            MAX_LIMBO_BYTES <= _limbo_bytes)
+        {
+            _retired_since_collect = 0;
+            need_collect = true;
+        }
+    }
+    if (need_collect) collect();
+}
+
+/// An object retired in epoch e is unreachable to any reader that
+/// entered in a later epoch. So, advance the epoch, find the oldest
+/// epoch that some reader is still in, and release everything that
+/// was retired before that.
+void EpochManager::collect()
+{
+    // Release outside of the lock; the destructors may be slow,
+    // and might even retire more stuff.
+    std::vector<std::shared_ptr<void>> garbage;
+    {
+        std::lock_guard<std::mutex> lck(_limbo_mtx);
+        _retired_since_collect = 0;
+        uint64_t oldest = _global_epoch.fetch_add(1) + 1;
+        for (Record* r = _records.load(); r; r = r->next)
+        {
+            uint64_t e = r->epoch.load();
+            if (0 < e and e < oldest) oldest = e;
+        }
+
+        while (not _limbo.empty() and _limbo.front().epoch < oldest)
+        {
+            _limbo_bytes -= _limbo.front().bytes;
+            garbage.emplace_back(std::move(_limbo.front().obj));
+            _limbo.pop_front();
+        }
+    }
+}
+
+/// Same argument as in collect(): once the epoch is advanced, any
+/// reader that enters afterwards cannot see what was unlinked before.
+/// So, only the readers that entered in an earlier epoch need to be
+/// waited on. They never block, so the wait is short.
+void EpochManager::synchronize()
+{
+    Record* self = _holder.rec;
+    uint64_t target = _global_epoch.fetch_add(1) + 1;
+    for (Record* r = _records.load(); r; r = r->next)
+    {
+        if (r == self) continue;
+        while (true)
+        {
+            uint64_t e = r->epoch.load();
+            if (0 == e or target <= e) break;
+            std::this_thread::yield();
+        }
+    }
+}
+
+size_t EpochManager::pending()
+{
+    std::lock_guard<std::mutex> lck(_limbo_mtx);
+    return _limbo.size();
+}
+
+size_t EpochManager::pending_bytes()
+{
+    std::lock_guard<std::mutex> lck(_limbo_mtx);
+    return _limbo_bytes;
+}
+
+/// The process-wide manager. It is never destroyed, so that atom
+/// tables torn down during static destruction can still retire.
+EpochManager& opencog::epoch_manager()
+{
+    static EpochManager* _mgr = new EpochManager();
+    return *_mgr;
+}
@@ -0,0 +1,136 @@
+/*
+ * opencog/atomspace/Epoch.h
+ *
+ * Copyright (C) 2019 OpenCog Foundation
+ * All Rights Reserved
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _OPENCOG_EPOCH_H
+#define _OPENCOG_EPOCH_H
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+
+namespace opencog
+{
+/** \addtogroup grp_atomspace
+ *  @{
+ */
+
+/**
+ * Epoch-based memory reclamation, for data structures that are read
+ * without taking any locks.
+ *
+ * Readers bracket their accesses with an EpochGuard; this costs one
+ * store on entry and one on exit, and never blocks. Writers (who
+ * still serialize among themselves, with ordinary locks) first unlink
+ * an object, so that new readers cannot find it, and then retire()
+ * it, instead of freeing it. Retired objects are released only after
+ * every reader that might still be looking at them has left its
+ * critical section.
+ *
+ * Retired objects are held as shared_ptr<void>, so that atoms (which
+ * are reference counted anyway) and raw arrays can be retired alike.
+ * Use the process-wide instance returned by epoch_manager().
+ */
+class EpochManager
+{
+public:
+    // One record per thread that has ever read under a guard.
+    // Records are recycled when threads exit, but never freed.
+    struct Record
+    {
+        // Epoch in which the thread entered; zero when quiescent.
+        std::atomic<uint64_t> epoch;
+        std::atomic<bool> in_use;
+        // Nesting depth of guards; touched only by the owning thread.
+        unsigned nest;
+        Record* next;
+    };
+
+private:
+    std::atomic<uint64_t> _global_epoch;
+    std::atomic<Record*> _records;
+
+    struct Retired
+    {
+        uint64_t epoch;
+        size_t bytes;
+        std::shared_ptr<void> obj;
+    };
+
+    std::mutex _limbo_mtx;
+    std::deque<Retired> _limbo;
+    size_t _limbo_bytes;
+    size_t _retired_since_collect;
+
+    Record* my_record();
+
+    EpochManager(const EpochManager&) = delete;
+    EpochManager& operator=(const EpochManager&) = delete;
+
+public:
+    EpochManager();
+
+    /// Enter and leave a read-side critical section.
+    /// Nested entries are allowed.
+    void enter();
+    void leave();
+
+    /// Hand over an object that has been made unreachable to new
+    /// readers. It is released once all current readers are done.
+    /// The size, in bytes, is only used to bound the amount of
+    /// memory waiting to be released.
+    void retire(std::shared_ptr<void>, size_t bytes = 0);
+
+    /// Release whatever can be released. This is called by retire()
+    /// every now and then, and whenever too much is waiting; and so
+    /// there is rarely a need to call it directly.
+    void collect();
+
+    /// Wait until every reader that might have seen something that
+    /// was unlinked before this call has left its critical section.
+    /// After this returns, the unlinked objects may be freed right
+    /// away, without being retired. The calling thread's own guard,
+    /// if any, is not waited for.
+    void synchronize();
+
+    /// Number of objects waiting to be released, and their size.
+    size_t pending();
+    size_t pending_bytes();
+};
+
+EpochManager& epoch_manager();
+
+/// RAII read-side critical section.
+class EpochGuard
+{
+public:
+    EpochGuard() { epoch_manager().enter(); }
+    ~EpochGuard() { epoch_manager().leave(); }
+
+    EpochGuard(const EpochGuard&) = delete;
+    EpochGuard& operator=(const EpochGuard&) = delete;
+};
+
+/** @}*/
+} //namespace opencog
+
+#endif // _OPENCOG_EPOCH_H
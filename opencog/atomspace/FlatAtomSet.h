@@ -0,0 +1,251 @@
+/*
+ * opencog/atomspace/FlatAtomSet.h
+ *
+ * Copyright (C) 2019 OpenCog Foundation
+ * All Rights Reserved
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _OPENCOG_FLAT_ATOM_SET_H
+#define _OPENCOG_FLAT_ATOM_SET_H
+
+#include <utility>
+#include <vector>
+
+#include <opencog/atoms/base/Atom.h>
+#include <opencog/atoms/base/Handle.h>
+
+namespace opencog
+{
+/** \addtogroup grp_atomspace
+ *  @{
+ */
+
+/**
+ * Open-addressing hash table of atoms, keyed by content hash.
+ *
+ * This is a drop-in alternative to std::unordered_multimap for the
+ * TypeIndex. The (hash, Handle) pairs are stored inline, in a single
+ * flat array, so there is no heap node per atom, and a lookup touches
+ * one or two cache lines instead of chasing a bucket chain. Collisions
+ * are resolved with Robin Hood linear probing, and removal uses
+ * backward-shift deletion, so there are no tombstones, and probe
+ * sequences stay short even at a high load factor.
+ *
+ * Empty slots are those holding a null Handle. Insertion and removal
+ * both move entries around, and so invalidate all iterators; to remove
+ * while iterating, collect the atoms first.
+ */
+class FlatAtomSet
+{
+	public:
+		typedef std::pair<ContentHash, Handle> value_type;
+
+	private:
+		std::vector<value_type> _slots;
+		size_t _size;
+
+		size_t mask(void) const { return _slots.size() - 1; }
+
+		// Distance of the entry at pos from its home slot.
+		size_t distance(size_t pos, ContentHash h) const
+		{
+			return (pos - (h & mask())) & mask();
+		}
+
+		void place(value_type&& v)
+		{
+			size_t pos = v.first & mask();
+			size_t dist = 0;
+			while (true)
+			{
+				value_type& s = _slots[pos];
+				if (nullptr == s.second)
+				{
+					s = std::move(v);
+					return;
+				}
+
+				// Take from the rich, give to the poor: whoever is
+				// closer to home gives up the slot.
+				size_t sdist = distance(pos, s.first);
+				if (sdist < dist)
+				{
+					std::swap(s, v);
+					dist = sdist;
+				}
+				pos = (pos + 1) & mask();
+				dist++;
+			}
+		}
+
+		void grow(void)
+		{
+			std::vector<value_type> old;
+			old.swap(_slots);
+			_slots.resize(old.empty() ? 16 : 2 * old.size());
+			for (value_type& v : old)
+				if (nullptr != v.second) place(std::move(v));
+		}
+
+		// Position of the atom equal (by content) to h, or npos.
+		size_t locate(const Handle& h) const
+		{
+			if (0 == _size) return npos;
+			ContentHash hv = h->get_hash();
+			size_t pos = hv & mask();
+			size_t dist = 0;
+			while (true)
+			{
+				const value_type& s = _slots[pos];
+				if (nullptr == s.second) return npos;
+
+				// If we got further from home than the resident,
+				// then the atom would have displaced it. Not here.
+				if (distance(pos, s.first) < dist) return npos;
+
+				if (s.first == hv and *h == *s.second) /* content-compare */
+					return pos;
+				pos = (pos + 1) & mask();
+				dist++;
+			}
+		}
+
+		template<typename V, typename P>
+		class iter
+		{
+			friend class FlatAtomSet;
+			P _p;
+			P _end;
+			void skip(void)
+			{
+				while (_p != _end and nullptr == _p->second) ++_p;
+			}
+			iter(P p, P e) : _p(p), _end(e) { skip(); }
+		public:
+			iter() : _p(nullptr), _end(nullptr) {}
+			V& operator*(void) const { return *_p; }
+			V* operator->(void) const { return &(*_p); }
+			iter& operator++(void) { ++_p; skip(); return *this; }
+			iter operator++(int) { iter tmp(*this); ++(*this); return tmp; }
+			bool operator==(const iter& o) const { return _p == o._p; }
+			bool operator!=(const iter& o) const { return _p != o._p; }
+		};
+
+	public:
+		static const size_t npos = (size_t) -1;
+
+		typedef iter<value_type, value_type*> iterator;
+		typedef iter<const value_type, const value_type*> const_iterator;
+
+		FlatAtomSet(void) : _size(0) {}
+		FlatAtomSet(FlatAtomSet&& o) noexcept
+			: _slots(std::move(o._slots)), _size(o._size) { o._size = 0; }
+		FlatAtomSet& operator=(FlatAtomSet&& o) noexcept
+		{
+			_slots = std::move(o._slots);
+			_size = o._size;
+			o._size = 0;
+			return *this;
+		}
+		FlatAtomSet(const FlatAtomSet&) = delete;
+		FlatAtomSet& operator=(const FlatAtomSet&) = delete;
+
+		size_t size(void) const { return _size; }
+		bool empty(void) const { return 0 == _size; }
+		size_t bucket_count(void) const { return _slots.size(); }
+
+		/// Call f(hash, probes) for each entry, where probes is the
+		/// number of slots that a lookup of that entry looks at.
+		template<typename F>
+		void foreach_probe(F f) const
+		{
+			for (size_t pos = 0; pos < _slots.size(); pos++)
+			{
+				const value_type& s = _slots[pos];
+				if (nullptr == s.second) continue;
+				f(s.first, distance(pos, s.first) + 1);
+			}
+		}
+
+		/// Insert. Duplicates are not checked for; the caller does that.
+		void insert(value_type v)
+		{
+			// Keep the load factor under 7/8.
+			if (8 * (_size + 1) > 7 * _slots.size()) grow();
+			place(std::move(v));
+			_size++;
+		}
+
+		/// Return the atom equal (by content) to h, if any.
+		Handle find(const Handle& h) const
+		{
+			size_t pos = locate(h);
+			if (npos == pos) return Handle::UNDEFINED;
+			return _slots[pos].second;
+		}
+
+		/// Remove the atom equal (by content) to h, if any.
+		void remove(const Handle& h)
+		{
+			size_t pos = locate(h);
+			if (npos == pos) return;
+
+			// Shift the rest of the cluster back by one, until an
+			// empty slot, or an entry that is already at home.
+			size_t next = (pos + 1) & mask();
+			while (nullptr != _slots[next].second and
+			       0 < distance(next, _slots[next].first))
+			{
+				_slots[pos] = std::move(_slots[next]);
+				pos = next;
+				next = (next + 1) & mask();
+			}
+			_slots[pos].second = Handle::UNDEFINED;
+			_size--;
+		}
+
+		void clear(void)
+		{
+			std::vector<value_type>().swap(_slots);
+			_size = 0;
+		}
+
+		iterator begin(void)
+		{
+			return iterator(_slots.data(), _slots.data() + _slots.size());
+		}
+		iterator end(void)
+		{
+			value_type* e = _slots.data() + _slots.size();
+			return iterator(e, e);
+		}
+		const_iterator begin(void) const
+		{
+			return const_iterator(_slots.data(), _slots.data() + _slots.size());
+		}
+		const_iterator end(void) const
+		{
+			const value_type* e = _slots.data() + _slots.size();
+			return const_iterator(e, e);
+		}
+};
+
+/** @}*/
+} //namespace opencog
+
+#endif // _OPENCOG_FLAT_ATOM_SET_H
@@ -0,0 +1,193 @@
+/*
+ * opencog/atomspace/LookupIndex.cc
+ *
+ * Copyright (C) 2019 OpenCog Foundation
+ * All Rights Reserved
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "Epoch.h"
+#include "LookupIndex.h"
+
+using namespace opencog;
+
+// Must be a power of two.
+#define MIN_TABLE_SIZE 16
+
+// A note about memory ordering: the slot hash is written before the
+// atom pointer is published, and read after it is loaded. Atom pointer
+// loads and stores are sequentially consistent; that is what makes the
+// epoch argument work (an unlinked atom cannot be seen by a reader that
+// entered after it was retired). On x86, these loads are plain moves.
+
+LookupIndex::Table::Table(size_t n)
+{
+	mask = n - 1;
+	slots = new Slot[n];
+	for (size_t i = 0; i < n; i++)
+	{
+		slots[i].hash.store(0, std::memory_order_relaxed);
+		slots[i].atom.store(nullptr, std::memory_order_relaxed);
+	}
+}
+
+LookupIndex::Table::~Table()
+{
+	delete[] slots;
+}
+
+LookupIndex::LookupIndex(void) :
+	_table(new Table(MIN_TABLE_SIZE)),
+	_live(0),
+	_used(0)
+{
+}
+
+LookupIndex::~LookupIndex()
+{
+	// No one can be reading any more; the table is going away.
+	delete _table.load();
+
+	// Release whatever this table retired while it was in use,
+	// instead of waiting for unrelated removals to get around to it.
+	epoch_manager().collect();
+}
+
+Handle LookupIndex::find(const Handle& h) const
+{
+	const Table* t = _table.load();
+	ContentHash hv = h->get_hash();
+	size_t i = hv & t->mask;
+	for (size_t n = 0; n <= t->mask; n++)
+	{
+		const Slot& s = t->slots[i];
+		Atom* a = s.atom.load();
+		if (nullptr == a) break;
+		if (tombstone() != a and
+		    s.hash.load(std::memory_order_relaxed) == hv and
+		    *a == *h) /* content-compare */
+			return a->get_handle();
+		i = (i + 1) & t->mask;
+	}
+	return Handle::UNDEFINED;
+}
+
+void LookupIndex::insert(const Handle& h)
+{
+	Table* t = _table.load(std::memory_order_relaxed);
+
+	// Keep the load factor under 3/4, counting tombstones.
+	if (4 * (_used + 1) > 3 * (t->mask + 1))
+	{
+		rehash(_live + 1);
+		t = _table.load(std::memory_order_relaxed);
+	}
+
+	ContentHash hv = h->get_hash();
+	size_t i = hv & t->mask;
+	while (true)
+	{
+		Slot& s = t->slots[i];
+		Atom* a = s.atom.load(std::memory_order_relaxed);
+		if (nullptr == a or tombstone() == a)
+		{
+			if (nullptr == a) _used++;
+			s.hash.store(hv, std::memory_order_relaxed);
+			s.atom.store(h.get());
+			_live++;
+			return;
+		}
+		i = (i + 1) & t->mask;
+	}
+}
+
+void LookupIndex::remove(const Handle& h)
+{
+	Table* t = _table.load(std::memory_order_relaxed);
+	size_t i = h->get_hash() & t->mask;
+	for (size_t n = 0; n <= t->mask; n++)
+	{
+		Slot& s = t->slots[i];
+		Atom* a = s.atom.load(std::memory_order_relaxed);
+		if (nullptr == a) return;
+		if (h.get() == a)
+		{
+			s.atom.store(tombstone());
+			_live--;
+
+			// Readers may still be looking at the atom.
+			epoch_manager().retire(h, sizeof(Atom));
+			return;
+		}
+		i = (i + 1) & t->mask;
+	}
+}
+
+size_t LookupIndex::bytes(void) const
+{
+	const Table* t = _table.load(std::memory_order_relaxed);
+	return sizeof(Table) + (t->mask + 1) * sizeof(Slot);
+}
+
+/// Copy the live atoms into a fresh table, sized to hold at least
+/// `need` atoms, dropping the tombstones along the way.
+void LookupIndex::rehash(size_t need)
+{
+	size_t sz = MIN_TABLE_SIZE;
+	while (3 * sz < 4 * need + 4) sz <<= 1;
+	// Leave room to grow, so that a table that is filling up does
+	// not get rehashed over and over.
+	if (sz < 2 * need) sz <<= 1;
+
+	Table* old = _table.load(std::memory_order_relaxed);
+	Table* fresh = new Table(sz);
+	for (size_t j = 0; j <= old->mask; j++)
+	{
+		Atom* a = old->slots[j].atom.load(std::memory_order_relaxed);
+		if (nullptr == a or tombstone() == a) continue;
+
+		ContentHash hv = old->slots[j].hash.load(std::memory_order_relaxed);
+		size_t i = hv & fresh->mask;
+		while (nullptr != fresh->slots[i].atom.load(std::memory_order_relaxed))
+			i = (i + 1) & fresh->mask;
+		fresh->slots[i].hash.store(hv, std::memory_order_relaxed);
+		fresh->slots[i].atom.store(a, std::memory_order_relaxed);
+	}
+	_used = _live;
+
+	_table.store(fresh);
+	epoch_manager().retire(std::shared_ptr<void>(old,
+		[](Table* p) { delete p; }), (old->mask + 1) * sizeof(Slot));
+}
+
+/// Empty the index. The atoms themselves are about to be dropped by
+/// the TypeIndex, so rather than keeping them alive in limbo, wait
+/// out the readers that might still be looking at the old table, and
+/// then free it right away.
+void LookupIndex::clear(void)
+{
+	Table* old = _table.load(std::memory_order_relaxed);
+	_table.store(new Table(MIN_TABLE_SIZE));
+	_live = 0;
+	_used = 0;
+
+	epoch_manager().synchronize();
+	delete old;
+
+	// Also release anything retired earlier, e.g. by remove().
+	epoch_manager().collect();
+}
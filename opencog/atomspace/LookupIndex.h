@@ -0,0 +1,113 @@
+/*
+ * opencog/atomspace/LookupIndex.h
+ *
+ * Copyright (C) 2019 OpenCog Foundation
+ * All Rights Reserved
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _OPENCOG_LOOKUP_INDEX_H
+#define _OPENCOG_LOOKUP_INDEX_H
+
+#include <atomic>
+
+#include <opencog/atoms/base/Atom.h>
+#include <opencog/atoms/base/Handle.h>
+
+namespace opencog
+{
+/** \addtogroup grp_atomspace
+ *  @{
+ */
+
+/**
+ * Content-hash index of atoms that can be searched without locking.
+ *
+ * This is an open-addressing (linear probing) hash table of raw atom
+ * pointers. Readers never block: they only need to be inside an
+ * EpochGuard while calling find(). Writers must be serialized by the
+ * caller (the AtomTable does this with the shard lock). Removed atoms,
+ * and the old slot arrays left behind when the table grows, are handed
+ * to the epoch manager, so that they stay valid until no reader can
+ * be looking at them. Clearing the index waits for the readers
+ * instead, so that a cleared table does not linger in limbo.
+ *
+ * This index does not own the atoms; the TypeIndex does. It only holds
+ * enough to turn a content hash into an atom. This duplicates the
+ * content index inside the TypeIndex, at a cost of 16 bytes per slot:
+ * the table doubles when it is 3/4 full, so that a growing table
+ * costs between 21 and 43 bytes per atom. Removals can leave it
+ * sparser, until the next rehash. See bytes(), and the lookup index
+ * line of the MemoryReport.
+ */
+class LookupIndex
+{
+	private:
+		struct Slot
+		{
+			std::atomic<ContentHash> hash;
+			std::atomic<Atom*> atom;
+		};
+
+		struct Table
+		{
+			size_t mask;
+			Slot* slots;
+			Table(size_t);
+			~Table();
+		};
+
+		std::atomic<Table*> _table;
+
+		// Number of atoms, and number of non-empty slots (atoms plus
+		// tombstones). Only writers touch these.
+		size_t _live;
+		size_t _used;
+
+		void rehash(size_t);
+
+		static Atom* tombstone(void)
+		{
+			return reinterpret_cast<Atom*>(1);
+		}
+
+		LookupIndex(const LookupIndex&) = delete;
+		LookupIndex& operator=(const LookupIndex&) = delete;
+
+	public:
+		LookupIndex(void);
+		~LookupIndex();
+
+		/// Return the atom having the same content as h, if any.
+		/// Lock-free; the caller must be holding an EpochGuard.
+		Handle find(const Handle& h) const;
+
+		/// Writers only; the caller must serialize these.
+		void insert(const Handle&);
+		void remove(const Handle&);
+		void clear(void);
+
+		size_t size(void) const { return _live; }
+
+		/// Bytes held by the slot array. Writers only, like the above.
+		size_t bytes(void) const;
+};
+
+/** @}*/
+} //namespace opencog
+
+#endif // _OPENCOG_LOOKUP_INDEX_H
@@ -0,0 +1,217 @@
+/*
+ * opencog/atomspace/MemoryReport.cc
+ *
+ * Copyright (C) 2019 OpenCog Foundation
+ * All Rights Reserved
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+#include <opencog/atoms/atom_types/NameServer.h>
+#include <opencog/atoms/base/Atom.h>
+#include <opencog/atoms/base/Link.h>
+#include <opencog/atoms/base/Node.h>
+#include <opencog/atoms/value/FloatValue.h>
+#include <opencog/atoms/value/LinkValue.h>
+#include <opencog/atoms/value/StringValue.h>
+
+#include "MemoryReport.h"
+
+using namespace opencog;
+
+// Atoms and values are made with allocate_shared, so the reference
+// counts sit in front of the object, in the same block.
+static const size_t SHARED_OVERHEAD = 2 * sizeof(void*);
+
+// Strings short enough to fit inside the std::string allocate nothing.
+static size_t string_bytes(const std::string& s)
+{
+	const char* p = s.data();
+	const char* self = (const char*) &s;
+	size_t bytes = sizeof(std::string);
+	if (p < self or self + sizeof(std::string) <= p)
+		bytes += s.capacity() + 1;
+	return bytes;
+}
+
+// An interned name: its pool entry, and the node of the pool's hash
+// table that points at it (a next pointer, the key and the entry
+// pointer, and about one bucket pointer).
+static size_t name_bytes(const std::string& s)
+{
+	return sizeof(Name::Entry) - sizeof(std::string) + string_bytes(s)
+		+ 4 * sizeof(void*);
+}
+
+/// Bytes used by a value. Atoms inside LinkValues are not counted;
+/// they are counted as atoms. Streams are not asked for their current
+/// value, as that would run them.
+static size_t value_bytes(const ValuePtr& v)
+{
+	Type t = v->get_type();
+	if (nameserver().isA(t, ATOM)) return 0;
+
+	size_t bytes = SHARED_OVERHEAD;
+	if (nameserver().isA(t, STREAM_VALUE))
+		return bytes + sizeof(FloatValue);
+
+	if (nameserver().isA(t, FLOAT_VALUE))
+	{
+		const std::vector<double>& fv(FloatValueCast(v)->value());
+		return bytes + sizeof(FloatValue) + fv.capacity() * sizeof(double);
+	}
+	if (nameserver().isA(t, STRING_VALUE))
+	{
+		const std::vector<std::string>& sv(StringValueCast(v)->value());
+		bytes += sizeof(StringValue);
+		for (const std::string& s : sv) bytes += string_bytes(s);
+		return bytes + (sv.capacity() - sv.size()) * sizeof(std::string);
+	}
+	if (nameserver().isA(t, LINK_VALUE))
+	{
+		const std::vector<ValuePtr>& lv(LinkValueCast(v)->value());
+		bytes += sizeof(LinkValue) + lv.capacity() * sizeof(ValuePtr);
+		for (const ValuePtr& vp : lv) bytes += value_bytes(vp);
+		return bytes;
+	}
+	return bytes + sizeof(Value);
+}
+
+MemoryUsage& MemoryUsage::operator+=(const MemoryUsage& o)
+{
+	count += o.count;
+	atoms += o.atoms;
+	outgoing += o.outgoing;
+	incoming += o.incoming;
+	value_tables += o.value_tables;
+	values += o.values;
+	return *this;
+}
+
+void MemoryReport::measure(const Handle& h)
+{
+	MemoryUsage& mu(atom_types[h->get_type()]);
+	mu.count++;
+	measured++;
+
+	mu.atoms += SHARED_OVERHEAD;
+	if (h->is_node())
+	{
+		// The name is the string in the pool entry; its address
+		// stands for the entry.
+		const std::string& name(h->get_name());
+		mu.atoms += sizeof(Node);
+		if (names.insert(&name).second)
+			mu.atoms += name_bytes(name);
+	}
+	else
+	{
+		mu.atoms += sizeof(Link);
+		mu.outgoing += h->getOutgoingSet().capacity() * sizeof(Handle);
+	}
+	mu.incoming += h->incoming_set_bytes();
+
+	std::vector<ValuePtr> vals;
+	mu.value_tables += h->value_table_bytes(&vals);
+	for (const ValuePtr& v : vals)
+	{
+		size_t bytes = value_bytes(v);
+		mu.values += bytes;
+		MemoryUsage& vu(value_types[v->get_type()]);
+		vu.count++;
+		vu.values += bytes;
+	}
+}
+
+void MemoryReport::scale(size_t n, size_t k)
+{
+	if (n == k or 0 == k) return;
+	auto up = [&](size_t& x) { x = (size_t) ((double) x * n / k + 0.5); };
+	auto up_all = [&](MemoryUsage& mu) {
+		up(mu.count); up(mu.atoms); up(mu.outgoing);
+		up(mu.incoming); up(mu.value_tables); up(mu.values);
+	};
+	for (auto& pr : atom_types) up_all(pr.second);
+	for (auto& pr : value_types) up_all(pr.second);
+}
+
+MemoryReport& MemoryReport::operator+=(const MemoryReport& o)
+{
+	for (const auto& pr : o.atom_types) atom_types[pr.first] += pr.second;
+	for (const auto& pr : o.value_types) value_types[pr.first] += pr.second;
+	measured += o.measured;
+	lookup_index += o.lookup_index;
+	names.insert(o.names.begin(), o.names.end());
+	return *this;
+}
+
+MemoryUsage MemoryReport::total(void) const
+{
+	MemoryUsage tot;
+	for (const auto& pr : atom_types) tot += pr.second;
+	return tot;
+}
+
+std::string MemoryReport::to_string(void) const
+{
+	typedef std::pair<Type, MemoryUsage> Row;
+	auto by_size = [](const Row& a, const Row& b) {
+		return a.second.total() > b.second.total();
+	};
+	std::vector<Row> arows(atom_types.begin(), atom_types.end());
+	std::vector<Row> vrows(value_types.begin(), value_types.end());
+	std::sort(arows.begin(), arows.end(), by_size);
+	std::sort(vrows.begin(), vrows.end(), by_size);
+
+	std::string rpt;
+	char buf[256];
+	snprintf(buf, sizeof(buf), "%-28s %10s %12s %12s %12s %12s %12s %12s\n",
+		"Atom type", "count", "atoms", "outgoing", "incoming",
+		"val tables", "values", "total");
+	rpt += buf;
+	auto row = [&](const std::string& name, const MemoryUsage& mu) {
+		snprintf(buf, sizeof(buf),
+			"%-28s %10zu %12zu %12zu %12zu %12zu %12zu %12zu\n",
+			name.c_str(), mu.count, mu.atoms, mu.outgoing, mu.incoming,
+			mu.value_tables, mu.values, mu.total());
+		rpt += buf;
+	};
+	for (const Row& r : arows)
+		row(nameserver().getTypeName(r.first), r.second);
+	row("Total", total());
+
+	size_t natoms = total().count;
+	snprintf(buf, sizeof(buf), "%-28s %10s %12zu %12.1f per atom\n",
+		"Lookup index", "", lookup_index,
+		0 < natoms ? (double) lookup_index / natoms : 0.0);
+	rpt += buf;
+
+	snprintf(buf, sizeof(buf), "\n%-28s %10s %12s\n",
+		"Value type", "count", "bytes");
+	rpt += buf;
+	for (const Row& r : vrows)
+	{
+		snprintf(buf, sizeof(buf), "%-28s %10zu %12zu\n",
+			nameserver().getTypeName(r.first).c_str(),
+			r.second.count, r.second.values);
+		rpt += buf;
+	}
+	return rpt;
+}
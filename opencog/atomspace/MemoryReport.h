@@ -0,0 +1,102 @@
+/*
+ * opencog/atomspace/MemoryReport.h
+ *
+ * Copyright (C) 2019 OpenCog Foundation
+ * All Rights Reserved
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _OPENCOG_MEMORY_REPORT_H
+#define _OPENCOG_MEMORY_REPORT_H
+
+#include <map>
+#include <string>
+#include <unordered_set>
+
+#include <opencog/atoms/base/Handle.h>
+#include <opencog/atoms/atom_types/types.h>
+
+namespace opencog
+{
+/** \addtogroup grp_atomspace
+ *  @{
+ */
+
+/// Bytes of memory used, by some number of atoms or values. For value
+/// types, only the count and the values are filled in.
+struct MemoryUsage
+{
+	size_t count = 0;
+	size_t atoms = 0;         // The atoms themselves, and node names.
+	size_t outgoing = 0;      // Outgoing sets of links.
+	size_t incoming = 0;      // Incoming sets.
+	size_t value_tables = 0;  // The key-value tables on the atoms.
+	size_t values = 0;        // The values held in those tables.
+
+	size_t total(void) const
+	{
+		return atoms + outgoing + incoming + value_tables + values;
+	}
+	MemoryUsage& operator+=(const MemoryUsage&);
+};
+
+/**
+ * Estimate of the memory used by an AtomSpace, by atom type, and by
+ * the type of the values attached to the atoms. The sizes are those
+ * of the base Node and Link objects, plus what they allocate; the
+ * extra members of C++ subclasses (e.g. the variable declarations
+ * cached by a ScopeLink) are not counted. A value shared by several
+ * atoms is counted once for each. Node names are interned, and so
+ * each name is counted just once, for the first node found with it.
+ *
+ * Large types are sampled, rather than walked in full, and so the
+ * byte counts are then only estimates; the atom counts are exact.
+ */
+struct MemoryReport
+{
+	std::map<Type, MemoryUsage> atom_types;
+	std::map<Type, MemoryUsage> value_types;
+
+	/// The number of atoms actually looked at.
+	size_t measured = 0;
+
+	/// Bytes held by the lock-free lookup indexes of the table. These
+	/// are not split by type, and are not part of total(); they are
+	/// exact, not sampled.
+	size_t lookup_index = 0;
+
+	/// The interned names counted so far, by the address of their
+	/// pool entry.
+	std::unordered_set<const void*> names;
+
+	/// Add one atom (and its values) to the report.
+	void measure(const Handle&);
+
+	/// Scale everything by n/k, after measuring k out of n atoms.
+	void scale(size_t n, size_t k);
+
+	MemoryReport& operator+=(const MemoryReport&);
+	MemoryUsage total(void) const;
+
+	/// A printable table, largest types first.
+	std::string to_string(void) const;
+};
+
+/** @}*/
+} //namespace opencog
+
+#endif // _OPENCOG_MEMORY_REPORT_H
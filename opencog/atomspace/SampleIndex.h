@@ -0,0 +1,106 @@
+/*
+ * opencog/atomspace/SampleIndex.h
+ *
+ * Copyright (C) 2019 OpenCog Foundation
+ * All Rights Reserved
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _OPENCOG_SAMPLE_INDEX_H
+#define _OPENCOG_SAMPLE_INDEX_H
+
+#include <vector>
+
+#include <opencog/atoms/base/Atom.h>
+#include <opencog/atoms/base/Handle.h>
+#include <opencog/atoms/atom_types/types.h>
+
+namespace opencog
+{
+/** \addtogroup grp_atomspace
+ *  @{
+ */
+
+/**
+ * Index of atoms, by type, that supports picking the n'th atom of a
+ * given type in constant time. This is what random sampling needs;
+ * the TypeIndex, being a hash table, can only be walked.
+ *
+ * Each type has a dense array of atoms. Removal swaps the last atom
+ * into the hole, so the arrays never have gaps. Each atom remembers
+ * its own position in the array, so that removal is constant time,
+ * too.
+ *
+ * This index does not own the atoms; the TypeIndex does. Not thread
+ * safe; the caller must serialize access (the AtomTable does this
+ * with the shard lock).
+ */
+class SampleIndex
+{
+	private:
+		std::vector<std::vector<Atom*>> _dense;
+
+	public:
+		SampleIndex(void);
+		void resize(void);
+
+		void insertAtom(const Handle& h)
+		{
+			std::vector<Atom*>& v(_dense.at(h->get_type()));
+			h->_sample_pos = v.size();
+			v.push_back(h.get());
+		}
+
+		void removeAtom(const Handle& h)
+		{
+			std::vector<Atom*>& v(_dense.at(h->get_type()));
+			size_t pos = h->_sample_pos;
+			if (v.size() <= pos or v[pos] != h.get()) return;
+
+			Atom* last = v.back();
+			v[pos] = last;
+			last->_sample_pos = pos;
+			v.pop_back();
+		}
+
+		size_t size(Type t) const
+		{
+			return _dense.at(t).size();
+		}
+
+		/// One more than the largest type held.
+		Type num_types(void) const { return _dense.size(); }
+
+		/// Return the i'th atom of type t.
+		Handle at(Type t, size_t i) const
+		{
+			return _dense[t][i]->get_handle();
+		}
+
+		/// The same, without taking a reference.
+		Atom* atom_at(Type t, size_t i) const
+		{
+			return _dense[t][i];
+		}
+
+		void clear(void);
+};
+
+/** @}*/
+} //namespace opencog
+
+#endif // _OPENCOG_SAMPLE_INDEX_H
@@ -0,0 +1,117 @@
+/*
+ * opencog/atomspace/TypeCounter.cc
+ *
+ * Copyright (C) 2019 OpenCog Foundation
+ * All Rights Reserved
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <algorithm>
+#include <iterator>
+#include <mutex>
+
+#include <opencog/atoms/atom_types/NameServer.h>
+
+#include "Epoch.h"
+#include "TypeCounter.h"
+
+using namespace opencog;
+
+/// Every shard of every table wants the same ancestry, so it is built
+/// just once, and rebuilt only when the types change.
+TypeCounter::Ancestry TypeCounter::make_ancestry(bool rebuild)
+{
+	static std::mutex mtx;
+	static Ancestry cached;
+
+	NameServer& ns = nameserver();
+	Type ntypes = ns.getNumberOfClasses();
+
+	std::lock_guard<std::mutex> lck(mtx);
+	if (not rebuild and cached and cached->size() == ntypes) return cached;
+
+	auto anc = std::make_shared<std::vector<std::vector<Type>>>(ntypes);
+	for (Type t = 0; t < ntypes; t++)
+	{
+		std::vector<Type>& v((*anc)[t]);
+		v.push_back(t);
+		ns.getParentsRecursive(t, std::back_inserter(v));
+	}
+	cached = anc;
+	return cached;
+}
+
+TypeCounter::Table::Table(const Ancestry& anc) :
+	ntypes(anc->size()),
+	exact(new std::atomic<size_t>[ntypes]),
+	subtree(new std::atomic<size_t>[ntypes]),
+	ancestry(anc)
+{
+	for (size_t i = 0; i < ntypes; i++)
+	{
+		exact[i].store(0, std::memory_order_relaxed);
+		subtree[i].store(0, std::memory_order_relaxed);
+	}
+}
+
+TypeCounter::Table::~Table()
+{
+	delete[] exact;
+	delete[] subtree;
+}
+
+TypeCounter::TypeCounter(void) :
+	_table(new Table(make_ancestry()))
+{
+}
+
+TypeCounter::~TypeCounter()
+{
+	// No one can be reading any more; the counter is going away.
+	delete _table.load();
+}
+
+/// Switch to a new type hierarchy. The exact counts carry over; the
+/// subtree counts are redone, as some type may have gained a parent.
+void TypeCounter::resize(const Ancestry& anc)
+{
+	Table* old = _table.load(std::memory_order_relaxed);
+	Table* fresh = new Table(anc);
+	size_t n = std::min(old->ntypes, fresh->ntypes);
+	for (size_t t = 0; t < n; t++)
+	{
+		size_t cnt = old->exact[t].load(std::memory_order_relaxed);
+		if (0 == cnt) continue;
+		bump(fresh->exact[t], cnt);
+		for (Type a : (*anc)[t])
+			bump(fresh->subtree[a], cnt);
+	}
+
+	_table.store(fresh, std::memory_order_release);
+	epoch_manager().retire(std::shared_ptr<void>(old,
+		[](Table* p) { delete p; }));
+}
+
+void TypeCounter::clear(void)
+{
+	Table* tab = _table.load(std::memory_order_relaxed);
+	for (size_t i = 0; i < tab->ntypes; i++)
+	{
+		tab->exact[i].store(0, std::memory_order_relaxed);
+		tab->subtree[i].store(0, std::memory_order_relaxed);
+	}
+}
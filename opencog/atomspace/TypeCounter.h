@@ -0,0 +1,118 @@
+/*
+ * opencog/atomspace/TypeCounter.h
+ *
+ * Copyright (C) 2019 OpenCog Foundation
+ * All Rights Reserved
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _OPENCOG_TYPE_COUNTER_H
+#define _OPENCOG_TYPE_COUNTER_H
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include <opencog/atoms/atom_types/types.h>
+
+namespace opencog
+{
+/** \addtogroup grp_atomspace
+ *  @{
+ */
+
+/**
+ * Running counts of atoms, by type, and by type subtree. Adding an
+ * atom of type t bumps the subtree count of every ancestor of t, so
+ * that the number of atoms of a type and all of its subtypes can be
+ * had without looping over the types.
+ *
+ * Writers must be serialized by the caller (the AtomTable does this
+ * with the shard lock). Readers never block: they only need to be
+ * inside an EpochGuard while calling count(), because the count
+ * arrays get replaced when new types are added.
+ */
+class TypeCounter
+{
+	public:
+		/// For each type, a list of that type, and all of its
+		/// ancestors. This is shared, read-only, by all counters.
+		/// Pass `rebuild` when the type hierarchy has changed.
+		typedef std::shared_ptr<const std::vector<std::vector<Type>>> Ancestry;
+		static Ancestry make_ancestry(bool rebuild = false);
+
+	private:
+		struct Table
+		{
+			size_t ntypes;
+			std::atomic<size_t>* exact;
+			std::atomic<size_t>* subtree;
+			Ancestry ancestry;
+			Table(const Ancestry&);
+			~Table();
+		};
+
+		std::atomic<Table*> _table;
+
+		// Only the writer ever changes a count, so there is no need
+		// for an atomic read-modify-write; the stores are atomic only
+		// so that readers see whole values.
+		static void bump(std::atomic<size_t>& c, size_t delta)
+		{
+			c.store(c.load(std::memory_order_relaxed) + delta,
+			        std::memory_order_relaxed);
+		}
+
+		void adjust(Type t, size_t delta)
+		{
+			Table* tab = _table.load(std::memory_order_relaxed);
+			if (tab->ntypes <= t) return;
+			bump(tab->exact[t], delta);
+			for (Type a : (*tab->ancestry)[t])
+				bump(tab->subtree[a], delta);
+		}
+
+		TypeCounter(const TypeCounter&) = delete;
+		TypeCounter& operator=(const TypeCounter&) = delete;
+
+	public:
+		TypeCounter(void);
+		~TypeCounter();
+
+		/// Writers only; the caller must serialize these.
+		void insert(Type t) { adjust(t, 1); }
+		void remove(Type t) { adjust(t, (size_t) -1); }
+		void resize(const Ancestry&);
+		void clear(void);
+
+		/// Return the number of atoms of type t, or, if subclass is
+		/// set, of type t and all of its subtypes. Lock-free; the
+		/// caller must be holding an EpochGuard.
+		size_t count(Type t, bool subclass) const
+		{
+			const Table* tab = _table.load(std::memory_order_acquire);
+			if (tab->ntypes <= t) return 0;
+			if (subclass)
+				return tab->subtree[t].load(std::memory_order_relaxed);
+			return tab->exact[t].load(std::memory_order_relaxed);
+		}
+};
+
+/** @}*/
+} //namespace opencog
+
+#endif // _OPENCOG_TYPE_COUNTER_H
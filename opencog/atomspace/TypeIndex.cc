@@ -19,6 +19,9 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
  */
 
+#include <algorithm>
+#include <cstdio>
+
 #include "TypeIndex.h"
 #include <opencog/atoms/atom_types/NameServer.h>
 
@@ -56,6 +59,69 @@ bool TypeIndex::contains_duplicate(const AtomSet& atoms) const
 
 // ================================================================
 
+HashStats& HashStats::operator+=(const HashStats& o)
+{
+	atoms += o.atoms;
+	distinct_hashes += o.distinct_hashes;
+	buckets += o.buckets;
+	used_buckets += o.used_buckets;
+	max_chain = std::max(max_chain, o.max_chain);
+	total_probes += o.total_probes;
+	return *this;
+}
+
+std::string HashStats::to_string(void) const
+{
+	char buf[256];
+	snprintf(buf, sizeof(buf),
+		"atoms: %zu distinct hashes: %zu collisions: %zu (rate %g)\n"
+		"buckets: %zu used: %zu longest chain: %zu mean probes: %.3f\n",
+		atoms, distinct_hashes, collisions(), collision_rate(),
+		buckets, used_buckets, max_chain, mean_probes());
+	return buf;
+}
+
+HashStats TypeIndex::hash_stats(void) const
+{
+	HashStats st;
+	std::vector<ContentHash> hashes;
+	for (const AtomSet& s : _idx)
+	{
+		if (s.empty()) continue;
+		hashes.clear();
+		st.atoms += s.size();
+		st.buckets += s.bucket_count();
+
+#ifdef TYPEINDEX_FLAT_HASH
+		st.used_buckets += s.size();
+		s.foreach_probe([&](ContentHash h, size_t probes) {
+			hashes.push_back(h);
+			st.total_probes += probes;
+			st.max_chain = std::max(st.max_chain, probes);
+		});
+#else
+		// Finding the k'th atom in a bucket steps over k entries.
+		for (size_t b = 0; b < s.bucket_count(); b++)
+		{
+			size_t n = s.bucket_size(b);
+			if (0 == n) continue;
+			st.used_buckets++;
+			st.total_probes += n * (n + 1) / 2;
+			st.max_chain = std::max(st.max_chain, n);
+		}
+		for (const auto& pr : s)
+			hashes.push_back(pr.first);
+#endif
+
+		std::sort(hashes.begin(), hashes.end());
+		st.distinct_hashes +=
+			std::unique(hashes.begin(), hashes.end()) - hashes.begin();
+	}
+	return st;
+}
+
+// ================================================================
+
 TypeIndex::iterator TypeIndex::begin(Type t, bool sub) const
 {
 	iterator it(t, sub);
@@ -23,11 +23,15 @@
 #define _OPENCOG_TYPEINDEX_H
 
 #include <set>
+#include <string>
 #include <vector>
 
 #include <opencog/atoms/base/Atom.h>
 #include <opencog/atoms/base/Handle.h>
 #include <opencog/atoms/atom_types/types.h>
+#ifdef TYPEINDEX_FLAT_HASH
+#include <opencog/atomspace/FlatAtomSet.h>
+#endif
 
 class AtomSpaceUTest;
 
@@ -37,7 +41,44 @@ namespace opencog
  *  @{
  */
 
+// The open-addressing table uses much less memory per atom, and finds
+// atoms faster; the multimap is the old, well-tested default. Pick one
+// with the TYPEINDEX_FLAT_HASH cmake option.
+#ifdef TYPEINDEX_FLAT_HASH
+typedef FlatAtomSet AtomSet;
+#else
 typedef std::unordered_multimap<ContentHash, Handle> AtomSet;
+#endif
+
+/**
+ * Health of the hash tables in the index, for debugging and tuning.
+ * A true collision is two different atoms, of the same type, with
+ * the same 64-bit hash; these cost a full content compare on every
+ * lookup. Probes count the table entries that a lookup has to step
+ * over to find an atom: the bucket chain for the multimap, and the
+ * probe sequence for the flat table.
+ */
+struct HashStats
+{
+	size_t atoms = 0;
+	size_t distinct_hashes = 0;
+	size_t buckets = 0;
+	size_t used_buckets = 0;
+	size_t max_chain = 0;
+	size_t total_probes = 0;
+
+	size_t collisions(void) const { return atoms - distinct_hashes; }
+	double collision_rate(void) const
+	{
+		return atoms ? double(collisions()) / atoms : 0.0;
+	}
+	double mean_probes(void) const
+	{
+		return atoms ? double(total_probes) / atoms : 0.0;
+	}
+	HashStats& operator+=(const HashStats&);
+	std::string to_string(void) const;
+};
 
 /**
  * Implements a vector of AtomSets; each AtomSet is a hash table of
@@ -71,6 +112,9 @@ class TypeIndex
 		void removeAtom(const Handle& h)
 		{
 			AtomSet& s(_idx.at(h->get_type()));
+#ifdef TYPEINDEX_FLAT_HASH
+			s.remove(h);
+#else
 			auto range = s.equal_range(h->get_hash());
 			auto bkt = range.first;
 			auto end = range.second;
@@ -80,11 +124,15 @@ class TypeIndex
 					break;
 				}
 			}
+#endif
 		}
 
 		Handle findAtom(const Handle& h) const
 		{
 			const AtomSet& s(_idx.at(h->get_type()));
+#ifdef TYPEINDEX_FLAT_HASH
+			return s.find(h);
+#else
 			auto range = s.equal_range(h->get_hash());
 			auto bkt = range.first;
 			auto end = range.second;
@@ -93,6 +141,7 @@ class TypeIndex
 					return bkt->second;
 			}
 			return Handle::UNDEFINED;
+#endif
 		}
 
 		size_t size(Type t) const
@@ -125,6 +174,11 @@ class TypeIndex
 			}
 		}
 
+		/// Walk every table, and collect the hash statistics. This is
+		/// slow, and is meant for debugging; the caller must hold the
+		/// lock that guards the index.
+		HashStats hash_stats(void) const;
+
 		// Return true if there exists some index containing duplicated
 		// atoms (equal by content). Used during unit tests.
 		bool contains_duplicate() const;
@@ -0,0 +1,194 @@
+/*
+ * opencog/atomspace/WorkPool.cc
+ *
+ * Copyright (C) 2019 OpenCog Foundation
+ * All Rights Reserved
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <algorithm>
+
+#include "WorkPool.h"
+
+using namespace opencog;
+
+// Set in threads that are running a loop body, so that nested loops
+// run in place.
+static thread_local bool _in_loop = false;
+
+WorkPool::WorkPool(size_t nthreads) :
+    _ranges(new Range[std::max<size_t>(nthreads, 1)]),
+    _generation(0),
+    _busy(0),
+    _stop(false),
+    _body(nullptr),
+    _grain(1),
+    _abort(false)
+{
+    for (size_t i = 1; i < nthreads; i++)
+        _workers.emplace_back(&WorkPool::worker, this, i);
+}
+
+WorkPool::~WorkPool()
+{
+    {
+        std::lock_guard<std::mutex> lck(_mtx);
+        _stop = true;
+    }
+    _wake.notify_all();
+    for (std::thread& t : _workers) t.join();
+}
+
+void WorkPool::worker(size_t id)
+{
+    _in_loop = true;
+    uint64_t seen = 0;
+    std::unique_lock<std::mutex> lck(_mtx);
+    while (true)
+    {
+        _wake.wait(lck, [&] { return _stop or _generation != seen; });
+        if (_stop) return;
+        seen = _generation;
+
+        lck.unlock();
+        run(id);
+        lck.lock();
+
+        if (0 == --_busy) _done.notify_all();
+    }
+}
+
+/// Take the next chunk of our own range.
+bool WorkPool::take(size_t id, size_t& b, size_t& e)
+{
+    Range& r = _ranges[id];
+    std::lock_guard<std::mutex> lck(r.mtx);
+    if (r.begin == r.end) return false;
+    b = r.begin;
+    e = std::min(r.begin + _grain, r.end);
+    r.begin = e;
+    return true;
+}
+
+/// Our own range is used up; move the back half of someone else's
+/// range over to ours, and take from that.
+bool WorkPool::steal(size_t id, size_t& b, size_t& e)
+{
+    size_t np = size();
+    for (size_t k = 1; k < np; k++)
+    {
+        size_t lo, hi;
+        {
+            Range& victim = _ranges[(id + k) % np];
+            std::lock_guard<std::mutex> lck(victim.mtx);
+            size_t left = victim.end - victim.begin;
+            if (0 == left) continue;
+            lo = victim.begin + left / 2;
+            hi = victim.end;
+            victim.end = lo;
+        }
+        {
+            Range& mine = _ranges[id];
+            std::lock_guard<std::mutex> lck(mine.mtx);
+            mine.begin = lo;
+            mine.end = hi;
+        }
+        if (take(id, b, e)) return true;
+    }
+    return false;
+}
+
+void WorkPool::run(size_t id)
+{
+    size_t b, e;
+    while (take(id, b, e) or steal(id, b, e))
+    {
+        for (size_t i = b; i < e; i++)
+        {
+            if (_abort.load(std::memory_order_relaxed)) return;
+            try
+            {
+                (*_body)(i);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lck(_error_mtx);
+                if (not _error) _error = std::current_exception();
+                _abort.store(true);
+                return;
+            }
+        }
+    }
+}
+
+void WorkPool::for_each(size_t n, const std::function<void(size_t)>& body,
+                        size_t grain)
+{
+    if (0 == n) return;
+    if (0 == grain) grain = 1;
+
+    // Run in place if there is no one to help, or if the pool is
+    // busy; this is what makes nested loops safe.
+    std::unique_lock<std::mutex> job;
+    if (not _in_loop and not _workers.empty() and grain < n)
+        job = std::unique_lock<std::mutex>(_job_mtx, std::try_to_lock);
+    if (not job.owns_lock())
+    {
+        for (size_t i = 0; i < n; i++) body(i);
+        return;
+    }
+
+    // Deal the range out evenly.
+    size_t np = size();
+    for (size_t i = 0; i < np; i++)
+    {
+        _ranges[i].begin = n * i / np;
+        _ranges[i].end = n * (i + 1) / np;
+    }
+    _body = &body;
+    _grain = grain;
+    _abort.store(false);
+    _error = nullptr;
+
+    {
+        std::lock_guard<std::mutex> lck(_mtx);
+        _busy = _workers.size();
+        _generation++;
+    }
+    _wake.notify_all();
+
+    _in_loop = true;
+    run(0);
+    _in_loop = false;
+
+    {
+        std::unique_lock<std::mutex> lck(_mtx);
+        _done.wait(lck, [&] { return 0 == _busy; });
+    }
+    _body = nullptr;
+
+    if (_error) std::rethrow_exception(_error);
+}
+
+WorkPool& opencog::work_pool()
+{
+    // Never deleted: the workers must outlive every static that
+    // might still be running a loop at exit.
+    static WorkPool* _pool =
+        new WorkPool(std::max(1u, std::thread::hardware_concurrency()));
+    return *_pool;
+}
@@ -0,0 +1,119 @@
+/*
+ * opencog/atomspace/WorkPool.h
+ *
+ * Copyright (C) 2019 OpenCog Foundation
+ * All Rights Reserved
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _OPENCOG_WORK_POOL_H
+#define _OPENCOG_WORK_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace opencog
+{
+/** \addtogroup grp_atomspace
+ *  @{
+ */
+
+/**
+ * A fixed set of worker threads, for running loops in parallel.
+ *
+ * The threads are started once, and then sleep between jobs; there
+ * is no per-call thread creation, and no global thread setting to
+ * flip back and forth. The index range of a loop is split evenly
+ * among the workers (and the calling thread, which works too); a
+ * worker that runs out takes half of what is left to some other
+ * worker. Thus, uneven bodies still keep every thread busy.
+ *
+ * A loop started from inside a loop body, or while some other thread
+ * has a loop running, is simply run in the calling thread. This
+ * keeps bodies free to call anything at all, without any risk of
+ * deadlock. Use the process-wide instance returned by work_pool().
+ */
+class WorkPool
+{
+    // The part of the index range not yet handed out to a thread.
+    struct Range
+    {
+        std::mutex mtx;
+        size_t begin;
+        size_t end;
+    };
+
+    std::vector<std::thread> _workers;
+    std::unique_ptr<Range[]> _ranges;
+
+    // Only one job runs at a time.
+    std::mutex _job_mtx;
+
+    // Wakes the workers up, and tells the caller that they are done.
+    std::mutex _mtx;
+    std::condition_variable _wake;
+    std::condition_variable _done;
+    uint64_t _generation;
+    size_t _busy;
+    bool _stop;
+
+    // The job being run.
+    const std::function<void(size_t)>* _body;
+    size_t _grain;
+    std::atomic<bool> _abort;
+    std::exception_ptr _error;
+    std::mutex _error_mtx;
+
+    void worker(size_t);
+    void run(size_t);
+    bool take(size_t, size_t&, size_t&);
+    bool steal(size_t, size_t&, size_t&);
+
+    WorkPool(const WorkPool&) = delete;
+    WorkPool& operator=(const WorkPool&) = delete;
+
+public:
+    /// Start nthreads-1 workers; the caller of for_each() is the
+    /// last thread.
+    WorkPool(size_t nthreads);
+    ~WorkPool();
+
+    /// Number of threads that work on a loop, the caller included.
+    size_t size() const { return _workers.size() + 1; }
+
+    /// Call body(i) for every i in [0, n), in parallel, and return
+    /// when all the calls are done. Indexes are handed out `grain`
+    /// at a time. If a call throws, the loop is cut short, and the
+    /// first exception is rethrown here.
+    void for_each(size_t n, const std::function<void(size_t)>& body,
+                  size_t grain = 1);
+};
+
+/// The pool is sized once, on first use, to the number of hardware
+/// threads.
+WorkPool& work_pool();
+
+/** @}*/
+} //namespace opencog
+
+#endif // _OPENCOG_WORK_POOL_H
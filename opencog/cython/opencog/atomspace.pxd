@@ -2,6 +2,8 @@ from libcpp cimport bool
 from libcpp.vector cimport vector
 from libcpp.memory cimport shared_ptr
 from libcpp.set cimport set as cpp_set
+from libcpp.map cimport map as cpp_map
+from libcpp.pair cimport pair
 from libcpp.string cimport string
 from cython.operator cimport dereference as deref
 
@@ -177,6 +179,22 @@ cdef class Atom(Value):
 
 cdef vector[cHandle] atom_list_to_vector(list lst);
 
+# MemoryReport
+cdef extern from "opencog/atomspace/MemoryReport.h" namespace "opencog":
+    cdef cppclass cMemoryUsage "opencog::MemoryUsage":
+        size_t count
+        size_t atoms
+        size_t outgoing
+        size_t incoming
+        size_t value_tables
+        size_t values
+        size_t total()
+
+    cdef cppclass cMemoryReport "opencog::MemoryReport":
+        cpp_map[Type, cMemoryUsage] atom_types
+        cpp_map[Type, cMemoryUsage] value_types
+        size_t measured
+
 # AtomSpace
 cdef extern from "opencog/atomspace/AtomSpace.h" namespace "opencog":
     cdef cppclass cAtomSpace "opencog::AtomSpace":
@@ -184,6 +202,11 @@ cdef extern from "opencog/atomspace/AtomSpace.h" namespace "opencog":
         cAtomSpace(cAtomSpace * parent)
 
         cHandle add_atom(cHandle handle) except +
+        vector[cHandle] add_atoms(vector[cHandle] handles) except +
+        vector[cHandle] fetch_atoms(vector[cHandle] handles) except +
+        void fetch_incoming_sets(vector[cHandle] handles) except +
+        void store_atoms(vector[cHandle] handles) except +
+        vector[cHandle] get_random_atoms(size_t k, Type t, bint subclass)
 
         cHandle xadd_node(Type t, string s) except +
         cHandle add_node(Type t, string s, tv_ptr tvn) except +
@@ -199,6 +222,7 @@ cdef extern from "opencog/atomspace/AtomSpace.h" namespace "opencog":
         cHandle get_atom(cHandle & h)
         bint is_valid_handle(cHandle h)
         int get_size()
+        cMemoryReport memory_report(size_t sample)
 
         # ==== query methods ====
         # get by type
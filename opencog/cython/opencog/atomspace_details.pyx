@@ -107,6 +107,62 @@ cdef class AtomSpace:
             return None
         return create_python_value_from_c_value(<cValuePtr&>result)
 
+    def add_atoms(self, atoms):
+        """ Add a list of Atoms to the AtomSpace, all in one go.
+        Much faster than calling add_atom() on each, for large lists.
+        @returns a list of the Atoms in the AtomSpace, in the same
+        order; None for those that could not be added.
+        """
+        if self.atomspace == NULL:
+            return None
+        cdef vector[cHandle] handle_vector = atom_list_to_vector(list(atoms))
+        cdef vector[cHandle] result = self.atomspace.add_atoms(handle_vector)
+        cdef cHandle h
+        added = []
+        for h in result:
+            if h == h.UNDEFINED:
+                added.append(None)
+            else:
+                added.append(create_python_value_from_c_value(<cValuePtr&>h))
+        return added
+
+    def fetch_atoms(self, atoms):
+        """ Fetch a list of Atoms, and their values, from the backing
+        store, all in one go. Much faster than fetching each one.
+        @returns a list of the Atoms in the AtomSpace, in the same
+        order; None for those that could not be added.
+        """
+        if self.atomspace == NULL:
+            return None
+        cdef vector[cHandle] handle_vector = atom_list_to_vector(list(atoms))
+        cdef vector[cHandle] result = self.atomspace.fetch_atoms(handle_vector)
+        cdef cHandle h
+        fetched = []
+        for h in result:
+            if h == h.UNDEFINED:
+                fetched.append(None)
+            else:
+                fetched.append(create_python_value_from_c_value(<cValuePtr&>h))
+        return fetched
+
+    def fetch_incoming_sets(self, atoms):
+        """ Fetch the incoming sets of a list of Atoms from the
+        backing store, all in one go. The fetch is not recursive.
+        """
+        if self.atomspace == NULL:
+            return
+        cdef vector[cHandle] handle_vector = atom_list_to_vector(list(atoms))
+        self.atomspace.fetch_incoming_sets(handle_vector)
+
+    def store_atoms(self, atoms):
+        """ Store a list of Atoms, and their values, to the backing
+        store, all in one go.
+        """
+        if self.atomspace == NULL:
+            return
+        cdef vector[cHandle] handle_vector = atom_list_to_vector(list(atoms))
+        self.atomspace.store_atoms(handle_vector)
+
     def add_node(self, Type t, atom_name, TruthValue tv=None):
         """ Add Node to AtomSpace
         @todo support [0.5,0.5] format for TruthValue.
@@ -223,6 +279,37 @@ cdef class AtomSpace:
             return 0
         return self.atomspace.get_size()
 
+    def memory_report(self, sample = 256):
+        """ Return an estimate of the bytes used, as two dicts keyed by
+        type name: one of atom types, under 'atoms', and one of value
+        types, under 'values'. Atom types get a dict of the count, and
+        of the bytes used by the atoms, their outgoing sets, their
+        incoming sets, their value tables and their values. Value types
+        get a count, and the bytes used. Types with more than sample
+        atoms (per index shard) are sampled; pass zero to measure every
+        atom.
+        """
+        if self.atomspace == NULL:
+            return None
+        cdef cMemoryReport rpt = self.atomspace.memory_report(sample)
+        cdef pair[Type, cMemoryUsage] pr
+        atoms = {}
+        for pr in rpt.atom_types:
+            atoms[get_type_name(pr.first)] = {
+                'count': pr.second.count,
+                'atoms': pr.second.atoms,
+                'outgoing': pr.second.outgoing,
+                'incoming': pr.second.incoming,
+                'value_tables': pr.second.value_tables,
+                'values': pr.second.values,
+                'total': pr.second.total()}
+        values = {}
+        for pr in rpt.value_types:
+            values[get_type_name(pr.first)] = {
+                'count': pr.second.count,
+                'bytes': pr.second.values}
+        return {'atoms': atoms, 'values': values}
+
     # query methods
     def get_atoms_by_type(self, Type t, subtype = True):
         if self.atomspace == NULL:
@@ -232,6 +319,22 @@ cdef class AtomSpace:
         self.atomspace.get_handles_by_type(back_inserter(handle_vector),t,subt)
         return convert_handle_seq_to_python_list(handle_vector)
 
+    def get_random_atoms(self, k, t=None, subtype = True):
+        """ Return a list of k atoms of type t (or its subtypes, if
+        subtype is True), drawn uniformly at random, with replacement.
+        If no type is given, the atoms are drawn from the whole
+        AtomSpace.
+        """
+        if self.atomspace == NULL:
+            return None
+        if t is None:
+            t = types.Atom
+        cdef Type ct = t
+        cdef bint subt = subtype
+        cdef vector[cHandle] handle_vector
+        handle_vector = self.atomspace.get_random_atoms(k, ct, subt)
+        return convert_handle_seq_to_python_list(handle_vector)
+
     @classmethod
     def include_incoming(cls, atoms):
         """
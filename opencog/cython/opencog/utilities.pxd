@@ -19,3 +19,13 @@ cdef extern from "opencog/cython/executioncontext/Context.h" namespace "opencog"
     cAtomSpace * pop_context_atomspace();
     void c_clear_context "opencog::clear_context" ();
 
+
+
+cdef extern from "opencog/persist/file/fast_load.h" namespace "opencog":
+    size_t c_load_file "opencog::load_file" (const string& filename, cAtomSpace& a) except +
+
+cdef extern from "opencog/persist/file/fast_store.h" namespace "opencog":
+    cdef enum DumpFormat:
+        DUMP_SEXPR
+        DUMP_BINARY
+    size_t c_dump_file "opencog::dump_file" (const string& filename, cAtomSpace& a, Type t, bint subclass, DumpFormat fmt, bint compress) except +
@@ -4,7 +4,7 @@ from opencog.atomspace cimport cValuePtr, create_python_value_from_c_value
 from opencog.atomspace cimport AtomSpace_factory
 
 from contextlib import contextmanager
-from opencog.atomspace import create_child_atomspace
+from opencog.atomspace import create_child_atomspace, types
 
 import warnings
 
@@ -114,3 +114,26 @@ def get_default_atomspace():
 def pop_default_atomspace():
     return AtomSpace_factory(pop_context_atomspace())
 
+
+def load_file(AtomSpace atomspace, str filename):
+    """
+    Load a file of Atomese s-expressions into the atomspace, without
+    going through guile. Returns the number of atoms read.
+    """
+    cdef string fname = filename.encode('UTF-8')
+    return c_load_file(fname, deref(atomspace.atomspace))
+
+
+def dump_file(AtomSpace atomspace, str filename, Type t=types.Atom,
+              binary=False, compress=False):
+    """
+    Write the atoms of type t, and of its subtypes, to a file, along
+    with their values; by default, all of them. The file is written
+    in Atomese s-expressions, or, if binary is set, in a compact
+    binary form. If compress is set, it is gzip'ed. load_file() reads
+    it back. Returns the number of atoms written.
+    """
+    cdef string fname = filename.encode('UTF-8')
+    cdef DumpFormat fmt = DUMP_BINARY if binary else DUMP_SEXPR
+    return c_dump_file(fname, deref(atomspace.atomspace), t, True, fmt,
+                       compress)
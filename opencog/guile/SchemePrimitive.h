@@ -393,12 +393,11 @@ protected:
 	}
 	SCM scm_from(const HandleSeq& hs)
 	{
-		SCM rc;
-		HandleSeq::const_iterator it = hs.begin();
-		if (it != hs.end())
-			rc = scm_list_1(SchemeSmob::handle_to_scm(*it));
-		++it;
-		for ( ; it != hs.end(); ++it)
+		// Cons from the back, so that the list keeps the order of
+		// the sequence; an empty sequence is the empty list.
+		SCM rc = SCM_EOL;
+		for (HandleSeq::const_reverse_iterator it = hs.rbegin();
+		     it != hs.rend(); ++it)
 		{
 			rc = scm_cons(SchemeSmob::handle_to_scm(*it), rc);
 		}
@@ -246,6 +246,7 @@ void SchemeSmob::register_procs()
 	register_proc("cog-new-value",         1, 0, 1, C(ss_new_value));
 	register_proc("cog-new-node",          2, 0, 1, C(ss_new_node));
 	register_proc("cog-new-link",          1, 0, 1, C(ss_new_link));
+	register_proc("cog-new-atoms",         1, 1, 0, C(ss_new_atoms));
 	register_proc("cog-node",              2, 0, 1, C(ss_node));
 	register_proc("cog-link",              1, 0, 1, C(ss_link));
 	register_proc("cog-delete",            1, 0, 1, C(ss_delete));
@@ -318,6 +319,8 @@ void SchemeSmob::register_procs()
 	// Taking AtomSpace as optional argument
 	register_proc("cog-count-atoms",       1, 1, 0, C(ss_count));
 	register_proc("cog-map-type",          2, 1, 0, C(ss_map_type));
+	register_proc("cog-random-atoms",      2, 1, 0, C(ss_random_atoms));
+	register_proc("cog-report-memory",     0, 1, 0, C(ss_report_memory));
 
 	// Value types
 	register_proc("cog-get-types",         0, 0, 0, C(ss_get_types));
@@ -83,6 +83,7 @@ private:
 	static SCM ss_new_value(SCM, SCM);
 	static SCM ss_new_node(SCM, SCM, SCM);
 	static SCM ss_new_link(SCM, SCM);
+	static SCM ss_new_atoms(SCM, SCM);
 	static SCM ss_node(SCM, SCM, SCM);
 	static SCM ss_link(SCM, SCM);
 	static SCM ss_delete(SCM, SCM);
@@ -136,6 +137,8 @@ private:
 	static SCM ss_get_subtypes(SCM);
 	static SCM ss_subtype_p(SCM, SCM);
 	static SCM ss_count(SCM, SCM);
+	static SCM ss_random_atoms(SCM, SCM, SCM);
+	static SCM ss_report_memory(SCM);
 
 	// Truth values
 	static SCM ss_tv_get_mean(SCM);
@@ -378,27 +378,23 @@ SCM SchemeSmob::ss_map_type (SCM proc, SCM stype, SCM aspace)
 	if (nullptr == atomspace)
 		atomspace = ss_get_env_as("cog-map-type");
 
-	// Get all of the handles of the indicated type
-	HandleSet hset;
-	atomspace->get_handleset_by_type(hset, t);
-
-	// Loop over all handles in the handle set.
-	// Call proc on each handle, in turn.
-	// Break out of the loop if proc returns anything other than #f
-	for (const Handle& h : hset) {
-
-		// In case h got removed from the atomspace between
-		// get_handles_by_type call and now. This may happen either
-		// externally or by proc itself (such as cog-extract-recursive)
-		if (not h->getAtomSpace())
-			continue;
-
-		SCM smob = handle_to_scm(h);
-		SCM rc = scm_call_1(proc, smob);
-		if (!scm_is_false(rc)) return rc;
-	}
-
-	return SCM_BOOL_F;
+	// Call proc on each atom, in turn, straight out of the atom
+	// table, and the tables of the parent atomspaces. Break out of
+	// the loop if proc returns anything other than #f
+	SCM rc = SCM_BOOL_F;
+	atomspace->foreach_handle_by_type(
+		[&](const Handle& h)->bool {
+			// In case h got removed from the atomspace after the
+			// walk reached it. This may happen either externally or
+			// by proc itself (such as cog-extract-recursive)
+			if (not h->getAtomSpace())
+				return false;
+
+			rc = scm_call_1(proc, handle_to_scm(h));
+			return not scm_is_false(rc);
+		}, t);
+
+	return rc;
 }
 
 /* ============================================================== */
@@ -519,6 +515,74 @@ SCM SchemeSmob::ss_count (SCM stype, SCM aspace)
 	return scm_from_size_t(cnt);
 }
 
+/**
+ * Return a list of k atoms of the indicated type (or its subtypes),
+ * drawn at random, with replacement. The aspace argument is optional.
+ */
+SCM SchemeSmob::ss_random_atoms (SCM stype, SCM sk, SCM aspace)
+{
+	Type t = verify_type(stype, "cog-random-atoms");
+	size_t k = verify_size(sk, "cog-random-atoms", 2);
+
+	AtomSpace* as = ss_to_atomspace(aspace);
+	if (nullptr == as)
+		as = ss_get_env_as("cog-random-atoms");
+
+	HandleSeq hs(as->get_random_atoms(k, t));
+
+	SCM list = SCM_EOL;
+	for (const Handle& h : hs)
+		list = scm_cons(handle_to_scm(h), list);
+
+	return list;
+}
+
+/**
+ * Return the bytes used, as two association lists: one by atom type,
+ * under the key `atoms`, and one by value type, under `values`. The
+ * aspace argument is optional.
+ */
+SCM SchemeSmob::ss_report_memory (SCM aspace)
+{
+	AtomSpace* as = ss_to_atomspace(aspace);
+	if (nullptr == as)
+		as = ss_get_env_as("cog-report-memory");
+
+	MemoryReport rpt(as->memory_report());
+
+	auto entry = [](const char* key, size_t val) {
+		return scm_cons(scm_from_utf8_symbol(key), scm_from_size_t(val));
+	};
+	auto type_sym = [](Type t) {
+		return scm_from_utf8_symbol(nameserver().getTypeName(t).c_str());
+	};
+
+	SCM vlist = SCM_EOL;
+	for (const auto& pr : rpt.value_types)
+	{
+		SCM row = scm_list_2(entry("count", pr.second.count),
+		                     entry("bytes", pr.second.values));
+		vlist = scm_cons(scm_cons(type_sym(pr.first), row), vlist);
+	}
+
+	SCM alist = SCM_EOL;
+	for (const auto& pr : rpt.atom_types)
+	{
+		const MemoryUsage& mu(pr.second);
+		SCM row = scm_list_n(entry("count", mu.count),
+		                     entry("atoms", mu.atoms),
+		                     entry("outgoing", mu.outgoing),
+		                     entry("incoming", mu.incoming),
+		                     entry("value-tables", mu.value_tables),
+		                     entry("values", mu.values),
+		                     entry("total", mu.total()),
+		                     SCM_UNDEFINED);
+		alist = scm_cons(scm_cons(type_sym(pr.first), row), alist);
+	}
+	return scm_list_2(scm_cons(scm_from_utf8_symbol("atoms"), alist),
+	                  scm_cons(scm_from_utf8_symbol("values"), vlist));
+}
+
 SCM SchemeSmob::ss_get_free_variables(SCM satom)
 {
 	Handle h = verify_handle(satom, "cog-free-variables");
@@ -539,6 +539,34 @@ SCM SchemeSmob::ss_new_link (SCM stype, SCM satom_list)
 	return SCM_EOL;
 }
 
+/**
+ * Add a whole list of atoms to the atomspace, in one go. Return a
+ * list of the atoms in the atomspace, in the same order.
+ */
+SCM SchemeSmob::ss_new_atoms (SCM satom_list, SCM aspace)
+{
+	HandleSeq atoms(verify_handle_list(satom_list, "cog-new-atoms", 1));
+
+	AtomSpace* atomspace = ss_to_atomspace(aspace);
+	if (nullptr == atomspace) atomspace = ss_get_env_as("cog-new-atoms");
+
+	try
+	{
+		HandleSeq added(atomspace->add_atoms(atoms));
+
+		SCM list = SCM_EOL;
+		for (size_t i = added.size(); 0 < i; i--)
+			list = scm_cons(handle_to_scm(added[i-1]), list);
+		return list;
+	}
+	catch (const std::exception& ex)
+	{
+		throw_exception(ex, "cog-new-atoms", satom_list);
+	}
+	scm_remember_upto_here_1(satom_list);
+	return SCM_EOL;
+}
+
 /**
  * Return the indicated link, of named type stype, holding the
  * indicated atom list, if it exists; else return nil if
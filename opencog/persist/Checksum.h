@@ -0,0 +1,74 @@
+/*
+ * opencog/persist/Checksum.h
+ *
+ * Copyright (C) 2019 OpenCog Foundation
+ * All Rights Reserved
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _OPENCOG_PERSIST_CHECKSUM_H
+#define _OPENCOG_PERSIST_CHECKSUM_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace opencog
+{
+/** \addtogroup grp_persist
+ *  @{
+ */
+
+/**
+ * CRC-32C (Castagnoli), for checking records written to disk.
+ *
+ * Unlike the hashes in opencog/atoms/base/hash.h, which may change
+ * from one release to the next, this is a fixed function, and so may
+ * be stored in files. It must never be changed; a file format that
+ * wants another checksum must get a new version number instead.
+ *
+ * Pass the result of one call as `crc` to the next, to checksum data
+ * that is not contiguous. crc32c("123456789", 9) is 0xE3069283.
+ */
+inline uint32_t crc32c(const void* data, size_t len, uint32_t crc = 0)
+{
+	struct Table
+	{
+		uint32_t t[256];
+		Table(void)
+		{
+			for (uint32_t i = 0; i < 256; i++)
+			{
+				uint32_t c = i;
+				for (int k = 0; k < 8; k++)
+					c = (c >> 1) ^ (0x82F63B78 & (0 - (c & 1)));
+				t[i] = c;
+			}
+		}
+	};
+	static const Table table;
+
+	const unsigned char* p = (const unsigned char*) data;
+	crc = ~crc;
+	for (size_t i = 0; i < len; i++)
+		crc = table.t[(crc ^ p[i]) & 0xff] ^ (crc >> 8);
+	return ~crc;
+}
+
+/** @}*/
+} // namespace opencog
+
+#endif // _OPENCOG_PERSIST_CHECKSUM_H
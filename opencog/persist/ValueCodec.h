@@ -0,0 +1,188 @@
+/*
+ * opencog/persist/ValueCodec.h
+ *
+ * Copyright (C) 2019 OpenCog Foundation
+ * All Rights Reserved
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _OPENCOG_PERSIST_VALUE_CODEC_H
+#define _OPENCOG_PERSIST_VALUE_CODEC_H
+
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include <opencog/util/exceptions.h>
+#include <opencog/atoms/atom_types/NameServer.h>
+#include <opencog/atoms/truthvalue/TruthValue.h>
+#include <opencog/atoms/value/FloatValue.h>
+#include <opencog/atoms/value/LinkValue.h>
+#include <opencog/atoms/value/StringValue.h>
+
+namespace opencog
+{
+/** \addtogroup grp_persist
+ *  @{
+ */
+
+/**
+ * The binary encoding of values, shared by the snapshot and the LSM
+ * backends. An encoded value is its type, a one-byte kind, and:
+ *
+ *   'A' atoms:   a reference to the atom
+ *   'F' floats:  uint32_t n, then n doubles (also truth values)
+ *   'S' strings: uint32_t n, then n times (uint32_t len, bytes)
+ *   'L' links:   uint32_t n, then n encoded values
+ *
+ * Each backend writes types and atom references in its own way (the
+ * snapshot as small indexes into tables in the file, the LSM store as
+ * type names and atom ids), and so supplies the functions that write
+ * and read them. Numbers are in native byte order.
+ *
+ * Stream values, and C++ subclasses of the basic values, are not
+ * encoded; they have no fixed contents.
+ */
+
+template<typename T>
+inline void codec_put(std::string& buf, T v)
+{
+	buf.append((const char*) &v, sizeof(T));
+}
+
+template<typename T>
+inline T codec_get(const char*& p)
+{
+	T v;
+	memcpy(&v, p, sizeof(T));
+	p += sizeof(T);
+	return v;
+}
+
+/// Append the value to the buffer; return false, and append nothing,
+/// if it cannot be encoded. `put_type(buf, Type)` writes a type, and
+/// `put_atom(buf, Handle)` a reference to an atom.
+template<typename PutType, typename PutAtom>
+bool encode_binary_value(std::string& buf, const ValuePtr& v,
+                         PutType put_type, PutAtom put_atom)
+{
+	if (nullptr == v) return false;
+	Type t = v->get_type();
+	NameServer& ns = nameserver();
+
+	if (v->is_atom())
+	{
+		put_type(buf, t);
+		buf.push_back('A');
+		put_atom(buf, HandleCast(v));
+		return true;
+	}
+	if (FLOAT_VALUE == t or ns.isA(t, TRUTH_VALUE))
+	{
+		const std::vector<double>& fv(FloatValueCast(v)->value());
+		put_type(buf, t);
+		buf.push_back('F');
+		codec_put<uint32_t>(buf, fv.size());
+		buf.append((const char*) fv.data(), fv.size() * sizeof(double));
+		return true;
+	}
+	if (STRING_VALUE == t)
+	{
+		const std::vector<std::string>& sv(StringValueCast(v)->value());
+		put_type(buf, t);
+		buf.push_back('S');
+		codec_put<uint32_t>(buf, sv.size());
+		for (const std::string& s : sv)
+		{
+			codec_put<uint32_t>(buf, s.size());
+			buf += s;
+		}
+		return true;
+	}
+	if (LINK_VALUE == t)
+	{
+		std::string elts;
+		uint32_t n = 0;
+		for (const ValuePtr& vp : LinkValueCast(v)->value())
+			if (encode_binary_value(elts, vp, put_type, put_atom)) n++;
+		put_type(buf, t);
+		buf.push_back('L');
+		codec_put<uint32_t>(buf, n);
+		buf += elts;
+		return true;
+	}
+	return false;
+}
+
+/// Decode one value, and move past it. `get_type(p)` reads a type,
+/// returning NOTYPE if it is not known in this process, and
+/// `get_atom(p)` reads a reference to an atom. Returns nullptr for
+/// values of unknown types; throws if the encoding is corrupt.
+template<typename GetType, typename GetAtom>
+ValuePtr decode_binary_value(const char*& p,
+                             GetType get_type, GetAtom get_atom)
+{
+	Type t = get_type(p);
+	char kind = codec_get<char>(p);
+
+	if ('A' == kind)
+		return get_atom(p);
+
+	uint32_t n = codec_get<uint32_t>(p);
+	if ('F' == kind)
+	{
+		std::vector<double> fv(n);
+		memcpy(fv.data(), p, n * sizeof(double));
+		p += n * sizeof(double);
+		if (FLOAT_VALUE == t) return createFloatValue(std::move(fv));
+		if (NOTYPE != t and nameserver().isA(t, TRUTH_VALUE))
+			return ValueCast(TruthValue::factory(t, fv));
+		return nullptr;
+	}
+	if ('S' == kind)
+	{
+		std::vector<std::string> sv;
+		sv.reserve(n);
+		for (uint32_t i = 0; i < n; i++)
+		{
+			uint32_t len = codec_get<uint32_t>(p);
+			sv.emplace_back(p, len);
+			p += len;
+		}
+		if (STRING_VALUE == t) return createStringValue(std::move(sv));
+		return nullptr;
+	}
+	if ('L' == kind)
+	{
+		std::vector<ValuePtr> lv;
+		lv.reserve(n);
+		for (uint32_t i = 0; i < n; i++)
+		{
+			ValuePtr vp(decode_binary_value(p, get_type, get_atom));
+			if (vp) lv.emplace_back(vp);
+		}
+		if (LINK_VALUE == t) return createLinkValue(std::move(lv));
+		return nullptr;
+	}
+	throw IOException(TRACE_INFO, "Corrupt encoded value, kind %d", kind);
+}
+
+/** @}*/
+} // namespace opencog
+
+#endif // _OPENCOG_PERSIST_VALUE_CODEC_H
@@ -0,0 +1,128 @@
+/*
+ * opencog/persist/file/BinaryFormat.h
+ *
+ * Copyright (C) 2019 OpenCog Foundation
+ * All Rights Reserved
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _OPENCOG_BINARY_FORMAT_H
+#define _OPENCOG_BINARY_FORMAT_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+namespace opencog
+{
+/** \addtogroup grp_persist
+ *  @{
+ */
+
+// The binary form of an atom dump, written by dump_atoms() and read
+// by load_file(). It is a little stack machine: each record pushes an
+// atom or a value, or pops some to make a bigger one, so that the
+// outgoing set of a link is always written before the link.
+//
+//   magic      -- BINARY_MAGIC
+//   type names -- varint count, then (varint len, bytes) each; the
+//                 index in this list is the type code used below
+//   blocks     -- uint32_t byte count (little-endian), then records.
+//                 A block holds only whole expressions, so that the
+//                 blocks can be decoded in parallel.
+//
+// The records:
+//   'N' type name     -- push a node; the name is (varint len, bytes)
+//   'L' type arity    -- pop arity atoms, push a link holding them
+//   'F' type n        -- push a float value (or truth value); n
+//                        little-endian doubles follow
+//   'S' type n        -- push a string value; n (varint len, bytes)
+//   'K' type n        -- pop n values, push a link value
+//   'T'               -- pop a truth value, set it on the atom on top
+//   'V'               -- pop a value, then a key; set on the atom on top
+//   'R'               -- pop an atom; it goes into the atomspace
+//
+// Types, arities and counts are unsigned LEB128 varints.
+
+#define BINARY_MAGIC "OCATOMS1"
+#define BINARY_MAGIC_LEN 8
+
+enum BinaryOp : char
+{
+	BIN_NODE = 'N',
+	BIN_LINK = 'L',
+	BIN_FLOATS = 'F',
+	BIN_STRINGS = 'S',
+	BIN_LINKVALUE = 'K',
+	BIN_TV = 'T',
+	BIN_VALUE = 'V',
+	BIN_ROOT = 'R',
+};
+
+inline void bin_put_varint(std::string& buf, uint64_t v)
+{
+	while (0x80 <= v)
+	{
+		buf += (char) (0x80 | (v & 0x7f));
+		v >>= 7;
+	}
+	buf += (char) v;
+}
+
+inline void bin_put_string(std::string& buf, const std::string& s)
+{
+	bin_put_varint(buf, s.size());
+	buf += s;
+}
+
+inline void bin_put_double(std::string& buf, double d)
+{
+	uint64_t v;
+	memcpy(&v, &d, sizeof(v));
+	for (int i = 0; i < 8; i++)
+		buf += (char) (v >> (8 * i));
+}
+
+inline void bin_put_u32(std::string& buf, uint32_t v)
+{
+	for (int i = 0; i < 4; i++)
+		buf += (char) (v >> (8 * i));
+}
+
+/// Read a varint, advancing p; return false if it runs past end.
+inline bool bin_get_varint(const char*& p, const char* end, uint64_t& v)
+{
+	v = 0;
+	for (int shift = 0; shift < 64 and p < end; shift += 7)
+	{
+		unsigned char c = *p++;
+		v |= ((uint64_t) (c & 0x7f)) << shift;
+		if (0 == (c & 0x80)) return true;
+	}
+	return false;
+}
+
+inline uint32_t bin_get_u32(const char* p)
+{
+	const unsigned char* u = (const unsigned char*) p;
+	return u[0] | (u[1] << 8) | (u[2] << 16) | ((uint32_t) u[3] << 24);
+}
+
+/** @}*/
+} //namespace opencog
+
+#endif // _OPENCOG_BINARY_FORMAT_H
@@ -0,0 +1,97 @@
+/*
+ * opencog/persist/file/FilePersistSCM.cc
+ *
+ * Copyright (C) 2019 OpenCog Foundation
+ * All Rights Reserved
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifdef HAVE_GUILE
+
+#include <opencog/atomspace/AtomSpace.h>
+#include <opencog/guile/SchemePrimitive.h>
+
+#include "fast_load.h"
+#include "fast_store.h"
+#include "FilePersistSCM.h"
+
+using namespace opencog;
+
+
+// =================================================================
+
+FilePersistSCM::FilePersistSCM(AtomSpace *as)
+{
+    _as = as;
+
+    static bool is_init = false;
+    if (is_init) return;
+    is_init = true;
+    scm_with_guile(init_in_guile, this);
+}
+
+void* FilePersistSCM::init_in_guile(void* self)
+{
+    scm_c_define_module("opencog persist-file", init_in_module, self);
+    scm_c_use_module("opencog persist-file");
+    return NULL;
+}
+
+void FilePersistSCM::init_in_module(void* data)
+{
+   FilePersistSCM* self = (FilePersistSCM*) data;
+   self->init();
+}
+
+void FilePersistSCM::init(void)
+{
+    define_scheme_primitive("load-file", &FilePersistSCM::do_load_file, this, "persist-file");
+    define_scheme_primitive("dump-atoms", &FilePersistSCM::do_dump_atoms, this, "persist-file");
+}
+
+size_t FilePersistSCM::do_load_file(const std::string& filename)
+{
+    // Load into the current atomspace.
+    AtomSpace *as = SchemeSmob::ss_get_env_as("load-file");
+    if (nullptr != as) _as = as;
+
+    if (nullptr == _as)
+        throw RuntimeException(TRACE_INFO,
+             "load-file: Error: Can't find the atomspace!");
+
+    return load_file(filename, *_as);
+}
+
+size_t FilePersistSCM::do_dump_atoms(const std::string& filename, Type t,
+                                     bool binary, bool compress)
+{
+    AtomSpace *as = SchemeSmob::ss_get_env_as("dump-atoms");
+    if (nullptr != as) _as = as;
+
+    if (nullptr == _as)
+        throw RuntimeException(TRACE_INFO,
+             "dump-atoms: Error: Can't find the atomspace!");
+
+    return dump_file(filename, *_as, t, true,
+                     binary ? DUMP_BINARY : DUMP_SEXPR, compress);
+}
+
+void opencog_persist_file_init(void)
+{
+    static FilePersistSCM patty(NULL);
+}
+#endif // HAVE_GUILE
@@ -0,0 +1,395 @@
+/*
+ * opencog/persist/file/SexprParser.cc
+ *
+ * Copyright (C) 2019 OpenCog Foundation
+ * All Rights Reserved
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#include <opencog/util/exceptions.h>
+#include <opencog/atoms/atom_types/NameServer.h>
+#include <opencog/atoms/base/Link.h>
+#include <opencog/atoms/base/Node.h>
+#include <opencog/atoms/truthvalue/TruthValue.h>
+#include <opencog/atoms/value/FloatValue.h>
+#include <opencog/atoms/value/LinkValue.h>
+#include <opencog/atoms/value/StringValue.h>
+
+#include "SexprParser.h"
+
+using namespace opencog;
+
+SexprParser::SexprParser(const char* begin, const char* end,
+                         const char* origin) :
+	_p(begin), _end(end), _origin(origin ? origin : begin), _natoms(0)
+{
+	_types["stv"] = SIMPLE_TRUTH_VALUE;
+	_types["ctv"] = COUNT_TRUTH_VALUE;
+	_types["itv"] = INDEFINITE_TRUTH_VALUE;
+	_types["ptv"] = PROBABILISTIC_TRUTH_VALUE;
+	_types["ftv"] = FUZZY_TRUTH_VALUE;
+}
+
+void SexprParser::syntax_error(const char* msg)
+{
+	size_t line = 1 + std::count(_origin, std::min(_p, _end), '\n');
+	throw SyntaxException(TRACE_INFO, "Line %zu: %s", line, msg);
+}
+
+// ---------------------------------------------------------------
+// Tokens
+
+static inline bool is_delim(char c)
+{
+	return ' ' == c or '\t' == c or '\n' == c or '\r' == c or '\f' == c
+		or '(' == c or ')' == c or '"' == c or ';' == c;
+}
+
+/// Skip whitespace and comments: `; ...`, `#| ... |#` and `#! ... !#`.
+void SexprParser::skip_space(void)
+{
+	while (_p < _end)
+	{
+		char c = *_p;
+		if (' ' == c or '\t' == c or '\n' == c or '\r' == c or '\f' == c)
+			_p++;
+		else if (';' == c)
+		{
+			const char* nl = (const char*) memchr(_p, '\n', _end - _p);
+			_p = nl ? nl + 1 : _end;
+		}
+		else if ('#' == c and _p + 1 < _end and ('|' == _p[1] or '!' == _p[1]))
+		{
+			char close = _p[1];
+			const char* q = _p + 2;
+			while (q + 1 < _end and not (close == q[0] and '#' == q[1])) q++;
+			if (_end <= q + 1) syntax_error("Unterminated block comment");
+			_p = q + 2;
+		}
+		else return;
+	}
+}
+
+/// Skip over a form whose open paren has already been read.
+void SexprParser::skip_form(void)
+{
+	int depth = 1;
+	while (0 < depth)
+	{
+		skip_space();
+		if (_end <= _p) syntax_error("Unexpected end of input");
+		char c = *_p;
+		if ('"' == c) { get_string(); continue; }
+		if ('(' == c) depth++;
+		else if (')' == c) depth--;
+		_p++;
+	}
+}
+
+void SexprParser::expect(char c)
+{
+	skip_space();
+	if (_end <= _p or c != *_p)
+	{
+		char msg[] = "Expecting a ' '";
+		msg[sizeof(msg) - 3] = c;
+		syntax_error(msg);
+	}
+	_p++;
+}
+
+const std::string& SexprParser::get_symbol(void)
+{
+	skip_space();
+	const char* start = _p;
+	while (_p < _end and not is_delim(*_p)) _p++;
+	if (start == _p) syntax_error("Expecting a symbol");
+	_sym.assign(start, _p - start);
+	return _sym;
+}
+
+/// A double-quoted string, with the scheme escapes.
+std::string SexprParser::get_string(void)
+{
+	skip_space();
+	if (_end <= _p or '"' != *_p) syntax_error("Expecting a string");
+	_p++;
+
+	std::string str;
+	while (true)
+	{
+		// Copy the plain runs in one go.
+		const char* start = _p;
+		while (_p < _end and '"' != *_p and '\\' != *_p) _p++;
+		str.append(start, _p - start);
+		if (_end <= _p) syntax_error("Unterminated string");
+		if ('"' == *_p++) return str;
+
+		if (_end <= _p) syntax_error("Unterminated string");
+		char c = *_p++;
+		switch (c)
+		{
+			case 'n': str += '\n'; break;
+			case 't': str += '\t'; break;
+			case 'r': str += '\r'; break;
+			case 'a': str += '\a'; break;
+			case 'f': str += '\f'; break;
+			case 'v': str += '\v'; break;
+			case 'b': str += '\b'; break;
+			case '0': str += '\0'; break;
+			case '\n':
+				// A line continuation; the leading blanks go too.
+				while (_p < _end and (' ' == *_p or '\t' == *_p)) _p++;
+				break;
+			default: str += c; break;
+		}
+	}
+}
+
+double SexprParser::get_number(void)
+{
+	skip_space();
+	const char* start = _p;
+	while (_p < _end and not is_delim(*_p)) _p++;
+
+	// The text need not be null-terminated; copy it out for strtod.
+	char buf[64];
+	size_t len = _p - start;
+	if (0 == len or sizeof(buf) <= len) syntax_error("Expecting a number");
+	memcpy(buf, start, len);
+	buf[len] = 0;
+
+	char* rest;
+	double d = strtod(buf, &rest);
+	if (rest != buf + len) syntax_error("Expecting a number");
+	return d;
+}
+
+/// Look up a type by the name used in the text: the full name, or
+/// the name without its Node or Link suffix.
+Type SexprParser::get_type(const std::string& name)
+{
+	auto it = _types.find(name);
+	if (_types.end() != it) return it->second;
+
+	NameServer& ns = nameserver();
+	Type t = ns.getType(name);
+	if (NOTYPE == t) t = ns.getType(name + "Node");
+	if (NOTYPE == t) t = ns.getType(name + "Link");
+	_types.emplace(name, t);
+	return t;
+}
+
+// ---------------------------------------------------------------
+// Expressions
+
+/// The body of an atom, after its type name.
+Handle SexprParser::parse_atom(Type t)
+{
+	Handle h;
+	if (nameserver().isNode(t))
+	{
+		skip_space();
+		if (_end <= _p or ')' == *_p)
+			syntax_error("Expecting a node name");
+		std::string name;
+		if ('"' == *_p)
+			name = get_string();
+		else
+		{
+			// (NumberNode 42) is allowed, as in scheme.
+			const char* start = _p;
+			get_number();
+			name.assign(start, _p - start);
+		}
+
+		// The factories check the atoms that they make.
+		try
+		{
+			h = createNode(t, std::move(name));
+		}
+		catch (const RuntimeException& ex)
+		{
+			syntax_error(ex.get_message());
+		}
+
+		skip_space();
+		while (_p < _end and '(' == *_p)
+		{
+			_p++;
+			ValuePtr vp(parse_value(get_type(get_symbol())));
+			if (not nameserver().isA(vp->get_type(), TRUTH_VALUE))
+				syntax_error("Only a truth value can follow the node name");
+			h->setTruthValue(TruthValueCast(vp));
+			skip_space();
+		}
+		expect(')');
+		_natoms++;
+		return h;
+	}
+
+	HandleSeq oset;
+	TruthValuePtr tv;
+	while (true)
+	{
+		skip_space();
+		if (_end <= _p) syntax_error("Unexpected end of input");
+		if (')' == *_p) break;
+		ValuePtr vp(parse_expr());
+		if (vp->is_atom())
+			oset.emplace_back(HandleCast(vp));
+		else if (nameserver().isA(vp->get_type(), TRUTH_VALUE))
+			tv = TruthValueCast(vp);
+		else
+			syntax_error("Only atoms and a truth value can be in a link");
+	}
+	_p++;
+
+	try
+	{
+		h = createLink(std::move(oset), t);
+	}
+	catch (const RuntimeException& ex)
+	{
+		syntax_error(ex.get_message());
+	}
+	if (tv) h->setTruthValue(tv);
+	_natoms++;
+	return h;
+}
+
+/// The body of a value, or of an atom, after its type name.
+ValuePtr SexprParser::parse_value(Type t)
+{
+	if (NOTYPE == t) syntax_error("Unknown type");
+
+	NameServer& ns = nameserver();
+	if (ns.isAtom(t)) return parse_atom(t);
+
+	if (ns.isA(t, TRUTH_VALUE) or FLOAT_VALUE == t)
+	{
+		std::vector<double> fv;
+		while (skip_space(), _p < _end and ')' != *_p)
+			fv.push_back(get_number());
+		expect(')');
+		if (FLOAT_VALUE == t) return createFloatValue(std::move(fv));
+		try
+		{
+			return ValueCast(TruthValue::factory(t, fv));
+		}
+		catch (const RuntimeException& ex)
+		{
+			syntax_error(ex.get_message());
+		}
+	}
+
+	if (STRING_VALUE == t)
+	{
+		std::vector<std::string> sv;
+		while (skip_space(), _p < _end and ')' != *_p)
+			sv.push_back(get_string());
+		expect(')');
+		return createStringValue(std::move(sv));
+	}
+
+	if (LINK_VALUE == t)
+	{
+		std::vector<ValuePtr> lv;
+		while (skip_space(), _p < _end and ')' != *_p)
+			lv.push_back(parse_expr());
+		expect(')');
+		return createLinkValue(std::move(lv));
+	}
+
+	syntax_error("Unsupported value type");
+}
+
+ValuePtr SexprParser::parse_expr(void)
+{
+	expect('(');
+	return parse_value(get_type(get_symbol()));
+}
+
+Handle SexprParser::parse_handle(void)
+{
+	ValuePtr vp(parse_expr());
+	if (not vp->is_atom()) syntax_error("Expecting an atom");
+	return HandleCast(vp);
+}
+
+/// The atoms held in a value, at any depth. In scheme, these would
+/// have been put into the atomspace when they were made.
+static void get_atoms(const ValuePtr& vp, HandleSeq& out)
+{
+	if (vp->is_atom())
+	{
+		out.emplace_back(HandleCast(vp));
+		return;
+	}
+	if (LINK_VALUE != vp->get_type()) return;
+	for (const ValuePtr& v : LinkValueCast(vp)->value())
+		get_atoms(v, out);
+}
+
+bool SexprParser::next(HandleSeq& out)
+{
+	skip_space();
+	if (_end <= _p) return false;
+	expect('(');
+
+	const std::string& sym = get_symbol();
+	if (sym == "cog-set-tv!")
+	{
+		Handle h(parse_handle());
+		ValuePtr vp(parse_expr());
+		if (not nameserver().isA(vp->get_type(), TRUTH_VALUE))
+			syntax_error("Expecting a truth value");
+		expect(')');
+		h->setTruthValue(TruthValueCast(vp));
+		out.emplace_back(h);
+		return true;
+	}
+
+	if (sym == "cog-set-value!")
+	{
+		Handle h(parse_handle());
+		Handle key(parse_handle());
+		ValuePtr vp(parse_expr());
+		expect(')');
+		h->setValue(key, vp);
+		out.emplace_back(key);
+		get_atoms(vp, out);
+		out.emplace_back(h);
+		return true;
+	}
+
+	if (sym == "use-modules" or sym == "define-module")
+	{
+		skip_form();
+		return true;
+	}
+
+	Type t = get_type(sym);
+	if (NOTYPE == t or not nameserver().isAtom(t))
+		syntax_error("Expecting an atom");
+	out.emplace_back(parse_atom(t));
+	return true;
+}
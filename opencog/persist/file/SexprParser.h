@@ -0,0 +1,106 @@
+/*
+ * opencog/persist/file/SexprParser.h
+ *
+ * Copyright (C) 2019 OpenCog Foundation
+ * All Rights Reserved
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _OPENCOG_SEXPR_PARSER_H
+#define _OPENCOG_SEXPR_PARSER_H
+
+#include <string>
+#include <unordered_map>
+
+#include <opencog/atoms/base/Handle.h>
+#include <opencog/atoms/value/Value.h>
+
+namespace opencog
+{
+/** \addtogroup grp_persist
+ *  @{
+ */
+
+/**
+ * Reads Atomese s-expressions from a block of text, and makes the
+ * atoms that they name, without going through guile. Only the
+ * subset of scheme that is found in data files is understood:
+ *
+ *   (ConceptNode "foo")  (Concept "foo" (stv 0.5 0.8))
+ *   (InheritanceLink (ConceptNode "a") (ConceptNode "b") (ctv 1 0 3))
+ *   (cog-set-tv! ATOM (stv 0.1 0.2))
+ *   (cog-set-value! ATOM KEY (FloatValue 1 2 3))
+ *
+ * Type names may be given with or without the Node or Link suffix.
+ * The values are FloatValue, StringValue, LinkValue and the truth
+ * values, either by type name or by their short names (stv, ctv,
+ * itv, ptv, ftv). Comments, (use-modules ...) and (define-module ...)
+ * are skipped. Anything else is a syntax error.
+ *
+ * The atoms that are made are not in any atomspace; the values are
+ * set on them, to be copied over when the atoms are added.
+ */
+class SexprParser
+{
+	private:
+		const char* _p;
+		const char* _end;
+
+		// Start of the whole text; for the line numbers in errors.
+		const char* _origin;
+
+		size_t _natoms;
+
+		// Type lookups, by the names used in the text. The nameserver
+		// takes a lock for each lookup, which the parsing threads
+		// would all pile up on.
+		std::string _sym;
+		std::unordered_map<std::string, Type> _types;
+
+		[[noreturn]] void syntax_error(const char*);
+		void skip_space(void);
+		void skip_form(void);
+		void expect(char);
+		const std::string& get_symbol(void);
+		std::string get_string(void);
+		double get_number(void);
+		Type get_type(const std::string&);
+
+		Handle parse_atom(Type);
+		ValuePtr parse_value(Type);
+		ValuePtr parse_expr(void);
+		Handle parse_handle(void);
+
+	public:
+		/// Parse the text from begin to end. If it is a part of some
+		/// larger text, then `origin` is the start of that.
+		SexprParser(const char* begin, const char* end,
+		            const char* origin = nullptr);
+
+		/// Parse the next top-level expression, and append the atoms
+		/// that it adds to `out`. Return false at the end of the text.
+		/// Throws SyntaxException, giving the line number.
+		bool next(HandleSeq& out);
+
+		/// Number of atoms made so far, the nested ones included.
+		size_t get_num_atoms(void) const { return _natoms; }
+};
+
+/** @}*/
+} //namespace opencog
+
+#endif // _OPENCOG_SEXPR_PARSER_H
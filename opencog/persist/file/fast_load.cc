@@ -0,0 +1,532 @@
+/*
+ * opencog/persist/file/fast_load.cc
+ *
+ * Copyright (C) 2019 OpenCog Foundation
+ * All Rights Reserved
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#include <opencog/util/exceptions.h>
+#include <opencog/util/Logger.h>
+#include <opencog/atoms/atom_types/NameServer.h>
+#include <opencog/atoms/base/Link.h>
+#include <opencog/atoms/base/Node.h>
+#include <opencog/atoms/truthvalue/TruthValue.h>
+#include <opencog/atoms/value/FloatValue.h>
+#include <opencog/atoms/value/LinkValue.h>
+#include <opencog/atoms/value/StringValue.h>
+#include <opencog/atomspace/WorkPool.h>
+
+#include "BinaryFormat.h"
+#include "SexprParser.h"
+#include "fast_load.h"
+
+using namespace opencog;
+
+// Each thread takes a chunk of about this many bytes at a time.
+#define CHUNK_SIZE (1024 * 1024)
+
+// Atoms are handed to the atomspace this many at a time.
+#define BATCH_SIZE 8192
+
+/// Find where to cut the text into chunks of about `chunk` bytes,
+/// each holding whole top-level expressions. This is a single pass
+/// that only tracks the paren depth, the strings and the comments;
+/// it is many times faster than the parsing that follows.
+static std::vector<const char*> cut_chunks(const char* p, const char* end,
+                                           size_t chunk)
+{
+	std::vector<const char*> cuts;
+	cuts.push_back(p);
+
+	long depth = 0;
+	const char* mark = p + chunk;
+	while (p < end)
+	{
+		char c = *p++;
+		if ('(' == c) depth++;
+		else if (')' == c)
+		{
+			depth--;
+			if (0 == depth and mark <= p)
+			{
+				cuts.push_back(p);
+				mark = p + chunk;
+			}
+		}
+		else if ('"' == c)
+		{
+			while (p < end and '"' != *p)
+				p += ('\\' == *p) ? 2 : 1;
+			p++;
+		}
+		else if (';' == c)
+		{
+			const char* nl = (const char*) memchr(p, '\n', end - p);
+			p = nl ? nl : end;
+		}
+		else if ('#' == c and p < end and ('|' == *p or '!' == *p))
+		{
+			char close = *p++;
+			while (p + 1 < end and not (close == p[0] and '#' == p[1])) p++;
+			p += 2;
+		}
+	}
+
+	// The last chunk gets whatever is left over, including any
+	// unbalanced parens, for the parser to complain about.
+	if (cuts.back() < end) cuts.push_back(end);
+	return cuts;
+}
+
+/// Read the chunks in parallel, but add them to the atomspace in
+/// chunk order, so that an atom given values in several places ends
+/// up with the last ones, as it would with a plain, serial load.
+/// `make(i)` returns the reader for the i'th chunk. Each thread parses
+/// its chunk into batches, and then adds those of all the chunks that
+/// are ready, in order, unless some other thread is already doing
+/// that. Returns the number of atoms read.
+template<typename Make>
+static size_t load_chunks(size_t nchunks, AtomSpace& as, Make make)
+{
+	std::atomic<size_t> natoms(0);
+	std::vector<std::vector<HandleSeq>> parsed(nchunks);
+	std::vector<bool> ready(nchunks, false);
+	std::mutex mtx;
+	size_t next = 0;
+	bool adding = false;
+
+	// Add the chunks that are ready, from `next` on, until one that
+	// is not. The lock is not held while adding.
+	auto drain = [&](void)
+	{
+		std::unique_lock<std::mutex> lck(mtx);
+		if (adding) return;
+		adding = true;
+		while (next < nchunks and ready[next])
+		{
+			std::vector<HandleSeq> batches;
+			batches.swap(parsed[next++]);
+			lck.unlock();
+			try
+			{
+				for (const HandleSeq& batch : batches)
+					if (not batch.empty()) as.add_atoms(batch);
+			}
+			catch (...)
+			{
+				lck.lock();
+				adding = false;
+				throw;
+			}
+			lck.lock();
+		}
+		adding = false;
+	};
+
+	auto body = [&](size_t i)
+	{
+		auto reader(make(i));
+		std::vector<HandleSeq> batches(1);
+		batches.back().reserve(BATCH_SIZE);
+		while (reader.next(batches.back()))
+		{
+			if (BATCH_SIZE <= batches.back().size())
+			{
+				batches.emplace_back();
+				batches.back().reserve(BATCH_SIZE);
+			}
+		}
+		natoms += reader.get_num_atoms();
+		{
+			std::lock_guard<std::mutex> lck(mtx);
+			parsed[i].swap(batches);
+			ready[i] = true;
+		}
+		drain();
+	};
+
+	// If a chunk is bad, still add the ones ahead of it that got
+	// read, as a serial load would have.
+	try
+	{
+		work_pool().for_each(nchunks, body);
+	}
+	catch (...)
+	{
+		drain();
+		throw;
+	}
+	return natoms;
+}
+
+// ---------------------------------------------------------------
+
+/// Decodes one block of the binary format; see BinaryFormat.h.
+class BinaryReader
+{
+	const char* _p;
+	const char* _end;
+	const std::vector<Type>& _types;
+	std::vector<ValuePtr> _stack;
+	size_t _natoms;
+
+	[[noreturn]] static void corrupt(void)
+	{
+		throw IOException(TRACE_INFO, "Bad or truncated binary data");
+	}
+
+	uint64_t get_varint(void)
+	{
+		uint64_t v;
+		if (not bin_get_varint(_p, _end, v)) corrupt();
+		return v;
+	}
+
+	size_t get_count(size_t min_bytes)
+	{
+		uint64_t n = get_varint();
+		if ((uint64_t) (_end - _p) / min_bytes < n) corrupt();
+		return n;
+	}
+
+	std::string get_string(void)
+	{
+		size_t len = get_count(1);
+		std::string s(_p, len);
+		_p += len;
+		return s;
+	}
+
+	Type get_type(void)
+	{
+		uint64_t code = get_varint();
+		if (_types.size() <= code or NOTYPE == _types[code])
+			throw IOException(TRACE_INFO,
+				"Binary data holds a type that is not known here");
+		return _types[code];
+	}
+
+	ValuePtr pop(void)
+	{
+		if (_stack.empty()) corrupt();
+		ValuePtr vp(_stack.back());
+		_stack.pop_back();
+		return vp;
+	}
+
+	Handle top_atom(void)
+	{
+		if (_stack.empty() or not _stack.back()->is_atom()) corrupt();
+		return HandleCast(_stack.back());
+	}
+
+public:
+	BinaryReader(const char* begin, const char* end,
+	             const std::vector<Type>& types) :
+		_p(begin), _end(end), _types(types), _natoms(0) {}
+
+	size_t get_num_atoms(void) const { return _natoms; }
+
+	bool next(HandleSeq& out)
+	{
+		while (_p < _end)
+		{
+			char op = *_p++;
+			switch (op)
+			{
+				case BIN_NODE:
+				{
+					Type t = get_type();
+					_stack.emplace_back(createNode(t, get_string()));
+					_natoms++;
+					break;
+				}
+				case BIN_LINK:
+				{
+					Type t = get_type();
+					size_t arity = get_varint();
+					if (_stack.size() < arity) corrupt();
+					HandleSeq oset;
+					oset.reserve(arity);
+					for (auto it = _stack.end() - arity; it != _stack.end(); it++)
+					{
+						if (not (*it)->is_atom()) corrupt();
+						oset.emplace_back(HandleCast(*it));
+					}
+					_stack.resize(_stack.size() - arity);
+					_stack.emplace_back(createLink(std::move(oset), t));
+					_natoms++;
+					break;
+				}
+				case BIN_FLOATS:
+				{
+					Type t = get_type();
+					size_t n = get_count(8);
+					std::vector<double> fv(n);
+					for (size_t i = 0; i < n; i++, _p += 8)
+					{
+						uint64_t v = 0;
+						for (int b = 0; b < 8; b++)
+							v |= ((uint64_t) (unsigned char) _p[b]) << (8 * b);
+						memcpy(&fv[i], &v, sizeof(double));
+					}
+					if (FLOAT_VALUE == t)
+						_stack.emplace_back(createFloatValue(std::move(fv)));
+					else if (nameserver().isA(t, TRUTH_VALUE))
+						_stack.emplace_back(ValueCast(TruthValue::factory(t, fv)));
+					else corrupt();
+					break;
+				}
+				case BIN_STRINGS:
+				{
+					get_type();
+					size_t n = get_count(1);
+					std::vector<std::string> sv;
+					sv.reserve(n);
+					for (size_t i = 0; i < n; i++)
+						sv.emplace_back(get_string());
+					_stack.emplace_back(createStringValue(std::move(sv)));
+					break;
+				}
+				case BIN_LINKVALUE:
+				{
+					get_type();
+					size_t n = get_varint();
+					if (_stack.size() < n) corrupt();
+					std::vector<ValuePtr> lv(_stack.end() - n, _stack.end());
+					_stack.resize(_stack.size() - n);
+					_stack.emplace_back(createLinkValue(std::move(lv)));
+					break;
+				}
+				case BIN_TV:
+				{
+					TruthValuePtr tv(TruthValueCast(pop()));
+					if (nullptr == tv) corrupt();
+					top_atom()->setTruthValue(tv);
+					break;
+				}
+				case BIN_VALUE:
+				{
+					ValuePtr vp(pop());
+					ValuePtr key(pop());
+					if (not key->is_atom()) corrupt();
+					top_atom()->setValue(HandleCast(key), vp);
+
+					// As in scheme, the key goes into the atomspace.
+					out.emplace_back(HandleCast(key));
+					break;
+				}
+				case BIN_ROOT:
+				{
+					out.emplace_back(top_atom());
+					_stack.pop_back();
+					return true;
+				}
+				default:
+					corrupt();
+			}
+		}
+		if (not _stack.empty()) corrupt();
+		return false;
+	}
+};
+
+static size_t load_binary(const char* base, size_t len, AtomSpace& as)
+{
+	const char* p = base + BINARY_MAGIC_LEN;
+	const char* end = base + len;
+
+	// The type table, by name, so that the type codes of the writer
+	// need not match the ones here.
+	uint64_t ntypes;
+	if (not bin_get_varint(p, end, ntypes))
+		throw IOException(TRACE_INFO, "Bad or truncated binary data");
+	std::vector<Type> types;
+	NameServer& ns = nameserver();
+	for (uint64_t i = 0; i < ntypes; i++)
+	{
+		uint64_t nlen;
+		if (not bin_get_varint(p, end, nlen) or (uint64_t) (end - p) < nlen)
+			throw IOException(TRACE_INFO, "Bad or truncated binary data");
+		types.push_back(ns.getType(std::string(p, nlen)));
+		p += nlen;
+	}
+
+	// The blocks; each holds whole expressions.
+	std::vector<std::pair<const char*, const char*>> blocks;
+	while (p < end)
+	{
+		if (end - p < 4 or (size_t) (end - p - 4) < bin_get_u32(p))
+			throw IOException(TRACE_INFO, "Bad or truncated binary data");
+		const char* begin = p + 4;
+		p = begin + bin_get_u32(p);
+		blocks.emplace_back(begin, p);
+	}
+
+	return load_chunks(blocks.size(), as, [&](size_t i) {
+		return BinaryReader(blocks[i].first, blocks[i].second, types);
+	});
+}
+
+static size_t load_sexpr(const char* base, size_t len, AtomSpace& as)
+{
+	std::vector<const char*> cuts(cut_chunks(base, base + len, CHUNK_SIZE));
+	return load_chunks(cuts.size() - 1, as, [&](size_t i) {
+		return SexprParser(cuts[i], cuts[i+1], base);
+	});
+}
+
+#ifdef HAVE_ZLIB
+/// Decompress a whole gzip file, of any number of members.
+static std::string gunzip(const char* base, size_t len)
+{
+	z_stream zs;
+	memset(&zs, 0, sizeof(zs));
+	if (Z_OK != inflateInit2(&zs, 15 + 16))
+		throw IOException(TRACE_INFO, "inflateInit failed");
+
+	std::string out(4 * len, 0);
+	size_t done = 0;
+	zs.next_in = (Bytef*) base;
+	zs.avail_in = len;
+	while (true)
+	{
+		if (out.size() == done) out.resize(2 * out.size());
+		zs.next_out = (Bytef*) &out[done];
+		zs.avail_out = out.size() - done;
+
+		int rc = inflate(&zs, Z_NO_FLUSH);
+		done = out.size() - zs.avail_out;
+		if (Z_STREAM_END == rc)
+		{
+			// On to the next member, if there is one.
+			if (0 == zs.avail_in) break;
+			inflateReset(&zs);
+			continue;
+		}
+		if (Z_OK != rc and not (Z_BUF_ERROR == rc and 0 == zs.avail_out))
+		{
+			inflateEnd(&zs);
+			throw IOException(TRACE_INFO, "Bad or truncated gzip data");
+		}
+	}
+	inflateEnd(&zs);
+	out.resize(done);
+	return out;
+}
+#endif
+
+size_t opencog::load_file(const std::string& filename, AtomSpace& as)
+{
+	auto start = std::chrono::steady_clock::now();
+
+	int fd = open(filename.c_str(), O_RDONLY);
+	if (fd < 0)
+		throw IOException(TRACE_INFO, "Cannot open %s: %s",
+			filename.c_str(), strerror(errno));
+
+	struct stat st;
+	if (fstat(fd, &st))
+	{
+		close(fd);
+		throw IOException(TRACE_INFO, "Cannot stat %s: %s",
+			filename.c_str(), strerror(errno));
+	}
+	size_t len = st.st_size;
+	if (0 == len)
+	{
+		close(fd);
+		return 0;
+	}
+
+	void* map = mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (MAP_FAILED == map)
+		throw IOException(TRACE_INFO, "Cannot map %s: %s",
+			filename.c_str(), strerror(errno));
+	madvise(map, len, MADV_SEQUENTIAL);
+
+	size_t natoms;
+	try
+	{
+		const char* base = (const char*) map;
+		size_t tlen = len;
+
+		// Compressed files are expanded in RAM.
+		std::string expanded;
+		if (2 <= len and '\x1f' == base[0] and '\x8b' == base[1])
+		{
+#ifdef HAVE_ZLIB
+			expanded = gunzip(base, len);
+			base = expanded.data();
+			tlen = expanded.size();
+#else
+			throw IOException(TRACE_INFO,
+				"The file is compressed, and zlib is missing");
+#endif
+		}
+
+		if (BINARY_MAGIC_LEN <= tlen and
+		    0 == memcmp(base, BINARY_MAGIC, BINARY_MAGIC_LEN))
+			natoms = load_binary(base, tlen, as);
+		else
+			natoms = load_sexpr(base, tlen, as);
+	}
+	catch (const SyntaxException& ex)
+	{
+		munmap(map, len);
+		throw SyntaxException(TRACE_INFO, "%s: %s",
+			filename.c_str(), ex.get_message());
+	}
+	catch (const IOException& ex)
+	{
+		munmap(map, len);
+		throw IOException(TRACE_INFO, "%s: %s",
+			filename.c_str(), ex.get_message());
+	}
+	catch (...)
+	{
+		munmap(map, len);
+		throw;
+	}
+	munmap(map, len);
+
+	std::chrono::duration<double> secs =
+		std::chrono::steady_clock::now() - start;
+	logger().info("load_file: loaded %zu atoms from %s in %f seconds "
+		"(%.0f atoms/sec)", natoms, filename.c_str(), secs.count(),
+		natoms / secs.count());
+
+	return natoms;
+}
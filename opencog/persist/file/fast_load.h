@@ -0,0 +1,57 @@
+/*
+ * opencog/persist/file/fast_load.h
+ *
+ * Copyright (C) 2019 OpenCog Foundation
+ * All Rights Reserved
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _OPENCOG_FAST_LOAD_H
+#define _OPENCOG_FAST_LOAD_H
+
+#include <string>
+
+#include <opencog/atomspace/AtomSpace.h>
+
+namespace opencog
+{
+/** \addtogroup grp_persist
+ *  @{
+ */
+
+/**
+ * Load a file of Atomese s-expressions into the atomspace, without
+ * going through guile. The file is split into chunks, at top-level
+ * expressions, and the chunks are parsed in parallel; the atoms are
+ * added in batches, in file order. See SexprParser for what is
+ * understood.
+ *
+ * As with a serial load, an atom that is given different values in
+ * different parts of the file ends up with the last ones.
+ *
+ * Returns the number of atoms read, the nested ones included. The
+ * rate, in atoms per second, is logged at the INFO level. Throws
+ * IOException if the file can't be read, and SyntaxException on bad
+ * input. Some or all of the chunks ahead of the bad one may have
+ * been added by then; nothing after it is.
+ */
+size_t load_file(const std::string& filename, AtomSpace& as);
+
+/** @}*/
+} //namespace opencog
+
+#endif // _OPENCOG_FAST_LOAD_H
@@ -0,0 +1,539 @@
+/*
+ * opencog/persist/file/fast_store.cc
+ *
+ * Copyright (C) 2019 OpenCog Foundation
+ * All Rights Reserved
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#include <opencog/util/exceptions.h>
+#include <opencog/util/Logger.h>
+#include <opencog/atoms/atom_types/NameServer.h>
+#include <opencog/atoms/base/Node.h>
+#include <opencog/atoms/truthvalue/TruthValue.h>
+#include <opencog/atoms/value/FloatValue.h>
+#include <opencog/atoms/value/LinkValue.h>
+#include <opencog/atoms/value/StringValue.h>
+#include <opencog/atomspace/WorkPool.h>
+
+#include "BinaryFormat.h"
+#include "fast_store.h"
+
+using namespace opencog;
+
+// Each thread writes out its buffer when it gets this big.
+#define FLUSH_SIZE (1024 * 1024)
+
+/// Where the output of all of the threads goes. The buffers are
+/// compressed by the threads that filled them; only the write itself
+/// is serialized.
+class DumpSink
+{
+	int _fd;
+	bool _compress;
+	std::mutex _mtx;
+
+public:
+	DumpSink(int fd, bool compress) : _fd(fd), _compress(compress)
+	{
+#ifndef HAVE_ZLIB
+		if (compress)
+			throw IOException(TRACE_INFO,
+				"dump_atoms: compression needs zlib, which is missing");
+#endif
+	}
+
+	void write(const std::string& buf)
+	{
+		if (buf.empty()) return;
+#ifdef HAVE_ZLIB
+		if (_compress)
+		{
+			std::string gz(gzip(buf));
+			std::lock_guard<std::mutex> lck(_mtx);
+			write_all(gz);
+			return;
+		}
+#endif
+		std::lock_guard<std::mutex> lck(_mtx);
+		write_all(buf);
+	}
+
+private:
+	void write_all(const std::string& buf)
+	{
+		const char* p = buf.data();
+		size_t left = buf.size();
+		while (0 < left)
+		{
+			ssize_t n = ::write(_fd, p, left);
+			if (n < 0)
+			{
+				if (EINTR == errno) continue;
+				throw IOException(TRACE_INFO, "dump_atoms: write failed: %s",
+					strerror(errno));
+			}
+			p += n;
+			left -= n;
+		}
+	}
+
+#ifdef HAVE_ZLIB
+	/// A complete gzip member. A gzip file may hold any number of
+	/// these back to back; they are decompressed as one.
+	static std::string gzip(const std::string& in)
+	{
+		z_stream zs;
+		memset(&zs, 0, sizeof(zs));
+		if (Z_OK != deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+		                         15 + 16, 8, Z_DEFAULT_STRATEGY))
+			throw IOException(TRACE_INFO, "dump_atoms: deflateInit failed");
+
+		std::string out;
+		out.resize(deflateBound(&zs, in.size()));
+		zs.next_in = (Bytef*) in.data();
+		zs.avail_in = in.size();
+		zs.next_out = (Bytef*) &out[0];
+		zs.avail_out = out.size();
+		int rc = deflate(&zs, Z_FINISH);
+		out.resize(zs.total_out);
+		deflateEnd(&zs);
+		if (Z_STREAM_END != rc)
+			throw IOException(TRACE_INFO, "dump_atoms: deflate failed");
+		return out;
+	}
+#endif
+};
+
+// ---------------------------------------------------------------
+
+/// Writes atoms into a buffer, and the buffer into the sink. There
+/// is one of these for each thread.
+///
+/// Each atom of a wanted type has a record of its own, and its truth
+/// value is written there, just once. Inside of other atoms, it is
+/// written bare; only atoms of the other types, which have no record
+/// of their own, carry their truth value along inside each link.
+class Dumper
+{
+	DumpSink& _sink;
+	DumpFormat _fmt;
+	const std::vector<std::string>& _names;
+	const std::vector<bool>& _wanted;
+	const Handle& _tv_key;
+	std::string _buf;
+
+	void sexpr_string(const std::string&);
+	void sexpr_double(double);
+	void sexpr_atom(const Handle&, bool with_tv);
+	void sexpr_value(const ValuePtr&);
+
+	void bin_atom(const Handle&, bool with_tv);
+	void bin_value(const ValuePtr&);
+
+	static bool can_write(const ValuePtr&);
+	void start_block(void);
+
+public:
+	Dumper(DumpSink& sink, DumpFormat fmt,
+	       const std::vector<std::string>& names,
+	       const std::vector<bool>& wanted, const Handle& tv_key) :
+		_sink(sink), _fmt(fmt), _names(names), _wanted(wanted),
+		_tv_key(tv_key)
+	{
+		_buf.reserve(FLUSH_SIZE + FLUSH_SIZE / 8);
+		start_block();
+	}
+
+	void dump(const Handle&, bool whole);
+	void flush(void);
+};
+
+/// Only these values can be written; the others (streams, mostly)
+/// are computed on the fly, and have no meaning in a file.
+bool Dumper::can_write(const ValuePtr& vp)
+{
+	if (nullptr == vp) return false;
+	Type t = vp->get_type();
+	return vp->is_atom() or FLOAT_VALUE == t or STRING_VALUE == t
+		or LINK_VALUE == t or nameserver().isA(t, TRUTH_VALUE);
+}
+
+void Dumper::start_block(void)
+{
+	// Room for the byte count, filled in by flush().
+	if (DUMP_BINARY == _fmt) _buf.assign(4, 0);
+}
+
+void Dumper::flush(void)
+{
+	if (DUMP_BINARY == _fmt)
+	{
+		if (4 == _buf.size()) return;
+		std::string len;
+		bin_put_u32(len, _buf.size() - 4);
+		_buf.replace(0, 4, len);
+	}
+	_sink.write(_buf);
+	_buf.clear();
+	start_block();
+}
+
+/// Write the atom, if `whole` is set, and then its values. If the
+/// atom is not whole, it was written inside of some other atom, but
+/// without its truth value; that is written here.
+void Dumper::dump(const Handle& h, bool whole)
+{
+	HandleSet keys(h->getKeys());
+	keys.erase(_tv_key);
+	TruthValuePtr tv(h->getTruthValue());
+
+	if (DUMP_SEXPR == _fmt)
+	{
+		if (whole)
+		{
+			sexpr_atom(h, true);
+			_buf += '\n';
+		}
+		else if (not tv->isDefaultTV())
+		{
+			_buf += "(cog-set-tv! ";
+			sexpr_atom(h, false);
+			_buf += ' ';
+			sexpr_value(ValueCast(tv));
+			_buf += ")\n";
+		}
+		for (const Handle& key : keys)
+		{
+			ValuePtr vp(h->getValue(key));
+			if (not can_write(vp)) continue;
+			_buf += "(cog-set-value! ";
+			sexpr_atom(h, false);
+			_buf += ' ';
+			sexpr_atom(key, false);
+			_buf += ' ';
+			sexpr_value(vp);
+			_buf += ")\n";
+		}
+	}
+	else
+	{
+		bool any = false;
+		for (const Handle& key : keys)
+			any = any or can_write(h->getValue(key));
+		if (not whole and not any and tv->isDefaultTV()) return;
+
+		bin_atom(h, true);
+		for (const Handle& key : keys)
+		{
+			ValuePtr vp(h->getValue(key));
+			if (not can_write(vp)) continue;
+			bin_atom(key, false);
+			bin_value(vp);
+			_buf += BIN_VALUE;
+		}
+		_buf += BIN_ROOT;
+	}
+
+	if (FLUSH_SIZE <= _buf.size()) flush();
+}
+
+// ---------------------------------------------------------------
+// S-expressions
+
+void Dumper::sexpr_string(const std::string& str)
+{
+	_buf += '"';
+	for (char c : str)
+	{
+		if ('"' == c or '\\' == c) _buf += '\\';
+		_buf += c;
+	}
+	_buf += '"';
+}
+
+/// The shortest form that reads back to the same double.
+void Dumper::sexpr_double(double d)
+{
+	char tmp[32];
+	snprintf(tmp, sizeof(tmp), "%.15g", d);
+	if (strtod(tmp, nullptr) != d)
+		snprintf(tmp, sizeof(tmp), "%.17g", d);
+	_buf += tmp;
+}
+
+void Dumper::sexpr_atom(const Handle& h, bool with_tv)
+{
+	_buf += '(';
+	_buf += _names[h->get_type()];
+
+	// The truth value goes after the name of a node, and before the
+	// outgoing set of a link, as guile prints them.
+	if (h->is_node())
+	{
+		_buf += ' ';
+		sexpr_string(h->get_name());
+	}
+
+	if (with_tv)
+	{
+		TruthValuePtr tv(h->getTruthValue());
+		if (not tv->isDefaultTV())
+		{
+			_buf += ' ';
+			sexpr_value(ValueCast(tv));
+		}
+	}
+
+	if (h->is_link())
+	{
+		for (const Handle& ho : h->getOutgoingSet())
+		{
+			_buf += ' ';
+			sexpr_atom(ho, with_tv and not _wanted[ho->get_type()]);
+		}
+	}
+	_buf += ')';
+}
+
+void Dumper::sexpr_value(const ValuePtr& vp)
+{
+	if (vp->is_atom())
+	{
+		sexpr_atom(HandleCast(vp), false);
+		return;
+	}
+
+	Type t = vp->get_type();
+	_buf += '(';
+
+	// The short names take the same numbers as the types do.
+	if (SIMPLE_TRUTH_VALUE == t) _buf += "stv";
+	else if (COUNT_TRUTH_VALUE == t) _buf += "ctv";
+	else if (PROBABILISTIC_TRUTH_VALUE == t) _buf += "ptv";
+	else if (FUZZY_TRUTH_VALUE == t) _buf += "ftv";
+	else _buf += _names[t];
+
+	if (STRING_VALUE == t)
+	{
+		for (const std::string& s : StringValueCast(vp)->value())
+		{
+			_buf += ' ';
+			sexpr_string(s);
+		}
+	}
+	else if (LINK_VALUE == t)
+	{
+		for (const ValuePtr& v : LinkValueCast(vp)->value())
+		{
+			if (not can_write(v)) continue;
+			_buf += ' ';
+			sexpr_value(v);
+		}
+	}
+	else
+	{
+		for (double d : FloatValueCast(vp)->value())
+		{
+			_buf += ' ';
+			sexpr_double(d);
+		}
+	}
+	_buf += ')';
+}
+
+// ---------------------------------------------------------------
+// Binary
+
+void Dumper::bin_atom(const Handle& h, bool with_tv)
+{
+	if (h->is_node())
+	{
+		_buf += BIN_NODE;
+		bin_put_varint(_buf, h->get_type());
+		bin_put_string(_buf, h->get_name());
+	}
+	else
+	{
+		const HandleSeq& oset = h->getOutgoingSet();
+		for (const Handle& ho : oset)
+			bin_atom(ho, with_tv and not _wanted[ho->get_type()]);
+		_buf += BIN_LINK;
+		bin_put_varint(_buf, h->get_type());
+		bin_put_varint(_buf, oset.size());
+	}
+
+	if (with_tv)
+	{
+		TruthValuePtr tv(h->getTruthValue());
+		if (not tv->isDefaultTV())
+		{
+			bin_value(ValueCast(tv));
+			_buf += BIN_TV;
+		}
+	}
+}
+
+void Dumper::bin_value(const ValuePtr& vp)
+{
+	if (vp->is_atom())
+	{
+		bin_atom(HandleCast(vp), false);
+		return;
+	}
+
+	Type t = vp->get_type();
+	if (STRING_VALUE == t)
+	{
+		const std::vector<std::string>& sv = StringValueCast(vp)->value();
+		_buf += BIN_STRINGS;
+		bin_put_varint(_buf, t);
+		bin_put_varint(_buf, sv.size());
+		for (const std::string& s : sv)
+			bin_put_string(_buf, s);
+	}
+	else if (LINK_VALUE == t)
+	{
+		size_t n = 0;
+		for (const ValuePtr& v : LinkValueCast(vp)->value())
+		{
+			if (not can_write(v)) continue;
+			bin_value(v);
+			n++;
+		}
+		_buf += BIN_LINKVALUE;
+		bin_put_varint(_buf, t);
+		bin_put_varint(_buf, n);
+	}
+	else
+	{
+		const std::vector<double>& fv = FloatValueCast(vp)->value();
+		_buf += BIN_FLOATS;
+		bin_put_varint(_buf, t);
+		bin_put_varint(_buf, fv.size());
+		for (double d : fv)
+			bin_put_double(_buf, d);
+	}
+}
+
+// ---------------------------------------------------------------
+
+size_t opencog::dump_atoms(int fd, AtomSpace& as, Type t, bool subclass,
+                           DumpFormat fmt, bool compress)
+{
+	auto start = std::chrono::steady_clock::now();
+	DumpSink sink(fd, compress);
+
+	// The type names, looked up once; and the types to be written.
+	NameServer& ns = nameserver();
+	Type ntypes = ns.getNumberOfClasses();
+	std::vector<std::string> names(ntypes);
+	std::vector<bool> wanted(ntypes, false);
+	std::vector<Type> types;
+	for (Type ty = 0; ty < ntypes; ty++)
+	{
+		names[ty] = ns.getTypeName(ty);
+		wanted[ty] = subclass ? ns.isA(ty, t) : ty == t;
+		if (wanted[ty] and ns.isAtom(ty)) types.push_back(ty);
+	}
+
+	if (DUMP_BINARY == fmt)
+	{
+		std::string hdr(BINARY_MAGIC);
+		bin_put_varint(hdr, ntypes);
+		for (const std::string& name : names)
+			bin_put_string(hdr, name);
+		sink.write(hdr);
+	}
+
+	Handle tv_key(createNode(PREDICATE_NODE, "*-TruthValueKey-*"));
+
+	std::atomic<size_t> count(0);
+	work_pool().for_each(types.size(), [&](size_t i)
+	{
+		Dumper dumper(sink, fmt, names, wanted, tv_key);
+		size_t n = 0;
+		as.foreach_handle_by_type([&](const Handle& h)->bool
+		{
+			// Atoms that are a part of some other atom being written
+			// get written with it.
+			bool whole = true;
+			if (0 < h->getIncomingSetSize())
+			{
+				for (const Handle& l : h->getIncomingSet(&as))
+				{
+					Type lt = l->get_type();
+					if (lt < ntypes and wanted[lt]) { whole = false; break; }
+				}
+			}
+			dumper.dump(h, whole);
+			n++;
+			return false;
+		}, types[i]);
+		dumper.flush();
+		count += n;
+	});
+
+	std::chrono::duration<double> secs =
+		std::chrono::steady_clock::now() - start;
+	logger().info("dump_atoms: wrote %zu atoms in %f seconds "
+		"(%.0f atoms/sec)", count.load(), secs.count(),
+		count.load() / secs.count());
+
+	return count;
+}
+
+size_t opencog::dump_file(const std::string& filename, AtomSpace& as,
+                          Type t, bool subclass, DumpFormat fmt,
+                          bool compress)
+{
+	int fd = open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0)
+		throw IOException(TRACE_INFO, "Cannot open %s: %s",
+			filename.c_str(), strerror(errno));
+
+	size_t count;
+	try
+	{
+		count = dump_atoms(fd, as, t, subclass, fmt, compress);
+	}
+	catch (...)
+	{
+		close(fd);
+		throw;
+	}
+	if (close(fd))
+		throw IOException(TRACE_INFO, "Cannot close %s: %s",
+			filename.c_str(), strerror(errno));
+	return count;
+}
@@ -0,0 +1,77 @@
+/*
+ * opencog/persist/file/fast_store.h
+ *
+ * Copyright (C) 2019 OpenCog Foundation
+ * All Rights Reserved
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _OPENCOG_FAST_STORE_H
+#define _OPENCOG_FAST_STORE_H
+
+#include <string>
+
+#include <opencog/atomspace/AtomSpace.h>
+
+namespace opencog
+{
+/** \addtogroup grp_persist
+ *  @{
+ */
+
+enum DumpFormat
+{
+	DUMP_SEXPR,     // Atomese s-expressions, as (load) reads them.
+	DUMP_BINARY,    // Compact; see BinaryFormat.h.
+};
+
+/**
+ * Write the atoms of type t (and its subtypes, if subclass is set) to
+ * the file descriptor fd, along with their values. Both formats can
+ * be read back with load_file(); uncompressed s-expressions can also
+ * be loaded into guile, with (load).
+ *
+ * Each atom is written as a complete expression, holding its
+ * outgoing set; an atom that sits in the outgoing set of another
+ * atom that is being written is written only as a part of that one.
+ * Values other than truth values are written with cog-set-value!.
+ *
+ * The types are written in parallel, on the threads of the
+ * WorkPool. No list of all the atoms is ever made: the atoms are
+ * visited a shard at a time, and the output is buffered a megabyte
+ * at a time for each thread.
+ *
+ * If compress is set, the output is in gzip format, made of many
+ * gzip members, one for each buffer; gunzip and zcat read it as a
+ * single file. This needs zlib; without it, IOException is thrown.
+ *
+ * Returns the number of atoms written. The rate is logged at the
+ * INFO level.
+ */
+size_t dump_atoms(int fd, AtomSpace& as, Type t = ATOM,
+                  bool subclass = true, DumpFormat fmt = DUMP_SEXPR,
+                  bool compress = false);
+
+/// As above, writing (and truncating) the named file.
+size_t dump_file(const std::string& filename, AtomSpace& as,
+                 Type t = ATOM, bool subclass = true,
+                 DumpFormat fmt = DUMP_SEXPR, bool compress = false);
+
+/** @}*/
+} //namespace opencog
+
+#endif // _OPENCOG_FAST_STORE_H
@@ -47,6 +47,12 @@ void PersistSCM::init(void)
 	             &PersistSCM::fetch_incoming_by_type, this, "persist");
 	define_scheme_primitive("store-atom",
 	             &PersistSCM::store_atom, this, "persist");
+	define_scheme_primitive("fetch-atoms",
+	             &PersistSCM::fetch_atoms, this, "persist");
+	define_scheme_primitive("fetch-incoming-sets",
+	             &PersistSCM::fetch_incoming_sets, this, "persist");
+	define_scheme_primitive("store-atoms",
+	             &PersistSCM::store_atoms, this, "persist");
 	define_scheme_primitive("load-atoms-of-type",
 	             &PersistSCM::load_type, this, "persist");
 	define_scheme_primitive("load-atomspace",
@@ -55,6 +61,10 @@ void PersistSCM::init(void)
 	             &PersistSCM::store_atomspace, this, "persist");
 	define_scheme_primitive("barrier",
 	             &PersistSCM::barrier, this, "persist");
+	define_scheme_primitive("set-atom-budget",
+	             &PersistSCM::set_atom_budget, this, "persist");
+	define_scheme_primitive("set-memory-budget",
+	             &PersistSCM::set_memory_budget, this, "persist");
 }
 
 // =====================================================================
@@ -92,6 +102,30 @@ Handle PersistSCM::store_atom(Handle h)
 	return h;
 }
 
+/**
+ * Fetch many atoms at once, in as few round-trips to the backing
+ * store as it can manage.
+ */
+HandleSeq PersistSCM::fetch_atoms(HandleSeq hs)
+{
+	AtomSpace *as = SchemeSmob::ss_get_env_as("fetch-atoms");
+	return as->fetch_atoms(hs);
+}
+
+HandleSeq PersistSCM::fetch_incoming_sets(HandleSeq hs)
+{
+	AtomSpace *as = SchemeSmob::ss_get_env_as("fetch-incoming-sets");
+	as->fetch_incoming_sets(hs);
+	return hs;
+}
+
+HandleSeq PersistSCM::store_atoms(HandleSeq hs)
+{
+	AtomSpace *as = SchemeSmob::ss_get_env_as("store-atoms");
+	as->store_atoms(hs);
+	return hs;
+}
+
 void PersistSCM::load_type(Type t)
 {
 	AtomSpace *as = SchemeSmob::ss_get_env_as("load-atoms-of-type");
@@ -116,6 +150,18 @@ void PersistSCM::barrier(void)
 	as->barrier();
 }
 
+void PersistSCM::set_atom_budget(size_t natoms)
+{
+	AtomSpace *as = SchemeSmob::ss_get_env_as("set-atom-budget");
+	as->set_atom_budget(natoms);
+}
+
+void PersistSCM::set_memory_budget(size_t bytes)
+{
+	AtomSpace *as = SchemeSmob::ss_get_env_as("set-memory-budget");
+	as->set_memory_budget(bytes);
+}
+
 void opencog_persist_init(void)
 {
    static PersistSCM patty;
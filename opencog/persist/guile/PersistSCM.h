@@ -43,10 +43,15 @@ private:
 	Handle fetch_incoming_set(Handle);
 	Handle fetch_incoming_by_type(Handle, Type);
 	Handle store_atom(Handle);
+	HandleSeq fetch_atoms(HandleSeq);
+	HandleSeq fetch_incoming_sets(HandleSeq);
+	HandleSeq store_atoms(HandleSeq);
 	void load_type(Type);
 	void load_atomspace(void);
 	void store_atomspace(void);
 	void barrier(void);
+	void set_atom_budget(size_t);
+	void set_memory_budget(size_t);
 
 public:
 	PersistSCM(void);
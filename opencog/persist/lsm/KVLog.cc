@@ -0,0 +1,231 @@
+/*
+ * opencog/persist/lsm/KVLog.cc
+ *
+ * Copyright (C) 2019 OpenCog Foundation
+ * All Rights Reserved
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <opencog/util/exceptions.h>
+#include <opencog/util/Logger.h>
+#include <opencog/persist/Checksum.h>
+
+#include "KVLog.h"
+
+using namespace opencog;
+
+// Write the buffer out once it gets this big, even without a sync().
+#define LOG_BUFFER_SIZE (1024*1024)
+
+// The first bytes of every log; the last one is the format version.
+static const char LOG_MAGIC[8] = {'O','C','K','V','L','O','G','2'};
+
+static const size_t RECORD_HEADER = 12;
+
+/// The checksum of a record: its length and count, then its payload.
+static uint32_t record_crc(uint32_t len, uint32_t count, const char* payload)
+{
+	uint32_t head[2] = {len, count};
+	return crc32c(payload, len, crc32c(head, sizeof(head)));
+}
+
+/* ================================================================ */
+
+void KVBatch::append(const std::string& key, const char* val, uint32_t vlen)
+{
+	uint32_t klen = key.size();
+	_rep.append((const char*) &klen, sizeof(klen));
+	_rep.append((const char*) &vlen, sizeof(vlen));
+	_rep.append(key);
+	if (KV_TOMBSTONE != vlen) _rep.append(val, vlen);
+	_count++;
+}
+
+/// Returns false if the payload is malformed.
+bool KVBatch::decode(const char* p, size_t len, const Visitor& f)
+{
+	const char* end = p + len;
+	while (p < end)
+	{
+		uint32_t klen, vlen;
+		if ((size_t) (end - p) < 2 * sizeof(uint32_t)) return false;
+		memcpy(&klen, p, sizeof(klen)); p += sizeof(klen);
+		memcpy(&vlen, p, sizeof(vlen)); p += sizeof(vlen);
+		bool dead = KV_TOMBSTONE == vlen;
+		if (dead) vlen = 0;
+		if ((size_t) (end - p) < (size_t) klen + vlen) return false;
+		std::string key(p, klen); p += klen;
+		std::string val(p, vlen); p += vlen;
+		f(std::move(key), std::move(val), dead);
+	}
+	return true;
+}
+
+/* ================================================================ */
+
+KVLog::KVLog(const std::string& path) :
+	_path(path), _bytes(0)
+{
+	_fd = open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+	if (_fd < 0)
+		throw IOException(TRACE_INFO, "Cannot open log %s: %s",
+			path.c_str(), strerror(errno));
+	_buf.reserve(LOG_BUFFER_SIZE + RECORD_HEADER);
+
+	struct stat st;
+	if (0 == fstat(_fd, &st) and 0 == st.st_size)
+	{
+		_buf.append(LOG_MAGIC, sizeof(LOG_MAGIC));
+		_bytes += sizeof(LOG_MAGIC);
+	}
+}
+
+KVLog::~KVLog()
+{
+	try { sync(); }
+	catch (const std::exception& ex)
+	{
+		logger().error("KVLog: %s", ex.what());
+	}
+	close(_fd);
+}
+
+void KVLog::write_out(void)
+{
+	const char* p = _buf.data();
+	size_t left = _buf.size();
+	while (0 < left)
+	{
+		ssize_t n = ::write(_fd, p, left);
+		if (n < 0)
+		{
+			if (EINTR == errno) continue;
+			throw IOException(TRACE_INFO, "Cannot write log %s: %s",
+				_path.c_str(), strerror(errno));
+		}
+		p += n;
+		left -= n;
+	}
+	_buf.clear();
+}
+
+void KVLog::append(const KVBatch& batch)
+{
+	uint32_t len = batch._rep.size();
+	uint32_t count = batch._count;
+	uint32_t check = record_crc(len, count, batch._rep.data());
+	_buf.append((const char*) &len, sizeof(len));
+	_buf.append((const char*) &count, sizeof(count));
+	_buf.append((const char*) &check, sizeof(check));
+	_buf.append(batch._rep);
+	_bytes += RECORD_HEADER + len;
+
+	if (LOG_BUFFER_SIZE <= _buf.size()) write_out();
+}
+
+void KVLog::sync(void)
+{
+	write_out();
+	if (fdatasync(_fd))
+		throw IOException(TRACE_INFO, "Cannot sync log %s: %s",
+			_path.c_str(), strerror(errno));
+}
+
+/* ================================================================ */
+
+size_t KVLog::replay(const std::string& path, const KVBatch::Visitor& f,
+                     bool newest)
+{
+	int fd = open(path.c_str(), newest ? O_RDWR : O_RDONLY);
+	if (fd < 0)
+		throw IOException(TRACE_INFO, "Cannot open log %s: %s",
+			path.c_str(), strerror(errno));
+
+	struct stat st;
+	std::string data;
+	if (0 == fstat(fd, &st)) data.resize(st.st_size);
+	size_t got = 0;
+	while (got < data.size())
+	{
+		ssize_t n = read(fd, &data[got], data.size() - got);
+		if (n < 0 and EINTR == errno) continue;
+		if (n <= 0) break;
+		got += n;
+	}
+
+	// A log that was created, but never written to, is empty. Any
+	// other log must start with the magic, unless it was torn while
+	// the magic itself was written.
+	const char* begin = data.data();
+	const char* end = begin + got;
+	const char* p = begin;
+	bool tagged = sizeof(LOG_MAGIC) <= got and
+		0 == memcmp(p, LOG_MAGIC, sizeof(LOG_MAGIC));
+	if (tagged)
+		p += sizeof(LOG_MAGIC);
+	else if (0 < got and not (newest and got < sizeof(LOG_MAGIC)))
+	{
+		close(fd);
+		throw IOException(TRACE_INFO,
+			"Not a log, or a log of another version: %s", path.c_str());
+	}
+
+	// Check each record before applying any of it.
+	size_t nbatch = 0;
+	while (tagged and RECORD_HEADER <= (size_t) (end - p))
+	{
+		uint32_t len, count, check;
+		memcpy(&len, p, sizeof(len));
+		memcpy(&count, p + 4, sizeof(count));
+		memcpy(&check, p + 8, sizeof(check));
+		const char* payload = p + RECORD_HEADER;
+		if ((size_t) (end - payload) < len) break;
+		if (record_crc(len, count, payload) != check) break;
+		if (not KVBatch::decode(payload, len, f)) break;
+		p = payload + len;
+		nbatch++;
+	}
+
+	// Older logs were synced before the next one was started, so only
+	// the newest can have a torn record, from a crash. It is cut off,
+	// so that it is not taken for damage once there is a newer log.
+	if (p != end)
+	{
+		if (not newest)
+		{
+			close(fd);
+			throw IOException(TRACE_INFO, "Corrupt record in log %s, "
+				"at byte %zu", path.c_str(), (size_t) (p - begin));
+		}
+		logger().warn("KVLog: dropping %zu bytes of torn record at the end of %s",
+			(size_t) (end - p), path.c_str());
+		if (ftruncate(fd, p - begin) or fdatasync(fd))
+		{
+			close(fd);
+			throw IOException(TRACE_INFO, "Cannot truncate log %s: %s",
+				path.c_str(), strerror(errno));
+		}
+	}
+	close(fd);
+	return nbatch;
+}
@@ -0,0 +1,115 @@
+/*
+ * opencog/persist/lsm/KVLog.h
+ *
+ * Copyright (C) 2019 OpenCog Foundation
+ * All Rights Reserved
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _OPENCOG_KV_LOG_H
+#define _OPENCOG_KV_LOG_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace opencog
+{
+/** \addtogroup grp_persist
+ *  @{
+ */
+
+/**
+ * A group of puts and deletes that are applied together: after a
+ * crash, either all of them are recovered from the log, or none are.
+ *
+ * The encoding is also the log record payload: for each entry, a
+ * uint32_t key length, a uint32_t value length (KV_TOMBSTONE for a
+ * delete), the key, and the value.
+ */
+class KVBatch
+{
+	friend class KVLog;
+	friend class KVStore;
+
+	std::string _rep;
+	size_t _count;
+
+	void append(const std::string& key, const char* val, uint32_t vlen);
+
+public:
+	KVBatch(void) : _count(0) {}
+
+	void put(const std::string& key, const std::string& val)
+	{ append(key, val.data(), val.size()); }
+	void del(const std::string& key)
+	{ append(key, nullptr, KV_TOMBSTONE); }
+
+	size_t size(void) const { return _count; }
+	bool empty(void) const { return 0 == _count; }
+	void clear(void) { _rep.clear(); _count = 0; }
+
+	/// Call f(key, value, is_delete) on each entry, in order.
+	typedef std::function<void(std::string&&, std::string&&, bool)> Visitor;
+	static bool decode(const char*, size_t, const Visitor&);
+	void foreach(const Visitor& f) const { decode(_rep.data(), _rep.size(), f); }
+
+	static const uint32_t KV_TOMBSTONE = 0xffffffff;
+};
+
+/**
+ * The write-ahead log. Batches are appended to a buffer in memory,
+ * and written to the file when the buffer fills, or at sync(). Only
+ * sync() makes them durable; it is what barrier() waits for.
+ *
+ * The file starts with an eight-byte magic, whose last byte is the
+ * format version. Each record is a uint32_t payload length, a uint32_t
+ * entry count, a uint32_t CRC-32C of the three (see
+ * opencog/persist/Checksum.h), and the payload. A crash can leave a
+ * torn record at the end of the newest log, and only there.
+ */
+class KVLog
+{
+	std::string _path;
+	int _fd;
+	std::string _buf;
+	uint64_t _bytes;
+
+	void write_out(void);
+
+public:
+	KVLog(const std::string& path);
+	~KVLog();
+
+	const std::string& path(void) const { return _path; }
+	uint64_t bytes(void) const { return _bytes; }
+
+	void append(const KVBatch&);
+	void sync(void);
+
+	/// Apply every batch in the log at path, oldest first. Returns
+	/// the number of batches applied. If this is the `newest` log, a
+	/// torn record at its end is dropped, and cut off the file; in
+	/// any other log, a bad record throws.
+	static size_t replay(const std::string& path, const KVBatch::Visitor&,
+	                     bool newest);
+};
+
+/** @}*/
+} //namespace opencog
+
+#endif // _OPENCOG_KV_LOG_H
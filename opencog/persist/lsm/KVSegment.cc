@@ -0,0 +1,305 @@
+/*
+ * opencog/persist/lsm/KVSegment.cc
+ *
+ * Copyright (C) 2019 OpenCog Foundation
+ * All Rights Reserved
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <opencog/util/exceptions.h>
+
+#include "KVLog.h"
+#include "KVSegment.h"
+
+using namespace opencog;
+
+// Put one key into the sparse index for each this many bytes of data.
+#define SEGMENT_BLOCK_SIZE 4096
+
+// The last byte is the format version. Version 1 hashed the keys for
+// the bloom filter with hash_bytes().
+static const char SEGMENT_MAGIC[8] = {'O','C','K','V','S','E','G','2'};
+
+struct SegmentFooter
+{
+	uint64_t index_off;
+	uint64_t index_count;
+	uint64_t bloom_off;
+	uint64_t bloom_words;
+	uint64_t count;
+	uint64_t data_end;
+	char magic[8];
+};
+
+/* ================================================================ */
+
+KVSegment::KVSegment(const std::string& path, uint64_t seq) :
+	_path(path), _seq(seq), _base(nullptr), _len(0)
+{
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		throw IOException(TRACE_INFO, "Cannot open segment %s: %s",
+			path.c_str(), strerror(errno));
+
+	struct stat st;
+	if (fstat(fd, &st) or (size_t) st.st_size < sizeof(SegmentFooter))
+	{
+		close(fd);
+		throw IOException(TRACE_INFO, "Not a segment: %s", path.c_str());
+	}
+
+	_len = st.st_size;
+	void* p = mmap(nullptr, _len, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (MAP_FAILED == p)
+		throw IOException(TRACE_INFO, "Cannot map segment %s: %s",
+			path.c_str(), strerror(errno));
+	_base = (const char*) p;
+
+	SegmentFooter f;
+	memcpy(&f, _base + _len - sizeof(f), sizeof(f));
+	size_t foot = _len - sizeof(f);
+	if (0 == memcmp(f.magic, SEGMENT_MAGIC, sizeof(f.magic) - 1) and
+	    f.magic[7] != SEGMENT_MAGIC[7])
+	{
+		munmap(p, _len);
+		throw IOException(TRACE_INFO, "Segment %s is of version %c, "
+			"not %c", path.c_str(), f.magic[7], SEGMENT_MAGIC[7]);
+	}
+	if (memcmp(f.magic, SEGMENT_MAGIC, sizeof(f.magic)) or
+	    f.data_end > f.index_off or f.index_off > f.bloom_off or
+	    f.bloom_off % sizeof(uint64_t) or
+	    f.bloom_off + f.bloom_words * sizeof(uint64_t) > foot)
+	{
+		munmap(p, _len);
+		throw IOException(TRACE_INFO, "Bad segment: %s", path.c_str());
+	}
+
+	_data_end = _base + f.data_end;
+	_count = f.count;
+	_bloom = (const uint64_t*) (_base + f.bloom_off);
+	_bloom_bits = f.bloom_words * 64;
+
+	const char* ip = _base + f.index_off;
+	_index.reserve(f.index_count);
+	for (uint64_t i = 0; i < f.index_count; i++)
+	{
+		uint32_t klen;
+		uint64_t off;
+		memcpy(&klen, ip, sizeof(klen));
+		KVSlice key(ip + sizeof(klen), klen);
+		memcpy(&off, ip + sizeof(klen) + klen, sizeof(off));
+		_index.push_back({key, off});
+		ip += sizeof(klen) + klen + sizeof(off);
+	}
+}
+
+KVSegment::~KVSegment()
+{
+	munmap((void*) _base, _len);
+}
+
+static inline uint64_t bloom_mix(uint64_t z)
+{
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+	return z ^ (z >> 31);
+}
+
+/// The bits set by a key are kept in the segment files, and so this
+/// must never change; a new hash needs a new SEGMENT_MAGIC. Bytes are
+/// taken in little-endian order, eight at a time, whatever the machine.
+uint64_t KVSegment::bloom_hash(const KVSlice& key)
+{
+	const uint8_t* p = (const uint8_t*) key.data;
+	size_t len = key.size;
+	uint64_t h = bloom_mix(len ^ 0x9e3779b97f4a7c15ull);
+	while (0 < len)
+	{
+		size_t n = std::min(len, (size_t) 8);
+		uint64_t w = 0;
+		for (size_t i = 0; i < n; i++)
+			w |= (uint64_t) p[i] << (8 * i);
+		h = bloom_mix(h ^ w) + 0x9e3779b97f4a7c15ull;
+		p += n;
+		len -= n;
+	}
+	return bloom_mix(h);
+}
+
+bool KVSegment::may_contain(const KVSlice& key) const
+{
+	if (0 == _bloom_bits) return false;
+	bool maybe = true;
+	bloom_probe(bloom_hash(key), _bloom_bits,
+		[&](size_t bit) {
+			if (0 == (_bloom[bit / 64] & (1ULL << (bit % 64)))) maybe = false;
+		});
+	return maybe;
+}
+
+const char* KVSegment::find_block(const KVSlice& key) const
+{
+	auto it = std::upper_bound(_index.begin(), _index.end(), key,
+		[](const KVSlice& k, const std::pair<KVSlice, uint64_t>& e) {
+			return k.compare(e.first) < 0; });
+	if (it == _index.begin()) return _base;
+	return _base + (it - 1)->second;
+}
+
+const char* KVSegment::decode(const char* p, KVSlice& key,
+                              KVSlice& value, bool& dead)
+{
+	uint32_t klen, vlen;
+	memcpy(&klen, p, sizeof(klen));
+	memcpy(&vlen, p + sizeof(klen), sizeof(vlen));
+	p += sizeof(klen) + sizeof(vlen);
+	dead = KVBatch::KV_TOMBSTONE == vlen;
+	if (dead) vlen = 0;
+	key = KVSlice(p, klen);
+	value = KVSlice(p + klen, vlen);
+	return p + klen + vlen;
+}
+
+KVSegment::Found KVSegment::get(const KVSlice& key, std::string& value) const
+{
+	if (not may_contain(key)) return ABSENT;
+
+	KVSlice k, v;
+	bool dead;
+	for (const char* p = find_block(key); p < _data_end; )
+	{
+		p = decode(p, k, v, dead);
+		int rc = k.compare(key);
+		if (rc < 0) continue;
+		if (0 < rc) break;
+		if (dead) return DELETED;
+		value.assign(v.data, v.size);
+		return PRESENT;
+	}
+	return ABSENT;
+}
+
+/* ================================================================ */
+
+KVSegmentCursor::KVSegmentCursor(const KVSegmentPtr& seg) :
+	_seg(seg), _p(seg->data_begin())
+{
+	load();
+}
+
+void KVSegmentCursor::load(void)
+{
+	if (_p >= _seg->data_end()) { _p = nullptr; return; }
+	_next = KVSegment::decode(_p, _key, _value, _dead);
+}
+
+void KVSegmentCursor::seek(const KVSlice& target)
+{
+	_p = _seg->find_block(target);
+	load();
+	while (valid() and _key.compare(target) < 0) next();
+}
+
+/* ================================================================ */
+
+KVSegmentWriter::KVSegmentWriter(const std::string& path) :
+	_path(path), _off(0), _block_start(0), _index_count(0), _count(0)
+{
+	_fh = fopen(path.c_str(), "wb");
+	if (nullptr == _fh)
+		throw IOException(TRACE_INFO, "Cannot create segment %s: %s",
+			path.c_str(), strerror(errno));
+	setvbuf(_fh, nullptr, _IOFBF, 1024*1024);
+}
+
+KVSegmentWriter::~KVSegmentWriter()
+{
+	if (nullptr == _fh) return;
+	fclose(_fh);
+	unlink(_path.c_str());
+}
+
+void KVSegmentWriter::put(const void* p, size_t len)
+{
+	if (len != fwrite(p, 1, len, _fh))
+		throw IOException(TRACE_INFO, "Cannot write segment %s: %s",
+			_path.c_str(), strerror(errno));
+	_off += len;
+}
+
+void KVSegmentWriter::add(const KVSlice& key, const KVSlice& value, bool dead)
+{
+	uint32_t klen = key.size;
+	if (0 == _count or SEGMENT_BLOCK_SIZE <= _off - _block_start)
+	{
+		_index.append((const char*) &klen, sizeof(klen));
+		_index.append(key.data, key.size);
+		_index.append((const char*) &_off, sizeof(_off));
+		_index_count++;
+		_block_start = _off;
+	}
+
+	uint32_t vlen = dead ? KVBatch::KV_TOMBSTONE : value.size;
+	put(&klen, sizeof(klen));
+	put(&vlen, sizeof(vlen));
+	put(key.data, key.size);
+	if (not dead) put(value.data, value.size);
+
+	_hashes.push_back(KVSegment::bloom_hash(key));
+	_count++;
+}
+
+void KVSegmentWriter::finish(void)
+{
+	SegmentFooter f;
+	memset(&f, 0, sizeof(f));
+	f.data_end = _off;
+	f.count = _count;
+	f.index_off = _off;
+	f.index_count = _index_count;
+	put(_index.data(), _index.size());
+
+	static const char zeros[8] = {0};
+	put(zeros, (8 - _off % 8) % 8);
+
+	size_t nbits = std::max((size_t) 64, _count * KVSegment::BLOOM_BITS_PER_KEY);
+	std::vector<uint64_t> bloom((nbits + 63) / 64, 0);
+	nbits = bloom.size() * 64;
+	for (uint64_t h : _hashes)
+		KVSegment::bloom_probe(h, nbits,
+			[&](size_t bit) { bloom[bit / 64] |= 1ULL << (bit % 64); });
+	f.bloom_off = _off;
+	f.bloom_words = bloom.size();
+	put(bloom.data(), bloom.size() * sizeof(uint64_t));
+
+	memcpy(f.magic, SEGMENT_MAGIC, sizeof(f.magic));
+	put(&f, sizeof(f));
+
+	if (fflush(_fh) or fsync(fileno(_fh)))
+		throw IOException(TRACE_INFO, "Cannot sync segment %s: %s",
+			_path.c_str(), strerror(errno));
+	fclose(_fh);
+	_fh = nullptr;
+}
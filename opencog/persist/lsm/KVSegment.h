@@ -0,0 +1,222 @@
+/*
+ * opencog/persist/lsm/KVSegment.h
+ *
+ * Copyright (C) 2019 OpenCog Foundation
+ * All Rights Reserved
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _OPENCOG_KV_SEGMENT_H
+#define _OPENCOG_KV_SEGMENT_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace opencog
+{
+/** \addtogroup grp_persist
+ *  @{
+ */
+
+/// A read-only piece of a string, or of a mapped file.
+struct KVSlice
+{
+	const char* data;
+	size_t size;
+
+	KVSlice(void) : data(nullptr), size(0) {}
+	KVSlice(const char* d, size_t n) : data(d), size(n) {}
+	KVSlice(const std::string& s) : data(s.data()), size(s.size()) {}
+
+	std::string str(void) const { return std::string(data, size); }
+	int compare(const KVSlice& other) const
+	{
+		int rc = memcmp(data, other.data, std::min(size, other.size));
+		if (rc) return rc;
+		return size < other.size ? -1 : size > other.size;
+	}
+	bool starts_with(const KVSlice& pfx) const
+	{
+		return pfx.size <= size and 0 == memcmp(data, pfx.data, pfx.size);
+	}
+};
+
+/// The value of a key in the memtable; a delete is kept as a
+/// tombstone, so that it hides older values in the segments.
+struct KVEntry
+{
+	std::string value;
+	bool dead;
+};
+typedef std::map<std::string, KVEntry> KVMemtable;
+
+/// A position in a sorted run of entries.
+class KVCursor
+{
+public:
+	virtual ~KVCursor() {}
+
+	/// Move to the first key not less than the given key.
+	virtual void seek(const KVSlice&) = 0;
+	virtual bool valid(void) const = 0;
+	virtual void next(void) = 0;
+
+	virtual KVSlice key(void) const = 0;
+	virtual KVSlice value(void) const = 0;
+	virtual bool dead(void) const = 0;
+};
+
+class KVMemCursor : public KVCursor
+{
+	std::shared_ptr<const KVMemtable> _mem;
+	KVMemtable::const_iterator _it;
+
+public:
+	KVMemCursor(const std::shared_ptr<const KVMemtable>& m) :
+		_mem(m), _it(m->begin()) {}
+
+	virtual void seek(const KVSlice& k) { _it = _mem->lower_bound(k.str()); }
+	virtual bool valid(void) const { return _it != _mem->end(); }
+	virtual void next(void) { ++_it; }
+	virtual KVSlice key(void) const { return KVSlice(_it->first); }
+	virtual KVSlice value(void) const { return KVSlice(_it->second.value); }
+	virtual bool dead(void) const { return _it->second.dead; }
+};
+
+/**
+ * An immutable, sorted file of entries. The file is memory-mapped;
+ * the sparse index (one key per few kilobytes of data) and the bloom
+ * filter are read in place.
+ *
+ * Layout: the entries, each encoded as in a KVBatch; the index, as
+ * (uint32_t key length, key, uint64_t offset) triples; the bloom
+ * filter, in uint64_t words; and a fixed-size footer, ending in an
+ * eight-byte magic whose last byte is the format version.
+ */
+class KVSegment
+{
+	std::string _path;
+	uint64_t _seq;
+	const char* _base;
+	size_t _len;
+	const char* _data_end;
+	size_t _count;
+
+	std::vector<std::pair<KVSlice, uint64_t>> _index;
+	const uint64_t* _bloom;
+	size_t _bloom_bits;
+
+	bool may_contain(const KVSlice&) const;
+
+	KVSegment(const KVSegment&) = delete;
+	KVSegment& operator=(const KVSegment&) = delete;
+
+public:
+	KVSegment(const std::string& path, uint64_t seq);
+	~KVSegment();
+
+	const std::string& path(void) const { return _path; }
+	uint64_t seq(void) const { return _seq; }
+	size_t size(void) const { return _count; }
+	size_t bytes(void) const { return _len; }
+
+	enum Found { ABSENT, PRESENT, DELETED };
+	Found get(const KVSlice& key, std::string& value) const;
+
+	/// Offset of the first entry that might hold the key, or after.
+	const char* find_block(const KVSlice&) const;
+	const char* data_begin(void) const { return _base; }
+	const char* data_end(void) const { return _data_end; }
+
+	/// Decode the entry at p; return a pointer to the next one.
+	static const char* decode(const char* p, KVSlice& key,
+	                          KVSlice& value, bool& dead);
+
+	/// The hash of a key, for the bloom filter. It is stored in the
+	/// files, in effect, and so is not hash_bytes(), which may change.
+	static uint64_t bloom_hash(const KVSlice&);
+
+	/// Call f on each of the bloom filter bits for the key hash.
+	template<typename F>
+	static void bloom_probe(uint64_t h, size_t nbits, F f)
+	{
+		uint64_t delta = (h >> 33) | (h << 31);
+		for (int i = 0; i < BLOOM_PROBES; i++, h += delta)
+			f(h % nbits);
+	}
+	static const int BLOOM_PROBES = 7;
+	static const int BLOOM_BITS_PER_KEY = 10;
+};
+
+typedef std::shared_ptr<const KVSegment> KVSegmentPtr;
+
+class KVSegmentCursor : public KVCursor
+{
+	KVSegmentPtr _seg;
+	const char* _p;
+	const char* _next;
+	KVSlice _key, _value;
+	bool _dead;
+
+	void load(void);
+
+public:
+	KVSegmentCursor(const KVSegmentPtr&);
+
+	virtual void seek(const KVSlice&);
+	virtual bool valid(void) const { return nullptr != _p; }
+	virtual void next(void) { _p = _next; load(); }
+	virtual KVSlice key(void) const { return _key; }
+	virtual KVSlice value(void) const { return _value; }
+	virtual bool dead(void) const { return _dead; }
+};
+
+/// Writes a new segment; the entries must be added in key order.
+/// The file is complete, and synced to disk, only after finish();
+/// if the writer is destroyed before that, the file is removed.
+class KVSegmentWriter
+{
+	std::string _path;
+	FILE* _fh;
+	uint64_t _off;
+	uint64_t _block_start;
+	std::string _index;
+	size_t _index_count;
+	std::vector<uint64_t> _hashes;
+	size_t _count;
+
+	void put(const void*, size_t);
+
+public:
+	KVSegmentWriter(const std::string& path);
+	~KVSegmentWriter();
+
+	void add(const KVSlice& key, const KVSlice& value, bool dead);
+	size_t size(void) const { return _count; }
+	void finish(void);
+};
+
+/** @}*/
+} //namespace opencog
+
+#endif // _OPENCOG_KV_SEGMENT_H
@@ -0,0 +1,593 @@
+/*
+ * opencog/persist/lsm/KVStore.cc
+ *
+ * Copyright (C) 2019 OpenCog Foundation
+ * All Rights Reserved
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include <opencog/util/exceptions.h>
+#include <opencog/util/Logger.h>
+
+#include "KVStore.h"
+
+using namespace opencog;
+
+// Rough cost of a memtable entry, over and above the key and value.
+#define MEMTABLE_OVERHEAD 64
+
+namespace {
+
+/// Walks several sorted runs at once, as if they were one. Where a
+/// key is in more than one run, the run that was added first wins.
+class MergeCursor
+{
+	std::vector<std::unique_ptr<KVCursor>> _runs;
+	int _cur;
+
+	void settle(void)
+	{
+		_cur = -1;
+		for (size_t i = 0; i < _runs.size(); i++)
+		{
+			if (not _runs[i]->valid()) continue;
+			if (_cur < 0 or _runs[i]->key().compare(_runs[_cur]->key()) < 0)
+				_cur = i;
+		}
+	}
+
+public:
+	MergeCursor(void) : _cur(-1) {}
+
+	void add(KVCursor* c) { _runs.emplace_back(c); }
+	void seek(const KVSlice& k)
+	{
+		for (auto& r : _runs) r->seek(k);
+		settle();
+	}
+	bool valid(void) const { return 0 <= _cur; }
+	KVSlice key(void) const { return _runs[_cur]->key(); }
+	KVSlice value(void) const { return _runs[_cur]->value(); }
+	bool dead(void) const { return _runs[_cur]->dead(); }
+
+	void next(void)
+	{
+		// The key stays valid: it points into a memtable or a
+		// mapped segment, not into the cursor.
+		KVSlice k = key();
+		for (auto& r : _runs)
+			if (r->valid() and 0 == r->key().compare(k)) r->next();
+		settle();
+	}
+};
+
+void apply(KVMemtable& mem, size_t& bytes,
+           std::string&& key, std::string&& value, bool dead)
+{
+	bytes += key.size() + value.size() + MEMTABLE_OVERHEAD;
+	KVEntry& ent = mem[std::move(key)];
+	ent.value = std::move(value);
+	ent.dead = dead;
+}
+
+} // anonymous namespace
+
+/* ================================================================ */
+
+KVStore::KVStore(const std::string& dir, size_t memtable_bytes,
+                 size_t max_segments) :
+	_dir(dir),
+	_memtable_limit(memtable_bytes),
+	_max_segments(std::max(max_segments, (size_t) 2)),
+	_lock_fd(-1),
+	_mem(std::make_shared<KVMemtable>()),
+	_mem_bytes(0),
+	_segments(std::make_shared<const SegmentList>()),
+	_next_seq(1),
+	_want_compact(false),
+	_stop(false),
+	_flush_count(0),
+	_compact_count(0)
+{
+	if (mkdir(dir.c_str(), 0755) and EEXIST != errno)
+		throw IOException(TRACE_INFO, "Cannot create %s: %s",
+			dir.c_str(), strerror(errno));
+
+	// One process at a time; two would clobber each other's files.
+	_lock_fd = open((dir + "/LOCK").c_str(), O_RDWR | O_CREAT, 0644);
+	if (_lock_fd < 0 or flock(_lock_fd, LOCK_EX | LOCK_NB))
+	{
+		if (0 <= _lock_fd) close(_lock_fd);
+		throw IOException(TRACE_INFO, "Cannot lock %s: %s",
+			dir.c_str(), strerror(errno));
+	}
+
+	try { recover(); }
+	catch (...)
+	{
+		close(_lock_fd);
+		throw;
+	}
+	_bg = std::thread(&KVStore::background, this);
+}
+
+KVStore::~KVStore()
+{
+	// Write out the memtable, so that the next open does not have
+	// to replay the log. If this fails, the log is still there.
+	bool flushed = false;
+	try { flush(); flushed = true; }
+	catch (const std::exception& ex)
+	{
+		logger().error("KVStore: %s", ex.what());
+	}
+
+	{
+		std::lock_guard<std::mutex> lck(_mtx);
+		_stop = true;
+		_work.notify_one();
+	}
+	_bg.join();
+	_log.reset();
+
+	// Everything is in the segments; the logs are empty.
+	if (flushed)
+		for (uint64_t seq : _mem_logs)
+			unlink(file("log", seq).c_str());
+	close(_lock_fd);
+}
+
+std::string KVStore::file(const char* kind, uint64_t seq) const
+{
+	char buf[64];
+	snprintf(buf, sizeof(buf), "/%s-%012" PRIu64, kind, seq);
+	return _dir + buf;
+}
+
+/* ================================================================ */
+
+/// Open the segments named in the manifest, and replay the logs into
+/// the memtable. Segment files not in the manifest are left over from
+/// a flush or a merge that did not finish; they are removed.
+void KVStore::recover(void)
+{
+	std::vector<uint64_t> live;
+	FILE* mf = fopen((_dir + "/MANIFEST").c_str(), "r");
+	if (mf)
+	{
+		char line[128];
+		uint64_t seq;
+		while (fgets(line, sizeof(line), mf))
+			if (1 == sscanf(line, "segment %" SCNu64, &seq))
+				live.push_back(seq);
+		fclose(mf);
+	}
+
+	std::vector<uint64_t> logs;
+	uint64_t max_seq = 0;
+	DIR* d = opendir(_dir.c_str());
+	if (nullptr == d)
+		throw IOException(TRACE_INFO, "Cannot read %s: %s",
+			_dir.c_str(), strerror(errno));
+	for (struct dirent* e = readdir(d); e; e = readdir(d))
+	{
+		uint64_t seq;
+		char tail;
+		if (1 == sscanf(e->d_name, "log-%" SCNu64 "%c", &seq, &tail))
+			logs.push_back(seq);
+		else if (1 == sscanf(e->d_name, "seg-%" SCNu64 "%c", &seq, &tail))
+		{
+			if (std::find(live.begin(), live.end(), seq) == live.end())
+				unlink((_dir + "/" + e->d_name).c_str());
+		}
+		else continue;
+		max_seq = std::max(max_seq, seq);
+	}
+	closedir(d);
+	for (uint64_t seq : live) max_seq = std::max(max_seq, seq);
+	_next_seq = max_seq + 1;
+
+	auto segs = std::make_shared<SegmentList>();
+	for (uint64_t seq : live)
+		segs->push_back(std::make_shared<KVSegment>(file("seg", seq), seq));
+	_segments = segs;
+
+	std::sort(logs.begin(), logs.end());
+	size_t nbatch = 0;
+	for (uint64_t seq : logs)
+	{
+		nbatch += KVLog::replay(file("log", seq),
+			[&](std::string&& k, std::string&& v, bool dead) {
+				apply(*_mem, _mem_bytes, std::move(k), std::move(v), dead);
+			}, seq == logs.back());
+		_mem_logs.push_back(seq);
+	}
+	if (0 < nbatch)
+		logger().info("KVStore: recovered %zu batches from %zu logs in %s",
+			nbatch, logs.size(), _dir.c_str());
+
+	uint64_t seq = _next_seq++;
+	_log.reset(new KVLog(file("log", seq)));
+	_mem_logs.push_back(seq);
+}
+
+/// Replace the manifest. The rename is atomic; the directory sync
+/// makes the rename, and the new segment files, durable.
+void KVStore::write_manifest(const SegmentList& segs)
+{
+	std::string tmp = _dir + "/MANIFEST.tmp";
+	FILE* fh = fopen(tmp.c_str(), "w");
+	bool ok = nullptr != fh;
+	if (ok)
+	{
+		fprintf(fh, "# Live segments, newest first.\n");
+		for (const KVSegmentPtr& seg : segs)
+			fprintf(fh, "segment %" PRIu64 "\n", seg->seq());
+		ok = 0 == fflush(fh) and 0 == fsync(fileno(fh));
+		ok = 0 == fclose(fh) and ok;
+	}
+	ok = ok and 0 == rename(tmp.c_str(), (_dir + "/MANIFEST").c_str());
+	if (ok)
+	{
+		int dfd = open(_dir.c_str(), O_RDONLY);
+		ok = 0 <= dfd and 0 == fsync(dfd);
+		if (0 <= dfd) close(dfd);
+	}
+	if (not ok)
+		throw IOException(TRACE_INFO, "Cannot write manifest in %s: %s",
+			_dir.c_str(), strerror(errno));
+}
+
+void KVStore::check_error(void) const
+{
+	if (_bg_error) std::rethrow_exception(_bg_error);
+}
+
+/* ================================================================ */
+
+/// Hand the memtable to the background thread, and start a new log
+/// for the new memtable. If the previous memtable is still being
+/// written, wait for it: the writers are faster than the disk.
+void KVStore::freeze(std::unique_lock<std::mutex>& lck)
+{
+	_done.wait(lck, [&] { return nullptr == _imm or _bg_error; });
+	check_error();
+
+	_log->sync();
+	uint64_t seq = _next_seq++;
+	_log.reset(new KVLog(file("log", seq)));
+
+	_imm = _mem;
+	_imm_logs = std::move(_mem_logs);
+	_mem_logs.assign(1, seq);
+	_mem = std::make_shared<KVMemtable>();
+	_mem_bytes = 0;
+	_work.notify_one();
+}
+
+void KVStore::write(const KVBatch& batch)
+{
+	if (batch.empty()) return;
+
+	std::unique_lock<std::mutex> lck(_mtx);
+	check_error();
+	if (_memtable_limit <= _mem_bytes) freeze(lck);
+
+	_log->append(batch);
+	batch.foreach([&](std::string&& k, std::string&& v, bool dead) {
+		apply(*_mem, _mem_bytes, std::move(k), std::move(v), dead);
+	});
+}
+
+void KVStore::put(const std::string& key, const std::string& value)
+{
+	KVBatch batch;
+	batch.put(key, value);
+	write(batch);
+}
+
+void KVStore::del(const std::string& key)
+{
+	KVBatch batch;
+	batch.del(key);
+	write(batch);
+}
+
+void KVStore::sync(void)
+{
+	std::lock_guard<std::mutex> lck(_mtx);
+	check_error();
+	_log->sync();
+}
+
+/* ================================================================ */
+
+bool KVStore::get(const std::string& key, std::string& value) const
+{
+	std::shared_ptr<const KVMemtable> imm;
+	std::shared_ptr<const SegmentList> segs;
+	{
+		std::lock_guard<std::mutex> lck(_mtx);
+		auto it = _mem->find(key);
+		if (it != _mem->end())
+		{
+			if (it->second.dead) return false;
+			value = it->second.value;
+			return true;
+		}
+		imm = _imm;
+		segs = _segments;
+	}
+
+	if (imm)
+	{
+		auto it = imm->find(key);
+		if (it != imm->end())
+		{
+			if (it->second.dead) return false;
+			value = it->second.value;
+			return true;
+		}
+	}
+
+	for (const KVSegmentPtr& seg : *segs)
+	{
+		switch (seg->get(key, value))
+		{
+			case KVSegment::PRESENT: return true;
+			case KVSegment::DELETED: return false;
+			case KVSegment::ABSENT: break;
+		}
+	}
+	return false;
+}
+
+void KVStore::scan(const std::string& prefix, const Scanner& f) const
+{
+	MergeCursor mc;
+	{
+		// The memtable keeps changing; take a copy of the part that
+		// is wanted. The rest does not change, once made.
+		std::lock_guard<std::mutex> lck(_mtx);
+		auto mem = std::make_shared<KVMemtable>();
+		for (auto it = _mem->lower_bound(prefix);
+		     it != _mem->end() and 0 == it->first.compare(0, prefix.size(), prefix);
+		     ++it)
+			mem->insert(mem->end(), *it);
+		mc.add(new KVMemCursor(mem));
+		if (_imm) mc.add(new KVMemCursor(_imm));
+		for (const KVSegmentPtr& seg : *_segments)
+			mc.add(new KVSegmentCursor(seg));
+	}
+
+	KVSlice pfx(prefix);
+	for (mc.seek(pfx); mc.valid() and mc.key().starts_with(pfx); mc.next())
+	{
+		if (mc.dead()) continue;
+		if (not f(mc.key(), mc.value())) break;
+	}
+}
+
+/* ================================================================ */
+
+void KVStore::background(void)
+{
+	std::unique_lock<std::mutex> lck(_mtx);
+	while (true)
+	{
+		bool do_flush = false, do_compact = false;
+		_work.wait(lck, [&] {
+			do_flush = _imm and not _bg_error;
+			do_compact = not _bg_error and
+				(_want_compact or _max_segments < _segments->size());
+			return do_flush or do_compact or _stop;
+		});
+		if (not do_flush and not do_compact) break;
+
+		bool all = _want_compact;
+		lck.unlock();
+		try
+		{
+			if (do_flush) flush_imm();
+			else compact_segments(all);
+		}
+		catch (...)
+		{
+			lck.lock();
+			logger().error("KVStore: background write failed in %s",
+				_dir.c_str());
+			_bg_error = std::current_exception();
+			_done.notify_all();
+			continue;
+		}
+		lck.lock();
+		if (not do_flush and all) _want_compact = false;
+		_done.notify_all();
+	}
+}
+
+void KVStore::flush_imm(void)
+{
+	std::shared_ptr<const KVMemtable> imm;
+	std::shared_ptr<const SegmentList> segs;
+	uint64_t seq;
+	{
+		std::lock_guard<std::mutex> lck(_mtx);
+		imm = _imm;
+		segs = _segments;
+		seq = _next_seq++;
+	}
+
+	// With no older segments, a delete has nothing left to hide.
+	bool bottom = segs->empty();
+	SegmentList fresh;
+	{
+		KVSegmentWriter w(file("seg", seq));
+		for (const auto& pr : *imm)
+		{
+			if (bottom and pr.second.dead) continue;
+			w.add(pr.first, pr.second.value, pr.second.dead);
+		}
+		if (0 < w.size())
+		{
+			w.finish();
+			fresh.push_back(std::make_shared<KVSegment>(file("seg", seq), seq));
+		}
+	}
+	fresh.insert(fresh.end(), segs->begin(), segs->end());
+	write_manifest(fresh);
+
+	// Only this thread changes the segment list, so it cannot have
+	// changed while the segment was being written.
+	std::vector<uint64_t> logs;
+	{
+		std::lock_guard<std::mutex> lck(_mtx);
+		_segments = std::make_shared<const SegmentList>(std::move(fresh));
+		_imm = nullptr;
+		logs.swap(_imm_logs);
+		_flush_count++;
+	}
+	for (uint64_t lseq : logs)
+		unlink(file("log", lseq).c_str());
+}
+
+KVSegmentPtr KVStore::merge(const SegmentList& segs, bool drop_deletes)
+{
+	uint64_t seq;
+	{
+		std::lock_guard<std::mutex> lck(_mtx);
+		seq = _next_seq++;
+	}
+
+	MergeCursor mc;
+	for (const KVSegmentPtr& seg : segs)
+		mc.add(new KVSegmentCursor(seg));
+
+	KVSegmentWriter w(file("seg", seq));
+	for (mc.seek(KVSlice("", 0)); mc.valid(); mc.next())
+	{
+		if (drop_deletes and mc.dead()) continue;
+		w.add(mc.key(), mc.value(), mc.dead());
+	}
+	if (0 == w.size()) return nullptr;
+	w.finish();
+	return std::make_shared<KVSegment>(file("seg", seq), seq);
+}
+
+/// Merge the newest segments, and keep going while the next older
+/// one is no more than twice the size of what is being merged: big,
+/// old segments are rewritten only now and then.
+void KVStore::compact_segments(bool all)
+{
+	std::shared_ptr<const SegmentList> segs;
+	{
+		std::lock_guard<std::mutex> lck(_mtx);
+		segs = _segments;
+	}
+	if (segs->empty() or (1 == segs->size() and not all)) return;
+
+	size_t n = segs->size();
+	if (not all)
+	{
+		n = 2;
+		size_t bytes = (*segs)[0]->bytes() + (*segs)[1]->bytes();
+		while (n < segs->size() and (*segs)[n]->bytes() <= 2 * bytes)
+			bytes += (*segs)[n++]->bytes();
+	}
+
+	SegmentList victims(segs->begin(), segs->begin() + n);
+	KVSegmentPtr merged = merge(victims, n == segs->size());
+
+	SegmentList fresh;
+	if (merged) fresh.push_back(merged);
+	fresh.insert(fresh.end(), segs->begin() + n, segs->end());
+	write_manifest(fresh);
+
+	{
+		std::lock_guard<std::mutex> lck(_mtx);
+		_segments = std::make_shared<const SegmentList>(std::move(fresh));
+		_compact_count++;
+	}
+
+	// Readers may still have these mapped; the files go away when
+	// they are done.
+	for (const KVSegmentPtr& seg : victims)
+		unlink(seg->path().c_str());
+}
+
+void KVStore::flush(void)
+{
+	std::unique_lock<std::mutex> lck(_mtx);
+	check_error();
+	if (not _mem->empty()) freeze(lck);
+	_done.wait(lck, [&] { return nullptr == _imm or _bg_error; });
+	check_error();
+}
+
+void KVStore::compact(void)
+{
+	flush();
+
+	std::unique_lock<std::mutex> lck(_mtx);
+	_want_compact = true;
+	_work.notify_one();
+	_done.wait(lck, [&] { return not _want_compact or _bg_error; });
+	check_error();
+}
+
+/* ================================================================ */
+
+size_t KVStore::num_segments(void) const
+{
+	std::lock_guard<std::mutex> lck(_mtx);
+	return _segments->size();
+}
+
+void KVStore::print_stats(void) const
+{
+	std::lock_guard<std::mutex> lck(_mtx);
+	printf("kvstore: %s\n", _dir.c_str());
+	printf("kvstore: memtable holds %zu keys, about %zu bytes\n",
+		_mem->size(), _mem_bytes);
+	printf("kvstore: log holds %" PRIu64 " bytes\n", _log->bytes());
+	if (_imm)
+		printf("kvstore: frozen memtable of %zu keys is being written\n",
+			_imm->size());
+
+	size_t entries = 0, bytes = 0;
+	for (const KVSegmentPtr& seg : *_segments)
+	{
+		entries += seg->size();
+		bytes += seg->bytes();
+	}
+	printf("kvstore: %zu segments, %zu entries, %zu bytes\n",
+		_segments->size(), entries, bytes);
+	printf("kvstore: %zu memtable flushes, %zu merges\n",
+		_flush_count, _compact_count);
+}
@@ -0,0 +1,154 @@
+/*
+ * opencog/persist/lsm/KVStore.h
+ *
+ * Copyright (C) 2019 OpenCog Foundation
+ * All Rights Reserved
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _OPENCOG_KV_STORE_H
+#define _OPENCOG_KV_STORE_H
+
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <opencog/persist/lsm/KVLog.h>
+#include <opencog/persist/lsm/KVSegment.h>
+
+namespace opencog
+{
+/** \addtogroup grp_persist
+ *  @{
+ */
+
+/**
+ * An embedded, log-structured key-value store, kept in one directory.
+ *
+ * Writes go to the write-ahead log, and to a sorted table in memory
+ * (the memtable). When the memtable gets big, it is frozen, and a
+ * background thread writes it out as an immutable, sorted segment
+ * file; the log that covered it is then deleted. The same thread
+ * merges segments together when there get to be too many of them,
+ * dropping overwritten values and deletes as it goes.
+ *
+ * Reads look at the memtable, then the frozen memtable, then the
+ * segments, newest first; the first one that has the key wins. Each
+ * segment has a bloom filter, so most segments that do not hold a
+ * key are skipped without touching the file.
+ *
+ * Only sync() makes writes durable. After a crash, everything up to
+ * the last sync() is recovered; a batch is recovered whole or not
+ * at all. The MANIFEST file names the live segments; it is replaced
+ * atomically, so a crash in the middle of a flush or a merge leaves
+ * the old segments in place.
+ *
+ * All methods are thread-safe. An error in the background thread is
+ * sticky: it is thrown from every later write.
+ */
+class KVStore
+{
+public:
+	/// Called for each key in a scan; return false to stop.
+	typedef std::function<bool(const KVSlice& key, const KVSlice& value)> Scanner;
+
+private:
+	typedef std::vector<KVSegmentPtr> SegmentList;
+
+	std::string _dir;
+	size_t _memtable_limit;
+	size_t _max_segments;
+	int _lock_fd;
+
+	mutable std::mutex _mtx;
+	std::condition_variable _work;
+	std::condition_variable _done;
+
+	std::shared_ptr<KVMemtable> _mem;
+	size_t _mem_bytes;
+	std::vector<uint64_t> _mem_logs;
+	std::unique_ptr<KVLog> _log;
+
+	std::shared_ptr<const KVMemtable> _imm;
+	std::vector<uint64_t> _imm_logs;
+
+	// Newest first. Replaced, never changed in place, so that readers
+	// can keep using the list they have while it is being replaced.
+	std::shared_ptr<const SegmentList> _segments;
+
+	uint64_t _next_seq;
+	bool _want_compact;
+	bool _stop;
+	std::exception_ptr _bg_error;
+	std::thread _bg;
+
+	size_t _flush_count;
+	size_t _compact_count;
+
+	std::string file(const char*, uint64_t) const;
+	void recover(void);
+	void write_manifest(const SegmentList&);
+	void check_error(void) const;
+
+	void freeze(std::unique_lock<std::mutex>&);
+	void background(void);
+	void flush_imm(void);
+	void compact_segments(bool all);
+	KVSegmentPtr merge(const SegmentList&, bool drop_deletes);
+
+	KVStore(const KVStore&) = delete;
+	KVStore& operator=(const KVStore&) = delete;
+
+public:
+	KVStore(const std::string& dir,
+	        size_t memtable_bytes = 64 * 1024 * 1024,
+	        size_t max_segments = 6);
+	~KVStore();
+
+	const std::string& dir(void) const { return _dir; }
+
+	void write(const KVBatch&);
+	void put(const std::string& key, const std::string& value);
+	void del(const std::string& key);
+
+	bool get(const std::string& key, std::string& value) const;
+
+	/// Call f on every live key that starts with the prefix, in order.
+	void scan(const std::string& prefix, const Scanner& f) const;
+
+	/// Make all writes so far durable.
+	void sync(void);
+
+	/// Write the memtable out to a segment, and wait for it.
+	void flush(void);
+
+	/// Merge all segments into one, and wait for it.
+	void compact(void);
+
+	size_t num_segments(void) const;
+	void print_stats(void) const;
+};
+
+/** @}*/
+} //namespace opencog
+
+#endif // _OPENCOG_KV_STORE_H
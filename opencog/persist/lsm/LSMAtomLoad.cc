@@ -0,0 +1,235 @@
+/*
+ * opencog/persist/lsm/LSMAtomLoad.cc
+ *
+ * Copyright (C) 2019 OpenCog Foundation
+ * All Rights Reserved
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+
+#include <chrono>
+
+#include <opencog/util/Logger.h>
+#include <opencog/atoms/base/Link.h>
+#include <opencog/atoms/base/Node.h>
+#include <opencog/atoms/truthvalue/TruthValue.h>
+#include <opencog/atoms/value/FloatValue.h>
+#include <opencog/atoms/value/LinkValue.h>
+#include <opencog/atoms/value/StringValue.h>
+
+#include <opencog/persist/ValueCodec.h>
+
+#include "LSMAtomStorage.h"
+#include "LSMKeys.h"
+
+using namespace opencog;
+
+// The encoding is described in LSMAtomStore.cc.
+
+template<typename T>
+static T get(const char*& p)
+{
+	T v;
+	memcpy(&v, p, sizeof(T));
+	p += sizeof(T);
+	return v;
+}
+
+/// Read a type name; NOTYPE if this process does not know it.
+static Type get_type(const char*& p)
+{
+	Type t = nameserver().getType(p);
+	p += strlen(p) + 1;
+	return t;
+}
+
+/* ================================================================ */
+
+/// Build the atom with the given id. The atoms in its outgoing set,
+/// and in its values, are built without values. Atoms already in
+/// built are used as they are.
+Handle LSMAtomStorage::fetch(uint64_t id, bool with_values, Built& built)
+{
+	if (not with_values)
+	{
+		auto it = built.find(id);
+		if (it != built.end()) return it->second;
+	}
+
+	std::string rec;
+	if (not _kv.get(lsm_atom_key(id), rec)) return Handle::UNDEFINED;
+	return decode_atom(id, rec, with_values, built);
+}
+
+Handle LSMAtomStorage::decode_atom(uint64_t id, const std::string& rec,
+                                   bool with_values, Built& built)
+{
+	const char* p = rec.data();
+	Type t = get_type(p);
+	char kind = get<char>(p);
+
+	Handle h;
+	if ('N' == kind)
+	{
+		uint32_t len = get<uint32_t>(p);
+		if (NOTYPE != t) h = createNode(t, std::string(p, len));
+		p += len;
+	}
+	else
+	{
+		uint32_t arity = get<uint32_t>(p);
+		HandleSeq oset;
+		oset.reserve(arity);
+		for (uint32_t i = 0; i < arity; i++)
+		{
+			Handle ho(fetch(get<uint64_t>(p), false, built));
+			if (nullptr == ho) return Handle::UNDEFINED;
+			oset.emplace_back(ho);
+		}
+		if (NOTYPE != t) h = createLink(std::move(oset), t);
+	}
+	if (nullptr == h) return h;
+	built.emplace(id, h);
+
+	if (not with_values) return h;
+	uint32_t nvals = get<uint32_t>(p);
+	for (uint32_t i = 0; i < nvals; i++)
+	{
+		Handle key(fetch(get<uint64_t>(p), false, built));
+		ValuePtr v(decode_value(p, built));
+		if (key and v) h->setValue(key, v);
+	}
+	return h;
+}
+
+/// Decode one value, and move past it. Returns nullptr if the type
+/// is not known in this process.
+ValuePtr LSMAtomStorage::decode_value(const char*& p, Built& built)
+{
+	return decode_binary_value(p, get_type,
+		[&](const char*& q) -> ValuePtr {
+			return fetch(get<uint64_t>(q), false, built);
+		});
+}
+
+/* ================================================================ */
+
+Handle LSMAtomStorage::getNode(Type t, const char * str)
+{
+	rethrow();
+	Handle h(createNode(t, str));
+	uint64_t id = find_id(h);
+	if (0 == id) return Handle::UNDEFINED;
+	Built built;
+	return fetch(id, true, built);
+}
+
+Handle LSMAtomStorage::getLink(Type t, const HandleSeq& hs)
+{
+	rethrow();
+	Handle h(createLink(hs, t));
+	uint64_t id = find_id(h);
+	if (0 == id) return Handle::UNDEFINED;
+	Built built;
+	return fetch(id, true, built);
+}
+
+/// Add the links that hold h, and are of type t (of any type, if t
+/// is NOTYPE), to the table, with their values.
+void LSMAtomStorage::get_incoming(AtomTable& table, const Handle& h, Type t)
+{
+	rethrow();
+	uint64_t id = find_id(h);
+	if (0 == id) return;
+
+	std::string tname;
+	if (NOTYPE != t) tname = nameserver().getTypeName(t);
+
+	std::vector<uint64_t> links;
+	_kv.scan(lsm_incoming_key(id), [&](const KVSlice& k, const KVSlice& v) {
+		if (NOTYPE == t or 0 == v.compare(tname))
+			links.push_back(lsm_get_id(k.data + 9));
+		return true;
+	});
+
+	Built built;
+	for (uint64_t lid : links)
+	{
+		Handle l(fetch(lid, true, built));
+		if (l) table.add(l, false, true);
+	}
+}
+
+void LSMAtomStorage::getIncomingSet(AtomTable& table, const Handle& h)
+{
+	get_incoming(table, h, NOTYPE);
+}
+
+void LSMAtomStorage::getIncomingByType(AtomTable& table, const Handle& h, Type t)
+{
+	get_incoming(table, h, t);
+}
+
+void LSMAtomStorage::loadType(AtomTable& table, Type t)
+{
+	rethrow();
+	std::vector<uint64_t> ids;
+	std::string prefix = lsm_type_key(t);
+	_kv.scan(prefix, [&](const KVSlice& k, const KVSlice&) {
+		ids.push_back(lsm_get_id(k.data + prefix.size()));
+		return true;
+	});
+
+	Built built;
+	for (uint64_t id : ids)
+	{
+		Handle h(fetch(id, true, built));
+		if (h) table.add(h, false, true);
+	}
+	logger().debug("LSMAtomStorage: loaded %zu atoms of type %s",
+		ids.size(), nameserver().getTypeName(t).c_str());
+}
+
+/// Load everything, in one pass over the atom records. They come in
+/// the order of their ids, and so almost always after the atoms in
+/// their outgoing sets.
+void LSMAtomStorage::loadAtomSpace(AtomTable& table)
+{
+	rethrow();
+	auto start = std::chrono::steady_clock::now();
+
+	size_t count = 0;
+	Built built;
+	std::string rec;
+	_kv.scan("a", [&](const KVSlice& k, const KVSlice& v) {
+		rec.assign(v.data, v.size);
+		Handle h(decode_atom(lsm_get_id(k.data + 1), rec, true, built));
+		if (h)
+		{
+			table.add(h, false, true);
+			count++;
+		}
+		return true;
+	});
+	table.barrier();
+
+	std::chrono::duration<double> secs =
+		std::chrono::steady_clock::now() - start;
+	logger().info("LSMAtomStorage: loaded %zu atoms from %s in %f seconds",
+		count, dir().c_str(), secs.count());
+}
@@ -0,0 +1,175 @@
+/*
+ * opencog/persist/lsm/LSMAtomStorage.cc
+ *
+ * Copyright (C) 2019 OpenCog Foundation
+ * All Rights Reserved
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <stdio.h>
+
+#include <opencog/util/Logger.h>
+
+#include "LSMAtomStorage.h"
+#include "LSMKeys.h"
+
+using namespace opencog;
+
+// The local disk keeps up with far more writers than a database
+// server does; the limit is mostly the encoding of the atoms.
+#define NUM_WB_QUEUES 4
+
+/* ================================================================ */
+// Constructors
+
+LSMAtomStorage::LSMAtomStorage(const std::string& dir) :
+	_kv(dir),
+	_next_id(1),
+	_write_queue(this, &LSMAtomStorage::vdo_store_atom, NUM_WB_QUEUES),
+	_async_write_queue_exception(nullptr)
+{
+	// Each store is cheap, so allow a deep backlog before stalling.
+	_write_queue.set_watermarks(16000, 2000);
+
+	std::string val;
+	if (_kv.get(LSM_NEXT_ID_KEY, val) and sizeof(uint64_t) == val.size())
+		memcpy(&_next_id, val.data(), sizeof(uint64_t));
+}
+
+LSMAtomStorage::~LSMAtomStorage()
+{
+	try { barrier(); }
+	catch (const std::exception& ex)
+	{
+		logger().error("LSMAtomStorage: lost stores to %s: %s",
+			dir().c_str(), ex.what());
+	}
+}
+
+/// Atoms are stored asynchronously, from the write queue. An error
+/// there is caught, and thrown at the next user of this class; see
+/// SQLAtomStorage::rethrow() for the same thing.
+void LSMAtomStorage::rethrow(void)
+{
+	if (_async_write_queue_exception)
+	{
+		std::exception_ptr exptr = _async_write_queue_exception;
+		_async_write_queue_exception = nullptr;
+		std::rethrow_exception(exptr);
+	}
+}
+
+/// Drain the store queue, and then sync the log: when this returns,
+/// everything stored so far survives a crash.
+void LSMAtomStorage::barrier()
+{
+	rethrow();
+	_write_queue.barrier();
+	rethrow();
+	_kv.sync();
+}
+
+void LSMAtomStorage::compact(void)
+{
+	barrier();
+	_kv.compact();
+}
+
+/* ================================================================ */
+// Ids
+
+uint64_t LSMAtomStorage::cached_id(const Handle& h)
+{
+	std::lock_guard<std::mutex> lck(_id_mtx);
+	auto it = _ids.find(h);
+	return it == _ids.end() ? 0 : it->second;
+}
+
+void LSMAtomStorage::cache_id(const Handle& h, uint64_t id)
+{
+	std::lock_guard<std::mutex> lck(_id_mtx);
+	_ids.emplace(h, id);
+}
+
+void LSMAtomStorage::clear_cache(void)
+{
+	std::lock_guard<std::mutex> lck(_id_mtx);
+	_ids.clear();
+}
+
+std::string LSMAtomStorage::content_key(const Handle& h,
+                                        const std::vector<uint64_t>& oids)
+{
+	std::string key("c");
+	key += nameserver().getTypeName(h->get_type());
+	key.push_back('\0');
+	if (h->is_node())
+		key += h->get_name();
+	else
+		for (uint64_t oid : oids) lsm_put_id(key, oid);
+	return key;
+}
+
+/// Return the id of the atom, or zero, if it was never stored.
+uint64_t LSMAtomStorage::find_id(const Handle& h)
+{
+	uint64_t id = cached_id(h);
+	if (id) return id;
+
+	std::vector<uint64_t> oids;
+	for (const Handle& ho : h->getOutgoingSet())
+	{
+		uint64_t oid = find_id(ho);
+		if (0 == oid) return 0;
+		oids.push_back(oid);
+	}
+
+	std::string val;
+	if (not _kv.get(content_key(h, oids), val)) return 0;
+	id = lsm_get_id(val.data());
+	cache_id(h, id);
+	return id;
+}
+
+/* ================================================================ */
+
+void LSMAtomStorage::print_stats(void)
+{
+	size_t cached;
+	{
+		std::lock_guard<std::mutex> lck(_id_mtx);
+		cached = _ids.size();
+	}
+	uint64_t issued;
+	{
+		std::lock_guard<std::mutex> lck(_create_mtx);
+		issued = _next_id - 1;
+	}
+	printf("lsm-stats: %lu atom ids issued, %zu cached\n", issued, cached);
+
+	// Store queue performance
+	unsigned long item_count = _write_queue._item_count;
+	unsigned long duplicate_count = _write_queue._duplicate_count;
+	unsigned long drain_count = _write_queue._drain_count;
+	printf("lsm-stats: write items=%lu dup=%lu drains=%lu\n",
+	       item_count, duplicate_count, drain_count);
+	printf("lsm-stats: currently in_drain=%d num_busy=%lu queue_size=%lu\n",
+	       _write_queue._in_drain, _write_queue.get_busy_writers(),
+	       _write_queue.get_size());
+	printf("\n");
+	_kv.print_stats();
+}
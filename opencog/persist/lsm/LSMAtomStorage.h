@@ -0,0 +1,135 @@
+/*
+ * opencog/persist/lsm/LSMAtomStorage.h
+ *
+ * Copyright (C) 2019 OpenCog Foundation
+ * All Rights Reserved
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _OPENCOG_LSM_ATOM_STORAGE_H
+#define _OPENCOG_LSM_ATOM_STORAGE_H
+
+#include <exception>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <opencog/util/async_buffer.h>
+
+#include <opencog/atoms/base/Atom.h>
+#include <opencog/atomspace/AtomTable.h>
+#include <opencog/atomspace/BackingStore.h>
+#include <opencog/persist/lsm/KVStore.h>
+
+namespace opencog
+{
+/** \addtogroup grp_persist
+ *  @{
+ */
+
+/**
+ * Stores atoms in an embedded, log-structured key-value store (see
+ * KVStore), kept in a directory on the local disk. There is no
+ * database server.
+ *
+ * Each atom gets a numeric id when it is first stored. The keys are:
+ *
+ *   'c' type-name NUL name         -> id, for nodes
+ *   'c' type-name NUL child-ids    -> id, for links
+ *   'a' id                         -> the atom, and its values
+ *   'i' child-id link-id           -> type name of the link
+ *   't' type-name NUL id           -> (empty)
+ *
+ * Ids in keys are big-endian, so that they sort in order. Children
+ * are always stored before their parents, and so have smaller ids;
+ * a scan of the 'a' keys meets every atom after its outgoing set.
+ *
+ * Stores are queued, and done by a pool of writer threads; barrier()
+ * waits for the queue to drain, and then makes everything durable.
+ */
+class LSMAtomStorage : public BackingStore
+{
+	private:
+		KVStore _kv;
+
+		// Ids of atoms seen so far, by content, so that they need
+		// not be looked up again. Like the TLB of the SQL backend.
+		std::mutex _id_mtx;
+		std::unordered_map<Handle, uint64_t> _ids;
+
+		// Serializes the issuing of new ids.
+		std::mutex _create_mtx;
+		uint64_t _next_id;
+
+		// Provider of asynchronous store of atoms.
+		async_buffer<LSMAtomStorage, Handle> _write_queue;
+		std::exception_ptr _async_write_queue_exception;
+		void rethrow(void);
+		void vdo_store_atom(const Handle&);
+
+		uint64_t cached_id(const Handle&);
+		void cache_id(const Handle&, uint64_t);
+		std::string content_key(const Handle&, const std::vector<uint64_t>&);
+		uint64_t find_id(const Handle&);
+
+		// Storing
+		std::string encode_values(const Handle&);
+		bool encode_value(std::string&, const ValuePtr&);
+		uint64_t store_atom(const Handle&, const std::string* values);
+		void do_store_atom(const Handle&);
+		void do_remove_atom(const Handle&, bool recursive);
+
+		// Loading
+		typedef std::unordered_map<uint64_t, Handle> Built;
+		Handle fetch(uint64_t, bool with_values, Built&);
+		Handle decode_atom(uint64_t, const std::string&, bool with_values, Built&);
+		ValuePtr decode_value(const char*&, Built&);
+		void get_incoming(AtomTable&, const Handle&, Type);
+
+	public:
+		LSMAtomStorage(const std::string& dir);
+		LSMAtomStorage(const LSMAtomStorage&) = delete; // disable copying
+		LSMAtomStorage& operator=(const LSMAtomStorage&) = delete; // disable assignment
+		virtual ~LSMAtomStorage();
+
+		const std::string& dir(void) const { return _kv.dir(); }
+		void clear_cache(void);     // forget the ids of atoms.
+		void compact(void);         // merge all the segment files.
+
+		// AtomStorage interface
+		Handle getNode(Type, const char *);
+		Handle getLink(Type, const HandleSeq&);
+		void getIncomingSet(AtomTable&, const Handle&);
+		void getIncomingByType(AtomTable&, const Handle&, Type t);
+		void storeAtom(const Handle&, bool synchronous = false);
+		void removeAtom(const Handle&, bool recursive);
+		void loadType(AtomTable&, Type);
+		void barrier();
+
+		// Large-scale loads and saves
+		void loadAtomSpace(AtomTable &); // Load entire contents
+		void storeAtomSpace(const AtomTable &); // Store all of AtomTable
+
+		// Debugging and performance monitoring
+		void print_stats(void);
+};
+
+/** @}*/
+} // namespace opencog
+
+#endif // _OPENCOG_LSM_ATOM_STORAGE_H
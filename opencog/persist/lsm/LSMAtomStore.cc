@@ -0,0 +1,291 @@
+/*
+ * opencog/persist/lsm/LSMAtomStore.cc
+ *
+ * Copyright (C) 2019 OpenCog Foundation
+ * All Rights Reserved
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <algorithm>
+
+#include <opencog/util/Logger.h>
+#include <opencog/atoms/value/FloatValue.h>
+#include <opencog/atoms/value/LinkValue.h>
+#include <opencog/atoms/value/StringValue.h>
+#include <opencog/atomspace/WorkPool.h>
+
+#include <opencog/persist/ValueCodec.h>
+
+#include "LSMAtomStorage.h"
+#include "LSMKeys.h"
+
+using namespace opencog;
+
+template<typename T>
+static void put(std::string& buf, T v)
+{
+	buf.append((const char*) &v, sizeof(T));
+}
+
+static void put_type(std::string& buf, Type t)
+{
+	buf += nameserver().getTypeName(t);
+	buf.push_back('\0');
+}
+
+/* ================================================================ */
+// Encoding of atom records and values; the decoding is in
+// LSMAtomLoad.cc.
+//
+// An atom record is the type name, NUL, then 'N', a uint32_t length
+// and the name; or 'L', a uint32_t arity and the uint64_t ids of the
+// outgoing set. Then come the values: a uint32_t count, and for each
+// one, the uint64_t id of the key and the encoded value.
+//
+// Values are encoded as in opencog/persist/ValueCodec.h, with the
+// type written as its name and a NUL, and atoms as their uint64_t id.
+// Stream values are not stored; they have no fixed contents.
+
+bool LSMAtomStorage::encode_value(std::string& buf, const ValuePtr& v)
+{
+	return encode_binary_value(buf, v, put_type,
+		[&](std::string& b, const Handle& h) {
+			put<uint64_t>(b, store_atom(h, nullptr));
+		});
+}
+
+/// Encode all of the values on the atom. The atoms that are keys,
+/// or are in the values, are stored (without their own values) if
+/// they have not been already.
+std::string LSMAtomStorage::encode_values(const Handle& h)
+{
+	std::string buf;
+	put<uint32_t>(buf, 0);
+	uint32_t n = 0;
+	for (const Handle& key : h->getKeys())
+	{
+		ValuePtr v = h->getValue(key);
+		if (nullptr == v) continue;
+
+		size_t mark = buf.size();
+		put<uint64_t>(buf, store_atom(key, nullptr));
+		if (encode_value(buf, v)) n++;
+		else buf.resize(mark);
+	}
+	memcpy(&buf[0], &n, sizeof(n));
+	return buf;
+}
+
+/* ================================================================ */
+
+/**
+ * Store the atom, if it is not yet stored, and return its id. Its
+ * outgoing set is stored first. If values are given, the atom record
+ * is (re-)written with them; otherwise, an atom that is already in
+ * the store is left alone.
+ *
+ * A new atom is written in one batch: its content key, its record,
+ * its entries in the incoming sets of its children and in the type
+ * index, and the next free id. After a crash, all of these are
+ * recovered, or none are.
+ */
+uint64_t LSMAtomStorage::store_atom(const Handle& h, const std::string* values)
+{
+	uint64_t id = cached_id(h);
+	if (id and nullptr == values) return id;
+
+	std::vector<uint64_t> oids;
+	for (const Handle& ho : h->getOutgoingSet())
+		oids.push_back(store_atom(ho, nullptr));
+
+	std::string ckey = content_key(h, oids);
+	std::string val;
+	if (0 == id and _kv.get(ckey, val)) id = lsm_get_id(val.data());
+
+	// The record, less the values.
+	std::string rec;
+	put_type(rec, h->get_type());
+	if (h->is_node())
+	{
+		const std::string& name = h->get_name();
+		rec.push_back('N');
+		put<uint32_t>(rec, name.size());
+		rec += name;
+	}
+	else
+	{
+		rec.push_back('L');
+		put<uint32_t>(rec, oids.size());
+		for (uint64_t oid : oids) put<uint64_t>(rec, oid);
+	}
+
+	if (0 == id)
+	{
+		std::lock_guard<std::mutex> lck(_create_mtx);
+
+		// Some other writer might have just created it.
+		if (_kv.get(ckey, val)) id = lsm_get_id(val.data());
+		else
+		{
+			id = _next_id++;
+			KVBatch batch;
+			std::string idstr;
+			lsm_put_id(idstr, id);
+			batch.put(ckey, idstr);
+
+			if (values) rec += *values;
+			else put<uint32_t>(rec, 0);
+			batch.put(lsm_atom_key(id), rec);
+
+			std::string tkey = lsm_type_key(h->get_type());
+			lsm_put_id(tkey, id);
+			batch.put(tkey, "");
+
+			const std::string& tname = nameserver().getTypeName(h->get_type());
+			std::sort(oids.begin(), oids.end());
+			oids.erase(std::unique(oids.begin(), oids.end()), oids.end());
+			for (uint64_t oid : oids)
+			{
+				std::string ikey = lsm_incoming_key(oid);
+				lsm_put_id(ikey, id);
+				batch.put(ikey, tname);
+			}
+
+			batch.put(LSM_NEXT_ID_KEY,
+				std::string((const char*) &_next_id, sizeof(_next_id)));
+			_kv.write(batch);
+			cache_id(h, id);
+			return id;
+		}
+	}
+
+	cache_id(h, id);
+	if (values) _kv.put(lsm_atom_key(id), rec + *values);
+	return id;
+}
+
+void LSMAtomStorage::do_store_atom(const Handle& h)
+{
+	std::string values = encode_values(h);
+	store_atom(h, &values);
+}
+
+void LSMAtomStorage::vdo_store_atom(const Handle& h)
+{
+	try
+	{
+		do_store_atom(h);
+	}
+	catch (...)
+	{
+		_async_write_queue_exception = std::current_exception();
+	}
+}
+
+/**
+ * Store the atom, all of the values on it, and its outgoing set.
+ * The values on the atoms of the outgoing set are not stored.
+ *
+ * By default, the store is done asynchronously, by the write queue.
+ * If the synchronous flag is set, it is done in this thread, before
+ * returning. Either way, it is durable only after barrier().
+ */
+void LSMAtomStorage::storeAtom(const Handle& h, bool synchronous)
+{
+	rethrow();
+
+	if (synchronous)
+	{
+		do_store_atom(h);
+		return;
+	}
+	_write_queue.insert(h);
+}
+
+void LSMAtomStorage::storeAtomSpace(const AtomTable& table)
+{
+	logger().info("LSMAtomStorage: bulk store to %s", dir().c_str());
+	rethrow();
+
+	// Nodes first, then links, so that most outgoing sets are in
+	// place by the time the links get to them.
+	HandleSeq atoms;
+	table.getHandlesByType(std::back_inserter(atoms), NODE, true);
+	table.getHandlesByType(std::back_inserter(atoms), LINK, true);
+
+	work_pool().for_each(atoms.size(),
+		[&](size_t i) { do_store_atom(atoms[i]); }, 256);
+
+	barrier();
+	logger().info("LSMAtomStorage: stored %zu atoms", atoms.size());
+}
+
+/* ================================================================ */
+
+/// Remove the atom. If it has an incoming set, it is removed only if
+/// the recursive flag is set, in which case the incoming set goes too.
+void LSMAtomStorage::do_remove_atom(const Handle& h, bool recursive)
+{
+	uint64_t id = find_id(h);
+	if (0 == id) return;
+
+	std::vector<uint64_t> links;
+	_kv.scan(lsm_incoming_key(id), [&](const KVSlice& k, const KVSlice&) {
+		links.push_back(lsm_get_id(k.data + 9));
+		return true;
+	});
+	if (not links.empty())
+	{
+		if (not recursive) return;
+		Built built;
+		for (uint64_t lid : links)
+		{
+			Handle l(fetch(lid, false, built));
+			if (l) do_remove_atom(l, true);
+		}
+	}
+
+	std::vector<uint64_t> oids;
+	for (const Handle& ho : h->getOutgoingSet())
+		oids.push_back(find_id(ho));
+
+	KVBatch batch;
+	batch.del(content_key(h, oids));
+	batch.del(lsm_atom_key(id));
+	std::string tkey = lsm_type_key(h->get_type());
+	lsm_put_id(tkey, id);
+	batch.del(tkey);
+	for (uint64_t oid : oids)
+	{
+		std::string ikey = lsm_incoming_key(oid);
+		lsm_put_id(ikey, id);
+		batch.del(ikey);
+	}
+	_kv.write(batch);
+
+	std::lock_guard<std::mutex> lck(_id_mtx);
+	_ids.erase(h);
+}
+
+void LSMAtomStorage::removeAtom(const Handle& h, bool recursive)
+{
+	// Stores still in the queue would bring the atom back.
+	rethrow();
+	_write_queue.barrier();
+	rethrow();
+	do_remove_atom(h, recursive);
+}
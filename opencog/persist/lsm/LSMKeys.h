@@ -0,0 +1,81 @@
+/*
+ * opencog/persist/lsm/LSMKeys.h
+ *
+ * Copyright (C) 2019 OpenCog Foundation
+ * All Rights Reserved
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _OPENCOG_LSM_KEYS_H
+#define _OPENCOG_LSM_KEYS_H
+
+#include <cstdint>
+#include <string>
+
+#include <opencog/atoms/atom_types/NameServer.h>
+
+namespace opencog
+{
+/** \addtogroup grp_persist
+ *  @{
+ */
+
+// The key layout is described in LSMAtomStorage.h.
+
+#define LSM_NEXT_ID_KEY "m:next-id"
+
+/// Append the id, big-endian, so that keys sort by id.
+static inline void lsm_put_id(std::string& s, uint64_t id)
+{
+	for (int shift = 56; 0 <= shift; shift -= 8)
+		s.push_back((char) (id >> shift));
+}
+
+static inline uint64_t lsm_get_id(const char* p)
+{
+	uint64_t id = 0;
+	for (int i = 0; i < 8; i++)
+		id = (id << 8) | (uint8_t) p[i];
+	return id;
+}
+
+static inline std::string lsm_atom_key(uint64_t id)
+{
+	std::string key("a");
+	lsm_put_id(key, id);
+	return key;
+}
+
+static inline std::string lsm_incoming_key(uint64_t child)
+{
+	std::string key("i");
+	lsm_put_id(key, child);
+	return key;
+}
+
+static inline std::string lsm_type_key(Type t)
+{
+	std::string key("t");
+	key += nameserver().getTypeName(t);
+	key.push_back('\0');
+	return key;
+}
+
+/** @}*/
+} //namespace opencog
+
+#endif // _OPENCOG_LSM_KEYS_H
@@ -0,0 +1,145 @@
+/*
+ * opencog/persist/lsm/LSMPersistSCM.cc
+ *
+ * Copyright (C) 2019 OpenCog Foundation
+ * All Rights Reserved
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifdef HAVE_GUILE
+
+#include <opencog/atomspace/AtomSpace.h>
+#include <opencog/guile/SchemePrimitive.h>
+
+#include "LSMAtomStorage.h"
+#include "LSMPersistSCM.h"
+
+using namespace opencog;
+
+
+// =================================================================
+
+LSMPersistSCM::LSMPersistSCM(AtomSpace *as)
+{
+    _as = as;
+    _backing = nullptr;
+
+    static bool is_init = false;
+    if (is_init) return;
+    is_init = true;
+    scm_with_guile(init_in_guile, this);
+}
+
+void* LSMPersistSCM::init_in_guile(void* self)
+{
+    scm_c_define_module("opencog persist-lsm", init_in_module, self);
+    scm_c_use_module("opencog persist-lsm");
+    return NULL;
+}
+
+void LSMPersistSCM::init_in_module(void* data)
+{
+   LSMPersistSCM* self = (LSMPersistSCM*) data;
+   self->init();
+}
+
+void LSMPersistSCM::init(void)
+{
+    define_scheme_primitive("lsm-open", &LSMPersistSCM::do_open, this, "persist-lsm");
+    define_scheme_primitive("lsm-close", &LSMPersistSCM::do_close, this, "persist-lsm");
+    define_scheme_primitive("lsm-stats", &LSMPersistSCM::do_stats, this, "persist-lsm");
+    define_scheme_primitive("lsm-clear-cache", &LSMPersistSCM::do_clear_cache, this, "persist-lsm");
+    define_scheme_primitive("lsm-compact", &LSMPersistSCM::do_compact, this, "persist-lsm");
+}
+
+LSMPersistSCM::~LSMPersistSCM()
+{
+    if (_backing) delete _backing;
+}
+
+void LSMPersistSCM::do_open(const std::string& dir)
+{
+    if (_backing)
+        throw RuntimeException(TRACE_INFO,
+             "lsm-open: Error: A store is already open!");
+
+    // Unconditionally use the current atomspace, until the next close.
+    AtomSpace *as = SchemeSmob::ss_get_env_as("lsm-open");
+    if (nullptr != as) _as = as;
+
+    if (nullptr == _as)
+        throw RuntimeException(TRACE_INFO,
+             "lsm-open: Error: Can't find the atomspace!");
+
+    if (_as->isAttachedToBackingStore())
+        throw RuntimeException(TRACE_INFO,
+             "lsm-open: Error: Atomspace connected to another storage backend!");
+
+    _backing = new LSMAtomStorage(dir);
+    _backing->registerWith(_as);
+}
+
+void LSMPersistSCM::do_close(void)
+{
+    if (nullptr == _backing)
+        throw RuntimeException(TRACE_INFO,
+             "lsm-close: Error: Store not open");
+
+    LSMAtomStorage *backing = _backing;
+    _backing = nullptr;
+
+    // Unhook first, so that no more stores get queued; the dtor then
+    // drains the queue, and writes out the memtable.
+    backing->unregisterWith(_as);
+    delete backing;
+}
+
+void LSMPersistSCM::do_stats(void)
+{
+    if (nullptr == _backing) {
+        printf("lsm-stats: Store not open\n");
+        return;
+    }
+
+    printf("lsm-stats: Atomspace holds %lu atoms\n", _as->get_size());
+    _backing->print_stats();
+}
+
+void LSMPersistSCM::do_clear_cache(void)
+{
+    if (nullptr == _backing) {
+        printf("lsm-stats: Store not open\n");
+        return;
+    }
+
+    _backing->clear_cache();
+}
+
+void LSMPersistSCM::do_compact(void)
+{
+    if (nullptr == _backing)
+        throw RuntimeException(TRACE_INFO,
+             "lsm-compact: Error: Store not open");
+
+    _backing->compact();
+}
+
+void opencog_persist_lsm_init(void)
+{
+    static LSMPersistSCM patty(NULL);
+}
+#endif // HAVE_GUILE
@@ -0,0 +1,68 @@
+/*
+ * opencog/persist/lsm/LSMPersistSCM.h
+ *
+ * Copyright (C) 2019 OpenCog Foundation
+ * All Rights Reserved
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _OPENCOG_LSM_PERSIST_SCM_H
+#define _OPENCOG_LSM_PERSIST_SCM_H
+
+#ifdef HAVE_GUILE
+
+#include <string>
+
+#include <opencog/atomspace/AtomSpace.h>
+#include <opencog/persist/lsm/LSMAtomStorage.h>
+
+namespace opencog
+{
+/** \addtogroup grp_persist
+ *  @{
+ */
+
+class LSMPersistSCM
+{
+private:
+    static void* init_in_guile(void*);
+    static void init_in_module(void*);
+    void init(void);
+
+    LSMAtomStorage *_backing;
+    AtomSpace *_as;
+
+public:
+    LSMPersistSCM(AtomSpace*);
+    ~LSMPersistSCM();
+
+    void do_open(const std::string&);
+    void do_close(void);
+    void do_stats(void);
+    void do_clear_cache(void);
+    void do_compact(void);
+}; // class
+
+/** @}*/
+}  // namespace
+
+extern "C" {
+void opencog_persist_lsm_init(void);
+};
+#endif // HAVE_GUILE
+
+#endif // _OPENCOG_LSM_PERSIST_SCM_H
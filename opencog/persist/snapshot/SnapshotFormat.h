@@ -0,0 +1,136 @@
+/*
+ * opencog/persist/snapshot/SnapshotFormat.h
+ *
+ * Copyright (C) 2019 OpenCog Foundation
+ * All Rights Reserved
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _OPENCOG_SNAPSHOT_FORMAT_H
+#define _OPENCOG_SNAPSHOT_FORMAT_H
+
+#include <cstdint>
+#include <cstring>
+
+#include <opencog/atoms/base/hash.h>
+
+namespace opencog
+{
+/** \addtogroup grp_persist
+ *  @{
+ */
+
+// Layout of a snapshot file. Everything is in native byte order; the
+// file is meant to be written and read back on the same kind of
+// machine. All offsets are from the start of the file.
+//
+//   header
+//   type names    -- ntypes NUL-terminated strings; the index in this
+//                    list is the type code used in the rest of the file
+//   atom records  -- natoms SnapAtom, sorted by height, so that the
+//                    outgoing set of an atom comes before it
+//   levels        -- uint64_t[nlevels+1], the first atom of each height
+//   names         -- node names, back to back, not NUL-terminated
+//   outgoing      -- uint32_t atom indexes
+//   values        -- per atom: uint32_t count, then count pairs of
+//                    (uint32_t key index, encoded value)
+//   incoming      -- uint64_t[natoms+1] offsets into uint32_t indexes
+//   by type       -- uint64_t[ntypes+1] offsets into uint32_t indexes
+//   lookup        -- uint32_t[nslots], open addressing on the content;
+//                    each slot holds an atom index plus one, or zero
+//
+// An encoded value is a uint16_t type code and a one-byte kind,
+// followed by:
+//   'A' atoms:   uint32_t index
+//   'F' floats:  uint32_t n, then n doubles (also truth values)
+//   'S' strings: uint32_t n, then n times (uint32_t len, bytes)
+//   'L' links:   uint32_t n, then n encoded values
+// This is the encoding of opencog/persist/ValueCodec.h.
+//
+// Each snapshot gets a random stamp when it is written. Changes made
+// after that are appended to a log, in a file of the same name plus
+// ".log", that starts with a SnapLogHeader holding the stamp of the
+// snapshot it applies to (zero if there was none). A log with any
+// other stamp is left over from an earlier snapshot, and is ignored.
+// Each record in the log is
+//
+//   uint32_t len, uint32_t crc32c of the body, then len bytes of body
+//
+// and the body is one of
+//
+//   'S' atom, uint32_t n, then n times (key atom, encoded value)
+//   'R' atom       -- removed
+//   'X' atom       -- removed, with its incoming set
+//
+// A store replaces all of the values of the atom. In the log, atoms
+// are written out in full, not as indexes: the type name, NUL, then
+// 'N', uint32_t len and the name, or 'L', uint32_t arity and the
+// outgoing atoms. Value types are written the same way, as names.
+
+static const char SNAPSHOT_MAGIC[8] = {'O','C','S','N','A','P','\0','\2'};
+static const char SNAPSHOT_LOG_MAGIC[8] = {'O','C','S','N','L','O','G','\1'};
+static const uint64_t SNAPSHOT_NO_VALUES = (uint64_t) -1;
+
+struct SnapHeader
+{
+	char magic[8];
+	uint64_t file_size;
+	uint64_t stamp;
+	uint64_t ntypes, types_off;
+	uint64_t natoms, atoms_off;
+	uint64_t nlevels, levels_off;
+	uint64_t names_off;
+	uint64_t outs_off;
+	uint64_t vals_off;
+	uint64_t inc_off, inc_idx_off;
+	uint64_t bytype_off, bytype_idx_off;
+	uint64_t nslots, slots_off;
+};
+
+struct SnapLogHeader
+{
+	char magic[8];
+	uint64_t stamp;
+};
+
+struct SnapAtom
+{
+	uint16_t type;
+	uint16_t is_link;
+	uint32_t len;     // name length, or arity
+	uint64_t off;     // into the names, or into the outgoing indexes
+	uint64_t voff;    // into the values, or SNAPSHOT_NO_VALUES
+};
+
+// The lookup key. This is not the atom hash: the file indexes of the
+// outgoing atoms go into it, not their hashes. If hash.h changes, the
+// magic number must change too.
+static inline uint64_t snap_node_key(uint16_t t, const char* name, size_t len)
+{
+	return hash_bytes(name, len, t);
+}
+
+template<typename Index>
+uint64_t snap_link_key(uint16_t t, size_t arity, Index idx)
+{
+	return hash_words(arity, idx, ((uint64_t) 1 << 32) | t);
+}
+
+/** @}*/
+} //namespace opencog
+
+#endif // _OPENCOG_SNAPSHOT_FORMAT_H
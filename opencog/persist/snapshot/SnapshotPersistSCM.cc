@@ -0,0 +1,124 @@
+/*
+ * opencog/persist/snapshot/SnapshotPersistSCM.cc
+ *
+ * Copyright (C) 2019 OpenCog Foundation
+ * All Rights Reserved
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifdef HAVE_GUILE
+
+#include <opencog/atomspace/AtomSpace.h>
+#include <opencog/guile/SchemePrimitive.h>
+
+#include "SnapshotStorage.h"
+#include "SnapshotPersistSCM.h"
+
+using namespace opencog;
+
+
+// =================================================================
+
+SnapshotPersistSCM::SnapshotPersistSCM(AtomSpace *as)
+{
+    _as = as;
+    _backing = nullptr;
+
+    static bool is_init = false;
+    if (is_init) return;
+    is_init = true;
+    scm_with_guile(init_in_guile, this);
+}
+
+void* SnapshotPersistSCM::init_in_guile(void* self)
+{
+    scm_c_define_module("opencog persist-snapshot", init_in_module, self);
+    scm_c_use_module("opencog persist-snapshot");
+    return NULL;
+}
+
+void SnapshotPersistSCM::init_in_module(void* data)
+{
+   SnapshotPersistSCM* self = (SnapshotPersistSCM*) data;
+   self->init();
+}
+
+void SnapshotPersistSCM::init(void)
+{
+    define_scheme_primitive("snapshot-open", &SnapshotPersistSCM::do_open, this, "persist-snapshot");
+    define_scheme_primitive("snapshot-close", &SnapshotPersistSCM::do_close, this, "persist-snapshot");
+    define_scheme_primitive("snapshot-stats", &SnapshotPersistSCM::do_stats, this, "persist-snapshot");
+}
+
+SnapshotPersistSCM::~SnapshotPersistSCM()
+{
+    if (_backing) delete _backing;
+}
+
+void SnapshotPersistSCM::do_open(const std::string& path)
+{
+    if (_backing)
+        throw RuntimeException(TRACE_INFO,
+             "snapshot-open: Error: A snapshot is already open!");
+
+    // Unconditionally use the current atomspace, until the next close.
+    AtomSpace *as = SchemeSmob::ss_get_env_as("snapshot-open");
+    if (nullptr != as) _as = as;
+
+    if (nullptr == _as)
+        throw RuntimeException(TRACE_INFO,
+             "snapshot-open: Error: Can't find the atomspace!");
+
+    if (_as->isAttachedToBackingStore())
+        throw RuntimeException(TRACE_INFO,
+             "snapshot-open: Error: Atomspace connected to another storage backend!");
+
+    _backing = new SnapshotStorage(path);
+    _backing->registerWith(_as);
+}
+
+void SnapshotPersistSCM::do_close(void)
+{
+    if (nullptr == _backing)
+        throw RuntimeException(TRACE_INFO,
+             "snapshot-close: Error: Snapshot not open");
+
+    SnapshotStorage *backing = _backing;
+    _backing = nullptr;
+
+    // Unhook first, so that no more stores get queued; the dtor then
+    // writes out whatever was pending.
+    backing->unregisterWith(_as);
+    delete backing;
+}
+
+void SnapshotPersistSCM::do_stats(void)
+{
+    if (nullptr == _backing) {
+        printf("snapshot-stats: Snapshot not open\n");
+        return;
+    }
+
+    printf("snapshot-stats: Atomspace holds %lu atoms\n", _as->get_size());
+    _backing->print_stats();
+}
+
+void opencog_persist_snapshot_init(void)
+{
+    static SnapshotPersistSCM patty(NULL);
+}
+#endif // HAVE_GUILE
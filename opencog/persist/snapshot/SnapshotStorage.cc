@@ -0,0 +1,915 @@
+/*
+ * opencog/persist/snapshot/SnapshotStorage.cc
+ *
+ * Copyright (C) 2019 OpenCog Foundation
+ * All Rights Reserved
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include <opencog/util/exceptions.h>
+#include <opencog/util/Logger.h>
+
+#include <opencog/atoms/atom_types/NameServer.h>
+#include <opencog/atoms/base/Link.h>
+#include <opencog/atoms/base/Node.h>
+#include <opencog/atoms/truthvalue/TruthValue.h>
+#include <opencog/atoms/value/FloatValue.h>
+#include <opencog/atoms/value/LinkValue.h>
+#include <opencog/atoms/value/StringValue.h>
+#include <opencog/atomspace/AtomSpace.h>
+#include <opencog/atomspace/WorkPool.h>
+
+#include <opencog/persist/Checksum.h>
+#include <opencog/persist/ValueCodec.h>
+
+#include "SnapshotFormat.h"
+#include "SnapshotStorage.h"
+
+using namespace opencog;
+
+static const uint16_t NO_CODE = (uint16_t) -1;
+static const size_t NOT_FOUND = (size_t) -1;
+
+// The log is merged into the snapshot once it is this large, or a
+// quarter of the size of the snapshot, whichever is more.
+static const uint64_t COMPACT_MIN = 4 * 1024 * 1024;
+
+template<typename T>
+static T get(const char*& p)
+{
+	T v;
+	memcpy(&v, p, sizeof(T));
+	p += sizeof(T);
+	return v;
+}
+
+SnapshotStorage::SnapshotStorage(const std::string& path) :
+	_path(path), _base(nullptr), _len(0), _hdr(nullptr), _atoms(nullptr),
+	_log_fd(-1), _log_len(0)
+{
+	map();
+	try
+	{
+		open_log();
+	}
+	catch (...)
+	{
+		unmap();
+		if (0 <= _log_fd) close(_log_fd);
+		throw;
+	}
+}
+
+SnapshotStorage::~SnapshotStorage()
+{
+	try
+	{
+		std::lock_guard<std::mutex> wlck(_write_mtx);
+		flush();
+	}
+	catch (const std::exception& ex)
+	{
+		logger().error("SnapshotStorage: lost changes to %s: %s",
+			_path.c_str(), ex.what());
+	}
+	unmap();
+	if (0 <= _log_fd) close(_log_fd);
+}
+
+/* ================================================================ */
+
+void SnapshotStorage::map(void)
+{
+	int fd = open(_path.c_str(), O_RDONLY);
+	if (fd < 0)
+	{
+		if (ENOENT == errno) return;
+		throw IOException(TRACE_INFO, "Cannot open snapshot %s: %s",
+			_path.c_str(), strerror(errno));
+	}
+
+	struct stat st;
+	if (fstat(fd, &st) or (size_t) st.st_size < sizeof(SnapHeader))
+	{
+		close(fd);
+		throw IOException(TRACE_INFO, "Not a snapshot: %s", _path.c_str());
+	}
+
+	void* p = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (MAP_FAILED == p)
+		throw IOException(TRACE_INFO, "Cannot map snapshot %s: %s",
+			_path.c_str(), strerror(errno));
+
+	_base = (const char*) p;
+	_len = st.st_size;
+	_hdr = at<SnapHeader>(0);
+
+	const SnapHeader& h(*_hdr);
+	bool ok = 0 == memcmp(h.magic, SNAPSHOT_MAGIC, sizeof(h.magic))
+		and h.file_size == _len;
+	for (uint64_t off : {h.types_off, h.atoms_off, h.levels_off,
+	                     h.names_off, h.outs_off, h.vals_off, h.inc_off,
+	                     h.inc_idx_off, h.bytype_off, h.bytype_idx_off,
+	                     h.slots_off})
+		ok = ok and off <= _len;
+	ok = ok and h.atoms_off + h.natoms * sizeof(SnapAtom) <= _len;
+	if (not ok)
+	{
+		unmap();
+		throw IOException(TRACE_INFO, "Bad or truncated snapshot: %s",
+			_path.c_str());
+	}
+	_atoms = at<SnapAtom>(h.atoms_off);
+
+	// Types are stored by name, so that the snapshot survives the
+	// addition of new types. Unknown types are skipped on load.
+	NameServer& ns = nameserver();
+	_codes.assign(ns.getNumberOfClasses(), NO_CODE);
+	const char* name = _base + h.types_off;
+	for (uint64_t i = 0; i < h.ntypes; i++)
+	{
+		Type t = ns.getType(name);
+		_types.push_back(t);
+		if (NOTYPE != t and t < _codes.size()) _codes[t] = i;
+		name += strlen(name) + 1;
+	}
+
+	// Start paging the file in, in the background.
+	madvise(p, _len, MADV_WILLNEED);
+}
+
+/// Switch over to the file that was just written. The old mapping is
+/// still valid until here, even though the file was renamed over.
+/// The file holds all of the changes, so the log starts over. The
+/// caller holds the write lock.
+void SnapshotStorage::remap(void)
+{
+	std::unique_lock<std::shared_timed_mutex> lck(_map_mtx);
+	unmap();
+	map();
+	_delta.clear();
+	_delta_in.clear();
+	if (0 <= _log_fd) reset_log();
+}
+
+void SnapshotStorage::unmap(void)
+{
+	if (_base) munmap((void*) _base, _len);
+	_base = nullptr;
+	_len = 0;
+	_hdr = nullptr;
+	_atoms = nullptr;
+	_types.clear();
+	_codes.clear();
+}
+
+size_t SnapshotStorage::size(void) const
+{
+	std::shared_lock<std::shared_timed_mutex> rlck(_map_mtx);
+	size_t n = _hdr ? _hdr->natoms : 0;
+	for (const auto& d : _delta)
+	{
+		bool in_file = NOT_FOUND != lookup(d.first);
+		if (d.second and not in_file) n++;
+		if (nullptr == d.second and in_file) n--;
+	}
+	return n;
+}
+
+void SnapshotStorage::print_stats(void) const
+{
+	printf("snapshot: %s\n", _path.c_str());
+	std::shared_lock<std::shared_timed_mutex> rlck(_map_mtx);
+	if (nullptr == _hdr)
+		printf("snapshot: no file yet\n");
+	else
+		printf("snapshot: %zu bytes, %lu atoms, %lu types, max height %lu\n",
+			_len, _hdr->natoms, _hdr->ntypes, _hdr->nlevels - 1);
+	printf("snapshot: %zu atoms changed since, in a log of %lu bytes\n",
+		_delta.size(), (unsigned long) _log_len);
+	std::lock_guard<std::mutex> lck(_pending_mtx);
+	printf("snapshot: %zu changes waiting for the next barrier\n",
+		_changes.size());
+}
+
+/* ================================================================ */
+// The log of changes since the snapshot was written.
+
+uint64_t SnapshotStorage::stamp(void) const
+{
+	return _hdr ? _hdr->stamp : 0;
+}
+
+static void log_put_type(std::string& buf, Type t)
+{
+	buf += nameserver().getTypeName(t);
+	buf.push_back('\0');
+}
+
+static Type log_get_type(const char*& p)
+{
+	Type t = nameserver().getType(p);
+	p += strlen(p) + 1;
+	return t;
+}
+
+static void log_put_atom(std::string& buf, const Handle& h)
+{
+	log_put_type(buf, h->get_type());
+	if (h->is_node())
+	{
+		const std::string& name = h->get_name();
+		buf.push_back('N');
+		codec_put<uint32_t>(buf, name.size());
+		buf += name;
+		return;
+	}
+	buf.push_back('L');
+	codec_put<uint32_t>(buf, h->get_arity());
+	for (const Handle& ho : h->getOutgoingSet())
+		log_put_atom(buf, ho);
+}
+
+/// Read an atom written by log_put_atom(). Returns nullptr if its
+/// type, or the type of an atom in it, is not known here.
+static Handle log_get_atom(const char*& p)
+{
+	Type t = log_get_type(p);
+	char kind = get<char>(p);
+	uint32_t n = get<uint32_t>(p);
+	if ('N' == kind)
+	{
+		std::string name(p, n);
+		p += n;
+		if (NOTYPE == t) return Handle::UNDEFINED;
+		return createNode(t, std::move(name));
+	}
+
+	HandleSeq oset;
+	oset.reserve(n);
+	for (uint32_t j = 0; j < n; j++)
+	{
+		Handle ho(log_get_atom(p));
+		if (nullptr == ho) t = NOTYPE;
+		oset.emplace_back(ho);
+	}
+	if (NOTYPE == t) return Handle::UNDEFINED;
+	return createLink(std::move(oset), t);
+}
+
+/// Append one change to the buffer, as a log record. A store takes
+/// the values of the atom as they are now.
+static void log_put_change(std::string& buf, char op, const Handle& h)
+{
+	std::string body(1, op);
+	log_put_atom(body, h);
+	if ('S' == op)
+	{
+		std::string vals;
+		uint32_t n = 0;
+		for (const Handle& key : h->getKeys())
+		{
+			size_t mark = vals.size();
+			log_put_atom(vals, key);
+			if (encode_binary_value(vals, h->getValue(key),
+			                        log_put_type, log_put_atom)) n++;
+			else vals.resize(mark);
+		}
+		codec_put<uint32_t>(body, n);
+		body += vals;
+	}
+	codec_put<uint32_t>(buf, body.size());
+	codec_put<uint32_t>(buf, crc32c(body.data(), body.size()));
+	buf += body;
+}
+
+/// A copy of one of the private atoms in _delta, with its values,
+/// that the caller may keep, and add to an AtomTable.
+static Handle copy_out(const Handle& h)
+{
+	Handle c;
+	if (h->is_link())
+	{
+		HandleSeq oset;
+		oset.reserve(h->get_arity());
+		for (const Handle& ho : h->getOutgoingSet())
+			oset.emplace_back(copy_out(ho));
+		c = createLink(std::move(oset), h->get_type());
+	}
+	else
+		c = createNode(h->get_type(), std::string(h->get_name()));
+	c->copyValues(h);
+	return c;
+}
+
+/// Open the log, if there is one, and apply the changes in it. Only
+/// the last record can be torn, by a crash while it was written; it
+/// is cut off. A log made for some other snapshot is started over.
+void SnapshotStorage::open_log(void)
+{
+	std::string lpath = _path + ".log";
+	_log_fd = open(lpath.c_str(), O_RDWR);
+	if (_log_fd < 0)
+	{
+		if (ENOENT == errno) return;
+		throw IOException(TRACE_INFO, "Cannot open snapshot log %s: %s",
+			lpath.c_str(), strerror(errno));
+	}
+
+	std::string buf;
+	char chunk[65536];
+	ssize_t n;
+	while (0 < (n = read(_log_fd, chunk, sizeof(chunk))))
+		buf.append(chunk, n);
+	if (n < 0)
+		throw IOException(TRACE_INFO, "Cannot read snapshot log %s: %s",
+			lpath.c_str(), strerror(errno));
+
+	SnapLogHeader lh;
+	memset(&lh, 0, sizeof(lh));
+	if (sizeof(lh) <= buf.size()) memcpy(&lh, buf.data(), sizeof(lh));
+	if (memcmp(lh.magic, SNAPSHOT_LOG_MAGIC, sizeof(lh.magic)) or
+	    lh.stamp != stamp())
+	{
+		if (not buf.empty())
+			logger().warn("SnapshotStorage: %s was not made for %s; "
+				"starting it over", lpath.c_str(), _path.c_str());
+		reset_log();
+		return;
+	}
+
+	size_t len = buf.size() - sizeof(lh);
+	size_t done = replay(buf.data() + sizeof(lh), len);
+	_log_len = sizeof(lh) + done;
+	if (done == len) return;
+
+	const char* p = buf.data() + sizeof(lh) + done;
+	if (8 <= len - done and 8 + (uint64_t) get<uint32_t>(p) < len - done)
+		throw IOException(TRACE_INFO, "Corrupt record in snapshot log %s "
+			"at byte %lu", lpath.c_str(), (unsigned long) _log_len);
+
+	logger().warn("SnapshotStorage: dropping a torn record at the end "
+		"of %s", lpath.c_str());
+	if (ftruncate(_log_fd, _log_len))
+		throw IOException(TRACE_INFO, "Cannot truncate snapshot log %s: %s",
+			lpath.c_str(), strerror(errno));
+}
+
+/// Empty the log, and stamp it with the snapshot now mapped.
+void SnapshotStorage::reset_log(void)
+{
+	std::string lpath = _path + ".log";
+	if (_log_fd < 0)
+		_log_fd = open(lpath.c_str(), O_RDWR | O_CREAT, 0644);
+
+	SnapLogHeader lh;
+	memcpy(lh.magic, SNAPSHOT_LOG_MAGIC, sizeof(lh.magic));
+	lh.stamp = stamp();
+	if (_log_fd < 0 or ftruncate(_log_fd, 0) or
+	    (ssize_t) sizeof(lh) != pwrite(_log_fd, &lh, sizeof(lh), 0) or
+	    fdatasync(_log_fd))
+		throw IOException(TRACE_INFO, "Cannot write snapshot log %s: %s",
+			lpath.c_str(), strerror(errno));
+	_log_len = sizeof(lh);
+}
+
+/// Append records to the log, and wait for them to reach the disk.
+void SnapshotStorage::append_log(const std::string& recs)
+{
+	if (_log_fd < 0) reset_log();
+
+	uint64_t end = _log_len;
+	if ((ssize_t) recs.size() ==
+	      pwrite(_log_fd, recs.data(), recs.size(), end) and
+	    0 == fdatasync(_log_fd))
+	{
+		_log_len = end + recs.size();
+		return;
+	}
+
+	int err = errno;
+	if (ftruncate(_log_fd, end))
+		logger().warn("SnapshotStorage: cannot truncate %s.log: %s",
+			_path.c_str(), strerror(errno));
+	throw IOException(TRACE_INFO, "Cannot write snapshot log %s.log: %s",
+		_path.c_str(), strerror(err));
+}
+
+/// Apply the records to the changes held in memory; return the length
+/// of those that were whole. The caller holds the map lock exclusively.
+size_t SnapshotStorage::replay(const char* buf, size_t len)
+{
+	size_t done = 0;
+	while (8 <= len - done)
+	{
+		const char* p = buf + done;
+		uint32_t n = get<uint32_t>(p);
+		uint32_t crc = get<uint32_t>(p);
+		if (len - done - 8 < n or crc32c(p, n) != crc) break;
+		apply(p);
+		done += 8 + n;
+	}
+	return done;
+}
+
+void SnapshotStorage::apply(const char* p)
+{
+	char op = get<char>(p);
+	Handle h(log_get_atom(p));
+	if (nullptr == h) return;
+	if ('S' != op)
+	{
+		remove_delta(h, 'X' == op);
+		return;
+	}
+
+	uint32_t n = get<uint32_t>(p);
+	for (uint32_t j = 0; j < n; j++)
+	{
+		Handle key(log_get_atom(p));
+		ValuePtr v(decode_binary_value(p, log_get_type,
+			[](const char*& q) -> ValuePtr { return log_get_atom(q); }));
+		if (key and v) h->setValue(key, v);
+	}
+	store_delta(h);
+}
+
+void SnapshotStorage::set_delta(const Handle& h, const Handle& copy)
+{
+	auto it = _delta.find(h);
+	if (it != _delta.end())
+	{
+		it->second = copy;
+		return;
+	}
+	_delta.emplace(h, copy);
+	if (h->is_link())
+		for (const Handle& ho : h->getOutgoingSet())
+			_delta_in.emplace(ho, h);
+}
+
+/// The atom is stored, with just the values it has. Its outgoing set
+/// and its keys are stored too, without values, if they are not there.
+void SnapshotStorage::store_delta(const Handle& h)
+{
+	if (h->is_link())
+		for (const Handle& ho : h->getOutgoingSet())
+			if (not exists(ho)) store_delta(ho);
+	for (const Handle& key : h->getKeys())
+		if (not exists(key)) store_delta(key);
+	set_delta(h, h);
+}
+
+/// The atom is removed. As with AtomTable::extract(), an atom that is
+/// still held by some link is removed only if `recursive`, and then
+/// so are the links.
+void SnapshotStorage::remove_delta(const Handle& h, bool recursive)
+{
+	if (not exists(h)) return;
+	HandleSeq links(holders(h));
+	if (not links.empty() and not recursive) return;
+	for (const Handle& l : links) remove_delta(l, true);
+	set_delta(h, Handle::UNDEFINED);
+}
+
+bool SnapshotStorage::exists(const Handle& h) const
+{
+	auto it = _delta.find(h);
+	if (it != _delta.end()) return nullptr != it->second;
+	return NOT_FOUND != lookup(h);
+}
+
+/// The links that hold the atom, in the file or in the log, less those
+/// that were removed. There may be duplicates.
+HandleSeq SnapshotStorage::holders(const Handle& h) const
+{
+	HandleSeq links;
+	size_t i = lookup(h);
+	if (NOT_FOUND != i)
+	{
+		const uint64_t* off = at<uint64_t>(_hdr->inc_off);
+		const uint32_t* inc = at<uint32_t>(_hdr->inc_idx_off);
+		for (uint64_t j = off[i]; j < off[i+1]; j++)
+		{
+			Handle l(fetch(inc[j], false));
+			if (l and 0 == _delta.count(l)) links.emplace_back(l);
+		}
+	}
+	auto range = _delta_in.equal_range(h);
+	for (auto it = range.first; it != range.second; it++)
+		if (_delta.at(it->second)) links.emplace_back(it->second);
+	return links;
+}
+
+/// The atom as it is now, with its values, or nullptr if there is no
+/// such atom.
+Handle SnapshotStorage::current(const Handle& h) const
+{
+	auto it = _delta.find(h);
+	if (it != _delta.end())
+		return it->second ? copy_out(it->second) : Handle::UNDEFINED;
+	size_t i = lookup(h);
+	if (NOT_FOUND == i) return Handle::UNDEFINED;
+	return fetch(i, true);
+}
+
+/* ================================================================ */
+
+/// Return the index of the atom in the snapshot, or NOT_FOUND.
+size_t SnapshotStorage::lookup(const Handle& h) const
+{
+	if (nullptr == _hdr or 0 == _hdr->nslots) return NOT_FOUND;
+	Type t = h->get_type();
+	if (_codes.size() <= t or NO_CODE == _codes[t]) return NOT_FOUND;
+	uint16_t code = _codes[t];
+
+	uint64_t key;
+	std::vector<uint32_t> kids;
+	if (h->is_node())
+	{
+		const std::string& name = h->get_name();
+		key = snap_node_key(code, name.data(), name.size());
+	}
+	else
+	{
+		for (const Handle& ho : h->getOutgoingSet())
+		{
+			size_t k = lookup(ho);
+			if (NOT_FOUND == k) return NOT_FOUND;
+			kids.push_back(k);
+		}
+		key = snap_link_key(code, kids.size(),
+			[&](size_t i) { return kids[i]; });
+	}
+
+	const uint32_t* slots = at<uint32_t>(_hdr->slots_off);
+	const char* names = at<char>(_hdr->names_off);
+	const uint32_t* outs = at<uint32_t>(_hdr->outs_off);
+	size_t mask = _hdr->nslots - 1;
+	for (size_t pos = key & mask; ; pos = (pos + 1) & mask)
+	{
+		uint32_t s = slots[pos];
+		if (0 == s) return NOT_FOUND;
+		const SnapAtom& a = _atoms[s - 1];
+		if (a.type != code) continue;
+		if (h->is_node())
+		{
+			const std::string& name = h->get_name();
+			if (a.len == name.size() and
+			    0 == memcmp(names + a.off, name.data(), a.len))
+				return s - 1;
+		}
+		else if (a.len == kids.size() and
+		         0 == memcmp(outs + a.off, kids.data(), 4 * a.len))
+			return s - 1;
+	}
+}
+
+/// Build the i'th atom. Its outgoing set is built too, but without
+/// values; those are not needed to find the atom in the AtomTable.
+Handle SnapshotStorage::fetch(size_t i, bool with_values) const
+{
+	const SnapAtom& a = _atoms[i];
+	Type t = _types[a.type];
+	if (NOTYPE == t) return Handle::UNDEFINED;
+
+	Handle h;
+	if (a.is_link)
+	{
+		const uint32_t* outs = at<uint32_t>(_hdr->outs_off) + a.off;
+		HandleSeq oset;
+		oset.reserve(a.len);
+		for (uint32_t j = 0; j < a.len; j++)
+		{
+			Handle ho(fetch(outs[j], false));
+			if (nullptr == ho) return Handle::UNDEFINED;
+			oset.emplace_back(ho);
+		}
+		h = createLink(std::move(oset), t);
+	}
+	else
+		h = createNode(t, std::string(at<char>(_hdr->names_off + a.off), a.len));
+
+	if (with_values) fetch_values(h, i, nullptr);
+	return h;
+}
+
+void SnapshotStorage::fetch_values(const Handle& h, size_t i,
+                                   const Built* built) const
+{
+	uint64_t voff = _atoms[i].voff;
+	if (SNAPSHOT_NO_VALUES == voff) return;
+
+	const char* p = at<char>(_hdr->vals_off + voff);
+	uint32_t n = get<uint32_t>(p);
+	for (uint32_t j = 0; j < n; j++)
+	{
+		uint32_t k = get<uint32_t>(p);
+		Handle key(built ? (*built)[k] : fetch(k, false));
+		ValuePtr v(decode_value(p, built));
+		if (key and v) h->setValue(key, v);
+	}
+}
+
+/// Decode one value, and move past it. Returns nullptr if the type
+/// is not known in this process.
+ValuePtr SnapshotStorage::decode_value(const char*& p,
+                                       const Built* built) const
+{
+	try
+	{
+		return decode_binary_value(p,
+			[&](const char*& q) {
+				uint16_t code = get<uint16_t>(q);
+				return code < _types.size() ? _types[code] : NOTYPE;
+			},
+			[&](const char*& q) -> ValuePtr {
+				uint32_t k = get<uint32_t>(q);
+				return built ? (*built)[k] : fetch(k, false);
+			});
+	}
+	catch (const IOException&)
+	{
+		throw IOException(TRACE_INFO, "Corrupt value in snapshot %s",
+			_path.c_str());
+	}
+}
+
+/* ================================================================ */
+
+Handle SnapshotStorage::getNode(Type t, const char* name)
+{
+	std::shared_lock<std::shared_timed_mutex> rlck(_map_mtx);
+	return current(createNode(t, name));
+}
+
+Handle SnapshotStorage::getLink(Type t, const HandleSeq& oset)
+{
+	std::shared_lock<std::shared_timed_mutex> rlck(_map_mtx);
+	return current(createLink(oset, t));
+}
+
+/// Links in the file that were changed since are taken from the log.
+void SnapshotStorage::fetch_incoming(AtomTable& table, const Handle& h,
+                                     Type t) const
+{
+	size_t i = lookup(h);
+	std::vector<uint32_t> links;
+	if (NOT_FOUND != i and
+	    (NOTYPE == t or (t < _codes.size() and NO_CODE != _codes[t])))
+	{
+		uint16_t code = NOTYPE == t ? NO_CODE : _codes[t];
+		const uint64_t* off = at<uint64_t>(_hdr->inc_off);
+		const uint32_t* inc = at<uint32_t>(_hdr->inc_idx_off);
+		for (uint64_t j = off[i]; j < off[i+1]; j++)
+			if (NO_CODE == code or _atoms[inc[j]].type == code)
+				links.push_back(inc[j]);
+	}
+
+	work_pool().for_each(links.size(), [&](size_t j) {
+		Handle l(fetch(links[j], false));
+		if (nullptr == l or 0 < _delta.count(l)) return;
+		fetch_values(l, links[j], nullptr);
+		table.add(l, false, true);
+	}, 64);
+
+	HandleSet seen;
+	auto range = _delta_in.equal_range(h);
+	for (auto it = range.first; it != range.second; it++)
+	{
+		const Handle& copy = _delta.at(it->second);
+		if (nullptr == copy or (NOTYPE != t and copy->get_type() != t))
+			continue;
+		if (seen.insert(copy).second)
+			table.add(copy_out(copy), false, true);
+	}
+}
+
+void SnapshotStorage::getIncomingSet(AtomTable& table, const Handle& h)
+{
+	std::shared_lock<std::shared_timed_mutex> rlck(_map_mtx);
+	fetch_incoming(table, h, NOTYPE);
+}
+
+void SnapshotStorage::getIncomingByType(AtomTable& table, const Handle& h,
+                                        Type t)
+{
+	std::shared_lock<std::shared_timed_mutex> rlck(_map_mtx);
+	fetch_incoming(table, h, t);
+}
+
+/// Only atoms that are not yet in the table are loaded, so that the
+/// values in the table are left alone.
+void SnapshotStorage::loadType(AtomTable& table, Type t)
+{
+	std::shared_lock<std::shared_timed_mutex> rlck(_map_mtx);
+	if (_hdr and t < _codes.size() and NO_CODE != _codes[t])
+	{
+		uint16_t code = _codes[t];
+		const uint64_t* off = at<uint64_t>(_hdr->bytype_off);
+		const uint32_t* idx = at<uint32_t>(_hdr->bytype_idx_off);
+		uint64_t begin = off[code];
+		work_pool().for_each(off[code+1] - begin, [&](size_t j) {
+			size_t i = idx[begin + j];
+			Handle h(fetch(i, false));
+			if (nullptr == h or 0 < _delta.count(h) or table.getHandle(h))
+				return;
+			fetch_values(h, i, nullptr);
+			table.add(h, false, true);
+		}, 256);
+	}
+
+	for (const auto& d : _delta)
+	{
+		if (nullptr == d.second or d.first->get_type() != t or
+		    table.getHandle(d.first)) continue;
+		table.add(copy_out(d.second), false, true);
+	}
+	table.barrier();
+}
+
+/// The atoms in the file, and then the changes in the log on top.
+void SnapshotStorage::loadAtomSpace(AtomTable& table)
+{
+	std::shared_lock<std::shared_timed_mutex> rlck(_map_mtx);
+	if (_hdr) load_file(table);
+
+	// The atoms that were stored since replace those in the file, and
+	// those that were removed were left out of it, above.
+	for (const auto& d : _delta)
+	{
+		if (nullptr == d.second) continue;
+		Handle h(table.getHandle(d.first));
+		bool clean = nullptr == h or not h->isDirty();
+		h = table.add(copy_out(d.second), false, true);
+		if (h and clean) h->clearDirty();
+	}
+
+	table.barrier();
+	logger().info("SnapshotStorage: loaded %lu atoms and %zu changes "
+		"from %s", _hdr ? _hdr->natoms : 0, _delta.size(), _path.c_str());
+}
+
+/// Atoms are stored by height, so each height can be built in
+/// parallel: the outgoing sets are all done by then. Values go on
+/// last, as their keys may be anywhere in the file. Atoms that were
+/// removed or stored since are left to the caller.
+void SnapshotStorage::load_file(AtomTable& table) const
+{
+	Built built(_hdr->natoms);
+	const uint64_t* levels = at<uint64_t>(_hdr->levels_off);
+	const char* names = at<char>(_hdr->names_off);
+	const uint32_t* outs = at<uint32_t>(_hdr->outs_off);
+
+	for (uint64_t lvl = 0; lvl < _hdr->nlevels; lvl++)
+	{
+		uint64_t begin = levels[lvl];
+		work_pool().for_each(levels[lvl+1] - begin, [&](size_t j) {
+			size_t i = begin + j;
+			const SnapAtom& a = _atoms[i];
+			Type t = _types[a.type];
+			if (NOTYPE == t) return;
+
+			Handle h;
+			if (a.is_link)
+			{
+				HandleSeq oset;
+				oset.reserve(a.len);
+				for (uint32_t k = 0; k < a.len; k++)
+				{
+					const Handle& ho(built[outs[a.off + k]]);
+					if (nullptr == ho) return;
+					oset.push_back(ho);
+				}
+				h = createLink(std::move(oset), t);
+			}
+			else
+				h = createNode(t, std::string(names + a.off, a.len));
+
+			auto d = _delta.find(h);
+			if (d != _delta.end() and nullptr == d->second) return;
+			built[i] = table.add(h, false, true);
+		}, 1024);
+	}
+
+	// Setting the values marks the atoms dirty; those that were clean
+	// before now hold just what the file holds, and so stay clean.
+	work_pool().for_each(built.size(), [&](size_t i) {
+		if (nullptr == built[i] or 0 < _delta.count(built[i])) return;
+		bool clean = not built[i]->isDirty();
+		fetch_values(built[i], i, &built);
+		if (clean) built[i]->clearDirty();
+	}, 1024);
+}
+
+/* ================================================================ */
+
+void SnapshotStorage::storeAtom(const Handle& h, bool synchronous)
+{
+	{
+		std::lock_guard<std::mutex> lck(_pending_mtx);
+		_changes.push_back({h, true, false});
+	}
+	if (synchronous) barrier();
+}
+
+void SnapshotStorage::removeAtom(const Handle& h, bool recursive)
+{
+	std::lock_guard<std::mutex> lck(_pending_mtx);
+	_changes.push_back({h, false, recursive});
+}
+
+/// Append the queued changes to the log, and apply them to the
+/// changes held in memory. The caller holds the write lock. Readers
+/// see the changes only once they are on disk. Once the log is large,
+/// it is merged into a new snapshot.
+void SnapshotStorage::flush(void)
+{
+	std::vector<Change> changes;
+	{
+		std::lock_guard<std::mutex> lck(_pending_mtx);
+		changes.swap(_changes);
+	}
+	if (changes.empty()) return;
+
+	std::string recs;
+	for (const Change& c : changes)
+		log_put_change(recs, c.store ? 'S' : c.recursive ? 'X' : 'R', c.h);
+
+	try
+	{
+		append_log(recs);
+	}
+	catch (...)
+	{
+		// Put them back, ahead of those that came in since.
+		std::lock_guard<std::mutex> lck(_pending_mtx);
+		changes.insert(changes.end(), _changes.begin(), _changes.end());
+		_changes.swap(changes);
+		throw;
+	}
+
+	{
+		std::unique_lock<std::shared_timed_mutex> lck(_map_mtx);
+		replay(recs.data(), recs.size());
+	}
+
+	if (std::max(COMPACT_MIN, (uint64_t) _len / 4) < _log_len)
+		compact();
+}
+
+/// Write a new snapshot, with the changes in the log merged in, by
+/// loading it all into a scratch AtomSpace. The caller holds the
+/// write lock. Readers carry on with the old mapping until the new
+/// file is in place.
+void SnapshotStorage::compact(void)
+{
+	AtomSpace scratch;
+	AtomTable& table = scratch.get_atomtable();
+	loadAtomSpace(table);
+	write(table, _path);
+	remap();
+}
+
+void SnapshotStorage::barrier(void)
+{
+	std::lock_guard<std::mutex> wlck(_write_mtx);
+	flush();
+}
+
+/// The table replaces all that was in the file, and so also all the
+/// changes that were not yet written.
+void SnapshotStorage::storeAtomSpace(const AtomTable& table)
+{
+	std::lock_guard<std::mutex> wlck(_write_mtx);
+	{
+		std::lock_guard<std::mutex> lck(_pending_mtx);
+		_changes.clear();
+	}
+	write(table, _path);
+	remap();
+}
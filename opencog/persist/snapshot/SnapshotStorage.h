@@ -0,0 +1,186 @@
+/*
+ * opencog/persist/snapshot/SnapshotStorage.h
+ *
+ * Copyright (C) 2019 OpenCog Foundation
+ * All Rights Reserved
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _OPENCOG_SNAPSHOT_STORAGE_H
+#define _OPENCOG_SNAPSHOT_STORAGE_H
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+#include <opencog/atoms/base/Atom.h>
+#include <opencog/atomspace/AtomTable.h>
+#include <opencog/atomspace/BackingStore.h>
+
+namespace opencog
+{
+/** \addtogroup grp_persist
+ *  @{
+ */
+
+struct SnapHeader;
+struct SnapAtom;
+
+/**
+ * A BackingStore kept in a single binary file, in a format that can
+ * be memory-mapped and used as-is: no parsing is needed to find an
+ * atom, its incoming set, or all atoms of a type. Opening a snapshot
+ * only maps it; atoms are built when they are asked for, either one
+ * at a time (getNode(), getLink(), getIncomingSet()), or all at once,
+ * in parallel (loadAtomSpace()).
+ *
+ * The file is written whole, by storeAtomSpace(). Single atoms passed
+ * to storeAtom() or removeAtom() are queued, and at the next barrier()
+ * appended to a log of changes next to the snapshot. A store replaces
+ * all of the values of the atom; a remove is remembered as such. The
+ * changes in the log are also kept in memory, and take precedence
+ * over the snapshot when reading. Once the log grows to a quarter of
+ * the size of the snapshot, the two are merged into a new snapshot.
+ * Thus a barrier costs time in proportion to the changes, and not to
+ * the size of the snapshot. Even so, this is meant for data that
+ * changes rarely; an AtomSpace with a budget cannot evict to a
+ * snapshot.
+ *
+ * Readers share the mapping; it is swapped for the new file only
+ * while none of them are using it.
+ *
+ * No external service is needed; the file is written to a temporary
+ * name and renamed into place, so a crash never leaves a torn file.
+ * A torn record at the end of the log is dropped when it is opened.
+ */
+class SnapshotStorage : public BackingStore
+{
+	private:
+		std::string _path;
+
+		// Held shared while reading the mapping below, and held
+		// exclusively while replacing it.
+		mutable std::shared_timed_mutex _map_mtx;
+
+		// Held while the log is written or the file is rewritten, so
+		// that concurrent barriers do not lose each other's changes.
+		std::mutex _write_mtx;
+
+		// The mapped file, or nullptr if there is none yet.
+		const char* _base;
+		size_t _len;
+		const SnapHeader* _hdr;
+		const SnapAtom* _atoms;
+
+		// File type code to in-memory type, and back.
+		std::vector<Type> _types;
+		std::vector<uint16_t> _codes;
+
+		// Changes waiting for the next barrier(), in order.
+		struct Change
+		{
+			Handle h;
+			bool store;
+			bool recursive;
+		};
+		mutable std::mutex _pending_mtx;
+		std::vector<Change> _changes;
+
+		// The log of changes made since the snapshot was written, or
+		// -1 if there is none yet.
+		int _log_fd;
+		std::atomic<uint64_t> _log_len;
+
+		// The changes in the log, by atom: a private copy of the atom,
+		// with all of its values as last stored, or nullptr if it was
+		// removed. Guarded by _map_mtx, like the mapping. The copies
+		// are never handed out, only copies of them.
+		std::map<Handle, Handle> _delta;
+
+		// The links in _delta, by the atoms in their outgoing sets.
+		std::multimap<Handle, Handle> _delta_in;
+
+		void map(void);
+		void unmap(void);
+		void remap(void);
+		void flush(void);
+		void compact(void);
+
+		uint64_t stamp(void) const;
+		void open_log(void);
+		void reset_log(void);
+		void append_log(const std::string&);
+		size_t replay(const char*, size_t);
+		void apply(const char*);
+		void set_delta(const Handle&, const Handle&);
+		void store_delta(const Handle&);
+		void remove_delta(const Handle&, bool recursive);
+		bool exists(const Handle&) const;
+		HandleSeq holders(const Handle&) const;
+		Handle current(const Handle&) const;
+
+		template<typename T>
+		const T* at(uint64_t off) const
+		{
+			return reinterpret_cast<const T*>(_base + off);
+		}
+
+		// During a bulk load, the atoms already built, by index.
+		typedef std::vector<Handle> Built;
+
+		size_t lookup(const Handle&) const;
+		Handle fetch(size_t, bool with_values) const;
+		void fetch_values(const Handle&, size_t, const Built*) const;
+		ValuePtr decode_value(const char*&, const Built*) const;
+		void fetch_incoming(AtomTable&, const Handle&, Type) const;
+		void load_file(AtomTable&) const;
+
+	public:
+		/// Open the snapshot at `path`. A missing file is not an
+		/// error; it is created by the first store.
+		SnapshotStorage(const std::string& path);
+		virtual ~SnapshotStorage();
+
+		const std::string& path(void) const { return _path; }
+		size_t size(void) const;
+		void print_stats(void) const;
+
+		/// Write a snapshot of the table to `path`. A log of changes
+		/// made to an earlier snapshot at the same path is no longer
+		/// applied to it.
+		static void write(const AtomTable&, const std::string& path);
+
+		virtual Handle getNode(Type, const char*);
+		virtual Handle getLink(Type, const HandleSeq&);
+		virtual void getIncomingSet(AtomTable&, const Handle&);
+		virtual void getIncomingByType(AtomTable&, const Handle&, Type);
+		virtual void storeAtom(const Handle&, bool synchronous = false);
+		virtual void removeAtom(const Handle&, bool recursive);
+		virtual void loadType(AtomTable&, Type);
+		virtual void loadAtomSpace(AtomTable&);
+		virtual void storeAtomSpace(const AtomTable&);
+		virtual void barrier(void);
+		virtual bool supportsEviction(void) const { return false; }
+};
+
+/** @}*/
+} //namespace opencog
+
+#endif // _OPENCOG_SNAPSHOT_STORAGE_H
@@ -0,0 +1,363 @@
+/*
+ * opencog/persist/snapshot/SnapshotWrite.cc
+ *
+ * Copyright (C) 2019 OpenCog Foundation
+ * All Rights Reserved
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <random>
+#include <unordered_map>
+
+#include <opencog/util/exceptions.h>
+#include <opencog/util/Logger.h>
+
+#include <opencog/atoms/atom_types/NameServer.h>
+#include <opencog/atoms/value/FloatValue.h>
+#include <opencog/atoms/value/LinkValue.h>
+#include <opencog/atoms/value/StringValue.h>
+
+#include <opencog/persist/ValueCodec.h>
+
+#include "SnapshotFormat.h"
+#include "SnapshotStorage.h"
+
+using namespace opencog;
+
+namespace {
+
+template<typename T>
+void put(std::string& buf, T v)
+{
+	buf.append((const char*) &v, sizeof(T));
+}
+
+/// Everything needed to lay out one snapshot. The atoms are first
+/// gathered, with their heights; then numbered, lowest first; then
+/// the sections are filled in.
+class SnapshotWriter
+{
+	// Position in _order, while gathering; file index, after.
+	std::unordered_map<Handle, size_t> _pos;
+	HandleSeq _order;
+	std::vector<uint32_t> _height;
+	std::vector<uint32_t> _index;
+
+	std::vector<Type> _types;
+	std::vector<uint16_t> _codes;
+
+	uint32_t gather(const Handle&);
+	void gather_value(const ValuePtr&);
+	uint16_t code(Type);
+	uint32_t index(const Handle& h) { return _index[_pos.at(h)]; }
+	bool encode(std::string&, const ValuePtr&);
+
+public:
+	SnapshotWriter(void) : _codes(nameserver().getNumberOfClasses(), -1) {}
+	void write(const AtomTable&, FILE*, uint64_t stamp);
+};
+
+/// A number that differs for every snapshot written, so that a log
+/// of changes is never applied to a snapshot other than its own.
+/// Zero is kept for "no snapshot".
+uint64_t new_stamp(void)
+{
+	std::random_device rd;
+	uint64_t s = ((uint64_t) rd() << 32) ^ rd() ^
+		std::chrono::system_clock::now().time_since_epoch().count();
+	return s ? s : 1;
+}
+
+} // anonymous namespace
+
+/// Add the atom, its outgoing set, and everything its values refer
+/// to; return its height.
+uint32_t SnapshotWriter::gather(const Handle& h)
+{
+	auto it = _pos.find(h);
+	if (it != _pos.end()) return _height[it->second];
+
+	uint32_t height = 0;
+	for (const Handle& ho : h->getOutgoingSet())
+		height = std::max(height, gather(ho) + 1);
+
+	_pos.emplace(h, _order.size());
+	_order.push_back(h);
+	_height.push_back(height);
+
+	for (const Handle& key : h->getKeys())
+	{
+		gather(key);
+		gather_value(h->getValue(key));
+	}
+	return height;
+}
+
+void SnapshotWriter::gather_value(const ValuePtr& v)
+{
+	if (nullptr == v) return;
+	if (v->is_atom())
+		gather(HandleCast(v));
+	else if (LINK_VALUE == v->get_type())
+		for (const ValuePtr& vp : LinkValueCast(v)->value())
+			gather_value(vp);
+}
+
+uint16_t SnapshotWriter::code(Type t)
+{
+	if ((uint16_t) -1 == _codes[t])
+	{
+		_codes[t] = _types.size();
+		_types.push_back(t);
+	}
+	return _codes[t];
+}
+
+/// Append the value; return false if it is of a kind that cannot be
+/// saved (streams, or C++ subclasses of the basic values).
+bool SnapshotWriter::encode(std::string& buf, const ValuePtr& v)
+{
+	return encode_binary_value(buf, v,
+		[&](std::string& b, Type t) { put<uint16_t>(b, code(t)); },
+		[&](std::string& b, const Handle& h) { put<uint32_t>(b, index(h)); });
+}
+
+void SnapshotWriter::write(const AtomTable& table, FILE* fh, uint64_t stamp)
+{
+	HandleSeq all;
+	table.getHandlesByType(std::back_inserter(all), ATOM, true);
+	for (const Handle& h : all) gather(h);
+	all.clear();
+
+	size_t natoms = _order.size();
+	if (std::numeric_limits<uint32_t>::max() <= natoms)
+		throw IOException(TRACE_INFO, "Too many atoms for a snapshot: %zu",
+			natoms);
+
+	// Number the atoms by height: a counting sort.
+	uint32_t max_height = 0;
+	for (uint32_t ht : _height) max_height = std::max(max_height, ht);
+	std::vector<uint64_t> levels(max_height + 2, 0);
+	for (uint32_t ht : _height) levels[ht + 1]++;
+	for (size_t l = 1; l < levels.size(); l++) levels[l] += levels[l-1];
+
+	_index.resize(natoms);
+	HandleSeq byindex(natoms);
+	{
+		std::vector<uint64_t> next(levels.begin(), levels.end() - 1);
+		for (size_t p = 0; p < natoms; p++)
+		{
+			_index[p] = next[_height[p]]++;
+			byindex[_index[p]] = _order[p];
+		}
+	}
+
+	// Fill in the atoms, their names, outgoing sets and values.
+	std::vector<SnapAtom> atoms(natoms);
+	std::string names, vals;
+	std::vector<uint32_t> outs;
+	std::vector<uint64_t> inc_off(natoms + 1, 0);
+	for (size_t i = 0; i < natoms; i++)
+	{
+		const Handle& h(byindex[i]);
+		SnapAtom& a = atoms[i];
+		a.type = code(h->get_type());
+		a.is_link = h->is_link();
+		if (a.is_link)
+		{
+			const HandleSeq& oset(h->getOutgoingSet());
+			a.len = oset.size();
+			a.off = outs.size();
+			for (size_t j = 0; j < oset.size(); j++)
+			{
+				uint32_t k = index(oset[j]);
+				outs.push_back(k);
+
+				// A link appears only once in an incoming set.
+				if (std::find(outs.end() - j - 1, outs.end() - 1, k) ==
+				    outs.end() - 1)
+					inc_off[k + 1]++;
+			}
+		}
+		else
+		{
+			const std::string& name = h->get_name();
+			a.len = name.size();
+			a.off = names.size();
+			names.append(name);
+		}
+
+		std::string vbuf;
+		uint32_t nvals = 0;
+		for (const Handle& key : h->getKeys())
+		{
+			size_t mark = vbuf.size();
+			put<uint32_t>(vbuf, index(key));
+			if (encode(vbuf, h->getValue(key))) nvals++;
+			else vbuf.resize(mark);
+		}
+		a.voff = SNAPSHOT_NO_VALUES;
+		if (0 < nvals)
+		{
+			a.voff = vals.size();
+			put<uint32_t>(vals, nvals);
+			vals.append(vbuf);
+		}
+	}
+
+	// The incoming sets, and the atoms by type, as offset tables.
+	for (size_t i = 0; i < natoms; i++) inc_off[i + 1] += inc_off[i];
+	std::vector<uint32_t> inc(inc_off[natoms]);
+	{
+		std::vector<uint64_t> next(inc_off.begin(), inc_off.end() - 1);
+		for (size_t i = 0; i < natoms; i++)
+		{
+			if (not atoms[i].is_link) continue;
+			const uint32_t* o = outs.data() + atoms[i].off;
+			for (uint32_t j = 0; j < atoms[i].len; j++)
+				if (std::find(o, o + j, o[j]) == o + j)
+					inc[next[o[j]]++] = i;
+		}
+	}
+
+	size_t ntypes = _types.size();
+	std::vector<uint64_t> bytype_off(ntypes + 1, 0);
+	for (const SnapAtom& a : atoms) bytype_off[a.type + 1]++;
+	for (size_t t = 0; t < ntypes; t++) bytype_off[t + 1] += bytype_off[t];
+	std::vector<uint32_t> bytype(natoms);
+	{
+		std::vector<uint64_t> next(bytype_off.begin(), bytype_off.end() - 1);
+		for (size_t i = 0; i < natoms; i++)
+			bytype[next[atoms[i].type]++] = i;
+	}
+
+	// The lookup table, at most half full.
+	size_t nslots = 16;
+	while (nslots < 2 * natoms) nslots *= 2;
+	std::vector<uint32_t> slots(nslots, 0);
+	for (size_t i = 0; i < natoms; i++)
+	{
+		const SnapAtom& a = atoms[i];
+		uint64_t key;
+		if (a.is_link)
+			key = snap_link_key(a.type, a.len,
+				[&](size_t j) { return outs[a.off + j]; });
+		else
+			key = snap_node_key(a.type, names.data() + a.off, a.len);
+		size_t pos = key & (nslots - 1);
+		while (slots[pos]) pos = (pos + 1) & (nslots - 1);
+		slots[pos] = i + 1;
+	}
+
+	std::string tnames;
+	for (Type t : _types)
+	{
+		tnames.append(nameserver().getTypeName(t));
+		tnames.push_back('\0');
+	}
+
+	// Lay it all out, each section aligned to eight bytes.
+	SnapHeader hdr;
+	memset(&hdr, 0, sizeof(hdr));
+	memcpy(hdr.magic, SNAPSHOT_MAGIC, sizeof(hdr.magic));
+	hdr.stamp = stamp;
+	hdr.ntypes = ntypes;
+	hdr.natoms = natoms;
+	hdr.nlevels = max_height + 1;
+	hdr.nslots = nslots;
+
+	std::vector<std::pair<const void*, size_t>> sections;
+	uint64_t off = sizeof(SnapHeader);
+	auto section = [&](const void* p, size_t len) {
+		off = (off + 7) & ~((uint64_t) 7);
+		uint64_t here = off;
+		sections.push_back({p, len});
+		off += len;
+		return here;
+	};
+	hdr.types_off = section(tnames.data(), tnames.size());
+	hdr.atoms_off = section(atoms.data(), natoms * sizeof(SnapAtom));
+	hdr.levels_off = section(levels.data(), levels.size() * sizeof(uint64_t));
+	hdr.names_off = section(names.data(), names.size());
+	hdr.outs_off = section(outs.data(), outs.size() * sizeof(uint32_t));
+	hdr.vals_off = section(vals.data(), vals.size());
+	hdr.inc_off = section(inc_off.data(), inc_off.size() * sizeof(uint64_t));
+	hdr.inc_idx_off = section(inc.data(), inc.size() * sizeof(uint32_t));
+	hdr.bytype_off = section(bytype_off.data(),
+		bytype_off.size() * sizeof(uint64_t));
+	hdr.bytype_idx_off = section(bytype.data(),
+		bytype.size() * sizeof(uint32_t));
+	hdr.slots_off = section(slots.data(), nslots * sizeof(uint32_t));
+	hdr.file_size = off;
+
+	bool ok = 1 == fwrite(&hdr, sizeof(hdr), 1, fh);
+	uint64_t at = sizeof(SnapHeader);
+	static const char zeros[8] = {0};
+	uint64_t offs[] = {hdr.types_off, hdr.atoms_off, hdr.levels_off,
+		hdr.names_off, hdr.outs_off, hdr.vals_off, hdr.inc_off,
+		hdr.inc_idx_off, hdr.bytype_off, hdr.bytype_idx_off, hdr.slots_off};
+	for (size_t s = 0; s < sections.size(); s++)
+	{
+		ok = ok and offs[s] - at == fwrite(zeros, 1, offs[s] - at, fh);
+		size_t len = sections[s].second;
+		ok = ok and len == fwrite(sections[s].first, 1, len, fh);
+		at = offs[s] + len;
+	}
+	if (not ok)
+		throw IOException(TRACE_INFO, "Error writing snapshot: %s",
+			strerror(errno));
+}
+
+/// Write to a temporary file, and rename it into place only when it
+/// is complete, so that readers never see a partial snapshot.
+void SnapshotStorage::write(const AtomTable& table, const std::string& path)
+{
+	std::string tmp = path + ".tmp";
+	FILE* fh = fopen(tmp.c_str(), "wb");
+	if (nullptr == fh)
+		throw IOException(TRACE_INFO, "Cannot create snapshot %s: %s",
+			tmp.c_str(), strerror(errno));
+
+	try
+	{
+		SnapshotWriter().write(table, fh, new_stamp());
+		if (fflush(fh) or fsync(fileno(fh)))
+			throw IOException(TRACE_INFO, "Error writing snapshot: %s",
+				strerror(errno));
+	}
+	catch (...)
+	{
+		fclose(fh);
+		unlink(tmp.c_str());
+		throw;
+	}
+	fclose(fh);
+
+	if (rename(tmp.c_str(), path.c_str()))
+		throw IOException(TRACE_INFO, "Cannot rename snapshot to %s: %s",
+			path.c_str(), strerror(errno));
+	logger().info("SnapshotStorage: wrote %zu atoms to %s",
+		table.getSize(), path.c_str());
+}
@@ -63,6 +63,21 @@ SQLAtomStorage::PseudoPtr SQLAtomStorage::getAtom(const char * query, int height
 SQLAtomStorage::PseudoPtr SQLAtomStorage::petAtom(UUID uuid)
 {
 	setup_typemap();
+
+	if (_use_libpq)
+	{
+		Response rp(conn_pool);
+		rp.uuid = TLB::INVALID_UUID;
+		int64_t param = uuid;
+		rp.exec_prepared("pet_atom", "SELECT uuid, type, name, outgoing "
+		                 "FROM Atoms WHERE uuid = $1;", 1, &param);
+		rp.rs->foreach_row(&Response::create_atom_cb, &rp);
+		if (rp.uuid == TLB::INVALID_UUID) return nullptr;
+
+		rp.height = -1;
+		return makeAtom(rp, rp.uuid);
+	}
+
 	char buff[BUFSZ];
 	snprintf(buff, BUFSZ, "SELECT * FROM Atoms WHERE uuid = %lu;", uuid);
 
@@ -74,8 +89,12 @@ SQLAtomStorage::PseudoPtr SQLAtomStorage::petAtom(UUID uuid)
 /// the outgoing set of the link has not yet been loaded.  In
 /// that case, we have to load the outgoing set first.
 ///
+/// If a map of already-fetched atoms is given, the outgoing set is
+/// looked up there first, before going to the database.
+///
 /// Note that this does NOT fetch any values!
-Handle SQLAtomStorage::get_recursive_if_not_exists(PseudoPtr p)
+Handle SQLAtomStorage::get_recursive_if_not_exists(PseudoPtr p,
+                                                   const PseudoMap* known)
 {
 	if (nameserver().isA(p->type, NODE))
 	{
@@ -96,7 +115,13 @@ Handle SQLAtomStorage::get_recursive_if_not_exists(PseudoPtr p)
 			resolved_oset.emplace_back(h);
 			continue;
 		}
-		PseudoPtr po(petAtom(idu));
+		PseudoPtr po;
+		if (known)
+		{
+			auto it = known->find(idu);
+			if (known->end() != it) po = it->second;
+		}
+		if (nullptr == po) po = petAtom(idu);
 
 		// Corrupted databases can have outoging sets that refer
 		// to non-existent atoms. This is rare, but has happened.
@@ -106,7 +131,7 @@ Handle SQLAtomStorage::get_recursive_if_not_exists(PseudoPtr p)
 				"SQLAtomStorage::get_recursive_if_not_exists: "
 				"Corrupt database; no atom for uuid=%lu", idu);
 
-		Handle ha(get_recursive_if_not_exists(po));
+		Handle ha(get_recursive_if_not_exists(po, known));
 		resolved_oset.emplace_back(ha);
 	}
 	Handle link(createLink(std::move(resolved_oset), p->type));
@@ -217,6 +242,118 @@ Handle SQLAtomStorage::getLink(Type t, const HandleSeq& hs)
 	return hg;
 }
 
+/**
+ * Look up the UUID's of all of the atoms that the TLB does not know
+ * yet, with one query per height, and put them into the TLB. A link
+ * cannot be looked up before the atoms in its outgoing set, so the
+ * heights go from the bottom up. Atoms that are not in the database
+ * are left out.
+ */
+void SQLAtomStorage::get_uuids(const HandleSeq& atoms)
+{
+	setup_typemap();
+
+	std::unordered_map<Handle, int> heights;
+	std::vector<HandleSeq> levels;
+	for (const Handle& h : atoms)
+		if (h) copy_collect(h, heights, levels);
+
+	for (size_t hei = 0; hei < levels.size(); hei++)
+	{
+		HandleSeq look;
+		std::string vals;
+		for (const Handle& h : levels[hei])
+		{
+			std::string row;
+			if (0 == hei)
+				row = "$ocp$" + h->get_name() + "$ocp$";
+			else
+			{
+				// If some atom in the outgoing set is not in the
+				// database, then neither is the link.
+				bool known = true;
+				for (const Handle& ho : h->getOutgoingSet())
+					if (TLB::INVALID_UUID == _tlbuf.getUUID(ho))
+						known = false;
+				if (not known) continue;
+				row = oset_to_string(h->getOutgoingSet());
+			}
+
+			if (not vals.empty()) vals += ", ";
+			vals += "(" + std::to_string(look.size()) + ", " +
+				std::to_string(storing_typemap[h->get_type()]) + ", " +
+				row + ")";
+			look.push_back(h);
+		}
+		if (look.empty()) continue;
+
+		std::string qry = "SELECT c.i, a.uuid FROM Atoms a JOIN (VALUES " +
+			vals + ") ";
+		if (0 == hei)
+		{
+			qry += "AS c(i, type, name) "
+			       "ON a.type = c.type AND a.name = c.name;";
+			_num_get_nodes += look.size();
+		}
+		else
+		{
+			qry += "AS c(i, type, outgoing) ON a.type = c.type "
+			       "AND a.outgoing = CAST(c.outgoing AS BIGINT[]);";
+			_num_get_links += look.size();
+		}
+
+		Response rp(conn_pool);
+		rp.exec(qry);
+		while (rp.rs->fetch_row())
+		{
+			size_t i = strtoul(rp.rs->get_column_value(0), nullptr, 10);
+			UUID uuid = strtoul(rp.rs->get_column_value(1), nullptr, 10);
+			_tlbuf.addAtom(look[i], uuid);
+			if (0 == hei) _num_got_nodes++; else _num_got_links++;
+		}
+	}
+}
+
+/**
+ * Fetch many atoms at once: their UUID's with one query per height,
+ * and then all of the values on all of them with one more query.
+ */
+HandleSeq SQLAtomStorage::getAtoms(const HandleSeq& atoms)
+{
+	rethrow();
+	get_uuids(atoms);
+
+	HandleSeq found;
+	found.reserve(atoms.size());
+	std::unordered_map<UUID, Handle> hmap;
+	std::string inset;
+	for (const Handle& h : atoms)
+	{
+		UUID uuid = h ? _tlbuf.getUUID(h) : TLB::INVALID_UUID;
+		if (TLB::INVALID_UUID == uuid)
+		{
+			found.emplace_back(Handle());
+			continue;
+		}
+		Handle ha(_tlbuf.getAtom(uuid));
+		found.emplace_back(ha);
+		if (not hmap.emplace(uuid, ha).second) continue;
+
+		if (not inset.empty()) inset += ", ";
+		inset += std::to_string(uuid);
+	}
+	if (hmap.empty()) return found;
+
+	Response rp(conn_pool);
+	rp.store = this;
+	rp.table = nullptr;
+	rp.hmap = &hmap;
+	rp.exec("SELECT key, type, floatvalue, stringvalue, linkvalue, atom "
+	        "FROM Valuations WHERE atom IN (" + inset + ");");
+	rp.rs->foreach_row(&Response::get_incoming_values_cb, &rp);
+	return found;
+}
+
 /**
  * Instantiate a new atom, from the response buffer contents
  */
@@ -243,6 +380,10 @@ SQLAtomStorage::PseudoPtr SQLAtomStorage::makeAtom(Response &rp, UUID uuid)
 	{
 		atom->name = rp.name;
 	}
+	else if (rp.binary)
+	{
+		atom->oset.swap(rp.outvec);
+	}
 	else
 	{
 		char *p = (char *) rp.outlist;
@@ -80,6 +80,12 @@ SQLAtomStorage::SQLAtomStorage(void) :
 	max_height = 0;
 	bulk_load = false;
 	bulk_store = false;
+
+	_batch_writes = false;
+	_write_batch_size = 1;
+	_write_batch_latency = std::chrono::milliseconds(0);
+	_batch_inflight = 0;
+	_batch_timer_stop = false;
 	clear_stats();
 }
 
@@ -123,6 +129,7 @@ void SQLAtomStorage::enlarge_conn_pool(int delta)
 void SQLAtomStorage::close_conn_pool()
 {
 	flushStoreQueue();
+	batch_stop();
 
 	while (not conn_pool.is_empty())
 	{
@@ -157,7 +164,8 @@ void SQLAtomStorage::connect(std::string uris)
 
 void SQLAtomStorage::open(std::string uri)
 {
-	connect(uri);
+	// The write-back batching options are ours, not the driver's.
+	connect(batch_options(uri));
 
 	// Allow for one connection per database-reader, and one connection
 	// for each writer.  Make sure that there are more connections than
@@ -169,15 +177,15 @@ void SQLAtomStorage::open(std::string uri)
 	// resources.  PSQL does not like this, and complains. Most of the
 	// time, all but a small handful of those connections are idle.
 	// Except during loading, when approx 100% of the pool gets used,
-	// due to the OMP_ALGO loops below. Likewise, when saving, when
+	// by the load threads in load_pipeline(). Likewise, when saving, when
 	// just about 100% of the NUM_WB_QUEUES are full and busy.
 	// So basically, the optimal solution seems to be to just set both
 	// to be equal to the total number of cores.
 	//
 	// Except this doesn't work, for several reasons:
-	// 1) The pool size has to be at least 1 larger than the OMP_ALGO,
-	// otherwise, we'll deadlock. The problem is that during fetches,
-	// two connections get used per OMP_ALGO thread.
+	// 1) The pool size has to be at least 1 larger than the number of
+	// load threads, otherwise, we'll deadlock. The problem is that
+	// during fetches, two connections get used per load thread.
 	// 2) Postgres has efficiency problems scaling above 8 or 12
 	// connections, at least, as of postgres 9.5 (2016).
 	// Actually, it seems not to be able to service more than 3 or 4
@@ -209,6 +217,8 @@ void SQLAtomStorage::open(std::string uri)
 
 	// Special case for the pre-defined atomspaces.
 	table_id_cache.insert(1);
+
+	batch_start();
 }
 
 /**
@@ -273,10 +283,14 @@ void SQLAtomStorage::rethrow(void)
 /// everything to PG, there's no guarantee that PG will process these
 /// requests in order. How likely this could be, I don't know.
 ///
+/// When the writers batch their stores, the batches that they are
+/// still holding are written out after the queues drain.
+///
 void SQLAtomStorage::flushStoreQueue()
 {
 	rethrow();
 	_write_queue.barrier();
+	batch_flush();
 	rethrow();
 }
 
@@ -448,6 +462,9 @@ void SQLAtomStorage::clear_stats(void)
 	_store_count = 0;
 	_valuation_stores = 0;
 	_value_stores = 0;
+	_batch_count = 0;
+	_batch_atoms = 0;
+	_batch_coalesced = 0;
 
 	_write_queue.clear_stats();
 
@@ -555,6 +572,16 @@ void SQLAtomStorage::print_stats(void)
 	       _write_queue._in_drain, _write_queue.get_busy_writers(),
 	       _write_queue.get_size());
 
+	size_t batch_count = _batch_count;
+	size_t batch_atoms = _batch_atoms;
+	size_t batch_coalesced = _batch_coalesced;
+	printf("write batching=%s batch size=%zu latency=%ld msecs\n",
+	       _batch_writes ? "true" : "false", _write_batch_size,
+	       (long) _write_batch_latency.count());
+	printf("write batches=%zu avg batch=%f coalesced stores=%zu\n",
+	       batch_count, batch_atoms / ((double) batch_count),
+	       batch_coalesced);
+
 	printf("current conn_pool free=%u of %d\n", conn_pool.size(),
 	       _initial_conn_pool_size);
 
@@ -26,8 +26,14 @@
 #define _OPENCOG_SQL_ATOM_STORAGE_H
 
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
 #include <mutex>
 #include <set>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 // #include <opencog/util/async_method_caller.h>
@@ -95,15 +101,21 @@ class SQLAtomStorage : public BackingStore
 		PseudoPtr getAtom(const char *, int);
 		PseudoPtr petAtom(UUID);
 
-		Handle get_recursive_if_not_exists(PseudoPtr);
+		typedef std::unordered_map<UUID, PseudoPtr> PseudoMap;
+		Handle get_recursive_if_not_exists(PseudoPtr,
+		                                   const PseudoMap* = nullptr);
 
 		Handle doGetNode(Type, const char *);
 		Handle doGetLink(Type, const HandleSeq&);
 
 		int getMaxObservedHeight(void);
 		int max_height;
+		void load_pipeline(int, size_t,
+		                   const std::function<size_t(int, size_t)>&,
+		                   const std::function<void(int, size_t, double)>&);
 
-		void getIncoming(AtomTable&, const char *);
+		void getIncoming(AtomTable&, const std::vector<UUID>&, int);
+		void get_uuids(const HandleSeq&);
 		// --------------------------
 		// Storing of atoms
 		std::mutex _store_mutex;
@@ -119,6 +131,40 @@ class SQLAtomStorage : public BackingStore
 		bool bulk_store;
 		time_t bulk_start;
 
+		// Bulk stores with COPY; postgres only.
+		int copy_collect(const Handle&, std::unordered_map<Handle, int>&,
+		                 std::vector<HandleSeq>&);
+		void copy_atoms(Response&, const HandleSeq&, int);
+		void copy_values(Response&, const HandleSeq&,
+		                 std::vector<ValuationPtr>&);
+		void copy_store(const HandleSeq&);
+
+		// Batched write-back; postgres only.
+		bool _batch_writes;
+		size_t _write_batch_size;
+		std::chrono::milliseconds _write_batch_latency;
+		std::mutex _batch_mutex;
+		std::condition_variable _batch_cv;
+		std::condition_variable _batch_done_cv;
+		HandleSeq _write_batch;
+		std::unordered_set<Handle> _write_batch_set;
+		std::chrono::steady_clock::time_point _write_batch_start;
+		int _batch_inflight;
+		std::thread _batch_timer;
+		bool _batch_timer_stop;
+
+		std::string batch_options(const std::string&);
+		void batch_start(void);
+		void batch_stop(void);
+		void batch_collect(const Handle&);
+		void batch_write(const HandleSeq&);
+		void batch_timer_loop(void);
+		void batch_flush(void);
+		void batch_atoms(Response&, const HandleSeq&, int);
+		void batch_values(Response&, const HandleSeq&,
+		                  std::vector<ValuationPtr>&);
+		void batch_store(const HandleSeq&);
+
 		// --------------------------
 		// Atom removal
 		void removeAtom(Response&, UUID, bool recursive);
@@ -206,6 +252,9 @@ class SQLAtomStorage : public BackingStore
 		std::atomic<size_t> _store_count;
 		std::atomic<size_t> _valuation_stores;
 		std::atomic<size_t> _value_stores;
+		std::atomic<size_t> _batch_count;
+		std::atomic<size_t> _batch_atoms;
+		std::atomic<size_t> _batch_coalesced;
 		time_t _stats_time;
 
 		// -------------------------------
@@ -258,6 +307,8 @@ class SQLAtomStorage : public BackingStore
 		Handle getLink(Type, const HandleSeq&);
 		void getIncomingSet(AtomTable&, const Handle&);
 		void getIncomingByType(AtomTable&, const Handle&, Type t);
+		HandleSeq getAtoms(const HandleSeq&);
+		void getIncomingSets(AtomTable&, const HandleSeq&);
 		void storeAtom(const Handle&, bool synchronous = false);
 		void removeAtom(const Handle&, bool recursive);
 		void loadType(AtomTable&, Type);
@@ -267,6 +318,8 @@ class SQLAtomStorage : public BackingStore
 		// Large-scale loads and saves
 		void loadAtomSpace(AtomTable &); // Load entire contents of DB
 		void storeAtomSpace(const AtomTable &); // Store all of AtomTable
+		void storeAtoms(const HandleSeq&, bool synchronous = false);
+		void releaseAtoms(const HandleSeq&);
 
 		// Debugging and performance monitoring
 		void print_stats(void);
@@ -114,6 +114,12 @@ void SQLAtomStorage::vdo_store_atom(const Handle& h)
 {
 	try
 	{
+		// Batched writers store the atom later; see SQLBatch.cc
+		if (_batch_writes)
+		{
+			batch_collect(h);
+			return;
+		}
 		if (not_yet_stored(h)) do_store_atom(h);
 		store_atom_values(h);
 	}
@@ -0,0 +1,454 @@
+/*
+ * opencog/persist/sql/multi-driver/SQLBatch.cc
+ * Batched write-back of atoms and values, with multi-row INSERTs.
+ *
+ * Copyright (C) 2019 OpenCog Foundation
+ * All Rights Reserved
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <stdlib.h>
+
+#include <algorithm>
+
+#include <opencog/atoms/base/Atom.h>
+#include <opencog/atoms/atom_types/NameServer.h>
+#include <opencog/atoms/value/FloatValue.h>
+#include <opencog/atoms/value/StringValue.h>
+#include <opencog/atoms/truthvalue/TruthValue.h>
+#include <opencog/atomspace/AtomSpace.h>
+#include <opencog/atomspaceutils/TLB.h>
+
+#include "SQLAtomStorage.h"
+#include "SQLResponse.h"
+
+using namespace opencog;
+
+/* ================================================================ */
+/*
+ * The write-back queues hand atoms to the writer threads one at a
+ * time. Written one at a time, each atom costs an INSERT, and each of
+ * its valuations a DELETE plus an INSERT, every time it is stored.
+ * A counting pipeline that bumps the same count fifty times before
+ * the queue drains pays for fifty writes.
+ *
+ * So, on postgres, the writers collect the atoms into a batch
+ * instead. An atom that is stored again, while it is still in the
+ * batch, is written only once; its values are read when the batch is
+ * written, so the latest ones go out. A batch is written when it is
+ * full, when the oldest atom in it has waited out the latency bound,
+ * or at a barrier. Each batch is two transactions: one multi-row
+ * INSERT per atom height, and one multi-row
+ * `INSERT ... ON CONFLICT DO UPDATE` for all of the valuations.
+ *
+ * The batch size and latency are set with the `write_batch` and
+ * `write_latency` (milliseconds) options in the URI given to open().
+ * A batch size of one turns batching off.
+ */
+
+/// Default number of atoms per batch.
+#define BATCH_SIZE 500
+
+/// Default longest wait, in milliseconds, before a batch is written.
+#define BATCH_MSEC 100
+
+/* ================================================================ */
+
+/// Remove the `write_batch` and `write_latency` options from the
+/// URI, and use them. Everything else after the question-mark is
+/// left for the database driver.
+std::string SQLAtomStorage::batch_options(const std::string& uri)
+{
+	_write_batch_size = BATCH_SIZE;
+	_write_batch_latency = std::chrono::milliseconds(BATCH_MSEC);
+
+	size_t qm = uri.find('?');
+	if (uri.npos == qm) return uri;
+
+	std::string rest;
+	size_t pos = qm + 1;
+	while (pos <= uri.size())
+	{
+		size_t amp = uri.find('&', pos);
+		if (uri.npos == amp) amp = uri.size();
+		std::string opt = uri.substr(pos, amp - pos);
+		pos = amp + 1;
+
+		if (0 == opt.compare(0, 12, "write_batch="))
+			_write_batch_size = strtoul(opt.c_str() + 12, nullptr, 10);
+		else if (0 == opt.compare(0, 14, "write_latency="))
+			_write_batch_latency = std::chrono::milliseconds(
+				strtoul(opt.c_str() + 14, nullptr, 10));
+		else if (not opt.empty())
+		{
+			rest += rest.empty() ? "?" : "&";
+			rest += opt;
+		}
+	}
+	return uri.substr(0, qm) + rest;
+}
+
+/// Start the thread that writes out batches that have waited too
+/// long. Multi-row upserts need postgres 9.5 or newer.
+void SQLAtomStorage::batch_start(void)
+{
+	_batch_writes = _use_libpq and 90500 <= _server_version
+		and 1 < _write_batch_size;
+	if (not _batch_writes) return;
+
+	_batch_timer_stop = false;
+	_batch_timer = std::thread(&SQLAtomStorage::batch_timer_loop, this);
+}
+
+void SQLAtomStorage::batch_stop(void)
+{
+	_batch_writes = false;
+	if (not _batch_timer.joinable()) return;
+	{
+		std::lock_guard<std::mutex> lck(_batch_mutex);
+		_batch_timer_stop = true;
+	}
+	_batch_cv.notify_all();
+	_batch_timer.join();
+}
+
+/// Add the atom to the current batch; this is called from the
+/// write-back queues. If the batch is full, write it, in this thread.
+void SQLAtomStorage::batch_collect(const Handle& h)
+{
+	HandleSeq batch;
+	{
+		std::lock_guard<std::mutex> lck(_batch_mutex);
+		if (not _write_batch_set.insert(h).second)
+		{
+			_batch_coalesced++;
+			return;
+		}
+		if (_write_batch.empty())
+		{
+			_write_batch_start = std::chrono::steady_clock::now();
+			_batch_cv.notify_all();
+		}
+		_write_batch.push_back(h);
+		if (_write_batch.size() < _write_batch_size) return;
+
+		batch.swap(_write_batch);
+		_write_batch_set.clear();
+		_batch_inflight++;
+	}
+	batch_write(batch);
+}
+
+/// Write the batch, and let the barrier know when it is done.
+void SQLAtomStorage::batch_write(const HandleSeq& batch)
+{
+	try
+	{
+		batch_store(batch);
+	}
+	catch (...)
+	{
+		std::lock_guard<std::mutex> lck(_batch_mutex);
+		_batch_inflight--;
+		_batch_done_cv.notify_all();
+		throw;
+	}
+	std::lock_guard<std::mutex> lck(_batch_mutex);
+	_batch_inflight--;
+	_batch_done_cv.notify_all();
+}
+
+void SQLAtomStorage::batch_timer_loop(void)
+{
+	std::unique_lock<std::mutex> lck(_batch_mutex);
+	while (not _batch_timer_stop)
+	{
+		if (_write_batch.empty())
+		{
+			_batch_cv.wait(lck);
+			continue;
+		}
+
+		auto due = _write_batch_start + _write_batch_latency;
+		if (std::chrono::steady_clock::now() < due)
+		{
+			_batch_cv.wait_until(lck, due);
+			continue;
+		}
+
+		HandleSeq batch;
+		batch.swap(_write_batch);
+		_write_batch_set.clear();
+		_batch_inflight++;
+		lck.unlock();
+
+		// Same as vdo_store_atom(): the user gets the exception at
+		// the next call into the backend.
+		try { batch_write(batch); }
+		catch (...)
+		{
+			_async_write_queue_exception = std::current_exception();
+		}
+		lck.lock();
+	}
+}
+
+/// Write out the current batch, and wait for the batches that other
+/// threads are writing. Called after the write-back queues drain.
+void SQLAtomStorage::batch_flush(void)
+{
+	if (not _batch_writes) return;
+
+	HandleSeq batch;
+	{
+		std::lock_guard<std::mutex> lck(_batch_mutex);
+		batch.swap(_write_batch);
+		_write_batch_set.clear();
+		if (not batch.empty()) _batch_inflight++;
+	}
+	if (not batch.empty()) batch_write(batch);
+
+	std::unique_lock<std::mutex> lck(_batch_mutex);
+	_batch_done_cv.wait(lck, [this] { return 0 == _batch_inflight; });
+}
+
+/* ================================================================ */
+
+/// Insert the atoms, all of the same height, with one statement.
+/// The atoms under them must already be in the Atoms table.
+void SQLAtomStorage::batch_atoms(Response& rp, const HandleSeq& atoms,
+                                 int hei)
+{
+	std::unordered_map<UUID, Handle> issued;
+	std::string qry = "INSERT INTO Atoms "
+		"(uuid, space, type, height, name, outgoing) VALUES ";
+	bool notfirst = false;
+	for (const Handle& h: atoms)
+	{
+		UUID uuid = _tlbuf.addAtom(h, TLB::INVALID_UUID);
+		issued.emplace(uuid, h);
+
+		if (notfirst) qry += ", "; else notfirst = true;
+		qry += "(" + std::to_string(uuid);
+
+		// XXX FIXME -- same hack as in do_store_single_atom().
+		qry += h->getAtomSpace() ? ", 1, " : ", 0, ";
+		qry += std::to_string(storing_typemap[h->get_type()]) + ", ";
+		qry += std::to_string(hei) + ", ";
+
+		// The same limits as in do_store_single_atom(), and for
+		// the same reasons: the UNIQUE indexes.
+		if (0 == hei)
+		{
+			if (2700 < h->get_name().size())
+				throw IOException(TRACE_INFO,
+					"Error: batch_atoms: Maxiumum Node name size is 2700.\n");
+
+			qry += "$ocp$" + h->get_name() + "$ocp$, NULL)";
+			_num_node_inserts++;
+			continue;
+		}
+
+		if (330 < h->get_arity())
+			throw IOException(TRACE_INFO,
+				"Error: batch_atoms: Maxiumum Link size is 330. "
+				"Atom was: %s\n", h->to_string().c_str());
+
+		qry += "NULL, " + oset_to_string(h->getOutgoingSet()) + ")";
+		_num_link_inserts++;
+	}
+	qry += " ON CONFLICT DO NOTHING RETURNING uuid;";
+
+	rp.exec(qry);
+	while (rp.rs->fetch_row())
+		issued.erase(strtoul(rp.rs->get_column_value(0), nullptr, 10));
+
+	// What is left was stored first by someone else. Use the UUID's
+	// that they got, as do_store_single_atom() does.
+	for (const auto& pr: issued)
+	{
+		_tlbuf.removeAtom(pr.first);
+		if (TLB::INVALID_UUID == check_uuid(pr.second))
+			throw IOException(TRACE_INFO,
+				"Error: batch_atoms: Lost atom %s\n",
+				pr.second->to_string().c_str());
+	}
+
+	if (max_height < hei) max_height = hei;
+	_store_count += atoms.size() - issued.size();
+}
+
+/// Upsert all of the values on the atoms, with one statement.
+/// LinkValues need rows in the Values table, so they are passed
+/// back, to be stored one at a time.
+void SQLAtomStorage::batch_values(Response& rp, const HandleSeq& atoms,
+                                  std::vector<ValuationPtr>& linkvals)
+{
+	UUID tvuid = get_uuid(tvpred);
+
+	// Rows go in (atom, key) order, so that two writers that upsert
+	// the same valuations lock them in the same order.
+	typedef std::pair<UUID, UUID> Pair;
+	std::vector<std::pair<Pair, std::string>> rows;
+	std::string deftv;
+	for (const Handle& h: atoms)
+	{
+		UUID auid = _tlbuf.getUUID(h);
+		bool default_tv = h->getTruthValue()->isDefaultTV();
+
+		// Default TV's are not stored, as in store_atom_values().
+		if (default_tv)
+		{
+			if (not deftv.empty()) deftv += ", ";
+			deftv += std::to_string(auid);
+		}
+
+		for (const Handle& key: h->getKeys())
+		{
+			ValuePtr pap = h->getValue(key);
+			Type vtype = pap->get_type();
+			UUID kuid = _tlbuf.getUUID(key);
+
+			if (default_tv and kuid == tvuid) continue;
+			if (nameserver().isA(vtype, LINK_VALUE))
+			{
+				linkvals.emplace_back(createValuation(key, h, pap));
+				continue;
+			}
+
+			std::string row = "(" + std::to_string(kuid) + ", " +
+				std::to_string(auid) + ", " +
+				std::to_string(storing_typemap[vtype]) + ", ";
+			if (nameserver().isA(vtype, FLOAT_VALUE))
+				row += float_to_string(FloatValueCast(pap)) + ", NULL";
+			else if (nameserver().isA(vtype, STRING_VALUE))
+				row += "NULL, " + string_to_string(StringValueCast(pap));
+			else
+				row += "NULL, NULL";
+			row += ", NULL)";
+			rows.emplace_back(Pair(auid, kuid), row);
+		}
+	}
+
+	std::sort(rows.begin(), rows.end());
+
+	std::string pairs;
+	std::string upsert = "INSERT INTO Valuations "
+		"(key, atom, type, floatvalue, stringvalue, linkvalue) VALUES ";
+	bool notfirst = false;
+	for (const auto& row: rows)
+	{
+		if (notfirst) { pairs += ", "; upsert += ", "; }
+		else notfirst = true;
+		pairs += "(" + std::to_string(row.first.second) + ", " +
+			std::to_string(row.first.first) + ")";
+		upsert += row.second;
+	}
+	upsert += " ON CONFLICT (key, atom) DO UPDATE SET type = EXCLUDED.type, "
+		"floatvalue = EXCLUDED.floatvalue, "
+		"stringvalue = EXCLUDED.stringvalue, "
+		"linkvalue = EXCLUDED.linkvalue;";
+
+	rp.exec("BEGIN;");
+	if (not rows.empty())
+	{
+		// The old valuations may have been LinkValues; their rows in
+		// the Values table go away with them, as in deleteValuation().
+		rp.exec("WITH RECURSIVE dead(vuid) AS ("
+		        "SELECT u.vuid FROM Valuations v "
+		        "JOIN (VALUES " + pairs + ") AS c(key, atom) "
+		        "ON v.key = c.key AND v.atom = c.atom, "
+		        "unnest(v.linkvalue) AS u(vuid) "
+		        "UNION ALL "
+		        "SELECT u.vuid FROM Values x JOIN dead ON x.vuid = dead.vuid, "
+		        "unnest(x.linkvalue) AS u(vuid)) "
+		        "DELETE FROM Values WHERE vuid IN (SELECT vuid FROM dead);");
+		rp.exec(upsert);
+	}
+	if (not deftv.empty())
+		rp.exec("DELETE FROM Valuations WHERE key = " +
+		        std::to_string(tvuid) + " AND atom IN (" + deftv + ");");
+	rp.exec("COMMIT;");
+
+	_valuation_stores += rows.size();
+}
+
+/// Store the atoms, their outgoing sets, and all of their values.
+void SQLAtomStorage::batch_store(const HandleSeq& atoms)
+{
+	setup_typemap();
+
+	{
+		// Hold the lock until the commit, so that no other thread
+		// uses a UUID issued here before its atom is visible; see
+		// not_yet_stored().
+		std::lock_guard<std::mutex> create_lock(_store_mutex);
+
+		std::unordered_map<Handle, int> heights;
+		std::vector<HandleSeq> levels;
+		for (const Handle& h: atoms)
+		{
+			copy_collect(h, heights, levels);
+			for (const Handle& key: h->getKeys())
+				copy_collect(key, heights, levels);
+		}
+
+		Response rp(conn_pool);
+		try
+		{
+			rp.exec("BEGIN;");
+			for (size_t hei = 0; hei < levels.size(); hei++)
+			{
+				if (levels[hei].empty()) continue;
+				batch_atoms(rp, levels[hei], hei);
+			}
+			rp.exec("COMMIT;");
+		}
+		catch (...)
+		{
+			// Nothing got stored; forget the UUID's issued, and put
+			// the connection back into a usable state.
+			for (const HandleSeq& lev: levels)
+				for (const Handle& h: lev)
+					_tlbuf.removeAtom(h);
+			try { rp.exec("ROLLBACK;"); } catch (...) {}
+			throw;
+		}
+	}
+
+	std::vector<ValuationPtr> linkvals;
+	{
+		Response rp(conn_pool);
+		try
+		{
+			batch_values(rp, atoms, linkvals);
+		}
+		catch (...)
+		{
+			try { rp.exec("ROLLBACK;"); } catch (...) {}
+			throw;
+		}
+	}
+
+	for (const ValuationPtr& valn: linkvals)
+		storeValuation(valn);
+
+	_batch_count++;
+	_batch_atoms += atoms.size();
+}
+
+/* ============================= END OF FILE ================= */
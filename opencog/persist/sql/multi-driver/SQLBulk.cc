@@ -24,12 +24,14 @@
 #include <time.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <chrono>
+#include <condition_variable>
 #include <memory>
+#include <unordered_set>
+#include <thread>
 
-#define OC_OMP 1  // hack alert -- force over-ride!
-#include <opencog/util/oc_assert.h>
-#include <opencog/util/oc_omp.h>
+#include <opencog/util/Logger.h>
 
 #include <opencog/atoms/base/Atom.h>
 #include <opencog/atoms/atom_types/NameServer.h>
@@ -46,40 +48,139 @@ using namespace opencog;
 #define BUFSZ 120
 /* ================================================================ */
 /**
- * Retreive the incoming set of the indicated atom.
+ * Retreive the incoming set of the indicated atom, together with
+ * everything needed to build it: the outgoing sets of the incoming
+ * links, all the way down, the keys of their values, and the values
+ * themselves. This is done in two queries, no matter how large the
+ * incoming set is. The first uses a recursive CTE to walk down the
+ * outgoing sets of the incoming links (and of their keys); the second
+ * gets all of the valuations on the incoming links.
+ *
+ * If dbtype is not negative, only links of that type are fetched.
+ * If several atoms are given, the incoming sets of all of them are
+ * fetched with the same two queries.
  */
-void SQLAtomStorage::getIncoming(AtomTable& table, const char *buff)
+void SQLAtomStorage::getIncoming(AtomTable& table,
+                                 const std::vector<UUID>& uuids, int dbtype)
 {
+	// The links in the incoming set. With libpq, for a single atom,
+	// these are the parameters of a prepared statement; else they are
+	// spelled out.
+	std::string inset;
+	bool prepared = _use_libpq and 1 == uuids.size();
+	int64_t params[2] = {(int64_t) uuids[0], dbtype};
+	int nparams = (0 <= dbtype) ? 2 : 1;
+	if (prepared)
+	{
+		inset = "a.outgoing @> ARRAY[CAST($1 AS BIGINT)]";
+		if (0 <= dbtype) inset += " AND a.type = $2";
+	}
+	else if (1 == uuids.size())
+	{
+		inset = "a.outgoing @> ARRAY[CAST(" + std::to_string(uuids[0]) +
+			" AS BIGINT)]";
+		if (0 <= dbtype) inset += " AND a.type = " + std::to_string(dbtype);
+	}
+	else
+	{
+		// The && operator is "overlaps": any of the atoms.
+		inset = "a.outgoing && CAST('{";
+		for (size_t i = 0; i < uuids.size(); i++)
+		{
+			if (0 < i) inset += ",";
+			inset += std::to_string(uuids[i]);
+		}
+		inset += "}' AS BIGINT[])";
+		if (0 <= dbtype) inset += " AND a.type = " + std::to_string(dbtype);
+	}
+
+	// Note: "select * from atoms where outgoing@>array[556];" will
+	// return all links with atom 556 in the outgoing set -- i.e. the
+	// incoming set of 556.  We could also use && here instead of @>
+	// but I don't know if this one is faster.
+	// The cast to BIGINT is needed, as otherwise one gets
+	// ERROR:  operator does not exist: bigint[] @> integer[]
+	std::string closure =
+		"WITH RECURSIVE inc AS ("
+		"SELECT a.uuid, a.type, a.name, a.outgoing FROM Atoms a "
+		"WHERE " + inset + "), "
+		"down(uuid) AS ("
+		"SELECT o.uuid FROM inc, LATERAL unnest(inc.outgoing) AS o(uuid) "
+		"UNION SELECT v.key FROM Valuations v JOIN inc ON v.atom = inc.uuid "
+		"UNION SELECT o.uuid FROM Atoms a JOIN down d ON a.uuid = d.uuid, "
+		"LATERAL unnest(a.outgoing) AS o(uuid)) "
+		"SELECT uuid, type, name, outgoing FROM inc "
+		"UNION SELECT a.uuid, a.type, a.name, a.outgoing "
+		"FROM Atoms a JOIN down d ON a.uuid = d.uuid;";
+
 	std::vector<PseudoPtr> pset;
-	Response rp(conn_pool);
-	rp.store = this;
-	rp.height = -1;
-	rp.pvec = &pset;
-	rp.exec(buff);
-	rp.rs->foreach_row(&Response::fetch_incoming_set_cb, &rp);
-
-	HandleSeq iset;
-	std::mutex iset_mutex;
-
-	// Parallelize always.
-	opencog::setting_omp(NUM_OMP_THREADS, NUM_OMP_THREADS);
-
-	// A parallel fetch is much much faster, esp for big osets.
-	// std::for_each(std::execution::par_unseq, ... requires C++17
-	OMP_ALGO::for_each(pset.begin(), pset.end(),
-		[&] (const PseudoPtr& p)
 	{
-		Handle hi(get_recursive_if_not_exists(p));
-		hi = table.add(hi, false);
+		Response rp(conn_pool);
+		rp.store = this;
+		rp.height = -1;
+		rp.pvec = &pset;
+		if (prepared)
+			rp.exec_prepared((0 <= dbtype) ? "incoming_by_type" :
+			                 "incoming_set", closure.c_str(),
+			                 nparams, params);
+		else
+			rp.exec(closure.c_str());
+		rp.rs->foreach_row(&Response::fetch_incoming_set_cb, &rp);
+	}
+
+	// The incoming links are the ones that hold one of the atoms, and
+	// have the right type; everything else is in their outgoing
+	// closure. makeAtom has already converted the types, so compare
+	// with the runtime type.
+	Type t = (0 <= dbtype) ? loading_typemap[dbtype] : NOTYPE;
+	std::unordered_set<UUID> held(uuids.begin(), uuids.end());
+	PseudoMap known;
+	std::vector<PseudoPtr> inlinks;
+	for (const PseudoPtr& p : pset)
+	{
+		known.emplace(p->uuid, p);
+		if (NOTYPE != t and p->type != t) continue;
+		for (UUID ou : p->oset)
+		{
+			if (0 == held.count(ou)) continue;
+			inlinks.emplace_back(p);
+			break;
+		}
+	}
+
+	std::unordered_map<UUID, Handle> hmap;
+	for (const PseudoPtr& p : inlinks)
+	{
+		Handle hi(get_recursive_if_not_exists(p, &known));
+		hi = table.add(hi, false, true);
 		_tlbuf.addAtom(hi, p->uuid);
-		get_atom_values(hi);
-		std::lock_guard<std::mutex> lck(iset_mutex);
-		iset.emplace_back(hi);
-	});
+		hmap.emplace(p->uuid, hi);
+	}
+
+	// Now get all the values, for all the links, in one go.
+	if (0 < hmap.size())
+	{
+		std::string vals =
+			"SELECT v.key, v.type, v.floatvalue, v.stringvalue, "
+			"v.linkvalue, v.atom FROM Valuations v "
+			"JOIN Atoms a ON v.atom = a.uuid WHERE " + inset + ";";
+
+		Response rp(conn_pool);
+		rp.store = this;
+		rp.table = &table;
+		rp.hmap = &hmap;
+		if (prepared)
+			rp.exec_prepared((0 <= dbtype) ? "incoming_by_type_values" :
+			                 "incoming_set_values", vals.c_str(),
+			                 nparams, params);
+		else
+			rp.exec(vals.c_str());
+		rp.rs->foreach_row(&Response::get_incoming_values_cb, &rp);
+	}
 
 	// Performance stats
 	_num_get_insets++;
-	_num_get_inlinks += iset.size();
+	_num_get_inlinks += hmap.size();
 }
 
 /**
@@ -94,19 +195,30 @@ void SQLAtomStorage::getIncomingSet(AtomTable& table, const Handle& h)
 	UUID uuid = check_uuid(h);
 	if (TLB::INVALID_UUID == uuid) return;
 
-	char buff[BUFSZ];
-	snprintf(buff, BUFSZ,
-		"SELECT * FROM Atoms WHERE outgoing @> ARRAY[CAST(%lu AS BIGINT)];",
-		uuid);
+	getIncoming(table, {uuid}, -1);
+}
 
-	// Note: "select * from atoms where outgoing@>array[556];" will
-	// return all links with atom 556 in the outgoing set -- i.e. the
-	// incoming set of 556.  We could also use && here instead of @>
-	// but I don't know if this one is faster.
-	// The cast to BIGINT is needed, as otherwise one gets
-	// ERROR:  operator does not exist: bigint[] @> integer[]
+/**
+ * Retreive the incoming sets of all of the atoms, in one go.
+ */
+void SQLAtomStorage::getIncomingSets(AtomTable& table, const HandleSeq& atoms)
+{
+	rethrow();
+
+	// Atoms that are not in storage cannot have an incoming set.
+	get_uuids(atoms);
+	std::vector<UUID> uuids;
+	for (const Handle& h : atoms)
+	{
+		UUID uuid = _tlbuf.getUUID(h);
+		if (TLB::INVALID_UUID != uuid) uuids.push_back(uuid);
+	}
+	if (uuids.empty()) return;
 
-	getIncoming(table, buff);
+	getIncoming(table, uuids, -1);
+
+	// Performance stats; getIncoming counted one.
+	_num_get_insets += uuids.size() - 1;
 }
 
 /**
@@ -122,14 +234,7 @@ void SQLAtomStorage::getIncomingByType(AtomTable& table, const Handle& h, Type t
 	UUID uuid = check_uuid(h);
 	if (TLB::INVALID_UUID == uuid) return;
 
-	int dbtype = storing_typemap[t];
-
-	char buff[BUFSZ];
-	snprintf(buff, BUFSZ,
-		"SELECT * FROM Atoms WHERE type = %d AND outgoing @> ARRAY[CAST(%lu AS BIGINT)];",
-		dbtype, uuid);
-
-	getIncoming(table, buff);
+	getIncoming(table, {uuid}, storing_typemap[t]);
 }
 
 /* ================================================================ */
@@ -143,6 +248,103 @@ int SQLAtomStorage::getMaxObservedHeight(void)
 	return rp.intval;
 }
 
+/**
+ * Run `load_chunk` on every chunk of every height, from 0 to max_hei,
+ * on NUM_OMP_THREADS threads. `load_chunk` returns the number of atoms
+ * that it loaded; `height_done` is called as each height finishes,
+ * with the number of atoms at that height, and the seconds since the
+ * start.
+ *
+ * There is no barrier between heights. Atoms are stored before the
+ * links that hold them, and so almost always have smaller UUID's.
+ * Thus, chunk i of height h needs, almost entirely, atoms from chunks
+ * 0 to i of the lower heights. It is handed out as soon as those are
+ * all done, and so the lower heights run only a little ahead of the
+ * higher ones, and no thread idles waiting for the slowest chunk of a
+ * height. The rare atom that is not yet resident is fetched on the
+ * spot, by get_recursive_if_not_exists().
+ */
+void SQLAtomStorage::load_pipeline(int max_hei, size_t nchunks,
+            const std::function<size_t(int, size_t)>& load_chunk,
+            const std::function<void(int, size_t, double)>& height_done)
+{
+	std::mutex mtx;
+	std::condition_variable cv;
+	size_t nhei = max_hei + 1;
+
+	// Per height: the next chunk to hand out, the number of chunks
+	// done in a row starting from chunk 0, which chunks are done, and
+	// how many atoms they held.
+	std::vector<size_t> next(nhei, 0);
+	std::vector<size_t> done(nhei, 0);
+	std::vector<std::vector<bool>> finished(nhei,
+		std::vector<bool>(nchunks, false));
+	std::vector<size_t> nloaded(nhei, 0);
+	std::exception_ptr fail;
+
+	auto start = std::chrono::steady_clock::now();
+
+	auto ready = [&](size_t hei, size_t chunk)
+	{
+		for (size_t lower = 0; lower < hei; lower++)
+			if (done[lower] <= chunk) return false;
+		return true;
+	};
+
+	auto worker = [&]()
+	{
+		std::unique_lock<std::mutex> lck(mtx);
+		while (not fail)
+		{
+			// The lowest height that has a chunk ready to go.
+			bool left = false;
+			size_t hei = nhei;
+			for (size_t h = 0; h < nhei; h++)
+			{
+				if (nchunks <= next[h]) continue;
+				left = true;
+				if (ready(h, next[h])) { hei = h; break; }
+			}
+			if (not left) return;
+			if (nhei == hei) { cv.wait(lck); continue; }
+
+			size_t chunk = next[hei]++;
+			lck.unlock();
+
+			size_t n = 0;
+			try { n = load_chunk(hei, chunk); }
+			catch (...)
+			{
+				lck.lock();
+				if (not fail) fail = std::current_exception();
+				cv.notify_all();
+				return;
+			}
+
+			lck.lock();
+			nloaded[hei] += n;
+			finished[hei][chunk] = true;
+			while (done[hei] < nchunks and finished[hei][done[hei]])
+				done[hei]++;
+			if (nchunks == done[hei])
+			{
+				std::chrono::duration<double> secs =
+					std::chrono::steady_clock::now() - start;
+				height_done(hei, nloaded[hei], secs.count());
+			}
+			cv.notify_all();
+		}
+	};
+
+	std::vector<std::thread> pool;
+	for (int i = 0; i < NUM_OMP_THREADS; i++)
+		pool.emplace_back(worker);
+	for (std::thread& t : pool)
+		t.join();
+
+	if (fail) std::rethrow_exception(fail);
+}
+
 void SQLAtomStorage::loadAtomSpace(AtomTable &table)
 {
 	rethrow();
@@ -167,29 +369,39 @@ void SQLAtomStorage::loadAtomSpace(AtomTable &table)
 		"Max Height is %d stepsize=%lu chunks=%zu\n",
 		 max_height, stepsize, steps.size());
 
-	// Parallelize always.
-	opencog::setting_omp(NUM_OMP_THREADS, NUM_OMP_THREADS);
-
-	for (int hei=0; hei<=max_height; hei++)
-	{
-		unsigned long cur = _load_count;
-
-		OMP_ALGO::for_each(steps.begin(), steps.end(),
-			[&](unsigned long rec)
+	load_pipeline(max_height, steps.size(),
+		[&](int hei, size_t chunk) -> size_t
 		{
+			unsigned long rec = steps[chunk];
 			Response rp(conn_pool);
 			rp.table = &table;
 			rp.store = this;
-			char buff[BUFSZ];
-			snprintf(buff, BUFSZ, "SELECT * FROM Atoms WHERE "
-			         "height = %d AND uuid > %lu AND uuid <= %lu;",
-			         hei, rec, rec+stepsize);
 			rp.height = hei;
-			rp.exec(buff);
+			if (_use_libpq)
+			{
+				int64_t params[3] = {hei, (int64_t) rec,
+				                     (int64_t) (rec+stepsize)};
+				rp.exec_prepared("load_height",
+				         "SELECT uuid, type, name, outgoing FROM Atoms "
+				         "WHERE height = $1 AND uuid > $2 AND uuid <= $3;",
+				         3, params);
+			}
+			else
+			{
+				char buff[BUFSZ];
+				snprintf(buff, BUFSZ, "SELECT * FROM Atoms WHERE "
+				         "height = %d AND uuid > %lu AND uuid <= %lu;",
+				         hei, rec, rec+stepsize);
+				rp.exec(buff);
+			}
 			rp.rs->foreach_row(&Response::load_all_atoms_cb, &rp);
+			return rp.nloaded;
+		},
+		[&](int hei, size_t count, double secs)
+		{
+			printf("Loaded %zu atoms at height %d; "
+			       "height done after %.1f seconds\n", count, hei, secs);
 		});
-		printf("Loaded %lu atoms at height %d\n", _load_count - cur, hei);
-	}
 
 	time_t secs = time(0) - bulk_start;
 	double rate = ((double) _load_count) / secs;
@@ -229,31 +441,42 @@ void SQLAtomStorage::loadType(AtomTable &table, Type atom_type)
 		"Max Height is %d stepsize=%lu chunks=%lu\n",
 		 max_height, stepsize, steps.size());
 
-	// Parallelize always.
-	opencog::setting_omp(NUM_OMP_THREADS, NUM_OMP_THREADS);
-
-	for (int hei=0; hei<=max_height; hei++)
-	{
-		unsigned long cur = _load_count;
-
-		OMP_ALGO::for_each(steps.begin(), steps.end(),
-			[&](unsigned long rec)
+	load_pipeline(max_height, steps.size(),
+		[&](int hei, size_t chunk) -> size_t
 		{
+			unsigned long rec = steps[chunk];
 			Response rp(conn_pool);
 			rp.table = &table;
 			rp.store = this;
-			char buff[BUFSZ];
-			snprintf(buff, BUFSZ, "SELECT * FROM Atoms WHERE type = %d "
-			         "AND height = %d AND uuid > %lu AND uuid <= %lu;",
-			         db_atom_type, hei, rec, rec+stepsize);
 			rp.height = hei;
-			rp.exec(buff);
+			if (_use_libpq)
+			{
+				int64_t params[4] = {db_atom_type, hei, (int64_t) rec,
+				                     (int64_t) (rec+stepsize)};
+				rp.exec_prepared("load_type_height",
+				         "SELECT uuid, type, name, outgoing FROM Atoms "
+				         "WHERE type = $1 AND height = $2 "
+				         "AND uuid > $3 AND uuid <= $4;",
+				         4, params);
+			}
+			else
+			{
+				char buff[BUFSZ];
+				snprintf(buff, BUFSZ, "SELECT * FROM Atoms WHERE type = %d "
+				         "AND height = %d AND uuid > %lu AND uuid <= %lu;",
+				         db_atom_type, hei, rec, rec+stepsize);
+				rp.exec(buff);
+			}
 			rp.rs->foreach_row(&Response::load_if_not_exists_cb, &rp);
+			return rp.nloaded;
+		},
+		[&](int hei, size_t count, double secs)
+		{
+			logger().debug("SQLAtomStorage::loadType: "
+			               "Loaded %zu atoms of type %d at height %d "
+			               "after %.1f seconds\n",
+			               count, db_atom_type, hei, secs);
 		});
-		logger().debug("SQLAtomStorage::loadType: "
-		               "Loaded %lu atoms of type %d at height %d\n",
-			_load_count - cur, db_atom_type, hei);
-	}
 	logger().debug("SQLAtomStorage::loadType: Finished loading %zu atoms in total\n",
 		_load_count- start_count);
 
@@ -292,17 +515,13 @@ void SQLAtomStorage::storeAtomSpace(const AtomTable &table)
 	bulk_start = time(0);
 
 	// Try to knock out the nodes first, then the links.
+	// storeAtoms() uses COPY, if it can.
 	HandleSeq atoms;
-	atoms.reserve(table.getNumNodes());
+	atoms.reserve(table.getNumNodes() + table.getNumLinks());
 	table.getHandlesByType(std::back_inserter(atoms), NODE, true);
-	for (const Handle& h: atoms) { storeAtom(h); }
-
-	atoms.clear();
-	atoms.reserve(table.getNumLinks());
 	table.getHandlesByType(std::back_inserter(atoms), LINK, true);
-	for (const Handle& h: atoms) { storeAtom(h); }
+	storeAtoms(atoms, true);
 
-	flushStoreQueue();
 	bulk_store = false;
 
 	time_t secs = time(0) - bulk_start;
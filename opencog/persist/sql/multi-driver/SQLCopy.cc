@@ -0,0 +1,456 @@
+/*
+ * opencog/persist/sql/multi-driver/SQLCopy.cc
+ * Bulk store of atoms and values, with the postgres COPY protocol.
+ *
+ * Copyright (C) 2019 OpenCog Foundation
+ * All Rights Reserved
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <unordered_set>
+
+#include <opencog/util/Logger.h>
+
+#include <opencog/atoms/base/Atom.h>
+#include <opencog/atoms/atom_types/NameServer.h>
+#include <opencog/atoms/value/FloatValue.h>
+#include <opencog/atoms/value/StringValue.h>
+#include <opencog/atoms/truthvalue/TruthValue.h>
+#include <opencog/atomspace/AtomSpace.h>
+#include <opencog/atomspaceutils/TLB.h>
+
+#include "SQLAtomStorage.h"
+#include "SQLResponse.h"
+
+using namespace opencog;
+
+/* ================================================================ */
+/*
+ * storeAtom() issues one INSERT per atom, and a DELETE plus an INSERT
+ * per valuation, each a round trip to the server. For large stores,
+ * the rows are instead streamed into temp tables with
+ * `COPY ... FROM STDIN`, in the binary format, and then merged into
+ * the Atoms and Valuations tables with one set-based statement each.
+ *
+ * Atoms are copied one height at a time, so that the outgoing sets of
+ * links can be written with the UUID's of atoms that made it into the
+ * Atoms table. Another user may have stored some of the atoms first;
+ * the merge skips those, and the TLB is pointed at the UUID's that
+ * the other user issued.
+ */
+
+/// Atoms per transaction.
+#define COPY_BATCH 100000
+
+/// Below this many atoms, the COPY is not worth the extra statements.
+#define COPY_MIN 500
+
+namespace {
+
+/// Rows in the postgres binary COPY format: a signature and header,
+/// then the rows, each a field count followed by length-prefixed
+/// fields, then a trailer. All numbers are big-endian.
+class CopyBuffer
+{
+	private:
+		std::string _buf;
+
+		void put16(uint16_t v)
+		{
+			_buf.push_back((char) (v >> 8));
+			_buf.push_back((char) v);
+		}
+		void put32(uint32_t v)
+		{
+			put16((uint16_t) (v >> 16));
+			put16((uint16_t) v);
+		}
+		void put64(uint64_t v)
+		{
+			put32((uint32_t) (v >> 32));
+			put32((uint32_t) v);
+		}
+
+		// One-dimensional array, without nulls.
+		void array_head(size_t len, uint32_t oid, size_t nelts)
+		{
+			put32(0 == nelts ? 12 : 20 + len);
+			put32(0 == nelts ? 0 : 1);
+			put32(0);
+			put32(oid);
+			if (0 == nelts) return;
+			put32(nelts);
+			put32(1);
+		}
+
+	public:
+		// Element type OID's, from pg_type.h
+		static const uint32_t INT8OID = 20;
+		static const uint32_t TEXTOID = 25;
+		static const uint32_t FLOAT8OID = 701;
+
+		CopyBuffer(void)
+		{
+			_buf.assign("PGCOPY\n\377\r\n\0", 11);
+			put32(0); // flags
+			put32(0); // header extension length
+		}
+
+		void row(int nfields) { put16(nfields); }
+		void null(void) { put32((uint32_t) -1); }
+
+		void int2(int16_t v) { put32(2); put16(v); }
+		void int8(int64_t v) { put32(8); put64(v); }
+		void text(const std::string& s)
+		{
+			put32(s.size());
+			_buf.append(s);
+		}
+
+		void int8_array(const std::vector<UUID>& v)
+		{
+			array_head(12 * v.size(), INT8OID, v.size());
+			for (UUID u : v) int8(u);
+		}
+		void float8_array(const std::vector<double>& v)
+		{
+			array_head(12 * v.size(), FLOAT8OID, v.size());
+			for (double d : v)
+			{
+				uint64_t bits;
+				memcpy(&bits, &d, 8);
+				put32(8);
+				put64(bits);
+			}
+		}
+		void text_array(const std::vector<std::string>& v)
+		{
+			size_t len = 0;
+			for (const std::string& s : v) len += 4 + s.size();
+			array_head(len, TEXTOID, v.size());
+			for (const std::string& s : v) text(s);
+		}
+
+		const std::string& finish(void)
+		{
+			put16(0xffff);
+			return _buf;
+		}
+};
+
+} // anonymous namespace
+
+/* ================================================================ */
+
+/// Return the height of the atom, and queue it, and any atoms under
+/// it, that the database does not have yet, by height.
+int SQLAtomStorage::copy_collect(const Handle& h,
+                                 std::unordered_map<Handle, int>& heights,
+                                 std::vector<HandleSeq>& levels)
+{
+	auto it = heights.find(h);
+	if (heights.end() != it) return it->second;
+
+	// Same heights as do_store_atom(): a link is one taller than
+	// its tallest member, and an empty link has height one.
+	int hei = 0;
+	if (h->is_link())
+	{
+		hei = 1;
+		for (const Handle& ho: h->getOutgoingSet())
+		{
+			int ohei = copy_collect(ho, heights, levels);
+			if (hei <= ohei) hei = ohei + 1;
+		}
+	}
+	heights.emplace(h, hei);
+
+	if (TLB::INVALID_UUID != _tlbuf.getUUID(h)) return hei;
+
+	if ((int) levels.size() <= hei) levels.resize(hei + 1);
+	levels[hei].push_back(h);
+	return hei;
+}
+
+/// Copy in the atoms, all of the same height, and merge them into
+/// the Atoms table. The atoms under them must already be there.
+void SQLAtomStorage::copy_atoms(Response& rp, const HandleSeq& atoms,
+                                int hei)
+{
+	std::unordered_map<UUID, Handle> issued;
+	CopyBuffer buf;
+	for (const Handle& h: atoms)
+	{
+		UUID uuid = _tlbuf.addAtom(h, TLB::INVALID_UUID);
+		issued.emplace(uuid, h);
+
+		buf.row(6);
+		buf.int8(uuid);
+
+		// XXX FIXME -- same hack as in do_store_single_atom().
+		buf.int8(h->getAtomSpace() ? 1 : 0);
+		buf.int2(storing_typemap[h->get_type()]);
+		buf.int2(hei);
+
+		// The same limits as in do_store_single_atom(), and for
+		// the same reasons: the UNIQUE indexes.
+		if (0 == hei)
+		{
+			if (2700 < h->get_name().size())
+				throw IOException(TRACE_INFO,
+					"Error: copy_atoms: Maxiumum Node name size is 2700.\n");
+
+			buf.text(h->get_name());
+			buf.null();
+			_num_node_inserts++;
+			continue;
+		}
+
+		if (330 < h->get_arity())
+			throw IOException(TRACE_INFO,
+				"Error: copy_atoms: Maxiumum Link size is 330. "
+				"Atom was: %s\n", h->to_string().c_str());
+
+		std::vector<UUID> oset;
+		for (const Handle& ho: h->getOutgoingSet())
+			oset.push_back(_tlbuf.getUUID(ho));
+		buf.null();
+		buf.int8_array(oset);
+		_num_link_inserts++;
+	}
+
+	rp.copy_in("COPY copy_atoms (uuid, space, type, height, name, outgoing) "
+	           "FROM STDIN WITH (FORMAT binary);", buf.finish());
+	rp.exec("INSERT INTO Atoms SELECT * FROM copy_atoms "
+	        "ON CONFLICT DO NOTHING;");
+
+	// Atoms that someone else stored first keep the UUID they got.
+	if (0 == hei)
+		rp.exec("SELECT c.uuid, a.uuid FROM copy_atoms c JOIN Atoms a "
+		        "ON a.type = c.type AND a.name = c.name "
+		        "WHERE a.uuid <> c.uuid;");
+	else
+		rp.exec("SELECT c.uuid, a.uuid FROM copy_atoms c JOIN Atoms a "
+		        "ON a.type = c.type AND a.outgoing = c.outgoing "
+		        "WHERE a.uuid <> c.uuid;");
+
+	size_t nclash = 0;
+	while (rp.rs->fetch_row())
+	{
+		UUID ours = strtoul(rp.rs->get_column_value(0), nullptr, 10);
+		UUID theirs = strtoul(rp.rs->get_column_value(1), nullptr, 10);
+		const Handle& h = issued[ours];
+		_tlbuf.removeAtom(ours);
+		_tlbuf.addAtom(h, theirs);
+		nclash++;
+	}
+
+	rp.exec("TRUNCATE copy_atoms;");
+
+	if (max_height < hei) max_height = hei;
+	_store_count += atoms.size() - nclash;
+}
+
+/// Copy in all of the values on the atoms, and merge them into the
+/// Valuations table. LinkValues need rows in the Values table, so
+/// they are passed back, to be stored one at a time.
+void SQLAtomStorage::copy_values(Response& rp, const HandleSeq& atoms,
+                                 std::vector<ValuationPtr>& linkvals)
+{
+	UUID tvuid = get_uuid(tvpred);
+
+	CopyBuffer buf;
+	size_t nrows = 0;
+	for (const Handle& h: atoms)
+	{
+		UUID auid = _tlbuf.getUUID(h);
+		bool default_tv = h->getTruthValue()->isDefaultTV();
+
+		for (const Handle& key: h->getKeys())
+		{
+			ValuePtr pap = h->getValue(key);
+			Type vtype = pap->get_type();
+			UUID kuid = _tlbuf.getUUID(key);
+
+			if (default_tv and kuid == tvuid) continue;
+			if (nameserver().isA(vtype, LINK_VALUE))
+			{
+				linkvals.emplace_back(createValuation(key, h, pap));
+				continue;
+			}
+
+			buf.row(6);
+			buf.int8(kuid);
+			buf.int8(auid);
+			buf.int2(storing_typemap[vtype]);
+			if (nameserver().isA(vtype, FLOAT_VALUE))
+			{
+				buf.float8_array(FloatValueCast(pap)->value());
+				buf.null();
+			}
+			else if (nameserver().isA(vtype, STRING_VALUE))
+			{
+				buf.null();
+				buf.text_array(StringValueCast(pap)->value());
+			}
+			else
+			{
+				buf.null();
+				buf.null();
+			}
+			buf.null();
+			nrows++;
+		}
+
+		// A row with a null type marks a valuation to be deleted.
+		// Default TV's are not stored, as in store_atom_values().
+		if (default_tv)
+		{
+			buf.row(6);
+			buf.int8(tvuid);
+			buf.int8(auid);
+			buf.null();
+			buf.null();
+			buf.null();
+			buf.null();
+		}
+	}
+
+	rp.copy_in("COPY copy_valuations "
+	           "(key, atom, type, floatvalue, stringvalue, linkvalue) "
+	           "FROM STDIN WITH (FORMAT binary);", buf.finish());
+
+	// The old valuations may have been LinkValues; their rows in the
+	// Values table go away with them, as in deleteValuation().
+	rp.exec("WITH RECURSIVE dead(vuid) AS ("
+	        "SELECT u.vuid FROM Valuations v "
+	        "JOIN copy_valuations c ON v.key = c.key AND v.atom = c.atom, "
+	        "unnest(v.linkvalue) AS u(vuid) "
+	        "UNION ALL "
+	        "SELECT u.vuid FROM Values x JOIN dead ON x.vuid = dead.vuid, "
+	        "unnest(x.linkvalue) AS u(vuid)) "
+	        "DELETE FROM Values WHERE vuid IN (SELECT vuid FROM dead);");
+
+	rp.exec("DELETE FROM Valuations v USING copy_valuations c "
+	        "WHERE c.type IS NULL AND v.key = c.key AND v.atom = c.atom;");
+
+	rp.exec("INSERT INTO Valuations SELECT * FROM copy_valuations "
+	        "WHERE type IS NOT NULL "
+	        "ON CONFLICT (key, atom) DO UPDATE SET type = EXCLUDED.type, "
+	        "floatvalue = EXCLUDED.floatvalue, "
+	        "stringvalue = EXCLUDED.stringvalue, "
+	        "linkvalue = EXCLUDED.linkvalue;");
+
+	_valuation_stores += nrows;
+}
+
+/// Store the atoms, their outgoing sets, and all of their values,
+/// in one transaction.
+void SQLAtomStorage::copy_store(const HandleSeq& batch)
+{
+	// A valuation can be merged only once per statement.
+	HandleSeq atoms;
+	std::unordered_set<Handle> seen;
+	for (const Handle& h: batch)
+		if (seen.insert(h).second) atoms.push_back(h);
+
+	std::vector<ValuationPtr> linkvals;
+	{
+		// Hold the lock until the commit, so that no other thread
+		// uses a UUID issued here before its atom is visible; see
+		// not_yet_stored().
+		std::lock_guard<std::mutex> create_lock(_store_mutex);
+
+		std::unordered_map<Handle, int> heights;
+		std::vector<HandleSeq> levels;
+		for (const Handle& h: atoms)
+		{
+			copy_collect(h, heights, levels);
+			for (const Handle& key: h->getKeys())
+				copy_collect(key, heights, levels);
+		}
+
+		Response rp(conn_pool);
+		try
+		{
+			rp.exec("BEGIN;");
+			rp.exec("CREATE TEMP TABLE copy_atoms (LIKE Atoms) "
+			        "ON COMMIT DROP;");
+			rp.exec("CREATE TEMP TABLE copy_valuations (LIKE Valuations) "
+			        "ON COMMIT DROP;");
+
+			for (size_t hei = 0; hei < levels.size(); hei++)
+			{
+				if (levels[hei].empty()) continue;
+				copy_atoms(rp, levels[hei], hei);
+			}
+			copy_values(rp, atoms, linkvals);
+
+			rp.exec("COMMIT;");
+		}
+		catch (...)
+		{
+			// Nothing got stored; forget the UUID's issued, and put
+			// the connection back into a usable state.
+			for (const HandleSeq& lev: levels)
+				for (const Handle& h: lev)
+					_tlbuf.removeAtom(h);
+			try { rp.exec("ROLLBACK;"); } catch (...) {}
+			throw;
+		}
+	}
+
+	for (const ValuationPtr& valn: linkvals)
+		storeValuation(valn);
+}
+
+/**
+ * Store all of the atoms, with their outgoing sets, and all of the
+ * values on them. Postgres gets large numbers of atoms in large
+ * batches, with COPY, and that store is always synchronous: it is
+ * done when this returns. Otherwise, the atoms go through the
+ * write-back queues, as with storeAtom(), and the store is done on
+ * return only if the `synchronous` flag is set.
+ */
+void SQLAtomStorage::storeAtoms(const HandleSeq& atoms, bool synchronous)
+{
+	rethrow();
+
+	if (not _use_libpq or atoms.size() < COPY_MIN)
+	{
+		for (const Handle& h: atoms) storeAtom(h);
+		if (synchronous) flushStoreQueue();
+		return;
+	}
+
+	setup_typemap();
+
+	for (size_t i = 0; i < atoms.size(); i += COPY_BATCH)
+	{
+		size_t end = std::min(atoms.size(), i + COPY_BATCH);
+		copy_store(HandleSeq(atoms.begin() + i, atoms.begin() + end));
+
+		logger().debug("SQLAtomStorage::storeAtoms: stored %zu of %zu",
+			end, atoms.size());
+	}
+}
+
+/* ============================= END OF FILE ================= */
@@ -63,6 +63,9 @@ class SQLAtomStorage::Response
 		const char *stringval;
 		UUID *linkval;
 
+		// Set if the results came back in the binary format.
+		bool binary;
+
 	private:
 		concurrent_stack<LLConnection*>& _pool;
 		LLConnection* _conn;
@@ -77,16 +80,19 @@ class SQLAtomStorage::Response
 		    floatval(0),
 		    stringval(nullptr),
 		    linkval(nullptr),
+		    binary(false),
 		    _pool(pool),
 		    _conn(nullptr),
 		    table(nullptr),
 		    store(nullptr),
+		    nloaded(0),
 		    pvec(nullptr),
 		    uvec(nullptr),
 		    tname(""),
 		    fltval(0),
 		    strval(nullptr),
 		    lnkval(nullptr),
+		    hmap(nullptr),
 		    intval(0)
 		{}
 
@@ -110,12 +116,14 @@ class SQLAtomStorage::Response
 			// SQL requests can be pending in parallel.
 			if (nullptr == _conn) _conn = _pool.value_pop();
 			rs = _conn->exec(buff, false);
+			binary = false;
 		}
 		void try_exec(const char * buff)
 		{
 			if (rs) rs->release();
 			if (nullptr == _conn) _conn = _pool.value_pop();
 			rs = _conn->exec(buff, true);
+			binary = false;
 		}
 		void exec(const std::string& str)
 		{
@@ -126,6 +134,129 @@ class SQLAtomStorage::Response
 			try_exec(str.c_str());
 		}
 
+		// Stream data to a `COPY ... FROM STDIN`. This uses the same
+		// connection as exec(), so that temp tables and transactions
+		// carry over.
+		void copy_in(const char * stmt, const std::string& data)
+		{
+			if (rs) rs->release();
+			rs = nullptr;
+			if (nullptr == _conn) _conn = _pool.value_pop();
+			_conn->copy_in(stmt, data);
+		}
+
+		// Run a prepared statement, with integer parameters. The
+		// results come back in binary, and the callbacks below decode
+		// them by column number, instead of parsing text. Postgres only.
+		void exec_prepared(const char * name, const char * stmt,
+		                   int nparams, const int64_t * params)
+		{
+			if (rs) rs->release();
+			if (nullptr == _conn) _conn = _pool.value_pop();
+			rs = _conn->exec_prepared(name, stmt, nparams, params);
+			binary = true;
+		}
+
+		// Binary results --------------------------------------------
+		// Integers are big-endian; arrays have a header of the number
+		// of dimensions, a has-nulls flag and the element type, then
+		// the size and lower bound of each dimension, and then the
+		// length-prefixed elements.
+		static uint64_t get_be(const char* p, int len)
+		{
+			uint64_t v = 0;
+			for (int i = 0; i < len; i++)
+				v = (v << 8) | (unsigned char) p[i];
+			return v;
+		}
+
+		int64_t int_col(int col)
+		{
+			const char* p = rs->get_column_value(col);
+			int len = rs->get_column_length(col);
+			uint64_t v = get_be(p, 0 < len ? len : 0);
+			if (2 == len) return (int16_t) v;
+			if (4 == len) return (int32_t) v;
+			return (int64_t) v;
+		}
+
+		// Call elt(ptr, len) for each element of a one-dimensional
+		// array column.
+		template<typename F>
+		void array_col(int col, F elt)
+		{
+			int len = rs->get_column_length(col);
+			if (len < 12) return;
+			const char* p = rs->get_column_value(col);
+			const char* end = p + len;
+			if (0 == get_be(p, 4)) return;
+			if (len < 20)
+				throw IOException(TRACE_INFO, "Malformed array");
+			int nelts = get_be(p+12, 4);
+			p += 20;
+			for (int i = 0; i < nelts; i++)
+			{
+				if (end < p+4)
+					throw IOException(TRACE_INFO, "Malformed array");
+				int elen = (int32_t) get_be(p, 4);
+				p += 4;
+				if (elen < 0) elen = 0;
+				if (end < p+elen)
+					throw IOException(TRACE_INFO, "Malformed array");
+				elt(p, elen);
+				p += elen;
+			}
+		}
+
+		// Atoms, as uuid, type, name, outgoing.
+		std::vector<UUID> outvec;
+		void get_atom_row(void)
+		{
+			uuid = int_col(0);
+			itype = int_col(1);
+			name = rs->get_column_value(2);
+			outvec.clear();
+			array_col(3, [&](const char* p, int len)
+				{ outvec.push_back(get_be(p, len)); });
+		}
+
+		// Values and valuations, as key (or vuid), type, floatvalue,
+		// stringvalue, linkvalue.
+		std::vector<double> fltvec;
+		std::vector<std::string> strvec;
+		std::vector<UUID> lnkvec;
+		void get_value_row(void)
+		{
+			key = int_col(0);
+			vtype = int_col(1);
+			fltvec.clear();
+			array_col(2, [&](const char* p, int len)
+			{
+				uint64_t bits = get_be(p, len);
+				double d;
+				memcpy(&d, &bits, sizeof(d));
+				fltvec.push_back(d);
+			});
+			strvec.clear();
+			array_col(3, [&](const char* p, int len)
+				{ strvec.emplace_back(p, len); });
+			lnkvec.clear();
+			array_col(4, [&](const char* p, int len)
+				{ lnkvec.push_back(get_be(p, len)); });
+		}
+
+		void get_atom_columns(void)
+		{
+			if (binary) get_atom_row();
+			else rs->foreach_column(&Response::create_atom_column_cb, this);
+		}
+
+		void get_value_columns(void)
+		{
+			if (binary) get_value_row();
+			else rs->foreach_column(&Response::get_value_column_cb, this);
+		}
+
 		// Fetching of atoms -----------------------------------------
 		bool create_atom_column_cb(const char *colname, const char * colvalue)
 		{
@@ -156,17 +287,18 @@ class SQLAtomStorage::Response
 		bool create_atom_cb(void)
 		{
 			// printf ("---- New atom found ----\n");
-			rs->foreach_column(&Response::create_atom_column_cb, this);
+			get_atom_columns();
 
 			return true;
 		}
 
 		AtomTable *table;
 		SQLAtomStorage *store;
+		size_t nloaded;   // Atoms loaded by the callbacks below.
 		bool load_all_atoms_cb(void)
 		{
 			// printf ("---- New atom found ----\n");
-			rs->foreach_column(&Response::create_atom_column_cb, this);
+			get_atom_columns();
 
 			// Two different throws mighht be caught here:
 			// 1) DB has an atom type that is not defined in the atomspace.
@@ -180,13 +312,18 @@ class SQLAtomStorage::Response
 				PseudoPtr p(store->makeAtom(*this, uuid));
 
 				Handle atom(store->get_recursive_if_not_exists(p));
-				Handle h(table->add(atom, false));
+				Handle h(table->add(atom, false, true));
 
 				// Force resolution in TLB, so that later removes work.
 				store->_tlbuf.addAtom(h, uuid);
 
 				// Get the values only after TLB insertion!!
+				// An atom that was clean holds just what the
+				// database holds, and so it stays clean.
+				bool clean = not h->isDirty();
 				store->get_atom_values(h);
+				if (clean) h->clearDirty();
+				nloaded++;
 			}
 			catch (const IOException& ex) {}
 
@@ -198,25 +335,28 @@ class SQLAtomStorage::Response
 		bool load_if_not_exists_cb(void)
 		{
 			// printf ("---- New atom found ----\n");
-			rs->foreach_column(&Response::create_atom_column_cb, this);
+			get_atom_columns();
 
 			Handle h(store->_tlbuf.getAtom(uuid));
 			if (nullptr == h)
 			{
 				PseudoPtr p(store->makeAtom(*this, uuid));
 				h = store->get_recursive_if_not_exists(p);
-				h = table->add(h, false);
+				h = table->add(h, false, true);
 				store->_tlbuf.addAtom(h, uuid);
 			}
 			else
 			{
 				// In case it's still in the TLB, but was
 				// previously removed from the atomspace.
-				h = table->add(h, false);
+				h = table->add(h, false, true);
 			}
 
 			// Clobber all values, including truth values.
+			bool clean = not h->isDirty();
 			store->get_atom_values(h);
+			if (clean) h->clearDirty();
+			nloaded++;
 			return false;
 		}
 
@@ -224,7 +364,7 @@ class SQLAtomStorage::Response
 		bool fetch_incoming_set_cb(void)
 		{
 			// printf ("---- New atom found ----\n");
-			rs->foreach_column(&Response::create_atom_column_cb, this);
+			get_atom_columns();
 
 			// Note, unlike the above 'load' routines, this merely fetches
 			// the atoms, and returns a vector of them.  They are loaded
@@ -287,7 +427,7 @@ class SQLAtomStorage::Response
 		UUID key;
 		bool get_value_cb(void)
 		{
-			rs->foreach_column(&Response::get_value_column_cb, this);
+			get_value_columns();
 			// Returning true halts the callback after one row.  The
 			// ODBC driver will clobber empty rows, so this is needed.
 			return true;
@@ -330,7 +470,7 @@ class SQLAtomStorage::Response
 		Handle atom;
 		bool get_all_values_cb(void)
 		{
-			rs->foreach_column(&Response::get_value_column_cb, this);
+			get_value_columns();
 
 			Handle hkey(store->_tlbuf.getAtom(key));
 			if (nullptr == hkey)
@@ -343,9 +483,9 @@ class SQLAtomStorage::Response
 				// ever verifies that the key gets inserted into some
 				// table.  The correct fix is to add AtomTable as a
 				// part of the BackingStore API. XXX TODO FIXME.
-				if (table) hkey = table->add(hkey, false);
+				if (table) hkey = table->add(hkey, false, true);
 				else if (atom->getAtomTable())
-					hkey = atom->getAtomTable()->add(hkey, false);
+					hkey = atom->getAtomTable()->add(hkey, false, true);
 				store->_tlbuf.addAtom(hkey, key);
 			}
 
@@ -354,6 +494,38 @@ class SQLAtomStorage::Response
 			return false;
 		}
 
+		// Values of a whole incoming set, or of a batch of atoms,
+		// fetched in one query. The atom column comes last, after the
+		// usual value columns.
+		std::unordered_map<UUID, Handle> *hmap;
+		bool get_incoming_values_cb(void)
+		{
+			get_value_columns();
+			if (binary) uuid = int_col(5);
+
+			auto it = hmap->find(uuid);
+			if (hmap->end() == it) return false;
+
+			// The keys were fetched along with the incoming set, so
+			// they should all be known by now.
+			Handle hkey(store->_tlbuf.getAtom(key));
+			if (nullptr == hkey)
+			{
+				PseudoPtr pu(store->petAtom(key));
+				hkey = store->get_recursive_if_not_exists(pu);
+			}
+			// Without a table, as for getAtoms(), put the key where
+			// the atom is, if it is anywhere.
+			if (table) hkey = table->add(hkey, false, true);
+			else if (it->second->getAtomTable())
+				hkey = it->second->getAtomTable()->add(hkey, false, true);
+			store->_tlbuf.addAtom(hkey, key);
+
+			ValuePtr pap = store->doUnpackValue(*this);
+			it->second->setValue(hkey, pap);
+			return false;
+		}
+
 		// Generic things --------------------------------------------
 		// Get generic positive integer values
 		unsigned long intval;
@@ -77,6 +77,16 @@ void SQLAtomStorage::extract_callback(const AtomPtr& atom)
 	_tlbuf.removeAtom(atom);
 }
 
+/// The atomspace evicted these, to stay under its budget; this is
+/// case 1) above, done on purpose. Drop them from the TLB, or else
+/// they would stay in RAM. They will be looked up again, by UUID,
+/// if they are ever fetched back.
+void SQLAtomStorage::releaseAtoms(const HandleSeq& atoms)
+{
+	for (const Handle& h : atoms)
+		_tlbuf.removeAtom(h);
+}
+
 /* ================================================================== */
 /// Return the UUID of the handle, if it is known.
 /// If the handle is in the database, then the correct UUID is returned.
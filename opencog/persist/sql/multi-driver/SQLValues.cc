@@ -312,6 +312,17 @@ SQLAtomStorage::VUID SQLAtomStorage::storeValue(const ValuePtr& pap)
 /// fetch is performed.
 ValuePtr SQLAtomStorage::getValue(VUID vuid)
 {
+	if (_use_libpq)
+	{
+		Response rp(conn_pool);
+		int64_t param = vuid;
+		rp.exec_prepared("get_value", "SELECT vuid, type, floatvalue, "
+		                 "stringvalue, linkvalue FROM Values WHERE vuid = $1;",
+		                 1, &param);
+		rp.rs->foreach_row(&Response::get_value_cb, &rp);
+		return doUnpackValue(rp);
+	}
+
 	char buff[BUFSZ];
 	snprintf(buff, BUFSZ, "SELECT * FROM Values WHERE vuid = %lu;", vuid);
 	return doGetValue(buff);
@@ -339,6 +350,24 @@ ValuePtr SQLAtomStorage::doUnpackValue(Response& rp)
 	// We expect rp.strval to be of the form
 	// {aaa,"bb bb bb","ccc ccc ccc"}
 	// Split it along the commas.
+	if (rp.binary)
+	{
+		if (vtype == STRING_VALUE)
+			return createStringValue(rp.strvec);
+		if (vtype == FLOAT_VALUE)
+			return createFloatValue(rp.fltvec);
+		if (nameserver().isA(vtype, TRUTH_VALUE))
+			return ValueCast(TruthValue::factory(vtype, rp.fltvec));
+		if (vtype == LINK_VALUE)
+		{
+			std::vector<ValuePtr> lnkarr;
+			for (VUID vu : rp.lnkvec)
+				lnkarr.emplace_back(getValue(vu));
+			return createLinkValue(lnkarr);
+		}
+		throw IOException(TRACE_INFO, "Unexpected value type=%d", rp.vtype);
+	}
+
 	if (vtype == STRING_VALUE)
 	{
 		std::vector<std::string> strarr;
@@ -461,13 +490,22 @@ void SQLAtomStorage::get_atom_values(Handle& atom)
 {
 	if (nullptr == atom) return;
 
-	char buff[BUFSZ];
-	snprintf(buff, BUFSZ,
-		"SELECT * FROM Valuations WHERE atom = %lu;",
-		get_uuid(atom));
-
 	Response rp(conn_pool);
-	rp.exec(buff);
+	if (_use_libpq)
+	{
+		int64_t param = get_uuid(atom);
+		rp.exec_prepared("get_valuations", "SELECT key, type, floatvalue, "
+		                 "stringvalue, linkvalue FROM Valuations "
+		                 "WHERE atom = $1;", 1, &param);
+	}
+	else
+	{
+		char buff[BUFSZ];
+		snprintf(buff, BUFSZ,
+			"SELECT * FROM Valuations WHERE atom = %lu;",
+			get_uuid(atom));
+		rp.exec(buff);
+	}
 
 	rp.store = this;
 	rp.atom = atom;
@@ -90,15 +90,10 @@ LLPGRecordSet * LLPGConnection::get_record_set(void)
 
 /* =========================================================== */
 
-LLRecordSet *
-LLPGConnection::exec(const char * buff, bool trial_run)
+void
+LLPGConnection::check_result(LLPGRecordSet* rs, const char * buff,
+                             bool trial_run)
 {
-	if (!is_connected) return NULL;
-
-	LLPGRecordSet* rs = get_record_set();
-
-	rs->_result = PQexec(_pgconn, buff);
-
 	ExecStatusType rest = PQresultStatus(rs->_result);
 	if (rest != PGRES_COMMAND_OK and
 	    rest != PGRES_EMPTY_QUERY and
@@ -134,11 +129,143 @@ LLPGConnection::exec(const char * buff, bool trial_run)
 	/* Use numbr of columns to indicate that the query hasn't
 	 * given results yet. */
 	rs->ncols = -1;
+}
+
+LLRecordSet *
+LLPGConnection::exec(const char * buff, bool trial_run)
+{
+	if (!is_connected) return NULL;
+
+	LLPGRecordSet* rs = get_record_set();
+
+	rs->_result = PQexec(_pgconn, buff);
+	rs->_binary = false;
+	check_result(rs, buff, trial_run);
 	return rs;
 }
 
 /* =========================================================== */
 
+#define INT8OID 20
+#define MAX_PARAMS 8
+
+LLRecordSet *
+LLPGConnection::exec_prepared(const char * name, const char * stmt,
+                              int nparams, const int64_t * params)
+{
+	if (!is_connected) return NULL;
+
+	if (MAX_PARAMS < nparams)
+		throw opencog::RuntimeException(TRACE_INFO,
+			"Too many parameters: %d\n%s", nparams, stmt);
+
+	if (_prepared.end() == _prepared.find(name))
+	{
+		Oid types[MAX_PARAMS];
+		for (int i=0; i<nparams; i++) types[i] = INT8OID;
+
+		PGresult* res = PQprepare(_pgconn, name, stmt, nparams, types);
+		if (PQresultStatus(res) != PGRES_COMMAND_OK)
+		{
+			std::string msg = PQresultErrorMessage(res);
+			PQclear(res);
+			throw opencog::RuntimeException(TRACE_INFO,
+				"Failed to prepare SQL statement: %s\nPQ query was: %s",
+				msg.c_str(), stmt);
+		}
+		PQclear(res);
+		_prepared.insert(name);
+	}
+
+	// The parameters go in binary, too: big-endian 8-byte ints.
+	char bytes[MAX_PARAMS][8];
+	const char* vals[MAX_PARAMS];
+	int lens[MAX_PARAMS];
+	int fmts[MAX_PARAMS];
+	for (int i=0; i<nparams; i++)
+	{
+		uint64_t v = params[i];
+		for (int j=7; 0<=j; j--) { bytes[i][j] = (char) v; v >>= 8; }
+		vals[i] = bytes[i];
+		lens[i] = 8;
+		fmts[i] = 1;
+	}
+
+	LLPGRecordSet* rs = get_record_set();
+
+	rs->_result = PQexecPrepared(_pgconn, name, nparams,
+	                             vals, lens, fmts, 1);
+	rs->_binary = true;
+	check_result(rs, stmt, false);
+	return rs;
+}
+
+/* =========================================================== */
+
+#define COPY_PIECE (1024*1024)
+
+void
+LLPGConnection::copy_in(const char * stmt, const std::string& data)
+{
+	if (!is_connected)
+		throw opencog::RuntimeException(TRACE_INFO,
+			"No connection to the database!");
+
+	PGresult* res = PQexec(_pgconn, stmt);
+	if (PQresultStatus(res) != PGRES_COPY_IN)
+	{
+		std::string msg = PQresultErrorMessage(res);
+		PQclear(res);
+		throw opencog::RuntimeException(TRACE_INFO,
+			"Failed to start COPY: %s\nPQ query was: %s",
+			msg.c_str(), stmt);
+	}
+	PQclear(res);
+
+	// The length passed to PQputCopyData is an int; so hand the
+	// data over in pieces. On a blocking connection, each call
+	// returns 1, or -1 on error.
+	const char* p = data.data();
+	size_t left = data.size();
+	int rc = 1;
+	while (0 < left and 1 == rc)
+	{
+		int n = (COPY_PIECE < left) ? COPY_PIECE : (int) left;
+		rc = PQputCopyData(_pgconn, p, n);
+		p += n;
+		left -= n;
+	}
+	if (1 == rc)
+		rc = PQputCopyEnd(_pgconn, nullptr);
+	else
+		PQputCopyEnd(_pgconn, "client gave up");
+
+	// Collect the outcome of the COPY. There is one result for it,
+	// and there must be no more after that.
+	std::string msg;
+	bool ok = (1 == rc);
+	if (not ok) msg = PQerrorMessage(_pgconn);
+	while (nullptr != (res = PQgetResult(_pgconn)))
+	{
+		if (PQresultStatus(res) != PGRES_COMMAND_OK)
+		{
+			ok = false;
+			msg = PQresultErrorMessage(res);
+		}
+		PQclear(res);
+	}
+
+	if (not ok)
+	{
+		opencog::logger().warn("COPY failed: %s", msg.c_str());
+		throw opencog::RuntimeException(TRACE_INFO,
+			"Failed to COPY data: %s\nPQ query was: %s",
+			msg.c_str(), stmt);
+	}
+}
+
+/* =========================================================== */
+
 void
 LLPGRecordSet::setup_cols(int new_ncols)
 {
@@ -152,6 +279,10 @@ LLPGRecordSet::setup_cols(int new_ncols)
 	values = new char*[new_ncols];
 	memset(values, 0, new_ncols * sizeof(char*));
 
+	if (vsizes) delete[] vsizes;
+	vsizes = new int[new_ncols];
+	memset(vsizes, 0, new_ncols * sizeof(int));
+
    arrsize = new_ncols;
 }
 
@@ -165,6 +296,7 @@ LLPGRecordSet::LLPGRecordSet(LLPGConnection* _conn)
 	_result = nullptr;
 	_nrows = -1;
 	_curr_row = -1;
+	_binary = false;
 }
 
 /* =========================================================== */
@@ -229,6 +361,18 @@ LLPGRecordSet::fetch_row(void)
 	{
 		values[i] = PQgetvalue(_result, _curr_row, i);
 	}
+
+	// Binary values may contain nulls; their length is needed.
+	if (_binary)
+	{
+		for (int i=0; i< ncols; i++)
+		{
+			if (PQgetisnull(_result, _curr_row, i))
+				vsizes[i] = -1;
+			else
+				vsizes[i] = PQgetlength(_result, _curr_row, i);
+		}
+	}
 	_curr_row++;
 	return true;
 }
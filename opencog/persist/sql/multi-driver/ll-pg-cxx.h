@@ -27,6 +27,8 @@
 
 #ifdef HAVE_PGSQL_STORAGE
 
+#include <set>
+
 #include <libpq-fe.h>
 
 #include "llapi.h"
@@ -43,12 +45,19 @@ class LLPGConnection : public LLConnection
 	private:
 		PGconn* _pgconn;
 		LLPGRecordSet* get_record_set(void);
+		void check_result(LLPGRecordSet*, const char *, bool);
+
+		// Names of the statements prepared on this connection.
+		std::set<std::string> _prepared;
 
 	public:
 		LLPGConnection(const char * uri);
 		~LLPGConnection();
 
 		LLRecordSet *exec(const char *, bool);
+		void copy_in(const char *, const std::string&);
+		LLRecordSet *exec_prepared(const char *, const char *,
+		                           int, const int64_t *);
 };
 
 class LLPGRecordSet : public LLRecordSet
@@ -56,6 +65,7 @@ class LLPGRecordSet : public LLRecordSet
 	friend class LLPGConnection;
 	private:
 		PGresult* _result;
+		bool _binary;
 		int _nrows;
 		int _curr_row;
 
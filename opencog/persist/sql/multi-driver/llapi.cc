@@ -64,6 +64,23 @@ LLConnection::~LLConnection()
     }
 }
 
+/* =========================================================== */
+
+void
+LLConnection::copy_in(const char * stmt, const std::string& data)
+{
+    throw opencog::RuntimeException(TRACE_INFO,
+        "This database driver does not support COPY:\n%s", stmt);
+}
+
+LLRecordSet *
+LLConnection::exec_prepared(const char * name, const char * stmt,
+                            int nparams, const int64_t * params)
+{
+    throw opencog::RuntimeException(TRACE_INFO,
+        "This database driver does not support binary results:\n%s", stmt);
+}
+
 /* =========================================================== */
 /* pseudo-private routine */
 
@@ -171,6 +188,14 @@ LLRecordSet::get_column_value(int column)
     return values[column];
 }
 
+int
+LLRecordSet::get_column_length(int column)
+{
+    if (column >= get_column_count() or nullptr == vsizes) return -1;
+
+    return vsizes[column];
+}
+
 /* =========================================================== */
 
 #ifdef UNIT_TEST_EXAMPLE
@@ -28,6 +28,8 @@
 #ifndef _OPENCOG_PERSISTENT_LL_DRIVER_H
 #define _OPENCOG_PERSISTENT_LL_DRIVER_H
 
+#include <stdint.h>
+
 #include <stack>
 #include <string>
 
@@ -52,6 +54,19 @@ class LLConnection
         bool connected(void) const { return is_connected; }
 
         virtual LLRecordSet *exec(const char *, bool=false) = 0;
+
+        // Run a `COPY ... FROM STDIN` statement, sending it the data.
+        // Drivers that cannot do this throw.
+        virtual void copy_in(const char *, const std::string&);
+
+        // Run a statement with BIGINT parameters $1, $2, ..., and get
+        // the results in the binary format. The statement is prepared
+        // the first time it is used, under the given name. Drivers
+        // that cannot do this throw.
+        virtual LLRecordSet *exec_prepared(const char *name,
+                                           const char *stmt,
+                                           int nparams,
+                                           const int64_t *params);
 };
 
 class LLRecordSet
@@ -81,6 +96,10 @@ class LLRecordSet
         int get_column_count();
         const char * get_column_value(int column);
 
+        // The size, in bytes, of a value in a binary result,
+        // or -1 if the value is null.
+        int get_column_length(int column);
+
         // call this, instead of the destructor,
         // when done with this instance.
         virtual void release(void);
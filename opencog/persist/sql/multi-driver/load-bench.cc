@@ -0,0 +1,152 @@
+/*
+ * FUNCTION:
+ * Load benchmark. Stores a synthetic dataset of many heights, and
+ * then loads it back, reporting the rate of each phase.
+ *
+ * Usage:
+ *    load-bench URI [NODES [LINKS-PER-HEIGHT [MAX-HEIGHT]]]
+ * for example,
+ *    load-bench "postgres:///opencog_test?user=opencog_tester" 100000
+ *
+ * CAUTION: this erases the contents of the database!
+ *
+ * HISTORY:
+ * Copyright (c) 2019 OpenCog Foundation
+ */
+
+#ifdef HAVE_SQL_STORAGE
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <chrono>
+#include <random>
+
+#include <opencog/atoms/base/Atom.h>
+#include <opencog/atoms/truthvalue/SimpleTruthValue.h>
+#include <opencog/atomspace/AtomSpace.h>
+#include <opencog/persist/sql/multi-driver/SQLAtomStorage.h>
+
+using namespace opencog;
+
+typedef std::chrono::steady_clock Clock;
+
+static double report(const char* phase, size_t natoms, Clock::time_point start)
+{
+	std::chrono::duration<double> secs = Clock::now() - start;
+	printf("load-bench: %-12s %9zu atoms in %8.2f secs = %9.0f atoms/sec\n",
+	       phase, natoms, secs.count(), natoms / secs.count());
+	return secs.count();
+}
+
+/// Nodes, then, at each height, links that hold one atom from the
+/// height just below, and one from anywhere below, so that the links
+/// at each height really do depend on every lower height.
+static size_t generate(AtomSpace* as, size_t nnodes, size_t nlinks,
+                       int max_hei)
+{
+	std::mt19937 rng(42);
+	std::vector<HandleSeq> levels(max_hei + 1);
+	HandleSeq below;
+
+	for (size_t i = 0; i < nnodes; i++)
+	{
+		Handle h = as->add_node(CONCEPT_NODE, "bench " + std::to_string(i));
+		if (0 == i%3)
+			h->setTruthValue(SimpleTruthValue::createTV(0.5, i));
+		levels[0].push_back(h);
+		below.push_back(h);
+	}
+
+	for (int hei = 1; hei <= max_hei; hei++)
+	{
+		const HandleSeq& prev = levels[hei-1];
+		for (size_t i = 0; i < nlinks; i++)
+		{
+			Handle a = prev[rng() % prev.size()];
+			Handle b = below[rng() % below.size()];
+			Handle h = as->add_link(LIST_LINK, a, b);
+			levels[hei].push_back(h);
+		}
+		below.insert(below.end(), levels[hei].begin(), levels[hei].end());
+	}
+	return as->get_size();
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 2)
+	{
+		fprintf(stderr, "Usage: %s URI [NODES [LINKS-PER-HEIGHT "
+		        "[MAX-HEIGHT]]]\n", argv[0]);
+		return 1;
+	}
+	std::string uri = argv[1];
+	size_t nnodes = (2 < argc) ? atol(argv[2]) : 100000;
+	size_t nlinks = (3 < argc) ? atol(argv[3]) : nnodes;
+	int max_hei = (4 < argc) ? atoi(argv[4]) : 10;
+
+	// Generate and store.
+	SQLAtomStorage* store = new SQLAtomStorage();
+	store->open(uri);
+	if (not store->connected())
+	{
+		fprintf(stderr, "load-bench: cannot connect to %s\n", uri.c_str());
+		return 1;
+	}
+	store->kill_data();
+
+	AtomSpace* as = new AtomSpace();
+	store->registerWith(as);
+
+	Clock::time_point start = Clock::now();
+	size_t natoms = generate(as, nnodes, nlinks, max_hei);
+	report("generate", natoms, start);
+
+	start = Clock::now();
+	as->store_atomspace();
+	as->barrier();
+	report("store", natoms, start);
+
+	store->unregisterWith(as);
+	delete as;
+	delete store;
+
+	// Load everything, in a fresh session. loadAtomSpace() reports
+	// when each height finishes.
+	store = new SQLAtomStorage();
+	store->open(uri);
+	as = new AtomSpace();
+	store->registerWith(as);
+
+	start = Clock::now();
+	as->load_atomspace();
+	report("load", as->get_size(), start);
+
+	store->unregisterWith(as);
+	delete as;
+	delete store;
+
+	// Load just the links, in a fresh session; their nodes have to
+	// be fetched along the way.
+	store = new SQLAtomStorage();
+	store->open(uri);
+	as = new AtomSpace();
+	store->registerWith(as);
+
+	start = Clock::now();
+	as->fetch_all_atoms_of_type(LIST_LINK);
+	report("load-type", as->get_size(), start);
+
+	store->print_stats();
+	store->kill_data();
+	store->unregisterWith(as);
+	delete as;
+	delete store;
+	return 0;
+}
+
+#else /* HAVE_SQL_STORAGE */
+int main () { return 1; }
+#endif /* HAVE_SQL_STORAGE */
+/* ============================= END OF FILE ================= */
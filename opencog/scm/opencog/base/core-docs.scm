@@ -92,6 +92,30 @@
         )
 ")
 
+(set-procedure-property! cog-new-atoms 'documentation
+"
+ cog-new-atoms ATOM-LIST [ATOMSPACE]
+    Add all of the atoms in ATOM-LIST to the atomspace, and return a
+    list of the resulting atoms, in the same order. This is the same
+    as re-creating each atom in turn, with `cog-new-node` or
+    `cog-new-link`, but is much faster for large lists: the whole
+    list is inserted at once.
+
+    If the optional ATOMSPACE argument is given, then the atoms are
+    added to it; otherwise, they are added to the current atomspace.
+
+    Example:
+        ; Copy two atoms from one atomspace into another.
+        guile> (define x (cog-new-node 'ConceptNode \"abc\"))
+        guile> (define y (cog-new-link 'ListLink x))
+        guile> (define as (cog-new-atomspace))
+        guile> (cog-new-atoms (list x y) as)
+        ((ConceptNode \"abc\")
+         (ListLink
+           (ConceptNode \"abc\")
+        ))
+")
+
 (set-procedure-property! cog-link 'documentation
 "
  cog-link LINK-TYPE ATOM-1 ... ATOM-N
@@ -841,6 +865,54 @@
   will display a count of all atoms of type 'ConceptNode
 ")
 
+(set-procedure-property! cog-random-atoms 'documentation
+"
+  cog-random-atoms ATOM-TYPE K [ATOMSPACE] -- Random sample of atoms
+
+  Return a list of K atoms of type `ATOM-TYPE` (or any of its
+  subtypes), drawn uniformly at random, with replacement. The time
+  taken does not depend on the size of the AtomSpace, so this is
+  suitable for stochastic sampling of large AtomSpaces. Asking for
+  many atoms at once is much cheaper than asking for one at a time.
+
+  If the optional argument `ATOMSPACE` is given, then the atoms are
+  drawn from that AtomSpace; otherwise, the default AtomSpace is used.
+
+  Example usage:
+     (cog-random-atoms 'Atom 10)
+  will return ten atoms, drawn from the whole AtomSpace, while
+     (cog-random-atoms 'ConceptNode 3)
+  will return three ConceptNodes.
+")
+
+(set-procedure-property! cog-report-memory 'documentation
+"
+  cog-report-memory [ATOMSPACE] -- Bytes used, by atom and value type
+
+  Return an estimate of the memory used by the atoms of each type,
+  and by the values attached to them. This is an association list
+  with two entries: `atoms`, an association list by atom type, and
+  `values`, an association list by value type. For each atom type,
+  the bytes are broken out into those used by the atoms themselves
+  (including node names, each counted once), their outgoing sets,
+  their incoming sets, their value tables, and the values in those
+  tables. Value types get a count and a number of bytes. Types with
+  many atoms are sampled, so the byte counts are estimates; the atom
+  counts are exact.
+
+  If the optional argument `ATOMSPACE` is given, then the report is
+  for that AtomSpace; otherwise, the default AtomSpace is used.
+
+  Example usage:
+     (assoc-ref (assoc-ref (cog-report-memory) 'atoms) 'ConceptNode)
+  will return something like
+     ((count . 3) (atoms . 312) (outgoing . 0) (incoming . 0)
+      (value-tables . 96) (values . 144) (total . 552))
+
+  See also:
+     cog-report-counts -- which reports counts by type.
+")
+
 (set-procedure-property! cog-atomspace 'documentation
 "
  cog-atomspace
@@ -112,6 +112,9 @@
 
  Load scheme data from the indicated file, and execute it.
 
+ Files holding only atoms and values can be loaded much faster with
+ (load-file), from the (opencog persist-file) module.
+
  Example Usage:
  (load-scm-from-file \"/tmp/some-file.scm\")
 "
@@ -155,6 +158,9 @@
  Export the entire contents of the atomspace to the file 'filename'
  If an absolute path is not specified, then the filename will be
  written to the directory in which the opencog server was started.
+
+ For large atomspaces, (dump-file), from the (opencog persist-file)
+ module, is much faster, and does not build a list of all the atoms.
 "
 	(let ((port (open-file filename "w"))
 		)
@@ -0,0 +1,61 @@
+;
+; OpenCog File Loader module
+;
+
+(define-module (opencog persist-file))
+
+(use-modules (opencog))
+(use-modules (opencog as-config))
+(load-extension (string-append opencog-ext-path-persist-file "libpersist-file") "opencog_persist_file_init")
+
+(export dump-atoms dump-file load-file)
+
+(set-procedure-property! dump-atoms 'documentation
+"
+ dump-atoms FILENAME TYPE BINARY COMPRESS
+
+   Same as `dump-file`, except that all of the arguments are mandatory.
+")
+
+(define* (dump-file FILENAME #:optional (TYPE 'Atom) (BINARY #f) (COMPRESS #f))
+"
+ dump-file FILENAME [TYPE [BINARY [COMPRESS]]]
+
+    Write the atoms of type TYPE, and of its subtypes, to FILENAME,
+    along with their values. By default, all atoms are written. The
+    file can be read back with (load-file).
+
+    Each atom is written as a complete s-expression; an atom that is
+    a part of some other atom that is written is written only as a
+    part of that one. If BINARY is #t, a compact binary form is
+    written instead. If COMPRESS is #t, the file is gzip'ed.
+
+    This is the same as (export-all-atoms), only much faster, and
+    without holding a list of all of the atoms. The types are written
+    in parallel.
+
+    Returns the number of atoms written.
+
+  Example:
+     (dump-file \"/tmp/everything.scm\")
+     (dump-file \"/tmp/concepts.bin.gz\" 'ConceptNode #t #t)
+"
+	(dump-atoms FILENAME TYPE BINARY COMPRESS)
+)
+
+(set-procedure-property! load-file 'documentation
+"
+ load-file FILENAME - Load the atoms in FILENAME into the atomspace.
+    The file must hold only atoms, values, (cog-set-tv! ...) and
+    (cog-set-value! ...) expressions; these are read directly, without
+    evaluating them as scheme. This is many times faster than (load),
+    and uses several threads. Files with other scheme code in them
+    must be loaded with (load) or (load-scm-from-file).
+
+    Files written by (dump-file), in any of its forms, can be loaded.
+
+    Returns the number of atoms read.
+
+  Example:
+     (load-file \"/tmp/my-atoms.scm\")
+")
@@ -0,0 +1,59 @@
+;
+; OpenCog Log-Structured Persistence module
+;
+
+(define-module (opencog persist-lsm))
+
+(use-modules (opencog))
+(use-modules (opencog persist))
+(use-modules (opencog as-config))
+(load-extension (string-append opencog-ext-path-persist-lsm "libpersist-lsm") "opencog_persist_lsm_init")
+
+(export lsm-clear-cache lsm-close lsm-compact lsm-open lsm-stats)
+
+(set-procedure-property! lsm-clear-cache 'documentation
+"
+ lsm-clear-cache - forget the ids of the atoms stored so far.
+    This frees up RAM. Atoms stored after this will have their ids
+    looked up again, which is slower.
+")
+
+(set-procedure-property! lsm-close 'documentation
+"
+ lsm-close - close the currently open store.
+    Pending stores are written out first. After the close, atoms can
+    no longer be stored to or fetched from the store.
+")
+
+(set-procedure-property! lsm-compact 'documentation
+"
+ lsm-compact - merge all of the segment files into one.
+    Segments are merged in the background as they accumulate, so
+    this is never needed. It frees the disk space held by deleted
+    and overwritten atoms, and makes fetches a little faster.
+")
+
+(set-procedure-property! lsm-open 'documentation
+"
+ lsm-open DIR - Open the store in the directory DIR.
+    The directory is created if it does not exist. Only one process
+    can have a store open at a time.
+
+    Stores, with (store-atom), are queued and written by several
+    threads. They are durable, that is, they survive a crash, only
+    after (barrier) returns.
+
+  Example:
+     (lsm-open \"/tmp/my-atoms\")
+     (load-atomspace)
+     (store-atom (Concept \"foo\"))
+     (barrier)
+     (lsm-close)
+")
+
+(set-procedure-property! lsm-stats 'documentation
+"
+ lsm-stats - report performance statistics.
+    This prints the state of the store queue, of the memtable, and
+    of the segment files.
+")
@@ -0,0 +1,44 @@
+;
+; OpenCog Snapshot Persistence module
+;
+
+(define-module (opencog persist-snapshot))
+
+(use-modules (opencog))
+(use-modules (opencog persist))
+(use-modules (opencog as-config))
+(load-extension (string-append opencog-ext-path-persist-snapshot "libpersist-snapshot") "opencog_persist_snapshot_init")
+
+(export snapshot-close snapshot-open snapshot-stats)
+
+(set-procedure-property! snapshot-close 'documentation
+"
+ snapshot-close - close the currently open snapshot.
+    Any atoms stored since the last barrier are first written out,
+    by rewriting the snapshot file. After the close, atoms can no
+    longer be stored to or fetched from the snapshot.
+")
+
+(set-procedure-property! snapshot-open 'documentation
+"
+ snapshot-open PATH - Open a snapshot file.
+    The file is memory-mapped, and not read until atoms are fetched
+    from it; opening takes the same time, no matter how big the file
+    is. If the file does not exist, it is created on the first store.
+
+    The snapshot is a read-mostly store: (load-atomspace) and
+    (load-atoms-of-type) are fast, and so are (fetch-atom) and
+    (fetch-incoming-set). Stores of single atoms are queued, and
+    written out at (barrier), by writing a new snapshot; so are
+    bulk stores, with (store-atomspace).
+
+  Example:
+     (snapshot-open \"/tmp/my-atoms.snap\")
+     (load-atomspace)
+     (snapshot-close)
+")
+
+(set-procedure-property! snapshot-stats 'documentation
+"
+ snapshot-stats - report the size of the open snapshot.
+")
@@ -73,7 +73,12 @@
        postgres:///DBNAME?user=USER&password=PASS
 
     Other key-value pairs following the question-mark are interpreted
-    by the postgres driver, according to postgres documentation.
+    by the postgres driver, according to postgres documentation, except
+    for these two, which control the batching of stores:
+       write_batch=N    -- write stores in batches of N atoms (default
+                           500); 1 writes each atom on its own.
+       write_latency=MS -- write a batch after its oldest store has
+                           waited MS milliseconds (default 100).
 
   Examples of use with valid URL's:
      (sql-open \"odbc://opencog_tester:cheese/opencog_test\")
@@ -82,6 +87,7 @@
      (sql-open \"postgres:///opencog_test?user=opencog_tester\")
      (sql-open \"postgres:///opencog_test?user=opencog_tester&host=localhost\")
      (sql-open \"postgres:///opencog_test?user=opencog_tester&password=cheese\")
+     (sql-open \"postgres:///opencog_test?user=opencog_tester&write_batch=2000\")
 ")
 
 (set-procedure-property! sql-set-hilo-watermarks! 'documentation
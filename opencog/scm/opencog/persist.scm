@@ -11,7 +11,9 @@
 
 ; This avoids complaints, when the docs are set, below.
 (export fetch-atom fetch-incoming-set fetch-incoming-by-type
-store-atom load-atoms-of-type barrier load-atomspace store-atomspace)
+store-atom fetch-atoms fetch-incoming-sets store-atoms
+load-atoms-of-type barrier load-atomspace store-atomspace
+set-atom-budget set-memory-budget)
 
 ;; -----------------------------------------------------
 ;;
@@ -50,6 +52,32 @@ store-atom load-atoms-of-type barrier load-atomspace store-atomspace)
     the atomspace.
 ")
 
+(set-procedure-property! fetch-atoms 'documentation
+"
+ fetch-atoms ATOM-LIST
+    Fetch all of the values on all of the atoms in ATOM-LIST, in as
+    few trips to SQL/persistent storage as possible. This is the same
+    as calling `fetch-atom` on each atom, but much faster for long
+    lists. Returns a list of the atoms, in the same order. As with
+    `fetch-atom`, atoms that are not in storage are added to the
+    atomspace anyway, without any values.
+")
+
+(set-procedure-property! fetch-incoming-sets 'documentation
+"
+ fetch-incoming-sets ATOM-LIST
+    Fetch the incoming sets of all of the atoms in ATOM-LIST from SQL
+    storage, all at once. The fetch is NOT recursive. Returns ATOM-LIST.
+")
+
+(set-procedure-property! store-atoms 'documentation
+"
+ store-atoms ATOM-LIST
+    Store all of the atoms in ATOM-LIST, and all of their keys and
+    values, to SQL/persistent storage, in as few trips as possible.
+    Returns ATOM-LIST.
+")
+
 (set-procedure-property! load-atoms-of-type 'documentation
 "
  load-atoms-of-type TYPE
@@ -67,6 +95,28 @@ store-atom load-atoms-of-type barrier load-atomspace store-atomspace)
     them to the database.
 ")
 
+(set-procedure-property! set-atom-budget 'documentation
+"
+ set-atom-budget COUNT
+    Keep no more than COUNT atoms in the current atomspace, so that it
+    can work on more data than fits in RAM. When there are more, the
+    least recently used atoms that no link in the atomspace holds are
+    saved to SQL/persistent storage, if they changed, and extracted.
+    They are fetched back when they are next asked for: by getting or
+    creating them, or by looking at an incoming set that lost them.
+    This replaces managing RAM by hand with `fetch-atom` and
+    `cog-extract`. A COUNT of zero removes the bound.
+
+    See also `set-memory-budget`.
+")
+
+(set-procedure-property! set-memory-budget 'documentation
+"
+ set-memory-budget BYTES
+    Same as `set-atom-budget`, but the bound is the estimated number
+    of bytes used by the atoms and their values.
+")
+
 (set-procedure-property! load-atomspace 'documentation
 "
  load-atomspace - load all atoms in the database.
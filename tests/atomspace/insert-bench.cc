@@ -0,0 +1,104 @@
+/*
+ * tests/atomspace/insert-bench.cc
+ *
+ * Insert benchmark. Measures how the atom insertion rate scales with
+ * the number of threads. The AtomTable index is striped into
+ * independently-locked shards, so unrelated insertions should scale
+ * nearly linearly, until memory bandwidth runs out. This is not run
+ * by ctest; ConcurrentInsertUTest checks the results for correctness.
+ *
+ * Usage:
+ *    insert-bench [ATOMS [MAX-THREADS]]
+ * for example,
+ *    insert-bench 240000 32
+ * Each run inserts ATOMS atoms, split evenly between the threads.
+ *
+ * Copyright (C) 2019 OpenCog Foundation
+ * All Rights Reserved
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <opencog/atomspace/AtomSpace.h>
+#include <opencog/atoms/base/Node.h>
+
+using namespace opencog;
+
+typedef std::chrono::steady_clock Clock;
+
+// Each thread adds n/2 nodes, and a link between consecutive pairs
+// of them. Nothing is shared between threads, except the table.
+static void insert(AtomSpace* as, int thread_id, int n)
+{
+    Handle prev;
+    for (int i = 0; i < n; i += 2) {
+        std::string name = "thread " + std::to_string(thread_id)
+            + " node " + std::to_string(i);
+        Handle h = as->add_node(CONCEPT_NODE, std::move(name));
+        if (prev)
+            as->add_link(LIST_LINK, prev, h);
+        prev = h;
+    }
+}
+
+static double timed_run(AtomSpace* as, int natoms, int nthreads)
+{
+    as->clear();
+    int per_thread = natoms / nthreads;
+
+    Clock::time_point start = Clock::now();
+    std::vector<std::thread> pool;
+    for (int i = 0; i < nthreads; i++)
+        pool.push_back(std::thread(insert, as, i, per_thread));
+    for (std::thread& t : pool) t.join();
+    std::chrono::duration<double> secs = Clock::now() - start;
+
+    // Each thread adds per_thread/2 nodes and one less link.
+    size_t expect = nthreads * (per_thread - 1);
+    if (as->get_size() != expect)
+        fprintf(stderr, "insert-bench: expected %zu atoms, got %zu\n",
+                expect, as->get_size());
+    return as->get_size() / secs.count();
+}
+
+int main(int argc, char* argv[])
+{
+    int natoms = (1 < argc) ? atoi(argv[1]) : 240000;
+    int max_threads = (2 < argc) ? atoi(argv[2]) : 32;
+    if (natoms <= 0 or max_threads <= 0) {
+        fprintf(stderr, "Usage: %s [ATOMS [MAX-THREADS]]\n", argv[0]);
+        return 1;
+    }
+
+    AtomSpace* as = new AtomSpace();
+    double base = timed_run(as, natoms, 1);
+    printf("insert-bench: threads: %2d  atoms/sec: %10.0f  speedup: %5.2f\n",
+           1, base, 1.0);
+    for (int n = 2; n <= max_threads; n *= 2) {
+        double rate = timed_run(as, natoms, n);
+        printf("insert-bench: threads: %2d  atoms/sec: %10.0f  speedup: %5.2f\n",
+               n, rate, rate / base);
+    }
+    delete as;
+    return 0;
+}
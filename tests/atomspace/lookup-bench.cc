@@ -0,0 +1,154 @@
+/*
+ * tests/atomspace/lookup-bench.cc
+ *
+ * Lookup benchmark. Reader threads resolve atoms by content, as the
+ * pattern matcher does, while a writer thread inserts nodes at a fixed
+ * rate. Lookups take no locks, so the rate should grow with the number
+ * of readers, whatever the writer does. This is not run by ctest;
+ * ConcurrentLookupUTest checks the lookups for correctness. The run
+ * begins by printing the memory used by the lookup index.
+ *
+ * Usage:
+ *    lookup-bench [ATOMS [MAX-READERS [WRITES-PER-SEC [MSECS]]]]
+ * for example,
+ *    lookup-bench 100000 64 20000 500
+ * Each run lasts MSECS milliseconds, at 1, 2, 4 ... MAX-READERS.
+ *
+ * Copyright (C) 2019 OpenCog Foundation
+ * All Rights Reserved
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <opencog/atomspace/AtomSpace.h>
+#include <opencog/atoms/base/Link.h>
+#include <opencog/atoms/base/Node.h>
+
+using namespace opencog;
+
+static AtomSpace* atomspace;
+static HandleSeq probes;
+static std::atomic_bool done;
+static std::atomic_size_t lookups;
+static std::atomic_size_t misses;
+static int write_rate;
+
+static void reader(int id)
+{
+    size_t n = 0;
+    size_t miss = 0;
+    size_t i = id * 7919;
+    while (not done) {
+        i = (i + 104729) % probes.size();
+        if (nullptr == atomspace->get_atom(probes[i])) miss++;
+        n++;
+    }
+    lookups += n;
+    misses += miss;
+}
+
+// Insert at a fixed rate, in bursts of 100. The names go on from one
+// run to the next, so that every run inserts new atoms.
+static void writer(void)
+{
+    static int count = 0;
+    int first = count;
+    auto start = std::chrono::steady_clock::now();
+    while (not done) {
+        for (int j = 0; j < 100; j++, count++) {
+            std::string name = "background " + std::to_string(count);
+            atomspace->add_node(CONCEPT_NODE, std::move(name));
+        }
+        auto due = start + std::chrono::microseconds(
+            (1000000L * (count - first)) / write_rate);
+        std::this_thread::sleep_until(due);
+    }
+}
+
+static double timed_run(int nreaders, int msecs)
+{
+    done = false;
+    lookups = 0;
+    misses = 0;
+
+    std::thread wr(writer);
+    std::vector<std::thread> pool;
+    for (int i = 0; i < nreaders; i++)
+        pool.push_back(std::thread(reader, i));
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(msecs));
+    done = true;
+    for (std::thread& t : pool) t.join();
+    wr.join();
+
+    // Every probe is in the atomspace; none should be missed.
+    if (0 < misses)
+        fprintf(stderr, "lookup-bench: %zu lookups missed\n",
+                (size_t) misses);
+    return (1000.0 * lookups) / msecs;
+}
+
+int main(int argc, char* argv[])
+{
+    int natoms = (1 < argc) ? atoi(argv[1]) : 100000;
+    int max_readers = (2 < argc) ? atoi(argv[2]) : 64;
+    write_rate = (3 < argc) ? atoi(argv[3]) : 20000;
+    int msecs = (4 < argc) ? atoi(argv[4]) : 500;
+    if (natoms <= 0 or max_readers <= 0 or write_rate <= 0 or msecs <= 0) {
+        fprintf(stderr, "Usage: %s [ATOMS [MAX-READERS "
+                "[WRITES-PER-SEC [MSECS]]]]\n", argv[0]);
+        return 1;
+    }
+
+    // Probes are atoms not in any atomspace; they are resolved by
+    // content. Half are nodes, half are links.
+    atomspace = new AtomSpace();
+    for (int i = 0; i < natoms; i++) {
+        std::string name = "probe " + std::to_string(i);
+        Handle h(atomspace->add_node(CONCEPT_NODE, std::move(name)));
+        if (i % 2) {
+            probes.emplace_back(createLink(LIST_LINK, h));
+            atomspace->add_link(LIST_LINK, h);
+        }
+        else
+            probes.emplace_back(createNode(CONCEPT_NODE, h->get_name()));
+    }
+
+    // What the lock-free index costs, on top of the type index.
+    MemoryReport rpt(atomspace->memory_report());
+    printf("lookup-bench: lookup index: %zu bytes, %.1f per atom\n",
+           rpt.lookup_index,
+           (double) rpt.lookup_index / atomspace->get_size());
+
+    printf("lookup-bench: background writes/sec: %d\n", write_rate);
+    for (int n = 1; n <= max_readers; n *= 2) {
+        double rate = timed_run(n, msecs);
+        printf("lookup-bench: readers: %2d  lookups/sec: %12.0f  "
+               "per reader: %10.0f\n", n, rate, rate / n);
+    }
+
+    probes.clear();
+    delete atomspace;
+    return 0;
+}
@@ -0,0 +1,109 @@
+/*
+ * tests/atomspace/memory-bench.cc
+ *
+ * Memory benchmark. Fills an AtomSpace with the atoms made by the
+ * RandomAtomGenerator, and prints how much memory they take, per atom:
+ * the bytes handed out by malloc, and the resident set size, both
+ * taken before and after. Unlike the MemoryReport, whose estimate it
+ * also prints, this counts everything, the AtomTable indexes and the
+ * allocator overhead included. This is not run by ctest.
+ *
+ * Usage:
+ *    memory-bench [ATOMS [PERCENT-LINKS]]
+ * for example,
+ *    memory-bench 1000000 50
+ *
+ * Copyright (C) 2019 OpenCog Foundation
+ * All Rights Reserved
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <malloc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <opencog/atomspace/AtomSpace.h>
+#include <opencog/atomspaceutils/RandomAtomGenerator.h>
+
+using namespace opencog;
+
+// Bytes in use, as seen by glibc malloc, large mmapped blocks included.
+static size_t heap_bytes(void)
+{
+#if defined(__GLIBC__) && \
+    (2 < __GLIBC__ || (2 == __GLIBC__ && 33 <= __GLIBC_MINOR__))
+    struct mallinfo2 mi = mallinfo2();
+#else
+    struct mallinfo mi = mallinfo();
+#endif
+    return (size_t) mi.uordblks + (size_t) mi.hblkhd;
+}
+
+// Resident set size, from /proc.
+static size_t rss_bytes(void)
+{
+    FILE* f = fopen("/proc/self/statm", "r");
+    if (nullptr == f) return 0;
+    unsigned long size = 0, resident = 0;
+    if (2 != fscanf(f, "%lu %lu", &size, &resident)) resident = 0;
+    fclose(f);
+    return resident * sysconf(_SC_PAGESIZE);
+}
+
+static void print_row(const char* what, double bytes, size_t natoms)
+{
+    printf("memory-bench: %-26s %14.0f bytes %10.1f per atom\n",
+           what, bytes, bytes / natoms);
+}
+
+int main(int argc, char* argv[])
+{
+    long natoms = (1 < argc) ? atol(argv[1]) : 1000000;
+    int percent = (2 < argc) ? atoi(argv[2]) : 50;
+    if (natoms <= 0 or percent < 0 or 100 < percent) {
+        fprintf(stderr, "Usage: %s [ATOMS [PERCENT-LINKS]]\n", argv[0]);
+        return 1;
+    }
+
+    AtomSpace* as = new AtomSpace();
+    size_t heap_before = heap_bytes();
+    size_t rss_before = rss_bytes();
+
+    // A fixed seed, so that runs can be compared.
+    {
+        RandomAtomGenerator gen(as, 42);
+        gen.make_random_atoms(natoms, percent / 100.0f);
+    }
+
+    size_t heap_after = heap_bytes();
+    size_t rss_after = rss_bytes();
+    size_t n = as->get_size();
+    MemoryReport rpt(as->memory_report(0));
+
+    printf("memory-bench: atoms: %zu  nodes: %zu  links: %zu\n",
+           n, as->get_num_nodes(), as->get_num_links());
+    print_row("malloc, in use:", (double) heap_after - heap_before, n);
+    print_row("resident set size:", (double) rss_after - rss_before, n);
+    print_row("MemoryReport estimate:", rpt.total().total(), n);
+    print_row("  of which values:",
+              rpt.total().value_tables + rpt.total().values, n);
+    print_row("lookup index:", rpt.lookup_index, n);
+
+    delete as;
+    return 0;
+}
@@ -73,6 +73,58 @@ class AtomSpaceTest(TestCase):
             caught = True
         self.assertEquals(caught, True)
 
+    def test_add_atoms(self):
+        n1 = Node("test1")
+        n2 = Node("test2")
+        l1 = Link(n1, n2)
+
+        # Copy them into a second atomspace, all at once.
+        other = AtomSpace()
+        added = other.add_atoms([l1, n1, n2, l1])
+        self.assertEquals(len(added), 4)
+        self.assertEquals(other.size(), 3)
+        self.assertEquals(added[0], added[3])
+        self.assertEquals(added[0].out, [added[1], added[2]])
+        self.assertEquals(added[1].name, "test1")
+
+        # Atoms that are already there are simply returned.
+        self.assertEquals(self.space.add_atoms([n1, l1]), [n1, l1])
+        self.assertEquals(self.space.size(), 3)
+
+    def test_get_random_atoms(self):
+        n1 = Node("test1")
+        n2 = Node("test2")
+        l1 = Link(n1, n2)
+
+        atoms = self.space.get_random_atoms(100)
+        self.assertEquals(len(atoms), 100)
+        self.assertEquals(set(atoms), set([n1, n2, l1]))
+
+        nodes = self.space.get_random_atoms(50, types.Node)
+        self.assertEquals(set(nodes), set([n1, n2]))
+        self.assertEquals(self.space.get_random_atoms(5, types.Node, False), [])
+
+    def test_memory_report(self):
+        n1 = Node("test1")
+        n2 = ConceptNode("test2")
+        l1 = Link(n1, n2)
+        l1.set_value(PredicateNode("key"), FloatValue([1.0, 2.0, 3.0]))
+
+        rpt = self.space.memory_report()
+        atoms = rpt["atoms"]
+        values = rpt["values"]
+        self.assertEquals(atoms["Node"]["count"], 1)
+        self.assertEquals(atoms["ConceptNode"]["count"], 1)
+        self.assertEquals(atoms["PredicateNode"]["count"], 1)
+        self.assertTrue(atoms["Link"]["outgoing"] > 0)
+        self.assertEquals(atoms["Node"]["outgoing"], 0)
+        self.assertTrue(atoms["Link"]["values"] > 0)
+        self.assertEquals(list(values.keys()), ["FloatValue"])
+        self.assertEquals(values["FloatValue"]["count"], 1)
+        self.assertEquals(values["FloatValue"]["bytes"], atoms["Link"]["values"])
+        self.assertTrue(all(r["total"] >= r["atoms"] > 0
+                            for r in atoms.values()))
+
     def test_is_valid(self):
         a1 = Node("test1")
         # check with Atom object
@@ -1,8 +1,11 @@
+import os
+import tempfile
 from unittest import TestCase
 
 from opencog.type_constructors import *
-from opencog.atomspace import AtomSpace
-from opencog.utilities import initialize_opencog, finalize_opencog
+from opencog.atomspace import AtomSpace, types
+from opencog.utilities import initialize_opencog, finalize_opencog, load_file
+from opencog.utilities import dump_file
 
 __author__ = 'Curtis Faith'
 
@@ -18,3 +21,30 @@ class UtilitiesTest(TestCase):
     def test_initialize_finalize(self):
         initialize_opencog(self.atomspace)
         finalize_opencog()
+
+    def test_load_file(self):
+        fname = tempfile.mktemp(suffix='.scm')
+        with open(fname, 'w') as f:
+            f.write('(Inheritance (Concept "a") (Concept "b" (stv 0.5 0.8)))\n')
+        try:
+            self.assertEqual(3, load_file(self.atomspace, fname))
+        finally:
+            os.remove(fname)
+        b = self.atomspace.add_node(types.ConceptNode, "b")
+        self.assertAlmostEqual(0.5, b.tv.mean, places=5)
+        self.assertAlmostEqual(0.8, b.tv.confidence, places=5)
+        self.assertEqual(3, len(self.atomspace))
+
+    def test_dump_file(self):
+        a = self.atomspace.add_node(types.ConceptNode, "a")
+        self.atomspace.add_link(types.ListLink, [a, a])
+        for binary in (False, True):
+            fname = tempfile.mktemp(suffix='.scm')
+            try:
+                self.assertEqual(2, dump_file(self.atomspace, fname,
+                                              binary=binary))
+                other = AtomSpace()
+                load_file(other, fname)
+                self.assertEqual(2, len(other))
+            finally:
+                os.remove(fname)
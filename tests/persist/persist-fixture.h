@@ -0,0 +1,133 @@
+/*
+ * tests/persist/persist-fixture.h
+ *
+ * Copyright (C) 2019 OpenCog Foundation
+ * All Rights Reserved
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License v3 as
+ * published by the Free Software Foundation and including the exceptions
+ * at http://opencog.org/wiki/Licenses
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program; if not, write to:
+ * Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// The small graph that the snapshot, LSM and file backend tests save
+// and restore, and the checks that each of them makes on it. The
+// tests of each backend add whatever is particular to it.
+
+#include <opencog/atoms/atom_types/atom_types.h>
+#include <opencog/atoms/base/Link.h>
+#include <opencog/atoms/base/Node.h>
+#include <opencog/atoms/value/FloatValue.h>
+#include <opencog/atoms/value/LinkValue.h>
+#include <opencog/atoms/value/StringValue.h>
+#include <opencog/atoms/truthvalue/SimpleTruthValue.h>
+#include <opencog/atomspace/AtomSpace.h>
+#include <opencog/atomspace/BackingStore.h>
+
+using namespace opencog;
+
+// The graph has the nodes a, b, c and key, the links (List a b),
+// (Evaluation c (List a b)) and (List a a), a truth value on a, and
+// values on the first two links under key; one of those values holds
+// the node in-value, which is not otherwise in the atomspace.
+static inline void populate_graph(AtomSpace& as)
+{
+	Handle a = as.add_node(CONCEPT_NODE, "a");
+	Handle b = as.add_node(CONCEPT_NODE, "b");
+	Handle c = as.add_node(PREDICATE_NODE, "c");
+	Handle ab = as.add_link(LIST_LINK, a, b);
+	Handle eval = as.add_link(EVALUATION_LINK, c, ab);
+	as.add_link(LIST_LINK, a, a);
+
+	a->setTruthValue(SimpleTruthValue::createTV(0.5, 0.25));
+	Handle key = as.add_node(PREDICATE_NODE, "key");
+	eval->setValue(key, createFloatValue(std::vector<double>({1, 2, 3})));
+	ab->setValue(key, createLinkValue(std::vector<ValuePtr>({
+		createStringValue("x"), createNode(CONCEPT_NODE, "in-value")})));
+}
+
+// The whole graph, values and all, has been loaded into as.
+static inline void check_graph(AtomSpace& as)
+{
+	Handle a = as.get_handle(CONCEPT_NODE, "a");
+	TS_ASSERT(a != nullptr);
+	TS_ASSERT(*a->getTruthValue() ==
+		*SimpleTruthValue::createTV(0.5, 0.25));
+	TS_ASSERT(nullptr != as.get_handle(LIST_LINK, a, a));
+
+	Handle key = as.get_handle(PREDICATE_NODE, "key");
+	Handle ab = as.get_handle(LIST_LINK, a,
+		as.get_handle(CONCEPT_NODE, "b"));
+	Handle eval = as.get_handle(EVALUATION_LINK,
+		as.get_handle(PREDICATE_NODE, "c"), ab);
+	TS_ASSERT(key != nullptr);
+	TS_ASSERT(eval != nullptr);
+
+	ValuePtr fv = eval->getValue(key);
+	TS_ASSERT(fv != nullptr);
+	TS_ASSERT(*fv == *createFloatValue(std::vector<double>({1, 2, 3})));
+
+	LinkValuePtr lv = LinkValueCast(ab->getValue(key));
+	TS_ASSERT(lv != nullptr);
+	TS_ASSERT_EQUALS(lv->value().size(), 2);
+	TS_ASSERT(*lv->value()[0] == *createStringValue("x"));
+	TS_ASSERT(as.get_handle(CONCEPT_NODE, "in-value") ==
+		HandleCast(lv->value()[1]));
+}
+
+// Single atoms come back with their values; misses are misses.
+static inline void check_fetch(AtomSpace& as, BackingStore& store)
+{
+	Handle a = as.fetch_atom(createNode(CONCEPT_NODE, "a"));
+	TS_ASSERT_EQUALS(as.get_size(), 1);
+	TS_ASSERT(*a->getTruthValue() ==
+		*SimpleTruthValue::createTV(0.5, 0.25));
+
+	Handle ab = as.fetch_atom(createLink(LIST_LINK,
+		createNode(CONCEPT_NODE, "a"), createNode(CONCEPT_NODE, "b")));
+	TS_ASSERT(ab != nullptr);
+	TS_ASSERT(ab->getOutgoingAtom(0) == a);
+
+	TS_ASSERT(nullptr == store.getNode(CONCEPT_NODE, "z"));
+	TS_ASSERT(nullptr == store.getLink(LIST_LINK, {a, a, a}));
+	TS_ASSERT(nullptr != store.getLink(LIST_LINK, {a, a}));
+}
+
+static inline void check_incoming(AtomSpace& as)
+{
+	Handle a = as.add_node(CONCEPT_NODE, "a");
+	as.fetch_incoming_set(a);
+
+	// (List a b) and (List a a), the latter only once.
+	TS_ASSERT_EQUALS(a->getIncomingSetSize(), 2);
+
+	Handle c = as.add_node(PREDICATE_NODE, "c");
+	as.fetch_incoming_by_type(c, LIST_LINK);
+	TS_ASSERT_EQUALS(c->getIncomingSetSize(), 0);
+	as.fetch_incoming_by_type(c, EVALUATION_LINK);
+	TS_ASSERT_EQUALS(c->getIncomingSetSize(), 1);
+}
+
+static inline void check_load_type(AtomSpace& as)
+{
+	// a, b and in-value.
+	as.fetch_all_atoms_of_type(CONCEPT_NODE);
+	HandleSeq hs;
+	as.get_handles_by_type(hs, CONCEPT_NODE);
+	TS_ASSERT_EQUALS(hs.size(), 3);
+
+	as.fetch_all_atoms_of_type(EVALUATION_LINK);
+	TS_ASSERT(nullptr != as.get_handle(LIST_LINK,
+		as.get_handle(CONCEPT_NODE, "a"),
+		as.get_handle(CONCEPT_NODE, "b")));
+}